@@ -105,6 +105,9 @@
 /* Define to 1 to enable DSP 56k emulation for Falcon mode */
 #cmakedefine ENABLE_DSP_EMU 1
 
+/* Define to 1 to enable the 68020+ JIT compiler (x86-64 only) */
+#cmakedefine ENABLE_JIT 1
+
 /* Define to 1 to use SDL3 instead of SDL2 */
 #cmakedefine ENABLE_SDL3 1
 
@@ -464,7 +464,7 @@ static void	ACIA_Set_Timers_IKBD ( struct ACIA *pACIA )
  * TX_Clock / Divider and we only need one timer interrupt to handle both RX and TX.
  * This freq should be converted to CPU_CYCLE : 1 ACIA cycle = 16 CPU cycles
  * (with cpu running at 8 MHz)
- * InternalCycleOffset allows to compensate for a != 0 value in PendingInterruptCount
+ * InternalCycleOffset allows to compensate for a != 0 value in CycInt_DelayedCycles
  * to keep a constant baud rate.
  * TODO : we use a fixed 8 MHz clock to convert cycles for our internal timers
  * in cycInt.c. This should be replaced some days by using MachineClocks.CPU_Freq.
@@ -501,7 +501,7 @@ void	ACIA_InterruptHandler_IKBD ( void )
 
 	/* Number of internal cycles we went over for this timer ( <= 0 ) */
 	/* Used to restart the next timer and keep a constant baud rate */
-	PendingCyclesOver = -PendingInterruptCount;			/* >= 0 */
+	PendingCyclesOver = -CycInt_DelayedCycles;			/* >= 0 */
 
 	LOG_TRACE ( TRACE_ACIA, "acia ikbd interrupt handler pending_cyc=%d VBL=%d HBL=%d\n" , PendingCyclesOver , nVBLs , nHBL );
 
@@ -1451,6 +1451,8 @@ static bool	Avi_StartRecording ( char *FileName , bool CropGui , uint32_t Fps ,
 	AviParams.AudioCodec = AVI_RECORD_AUDIO_CODEC_PCM;
 	AviParams.AudioFreq = ConfigureParams.Sound.nPlaybackFreq;
 
+	/* In headless mode, the screen may not have been converted yet */
+	ConvST_RefreshOnDemand();
 	Screen_GetDimension(&AviParams.surface_pixels, &AviParams.surface_w,
 	                    &AviParams.surface_h, &AviParams.surface_pitch);
 
@@ -85,6 +85,8 @@ static const struct Config_Tag configs_Screen[] =
 	{ "bResizable", Bool_Tag, &ConfigureParams.Screen.bResizable },
 	{ "bAllowOverscan", Bool_Tag, &ConfigureParams.Screen.bAllowOverscan },
 	{ "nSpec512Threshold", Int_Tag, &ConfigureParams.Screen.nSpec512Threshold },
+	{ "bDirectLines", Bool_Tag, &ConfigureParams.Screen.bDirectLines },
+	{ "bScanlines", Bool_Tag, &ConfigureParams.Screen.bScanlines },
 	{ "bAspectCorrect", Bool_Tag, &ConfigureParams.Screen.bAspectCorrect },
 	{ "bUseExtVdiResolutions", Bool_Tag, &ConfigureParams.Screen.bUseExtVdiResolutions },
 	{ "nVdiWidth", Int_Tag, &ConfigureParams.Screen.nVdiWidth },
@@ -102,6 +104,7 @@ static const struct Config_Tag configs_Screen[] =
 	{ "ScreenShotFormat", Int_Tag, &ConfigureParams.Screen.ScreenShotFormat },
 	{ "szScreenShotDir", String_Tag, ConfigureParams.Screen.szScreenShotDir },
 	{ "bUseVsync", Bool_Tag, &ConfigureParams.Screen.bUseVsync },
+	{ "bHeadless", Bool_Tag, &ConfigureParams.Screen.bHeadless },
 	{ NULL , Error_Tag, NULL }
 };
 
@@ -333,6 +336,8 @@ static const struct Config_Tag configs_Sound[] =
 	{ "nSdlAudioBufferSize", Int_Tag, &ConfigureParams.Sound.SdlAudioBufferSize },
 	{ "szYMCaptureFileName", String_Tag, ConfigureParams.Sound.szYMCaptureFileName },
 	{ "YmVolumeMixing", Int_Tag, &ConfigureParams.Sound.YmVolumeMixing },
+	{ "ResampleMethod", Int_Tag, &ConfigureParams.Sound.ResampleMethod },
+	{ "bSynthThread", Bool_Tag, &ConfigureParams.Sound.bSynthThread },
 	{ NULL , Error_Tag, NULL }
 };
 
@@ -564,6 +569,7 @@ static const struct Config_Tag configs_System[] =
 	{ "bPatchTimerD", Bool_Tag, &ConfigureParams.System.bPatchTimerD },
 	{ "bFastBoot", Bool_Tag, &ConfigureParams.System.bFastBoot },
 	{ "bFastForward", Bool_Tag, &ConfigureParams.System.bFastForward },
+	{ "bFastForwardIdleSkip", Bool_Tag, &ConfigureParams.System.bFastForwardIdleSkip },
 	{ "bAddressSpace24", Bool_Tag, &ConfigureParams.System.bAddressSpace24 },
 	{ "bCycleExactCpu", Bool_Tag, &ConfigureParams.System.bCycleExactCpu },
 	{ "bCpuDataCache", Bool_Tag, &ConfigureParams.System.bCpuDataCache },
@@ -571,6 +577,9 @@ static const struct Config_Tag configs_System[] =
 /* JIT	{ "bCompatibleFPU", Bool_Tag, &ConfigureParams.System.bCompatibleFPU }, */
 	{ "bSoftFloatFPU", Bool_Tag, &ConfigureParams.System.bSoftFloatFPU },
 	{ "bMMU", Bool_Tag, &ConfigureParams.System.bMMU },
+	{ "bMmuHostAtc", Bool_Tag, &ConfigureParams.System.bMmuHostAtc },
+	{ "bJIT", Bool_Tag, &ConfigureParams.System.bJIT },
+	{ "bBlockCache", Bool_Tag, &ConfigureParams.System.bBlockCache },
 	{ "VideoTiming", Int_Tag, &ConfigureParams.System.VideoTimingMode },
 	{ NULL , Error_Tag, NULL }
 };
@@ -767,6 +776,8 @@ void Configuration_SetDefault(void)
 	ConfigureParams.Screen.nFrameSkips = AUTO_FRAMESKIP_LIMIT;
 	ConfigureParams.Screen.bAllowOverscan = true;
 	ConfigureParams.Screen.nSpec512Threshold = 1;
+	ConfigureParams.Screen.bDirectLines = false;
+	ConfigureParams.Screen.bScanlines = false;
 	ConfigureParams.Screen.bAspectCorrect = true;
 	ConfigureParams.Screen.nMonitorType = MONITOR_TYPE_RGB;
 	ConfigureParams.Screen.bUseExtVdiResolutions = false;
@@ -788,6 +799,7 @@ void Configuration_SetDefault(void)
 	ConfigureParams.Screen.nZoomFactor = 1.0;
 	ConfigureParams.Screen.bUseSdlRenderer = true;
 	ConfigureParams.Screen.bUseVsync = false;
+	ConfigureParams.Screen.bHeadless = false;
 #if HAVE_LIBPNG
 	ConfigureParams.Screen.ScreenShotFormat = SCREEN_SNAPSHOT_PNG;
 #else
@@ -805,6 +817,8 @@ void Configuration_SetDefault(void)
 	                 psWorkingDir, "hatari", "wav");
 	ConfigureParams.Sound.SdlAudioBufferSize = 0;
 	ConfigureParams.Sound.YmVolumeMixing = YM_TABLE_MIXING;
+	ConfigureParams.Sound.ResampleMethod = YM2149_RESAMPLE_METHOD_WEIGHTED_AVERAGE_N;
+	ConfigureParams.Sound.bSynthThread = false;
 
 	/* Set defaults for Rom */
 	File_MakePathBuf(ConfigureParams.Rom.szTosImageFileName,
@@ -838,6 +852,9 @@ void Configuration_SetDefault(void)
 	ConfigureParams.System.bCompatibleFPU = true; /* JIT */
 	ConfigureParams.System.bSoftFloatFPU = false;
 	ConfigureParams.System.bMMU = false;
+	ConfigureParams.System.bMmuHostAtc = true;
+	ConfigureParams.System.bJIT = false;
+	ConfigureParams.System.bBlockCache = false;
 	ConfigureParams.System.bCpuDataCache = true;
 	ConfigureParams.System.bCycleExactCpu = true;
 	ConfigureParams.System.VideoTimingMode = VIDEO_TIMING_MODE_WS3;
@@ -846,6 +863,7 @@ void Configuration_SetDefault(void)
 	ConfigureParams.System.bPatchTimerD = false;
 	ConfigureParams.System.bFastBoot = false;
 	ConfigureParams.System.bFastForward = false;
+	ConfigureParams.System.bFastForwardIdleSkip = true;
 
 	/* Set defaults for Video */
 #if HAVE_LIBPNG
@@ -939,6 +957,16 @@ void Configuration_Apply(bool bReset)
 	YmVolumeMixing = ConfigureParams.Sound.YmVolumeMixing;
 	Sound_SetYmVolumeMixing();
 
+	/* Resampling to the host audio frequency */
+	if ( ( ConfigureParams.Sound.ResampleMethod < YM2149_RESAMPLE_METHOD_NEAREST )
+	  || ( ConfigureParams.Sound.ResampleMethod > YM2149_RESAMPLE_METHOD_SINC ) )
+		ConfigureParams.Sound.ResampleMethod = YM2149_RESAMPLE_METHOD_WEIGHTED_AVERAGE_N;
+
+	YM2149_Resample_Method = ConfigureParams.Sound.ResampleMethod;
+
+	/* YM2149 synthesis in its own thread */
+	Sound_SetSynthThread(ConfigureParams.Sound.bSynthThread);
+
 	/* Falcon : update clocks values if sound freq changed  */
 	if ( Config_IsMachineFalcon() )
 		Crossbar_Recalculate_Clocks_Cycles();
@@ -10,6 +10,7 @@
 #include "main.h"
 #include "configuration.h"
 #include "conv_gen.h"
+#include "conv_simd.h"
 #include "conv_st.h"
 #include "endianswap.h"
 #include "gui_event.h"
@@ -34,8 +35,73 @@ struct screen_zoom_s
 };
 
 static struct screen_zoom_s screen_zoom;
+
+/* Conversion parameters, a change needs a full update of the host screen */
+struct screen_params_s
+{
+	uint32_t vaddr;
+	int vw, vh, vbpp, nextline, hscroll;
+	int leftBorder, rightBorder, upperBorder, lowerBorder;
+	int zoomx, zoomy;
+	int ttspecial;
+	uint32_t *hvram;
+	int width, height, pitch;
+	int genconv_width, genconv_height;
+};
+
+/* Copy of the emulated screen lines of the previous conversion, to convert
+ * only the lines which changed since then */
+struct screen_copy_s
+{
+	bool fullupdate;		/* Convert everything on next frame */
+	struct screen_params_s params;
+	uint32_t palette[256];
+	uint8_t *lines;
+	int linesize;			/* Bytes per line in 'lines' */
+	int size;
+	bool changed;			/* Lines converted by last ConvGen_Convert() */
+	int dirty_top;			/* Host screen lines changed since */
+	int dirty_bottom;		/* ConvGen_GetDirtyLines() */
+};
+
+static struct screen_copy_s screen_copy = { .fullupdate = true, .dirty_top = INT_MAX };
+
+/* Graphical areas of more host pixels than the biggest ST screen (640x400
+ * for ST high or zoomed ST low / medium resolution) are converted by bands
+ * of lines in parallel, by the host screen worker threads */
+#define CONVGEN_BAND_PIXELS	(640 * 400)
+#define CONVGEN_MAX_BANDS	4
+
+/* Host lines 'first' to 'last' - 1 of a graphical area, the state of
+ * their conversion is independent of the other bands */
+struct conv_band_s
+{
+	int idx;
+	int first, last;
+	uint32_t nLineEndAddr;		/* End of the first emulated line */
+	int dirty_top, dirty_bottom;	/* Host screen lines changed */
+	bool changed;
+};
+
+/* Graphical area to convert, shared by its bands */
+struct conv_area_s
+{
+	void (*convert)(const struct conv_area_s *a, struct conv_band_s *band);
+	uint16_t *fvram;
+	uint32_t *hvram;		/* First host line of the graphical area */
+	int pitch, scrwidth;
+	int vw, vbpp, nextline, hscrolloffset;
+	int leftBorder, rightBorder;
+	int coefx, coefy;
+	struct conv_band_s band[CONVGEN_MAX_BANDS];
+};
+
 static bool bTTSampleHold = false;		/* TT special video mode */
 static int nSampleHoldIdx;
+static bool bSimdHiColor;			/* Host pixel format usable by ConvSimd_HiColorLine */
+static CONVSIMD_RGB SimdRGBFormat;
+static uint8_t *pSimdPixels[CONVGEN_MAX_BANDS];	/* Palette indexes of a line for ConvSimd_PaletteLine */
+static int nSimdPixelsSize[CONVGEN_MAX_BANDS];
 static uint32_t nScreenBaseAddr;		/* address of screen in STRam */
 int ConvertW = 0;
 int ConvertH = 0;
@@ -99,6 +165,149 @@ static void ConvGen_memset_uint32(uint32_t *addr, uint32_t color, int count)
 	}
 }
 
+/**
+ * Convert the whole screen on next frame, for example when the host
+ * screen was cleared or re-created
+ */
+void ConvGen_SetFullUpdate(void)
+{
+	screen_copy.fullupdate = true;
+}
+
+/**
+ * Mark 'count' host screen lines of 'band' starting at 'hvram_line'
+ * as changed
+ */
+static void ConvGen_SetDirty(struct conv_band_s *band, uint32_t *hvram_line, int count)
+{
+	struct screen_params_s *p = &screen_copy.params;
+	int y = (hvram_line - p->hvram) / (p->pitch / sizeof(uint32_t));
+
+	if (y < band->dirty_top)
+		band->dirty_top = y;
+	if (y + count > band->dirty_bottom)
+		band->dirty_bottom = y + count;
+	band->changed = true;
+}
+
+/**
+ * Get the host screen lines changed by the conversions since the previous
+ * call (lines 'top' to 'bottom' - 1, 'bottom' can be bigger than the host
+ * screen height). Return false if nothing changed.
+ */
+bool ConvGen_GetDirtyLines(int *top, int *bottom)
+{
+	bool changed;
+
+	if (screen_copy.fullupdate)
+	{
+		screen_copy.dirty_top = 0;
+		screen_copy.dirty_bottom = INT_MAX;
+	}
+
+	*top = screen_copy.dirty_top;
+	*bottom = screen_copy.dirty_bottom;
+	changed = *top < *bottom;
+
+	screen_copy.dirty_top = INT_MAX;
+	screen_copy.dirty_bottom = 0;
+	return changed;
+}
+
+/**
+ * Return true if line 'y' of the emulated screen ('size' bytes at
+ * 'fvram_line') needs to be converted, because it changed since the
+ * previous conversion or the whole screen needs to be converted.
+ */
+static bool ConvGen_LineChanged(int y, uint16_t *fvram_line, int size)
+{
+	uint8_t *copy;
+
+	if (size > screen_copy.linesize || (y + 1) * screen_copy.linesize > screen_copy.size)
+		return true;
+
+	copy = screen_copy.lines + y * screen_copy.linesize;
+	if (!screen_copy.fullupdate && memcmp(copy, fvram_line, size) == 0)
+		return false;
+
+	memcpy(copy, fvram_line, size);
+	return true;
+}
+
+/**
+ * Check if the conversion parameters and the palette are the same as for
+ * the previous frame, else convert the whole screen. 'lines' lines of
+ * 'linesize' bytes of the emulated screen can be compared.
+ */
+static void ConvGen_CheckFullUpdate(const struct screen_params_s *params,
+                                    int lines, int linesize)
+{
+	uint8_t *copy;
+
+	if (memcmp(params, &screen_copy.params, sizeof(*params)) != 0
+	    || memcmp(palette.native, screen_copy.palette, sizeof(screen_copy.palette)) != 0
+	    || linesize != screen_copy.linesize)
+	{
+		screen_copy.fullupdate = true;
+		screen_copy.params = *params;
+		memcpy(screen_copy.palette, palette.native, sizeof(screen_copy.palette));
+		screen_copy.linesize = linesize;
+	}
+
+	if (lines * linesize > screen_copy.size)
+	{
+		copy = realloc(screen_copy.lines, lines * linesize);
+		if (copy)
+		{
+			screen_copy.lines = copy;
+			screen_copy.size = lines * linesize;
+		}
+		screen_copy.fullupdate = true;
+	}
+}
+
+/**
+ * Check if the host pixel format can be used by ConvSimd_HiColorLine
+ * (8 bits per component, Screen_MapRGB only setting these bits and the
+ * same alpha bits for all colors)
+ */
+static void ConvGen_SetSimdFormat(void)
+{
+	uint32_t rmask, gmask, bmask;
+	CONVSIMD_RGB *f = &SimdRGBFormat;
+
+	bSimdHiColor = false;
+	if (!ConvSimd_HiColorLine)
+		return;
+
+	Screen_GetPixelFormat(&rmask, &gmask, &bmask, &f->rshift, &f->gshift, &f->bshift);
+	if (rmask != 0xffu << f->rshift || gmask != 0xffu << f->gshift || bmask != 0xffu << f->bshift)
+		return;
+
+	f->base = Screen_MapRGB(0, 0, 0);
+	bSimdHiColor = Screen_MapRGB(0x12, 0xa4, 0x7f) ==
+		(f->base | 0x12u << f->rshift | 0xa4u << f->gshift | 0x7fu << f->bshift);
+}
+
+/**
+ * Return a buffer for 'count' palette indexes for band 'idx', or NULL
+ * if it can't be allocated
+ */
+static uint8_t *ConvGen_GetSimdPixels(int idx, int count)
+{
+	uint8_t *pixels;
+
+	if (count > nSimdPixelsSize[idx])
+	{
+		pixels = realloc(pSimdPixels[idx], count);
+		if (!pixels)
+			return NULL;
+		pSimdPixels[idx] = pixels;
+		nSimdPixelsSize[idx] = count;
+	}
+	return pSimdPixels[idx];
+}
+
 static inline uint32_t idx2pal(uint8_t idx)
 {
 	if (unlikely(bTTSampleHold))
@@ -205,12 +414,25 @@ static void ConvGen_BitplaneToChunky32(uint16_t *atariBitplaneData,
 }
 
 
-static inline uint32_t *ConvGen_BitplaneLineTo32bpp(uint16_t *fvram_column,
+static inline uint32_t *ConvGen_BitplaneLineTo32bpp(struct conv_band_s *band,
+                                                    uint16_t *fvram_column,
                                                     uint32_t *hvram_column, int vw,
                                                     int vbpp, int hscrolloffset)
 {
 	uint32_t hvram_buf[16];
-	int i;
+	uint8_t *pixels;
+	int i, count;
+
+	/* Whole line at once (not with TT sample hold, which depends on */
+	/* the previous pixels) */
+	count = ((vw + 15) >> 4) * 16;
+	if (ConvSimd_BitplanePixels && !bTTSampleHold
+	    && (pixels = ConvGen_GetSimdPixels(band->idx, count + 16)))
+	{
+		ConvSimd_BitplanePixels(fvram_column, vbpp, pixels, (count >> 4) + (hscrolloffset != 0));
+		ConvSimd_PaletteLine(pixels + hscrolloffset, hvram_column, count, palette.native);
+		return hvram_column + count;
+	}
 
 	/* First 16 pixels */
 	ConvGen_BitplaneToChunky32(fvram_column, vbpp, hvram_buf);
@@ -242,6 +464,128 @@ static inline uint32_t *ConvGen_BitplaneLineTo32bpp(uint16_t *fvram_column,
 }
 
 
+/**
+ * Convert a band of the graphical area (run by a worker thread for
+ * the bands of big screens)
+ */
+static void ConvGen_ConvertBand(int idx, void *data)
+{
+	struct conv_area_s *a = data;
+
+	a->convert(a, &a->band[idx]);
+}
+
+/**
+ * Convert the 'lines' host lines of the graphical area 'a'. Big areas
+ * are split in bands converted in parallel: each band starts with a new
+ * emulated line ('ytable' gives the emulated line of each host line when
+ * zooming), so that the result doesn't depend on the band order.
+ */
+static void ConvGen_ConvertArea(struct conv_area_s *a, int lines, const int *ytable)
+{
+	struct conv_band_s *band;
+	int bands = 1, first = 0, last, emulines = 0;
+	int i, y;
+
+	/* The TT sample-hold pixels depend on the previous pixels */
+	if (lines * a->scrwidth > CONVGEN_BAND_PIXELS && !bTTSampleHold)
+	{
+		bands = Screen_GetWorkerCount() + 1;
+		if (bands > CONVGEN_MAX_BANDS)
+			bands = CONVGEN_MAX_BANDS;
+	}
+
+	for (i = 0; i < bands; i++)
+	{
+		last = lines * (i + 1) / bands;
+		if (last < first)
+			last = first;
+		while (ytable && last > 0 && last < lines && ytable[last] == ytable[last - 1])
+			last++;
+
+		band = &a->band[i];
+		band->idx = i;
+		band->first = first;
+		band->last = last;
+		band->nLineEndAddr = nScreenBaseAddr + a->nextline * 2 * (emulines + 1);
+		band->dirty_top = INT_MAX;
+		band->dirty_bottom = 0;
+		band->changed = false;
+
+		if (!ytable)
+			emulines = last;
+		for (y = first; ytable && y < last; y++)
+		{
+			if (y == 0 || ytable[y] != ytable[y - 1])
+				emulines++;
+		}
+		first = last;
+	}
+
+	if (bands > 1)
+		Screen_RunWorkers(ConvGen_ConvertBand, bands, a);
+	else
+		ConvGen_ConvertBand(0, a);
+
+	for (i = 0; i < bands; i++)
+	{
+		band = &a->band[i];
+		if (band->dirty_top < screen_copy.dirty_top)
+			screen_copy.dirty_top = band->dirty_top;
+		if (band->dirty_bottom > screen_copy.dirty_bottom)
+			screen_copy.dirty_bottom = band->dirty_bottom;
+		if (band->changed)
+			screen_copy.changed = true;
+	}
+}
+
+
+static void ConvGen_BitplaneBandNoZoom(const struct conv_area_s *a,
+                                       struct conv_band_s *band)
+{
+	uint16_t *fvram_line = a->fvram + band->first * a->nextline;
+	uint32_t *hvram_line = a->hvram + band->first * a->pitch;
+	uint32_t nLineEndAddr = band->nLineEndAddr;
+	int linesize = (((a->vw + 15) >> 4) + (a->hscrolloffset != 0)) * a->vbpp * 2;
+	int h;
+
+	for (h = band->first; h < band->last; h++)
+	{
+		uint32_t *hvram_column = hvram_line;
+
+		if (nLineEndAddr > STRamEnd)
+		{
+			if (screen_copy.fullupdate)
+				ConvGen_memset_uint32(hvram_line, palette.native[0], a->pitch);
+			hvram_line += a->pitch;
+			continue;
+		}
+
+		/* Skip the lines which didn't change */
+		if (ConvGen_LineChanged(h, fvram_line, linesize))
+		{
+			if (bTTSampleHold)
+				nSampleHoldIdx = 0;
+
+			/* Left border first */
+			ConvGen_memset_uint32(hvram_column, palette.native[0], a->leftBorder);
+			hvram_column += a->leftBorder;
+
+			hvram_column = ConvGen_BitplaneLineTo32bpp(band, fvram_line, hvram_column,
+			                                           a->vw, a->vbpp, a->hscrolloffset);
+
+			/* Right border */
+			ConvGen_memset_uint32(hvram_column, palette.native[0], a->rightBorder);
+
+			ConvGen_SetDirty(band, hvram_line, 1);
+		}
+
+		nLineEndAddr += a->nextline * 2;
+		fvram_line += a->nextline;
+		hvram_line += a->pitch;
+	}
+}
+
 static void ConvGen_BitplaneTo32bppNoZoom(uint16_t *fvram_line,
                                           uint32_t *hvram, int pitch,
                                           int scrwidth, int scrheight,
@@ -250,51 +594,98 @@ static void ConvGen_BitplaneTo32bppNoZoom(uint16_t *fvram_line,
                                           int leftBorder, int rightBorder,
                                           int upperBorder, int lowBorder)
 {
+	struct conv_area_s area;
 	uint32_t *hvram_line = hvram;
-	uint32_t nLineEndAddr = nScreenBaseAddr + nextline * 2;
 	int h;
 
 	/* Render the upper border */
 	for (h = 0; h < upperBorder; h++)
 	{
-		ConvGen_memset_uint32(hvram_line, palette.native[0], scrwidth);
+		if (screen_copy.fullupdate)
+			ConvGen_memset_uint32(hvram_line, palette.native[0], scrwidth);
 		hvram_line += pitch;
 	}
 
 	/* Render the graphical area */
-	for (h = 0; h < vh; h++)
+	area.convert = ConvGen_BitplaneBandNoZoom;
+	area.fvram = fvram_line;
+	area.hvram = hvram_line;
+	area.pitch = pitch;
+	area.scrwidth = scrwidth;
+	area.vw = vw;
+	area.vbpp = vbpp;
+	area.nextline = nextline;
+	area.hscrolloffset = hscrolloffset;
+	area.leftBorder = leftBorder;
+	area.rightBorder = rightBorder;
+	area.coefx = area.coefy = 1;
+	ConvGen_ConvertArea(&area, vh, NULL);
+	hvram_line += vh * pitch;
+
+	/* Render the lower border */
+	for (h = 0; h < lowBorder; h++)
+	{
+		if (screen_copy.fullupdate)
+			ConvGen_memset_uint32(hvram_line, palette.native[0], scrwidth);
+		hvram_line += pitch;
+	}
+}
+
+static void ConvGen_HiColorBandNoZoom(const struct conv_area_s *a,
+                                      struct conv_band_s *band)
+{
+	uint16_t *fvram_line = a->fvram + band->first * a->nextline;
+	uint32_t *hvram_line = a->hvram + band->first * a->pitch;
+	uint32_t nLineEndAddr = band->nLineEndAddr;
+	int h, w;
+
+	for (h = band->first; h < band->last; h++)
 	{
+		uint16_t *fvram_column = fvram_line;
 		uint32_t *hvram_column = hvram_line;
 
 		if (nLineEndAddr > STRamEnd)
 		{
-			ConvGen_memset_uint32(hvram_line, palette.native[0], pitch);
-			hvram_line += pitch;
+			if (screen_copy.fullupdate)
+				ConvGen_memset_uint32(hvram_line, palette.native[0], a->pitch);
+			hvram_line += a->pitch;
 			continue;
 		}
 
-		nSampleHoldIdx = 0;
-
-		/* Left border first */
-		ConvGen_memset_uint32(hvram_column, palette.native[0], leftBorder);
-		hvram_column += leftBorder;
+		/* Skip the lines which didn't change */
+		if (ConvGen_LineChanged(h, fvram_line, a->vw * 2))
+		{
+			/* Left border first */
+			ConvGen_memset_uint32(hvram_column, palette.native[0], a->leftBorder);
+			hvram_column += a->leftBorder;
 
-		hvram_column = ConvGen_BitplaneLineTo32bpp(fvram_line, hvram_column,
-		                                              vw, vbpp, hscrolloffset);
+			/* Graphical area */
+			if (bSimdHiColor)
+			{
+				ConvSimd_HiColorLine(fvram_column, hvram_column, a->vw, &SimdRGBFormat);
+				hvram_column += a->vw;
+			}
+			else
+			{
+				for (w = 0; w < a->vw; w++)
+				{
+					uint16_t srcword = be_swap16(*fvram_column++);
+					uint8_t r = ((srcword >> 8) & 0xf8) | (srcword >> 13);
+					uint8_t g = ((srcword >> 3) & 0xfc) | ((srcword >> 9) & 0x3);
+					uint8_t b = (srcword << 3) | ((srcword >> 2) & 0x07);
+					*hvram_column ++ = Screen_MapRGB(r, g, b);
+				}
+			}
 
-		/* Right border */
-		ConvGen_memset_uint32(hvram_column, palette.native[0], rightBorder);
+			/* Right border */
+			ConvGen_memset_uint32(hvram_column, palette.native[0], a->rightBorder);
 
-		nLineEndAddr += nextline * 2;
-		fvram_line += nextline;
-		hvram_line += pitch;
-	}
+			ConvGen_SetDirty(band, hvram_line, 1);
+		}
 
-	/* Render the lower border */
-	for (h = 0; h < lowBorder; h++)
-	{
-		ConvGen_memset_uint32(hvram_line, palette.native[0], scrwidth);
-		hvram_line += pitch;
+		nLineEndAddr += a->nextline * 2;
+		fvram_line += a->nextline;
+		hvram_line += a->pitch;
 	}
 }
 
@@ -306,56 +697,39 @@ static void ConvGen_HiColorTo32bppNoZoom(uint16_t *fvram_line,
                                          int leftBorder, int rightBorder,
                                          int upperBorder, int lowBorder)
 {
+	struct conv_area_s area;
 	uint32_t *hvram_line = hvram;
-	uint32_t nLineEndAddr = nScreenBaseAddr + nextline * 2;
-	int h, w;
+	int h;
 
 	/* Render the upper border */
 	for (h = 0; h < upperBorder; h++)
 	{
-		ConvGen_memset_uint32(hvram_line, palette.native[0], scrwidth);
+		if (screen_copy.fullupdate)
+			ConvGen_memset_uint32(hvram_line, palette.native[0], scrwidth);
 		hvram_line += pitch;
 	}
 
 	/* Render the graphical area */
-	for (h = 0; h < vh; h++)
-	{
-		uint16_t *fvram_column = fvram_line;
-		uint32_t *hvram_column = hvram_line;
-
-		if (nLineEndAddr > STRamEnd)
-		{
-			ConvGen_memset_uint32(hvram_line, palette.native[0], pitch);
-			hvram_line += pitch;
-			continue;
-		}
-
-		/* Left border first */
-		ConvGen_memset_uint32(hvram_column, palette.native[0], leftBorder);
-		hvram_column += leftBorder;
-
-		/* Graphical area */
-		for (w = 0; w < vw; w++)
-		{
-			uint16_t srcword = be_swap16(*fvram_column++);
-			uint8_t r = ((srcword >> 8) & 0xf8) | (srcword >> 13);
-			uint8_t g = ((srcword >> 3) & 0xfc) | ((srcword >> 9) & 0x3);
-			uint8_t b = (srcword << 3) | ((srcword >> 2) & 0x07);
-			*hvram_column ++ = Screen_MapRGB(r, g, b);
-		}
-
-		/* Right border */
-		ConvGen_memset_uint32(hvram_column, palette.native[0], rightBorder);
-
-		nLineEndAddr += nextline * 2;
-		fvram_line += nextline;
-		hvram_line += pitch;
-	}
+	area.convert = ConvGen_HiColorBandNoZoom;
+	area.fvram = fvram_line;
+	area.hvram = hvram_line;
+	area.pitch = pitch;
+	area.scrwidth = scrwidth;
+	area.vw = vw;
+	area.vbpp = vbpp;
+	area.nextline = nextline;
+	area.hscrolloffset = 0;
+	area.leftBorder = leftBorder;
+	area.rightBorder = rightBorder;
+	area.coefx = area.coefy = 1;
+	ConvGen_ConvertArea(&area, vh, NULL);
+	hvram_line += vh * pitch;
 
 	/* Render the bottom border */
 	for (h = 0; h < lowBorder; h++)
 	{
-		ConvGen_memset_uint32(hvram_line, palette.native[0], scrwidth);
+		if (screen_copy.fullupdate)
+			ConvGen_memset_uint32(hvram_line, palette.native[0], scrwidth);
 		hvram_line += pitch;
 	}
 }
@@ -445,161 +819,327 @@ static void ConvGen_ConvertWithoutZoom(uint16_t *fvram, int vw, int vh, int vbpp
 }
 
 
-static void ConvGen_BitplaneTo32bppZoomed(uint16_t *fvram,
-                                          uint32_t *hvram, int pitch,
-                                          int scrwidth, int scrheight,
-                                          int vw, int vh, int vbpp,
-                                          int nextline, int hscrolloffset,
-                                          int leftBorder, int rightBorder,
-                                          int upperBorder, int lowerBorder,
-                                          int coefx, int coefy)
+/**
+ * Copy the first line of a group of zoomed lines to its 'repeat'th
+ * line. With scanlines, the lower half of the group (the 2nd line of
+ * 2, the 3rd of 3, the 3rd and 4th of 4...) gets half intensity.
+ */
+static void ConvGen_RepeatLine(struct conv_band_s *band, uint32_t *hvram_line,
+                               int pitch, int scrwidth, int repeat, int coefy)
+{
+	uint32_t *src = hvram_line - repeat * pitch;
+	uint32_t rmask, gmask, bmask, mask;
+	int w;
+
+	if (!ConfigureParams.Screen.bScanlines || coefy < 2
+	    || repeat < (coefy + 1) / 2)
+	{
+		memcpy(hvram_line, src, scrwidth * sizeof(uint32_t));
+	}
+	else
+	{
+		Screen_GetPixelFormat(&rmask, &gmask, &bmask, NULL, NULL, NULL);
+		mask = ((rmask >> 1) & rmask)
+		     | ((gmask >> 1) & gmask)
+		     | ((bmask >> 1) & bmask);
+		if (ConvSimd_HalveLine)
+			ConvSimd_HalveLine(src, hvram_line, scrwidth, mask);
+		else
+		{
+			for (w = 0; w < scrwidth; w++)
+				hvram_line[w] = (src[w] >> 1) & mask;
+		}
+	}
+	ConvGen_SetDirty(band, hvram_line, 1);
+}
+
+static void ConvGen_BitplaneBandZoomed(const struct conv_area_s *a,
+                                       struct conv_band_s *band)
 {
 	/* One complete 16-pixel aligned planar 2 chunky line */
-	uint32_t *p2cline = malloc(sizeof(uint32_t) * ((vw+15) & ~15));
-	uint32_t *hvram_line = hvram;
+	uint32_t *p2cline = malloc(sizeof(uint32_t) * ((a->vw+15) & ~15));
+	uint32_t *hvram_line = a->hvram + band->first * a->pitch;
 	uint32_t *hvram_column = p2cline;
 	uint16_t *fvram_line;
-	uint32_t nLineEndAddr = nScreenBaseAddr + nextline * 2;
+	uint32_t nLineEndAddr = band->nLineEndAddr;
+	int linesize = (((a->vw + 15) >> 4) + (a->hscrolloffset != 0)) * a->vbpp * 2;
+	int coefx = a->coefx;
+	bool bLineChanged = true;
 	int cursrcline = -1;
-	int scrIdx = 0;
+	int repeat = 0;
 	int w, h;
 
-	/* Render the upper border */
-	for (h = 0; h < upperBorder * coefy; h++)
+	for (h = band->first; h < band->last; h++)
 	{
-		ConvGen_memset_uint32(hvram_line, palette.native[0], scrwidth);
-		hvram_line += pitch;
-	}
+		fvram_line = a->fvram + (screen_zoom.zoomytable[h] * a->nextline);
+		if (bTTSampleHold)
+			nSampleHoldIdx = 0;
 
-	/* Render the graphical area */
-	for (h = 0; h < scrheight; h++)
-	{
-		fvram_line = fvram + (screen_zoom.zoomytable[scrIdx] * nextline);
-		scrIdx ++;
-		nSampleHoldIdx = 0;
+		/* Skip the lines which didn't change */
+		if (screen_zoom.zoomytable[h] != cursrcline)
+		{
+			if (nLineEndAddr > STRamEnd)
+				bLineChanged = screen_copy.fullupdate;
+			else
+				bLineChanged = ConvGen_LineChanged(screen_zoom.zoomytable[h],
+				                                   fvram_line, linesize);
+		}
 
+		if (!bLineChanged)
+		{
+			if (screen_zoom.zoomytable[h] != cursrcline && nLineEndAddr <= STRamEnd)
+				nLineEndAddr += a->nextline * 2;
+		}
 		/* Recopy the same line ? */
-		if (screen_zoom.zoomytable[h] == cursrcline)
+		else if (screen_zoom.zoomytable[h] == cursrcline)
 		{
-			memcpy(hvram_line, hvram_line - pitch, scrwidth * sizeof(uint32_t));
+			ConvGen_RepeatLine(band, hvram_line, a->pitch, a->scrwidth, ++repeat, a->coefy);
 		}
 		else if (nLineEndAddr > STRamEnd)
 		{
-			ConvGen_memset_uint32(hvram_line, palette.native[0], pitch);
+			ConvGen_memset_uint32(hvram_line, palette.native[0], a->pitch);
 		}
 		else
 		{
-			ConvGen_BitplaneLineTo32bpp(fvram_line, p2cline,
-			                            vw, vbpp, hscrolloffset);
+			ConvGen_BitplaneLineTo32bpp(band, fvram_line, p2cline,
+			                            a->vw, a->vbpp, a->hscrolloffset);
 
 			hvram_column = hvram_line;
 			/* Display the Left border */
-			ConvGen_memset_uint32(hvram_column, palette.native[0], leftBorder * coefx);
-			hvram_column += leftBorder * coefx;
+			ConvGen_memset_uint32(hvram_column, palette.native[0], a->leftBorder * coefx);
+			hvram_column += a->leftBorder * coefx;
 
 			/* Display the Graphical area */
-			for (w = 0; w < vw * coefx; w++)
+			if (ConvSimd_ScaleLine && coefx > 1)
 			{
-				hvram_column[w] = p2cline[screen_zoom.zoomxtable[w]];
+				ConvSimd_ScaleLine(p2cline, hvram_column, a->vw, coefx);
 			}
-			hvram_column += vw * coefx;
+			else if (ConvSimd_ZoomLine)
+			{
+				ConvSimd_ZoomLine(p2cline, hvram_column, a->vw * coefx, screen_zoom.zoomxtable);
+			}
+			else
+			{
+				for (w = 0; w < a->vw * coefx; w++)
+				{
+					hvram_column[w] = p2cline[screen_zoom.zoomxtable[w]];
+				}
+			}
+			hvram_column += a->vw * coefx;
 
 			/* Display the Right border */
-			ConvGen_memset_uint32(hvram_column, palette.native[0], rightBorder * coefx);
+			ConvGen_memset_uint32(hvram_column, palette.native[0], a->rightBorder * coefx);
 
-			nLineEndAddr += nextline * 2;
+			ConvGen_SetDirty(band, hvram_line, 1);
+			nLineEndAddr += a->nextline * 2;
 		}
 
-		hvram_line += pitch;
+		if (screen_zoom.zoomytable[h] != cursrcline)
+			repeat = 0;
+		hvram_line += a->pitch;
 		cursrcline = screen_zoom.zoomytable[h];
 	}
 
+	free(p2cline);
+}
+
+static void ConvGen_BitplaneTo32bppZoomed(uint16_t *fvram,
+                                          uint32_t *hvram, int pitch,
+                                          int scrwidth, int scrheight,
+                                          int vw, int vh, int vbpp,
+                                          int nextline, int hscrolloffset,
+                                          int leftBorder, int rightBorder,
+                                          int upperBorder, int lowerBorder,
+                                          int coefx, int coefy)
+{
+	struct conv_area_s area;
+	uint32_t *hvram_line = hvram;
+	int h;
+
+	/* Render the upper border */
+	for (h = 0; h < upperBorder * coefy; h++)
+	{
+		if (screen_copy.fullupdate)
+			ConvGen_memset_uint32(hvram_line, palette.native[0], scrwidth);
+		hvram_line += pitch;
+	}
+
+	/* Render the graphical area */
+	area.convert = ConvGen_BitplaneBandZoomed;
+	area.fvram = fvram;
+	area.hvram = hvram_line;
+	area.pitch = pitch;
+	area.scrwidth = scrwidth;
+	area.vw = vw;
+	area.vbpp = vbpp;
+	area.nextline = nextline;
+	area.hscrolloffset = hscrolloffset;
+	area.leftBorder = leftBorder;
+	area.rightBorder = rightBorder;
+	area.coefx = coefx;
+	area.coefy = coefy;
+	ConvGen_ConvertArea(&area, scrheight, screen_zoom.zoomytable);
+	hvram_line += scrheight * pitch;
+
 	/* Render the lower border */
 	for (h = 0; h < lowerBorder * coefy; h++)
 	{
-		ConvGen_memset_uint32(hvram_line, palette.native[0], scrwidth);
+		if (screen_copy.fullupdate)
+			ConvGen_memset_uint32(hvram_line, palette.native[0], scrwidth);
 		hvram_line += pitch;
 	}
-
-	free(p2cline);
 }
 
-static void ConvGen_HiColorTo32bppZoomed(uint16_t *fvram,
-                                         uint32_t *hvram, int pitch,
-                                         int scrwidth, int scrheight,
-                                         int vw, int vh, int vbpp,
-                                         int nextline,
-                                         int leftBorder, int rightBorder,
-                                         int upperBorder, int lowerBorder,
-                                         int coefx, int coefy)
+static void ConvGen_HiColorBandZoomed(const struct conv_area_s *a,
+                                      struct conv_band_s *band)
 {
-	uint32_t *hvram_line = hvram;
+	uint32_t *hvram_line = a->hvram + band->first * a->pitch;
 	uint32_t *hvram_column = hvram_line;
 	uint16_t *fvram_line;
-	uint32_t nLineEndAddr = nScreenBaseAddr + nextline * 2;
+	uint32_t nLineEndAddr = band->nLineEndAddr;
+	uint32_t *hicolorline = NULL;
+	int hicolorcount = 0;
+	int coefx = a->coefx;
+	bool bLineChanged = true;
 	int cursrcline = -1;
-	int scrIdx = 0;
+	int repeat = 0;
 	int w, h;
 
-	/* Render the upper border */
-	for (h = 0; h < upperBorder * coefy; h++)
-	{
-		ConvGen_memset_uint32(hvram_line, palette.native[0], scrwidth);
-		hvram_line += pitch;
-	}
+	/* Pixels of a line used by the zoom */
+	if (a->vw > 0)
+		hicolorcount = screen_zoom.zoomxtable[a->vw * coefx - 1] + 1;
 
-	/* Render the graphical area */
-	for (h = 0; h < scrheight; h++)
+	/* One complete converted line, to be zoomed */
+	if (bSimdHiColor && a->vw > 0)
+		hicolorline = malloc(sizeof(uint32_t) * hicolorcount);
+
+	for (h = band->first; h < band->last; h++)
 	{
 		uint16_t *fvram_column;
 
-		fvram_line = fvram + (screen_zoom.zoomytable[scrIdx] * nextline);
-		scrIdx ++;
+		fvram_line = a->fvram + (screen_zoom.zoomytable[h] * a->nextline);
 		fvram_column = fvram_line;
 
+		/* Skip the lines which didn't change */
+		if (screen_zoom.zoomytable[h] != cursrcline)
+		{
+			if (nLineEndAddr > STRamEnd)
+				bLineChanged = screen_copy.fullupdate;
+			else
+				bLineChanged = ConvGen_LineChanged(screen_zoom.zoomytable[h],
+				                                   fvram_line, hicolorcount * 2);
+		}
+
+		if (!bLineChanged)
+		{
+			if (screen_zoom.zoomytable[h] != cursrcline && nLineEndAddr <= STRamEnd)
+				nLineEndAddr += a->nextline * 2;
+		}
 		/* Recopy the same line ? */
-		if (screen_zoom.zoomytable[h] == cursrcline)
+		else if (screen_zoom.zoomytable[h] == cursrcline)
 		{
-			memcpy(hvram_line, hvram_line - pitch, scrwidth * sizeof(uint32_t));
+			ConvGen_RepeatLine(band, hvram_line, a->pitch, a->scrwidth, ++repeat, a->coefy);
 		}
 		else if (nLineEndAddr > STRamEnd)
 		{
-			ConvGen_memset_uint32(hvram_line, palette.native[0], pitch);
+			ConvGen_memset_uint32(hvram_line, palette.native[0], a->pitch);
 		}
 		else
 		{
 			hvram_column = hvram_line;
 
 			/* Display the Left border */
-			ConvGen_memset_uint32(hvram_column, palette.native[0], leftBorder * coefx);
-			hvram_column += leftBorder * coefx;
+			ConvGen_memset_uint32(hvram_column, palette.native[0], a->leftBorder * coefx);
+			hvram_column += a->leftBorder * coefx;
 
 			/* Display the Graphical area */
-			for (w = 0; w < vw * coefx; w++)
+			if (hicolorline)
+			{
+				ConvSimd_HiColorLine(fvram_column, hicolorline, hicolorcount, &SimdRGBFormat);
+				if (ConvSimd_ScaleLine && coefx > 1)
+					ConvSimd_ScaleLine(hicolorline, hvram_column, a->vw, coefx);
+				else if (ConvSimd_ZoomLine)
+					ConvSimd_ZoomLine(hicolorline, hvram_column, a->vw * coefx, screen_zoom.zoomxtable);
+				else
+				{
+					for (w = 0; w < a->vw * coefx; w++)
+						hvram_column[w] = hicolorline[screen_zoom.zoomxtable[w]];
+				}
+				hvram_column += a->vw * coefx;
+			}
+			else
 			{
-				uint16_t srcword;
-				uint8_t r, g, b;
-				srcword = be_swap16(fvram_column[screen_zoom.zoomxtable[w]]);
-				r = ((srcword >> 8) & 0xf8) | (srcword >> 13);
-				g = ((srcword >> 3) & 0xfc) | ((srcword >> 9) & 0x3);
-				b = (srcword << 3) | ((srcword >> 2) & 0x07);
-				*hvram_column ++ = Screen_MapRGB(r, g, b);
+				for (w = 0; w < a->vw * coefx; w++)
+				{
+					uint16_t srcword;
+					uint8_t r, g, b;
+					srcword = be_swap16(fvram_column[screen_zoom.zoomxtable[w]]);
+					r = ((srcword >> 8) & 0xf8) | (srcword >> 13);
+					g = ((srcword >> 3) & 0xfc) | ((srcword >> 9) & 0x3);
+					b = (srcword << 3) | ((srcword >> 2) & 0x07);
+					*hvram_column ++ = Screen_MapRGB(r, g, b);
+				}
 			}
 
 			/* Display the Right border */
-			ConvGen_memset_uint32(hvram_column, palette.native[0], rightBorder * coefx);
+			ConvGen_memset_uint32(hvram_column, palette.native[0], a->rightBorder * coefx);
 
-			nLineEndAddr += nextline * 2;
+			ConvGen_SetDirty(band, hvram_line, 1);
+			nLineEndAddr += a->nextline * 2;
 		}
 
-		hvram_line += pitch;
+		if (screen_zoom.zoomytable[h] != cursrcline)
+			repeat = 0;
+		hvram_line += a->pitch;
 		cursrcline = screen_zoom.zoomytable[h];
 	}
 
+	free(hicolorline);
+}
+
+static void ConvGen_HiColorTo32bppZoomed(uint16_t *fvram,
+                                         uint32_t *hvram, int pitch,
+                                         int scrwidth, int scrheight,
+                                         int vw, int vh, int vbpp,
+                                         int nextline,
+                                         int leftBorder, int rightBorder,
+                                         int upperBorder, int lowerBorder,
+                                         int coefx, int coefy)
+{
+	struct conv_area_s area;
+	uint32_t *hvram_line = hvram;
+	int h;
+
+	/* Render the upper border */
+	for (h = 0; h < upperBorder * coefy; h++)
+	{
+		if (screen_copy.fullupdate)
+			ConvGen_memset_uint32(hvram_line, palette.native[0], scrwidth);
+		hvram_line += pitch;
+	}
+
+	/* Render the graphical area */
+	area.convert = ConvGen_HiColorBandZoomed;
+	area.fvram = fvram;
+	area.hvram = hvram_line;
+	area.pitch = pitch;
+	area.scrwidth = scrwidth;
+	area.vw = vw;
+	area.vbpp = vbpp;
+	area.nextline = nextline;
+	area.hscrolloffset = 0;
+	area.leftBorder = leftBorder;
+	area.rightBorder = rightBorder;
+	area.coefx = coefx;
+	area.coefy = coefy;
+	ConvGen_ConvertArea(&area, scrheight, screen_zoom.zoomytable);
+	hvram_line += scrheight * pitch;
+
 	/* Render the lower border */
 	for (h = 0; h < lowerBorder * coefy; h++)
 	{
-		ConvGen_memset_uint32(hvram_line, palette.native[0], scrwidth);
+		if (screen_copy.fullupdate)
+			ConvGen_memset_uint32(hvram_line, palette.native[0], scrwidth);
 		hvram_line += pitch;
 	}
 }
@@ -698,11 +1238,20 @@ static void ConvGen_ConvertWithZoom(uint16_t *fvram, int vw, int vh, int vbpp, i
 	}
 }
 
-void ConvGen_Convert(uint32_t vaddr, void *fvram, int vw, int vh,
+/**
+ * Convert the emulated screen to the host screen. Only the lines which
+ * changed since the previous call are converted, unless the parameters,
+ * the palette or the host screen changed.
+ * Return true if some lines were converted.
+ */
+bool ConvGen_Convert(uint32_t vaddr, void *fvram, int vw, int vh,
                      int vbpp, int nextline, int hscroll,
                      int leftBorderSize, int rightBorderSize,
                      int upperBorderSize, int lowerBorderSize)
 {
+	struct screen_params_s params;
+	int linesize;
+
 	nScreenBaseAddr = vaddr;
 	ConvertW = vw;
 	ConvertH = vh;
@@ -715,6 +1264,36 @@ void ConvGen_Convert(uint32_t vaddr, void *fvram, int vw, int vh,
 	if (ConvertPaletteSize > 256)
 		ConvertPaletteSize = 256;
 
+	if (vbpp == 16)
+		ConvGen_SetSimdFormat();
+
+	/* Same conversion as for the previous frame ? */
+	memset(&params, 0, sizeof(params));
+	params.vaddr = vaddr;
+	params.vw = vw;
+	params.vh = vh;
+	params.vbpp = vbpp;
+	params.nextline = nextline;
+	params.hscroll = hscroll;
+	params.leftBorder = leftBorderSize;
+	params.rightBorder = rightBorderSize;
+	params.upperBorder = upperBorderSize;
+	params.lowerBorder = lowerBorderSize;
+	params.zoomx = nScreenZoomX;
+	params.zoomy = nScreenZoomY;
+	params.ttspecial = TTSpecialVideoMode;
+	Screen_GetDimension(&params.hvram, &params.width, &params.height, &params.pitch);
+	params.genconv_width = Screen_GetGenConvWidth();
+	params.genconv_height = Screen_GetGenConvHeight();
+
+	if (vbpp < 16)
+		linesize = (((vw + 15) >> 4) + 1) * vbpp * 2;
+	else
+		linesize = (leftBorderSize + vw + rightBorderSize) * 2;
+	ConvGen_CheckFullUpdate(&params, upperBorderSize + vh + lowerBorderSize, linesize);
+
+	screen_copy.changed = screen_copy.fullupdate;
+
 	if (nScreenZoomX * nScreenZoomY != 1) {
 		ConvGen_ConvertWithZoom(fvram, vw, vh, vbpp, nextline, hscroll,
 		                        leftBorderSize, rightBorderSize,
@@ -724,6 +1303,14 @@ void ConvGen_Convert(uint32_t vaddr, void *fvram, int vw, int vh,
 		                           leftBorderSize, rightBorderSize,
 		                           upperBorderSize, lowerBorderSize);
 	}
+
+	if (screen_copy.fullupdate)
+	{
+		screen_copy.dirty_top = 0;
+		screen_copy.dirty_bottom = INT_MAX;
+		screen_copy.fullupdate = false;
+	}
+	return screen_copy.changed;
 }
 
 bool ConvGen_Draw(uint32_t vaddr, int vw, int vh, int vbpp, int nextline,
@@ -788,6 +1375,9 @@ void ConvGen_SetSize(int width, int height, bool bForceChange)
 	int screenwidth, screenheight, maxw, maxh;
 	int scalex, scaley, sbarheight;
 
+	/* The host screen may be cleared or re-created */
+	ConvGen_SetFullUpdate();
+
 	if (width == -1)
 		width = genconv_width_req;
 	else
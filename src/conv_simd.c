@@ -0,0 +1,788 @@
+/*
+  Hatari - conv_simd.c
+
+  SIMD kernels for the screen conversion : ST low / medium resolution
+  (conv_st.c) and TT / Falcon bitplanes and 16 bit modes (conv_gen.c).
+
+  A block of 16 pixels (1, 2, 4 or 8 interleaved planes of 16 bits) is
+  converted to 16 palette indexes in one vector register : each byte of
+  the planes is replicated over 8 bytes, each byte testing one bit, and
+  the bits of all the planes are merged. With AVX2 and NEON, the indexes are
+  then mapped to 32 bit colors with byte shuffles : the 16 entries palette
+  is split into 4 tables of 16 bytes (one per byte of the color) which
+  are looked up in parallel and interleaved again. SSE2 has no byte
+  shuffle, so it's only used to get the indexes for the Spec512 routines
+  (which change the palette while plotting a line).
+
+  The 256 colors palette of the TT / Falcon modes is too big for byte
+  shuffles : it's read with gather instructions with AVX2, else one
+  color at a time. Falcon 16 bit pixels are expanded to 8 bits per
+  component and shifted to their place in the host pixel format.
+
+  Zoomed modes convert each line at native resolution first and scale
+  it afterwards in a separate pass : 2x, 3x and 4x integer zoom duplicate
+  the pixels with shuffles / interleaving stores, and TV mode / scanlines
+  halve the intensity of the copied lines.
+
+  The kernels are selected at run time depending on the host cpu ; when
+  none is available, the scalar routines in src/convert/ and conv_gen.c
+  are used.
+  The result is the same pixel for pixel (see tests/unit/test-conv_simd.c).
+
+  This file is distributed under the GNU General Public License, version 2
+  or at your option any later version. Read the file gpl.txt for details.
+*/
+const char ConvSimd_fileid[] = "Hatari conv_simd.c";
+
+#include <string.h>
+
+#include "main.h"
+#include "conv_simd.h"
+#include "endianswap.h"
+#include "simd.h"
+
+/* The byte shuffles of the NEON kernels expect little endian pixels */
+#if defined(SIMD_HOST_NEON) \
+	&& defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+# define CONVSIMD_NEON 1
+# define CONVSIMD_LEVELS	( SIMD_LEVEL(SIMD_SSE2) | SIMD_LEVEL(SIMD_AVX2) | SIMD_LEVEL(SIMD_NEON) )
+#else
+# define CONVSIMD_LEVELS	( SIMD_LEVEL(SIMD_SSE2) | SIMD_LEVEL(SIMD_AVX2) )
+#endif
+
+
+bool (*ConvSimd_LowLine)(const uint32_t *st, const uint32_t *copy, uint32_t *dst,
+                         int blocks, bool update, const uint32_t *palette, bool doubled);
+bool (*ConvSimd_MedLine)(const uint32_t *st, const uint32_t *copy, uint32_t *dst,
+                         int blocks, bool update, const uint32_t *palette);
+void (*ConvSimd_LowPixels)(const uint32_t *st, uint8_t *pixels, int blocks);
+void (*ConvSimd_MedPixels)(const uint32_t *st, uint8_t *pixels, int blocks);
+void (*ConvSimd_BitplanePixels)(const uint16_t *planes, int bpp, uint8_t *pixels, int blocks);
+void (*ConvSimd_PaletteLine)(const uint8_t *pixels, uint32_t *dst, int count,
+                             const uint32_t *palette);
+void (*ConvSimd_HiColorLine)(const uint16_t *src, uint32_t *dst, int count,
+                             const CONVSIMD_RGB *format);
+void (*ConvSimd_ZoomLine)(const uint32_t *src, uint32_t *dst, int count, const int *xtable);
+void (*ConvSimd_ScaleLine)(const uint32_t *src, uint32_t *dst, int count, int factor);
+void (*ConvSimd_HalveLine)(const uint32_t *src, uint32_t *dst, int count, uint32_t mask);
+
+
+/*-----------------------------------------------------------------------*/
+/* Generic code, for the cpus without gather instructions and for the
+ * remaining pixels of the lines */
+
+static void Generic_ScaleLine(const uint32_t *src, uint32_t *dst, int count, int factor)
+{
+	int k;
+
+	while (count-- > 0)
+	{
+		for (k = 0; k < factor; k++)
+			*dst++ = *src;
+		src++;
+	}
+}
+
+static void Generic_HalveLine(const uint32_t *src, uint32_t *dst, int count, uint32_t mask)
+{
+	while (count-- > 0)
+		*dst++ = (*src++ >> 1) & mask;
+}
+
+static void Generic_PaletteLine(const uint8_t *pixels, uint32_t *dst, int count,
+                                const uint32_t *palette)
+{
+	while (count-- > 0)
+		*dst++ = palette[*pixels++];
+}
+
+/* Remaining pixels of a Falcon 16 bit line, same as in conv_gen.c */
+static void Generic_HiColorLine(const uint16_t *src, uint32_t *dst, int count,
+                                const CONVSIMD_RGB *format)
+{
+	uint16_t srcword;
+	uint32_t r, g, b;
+
+	while (count-- > 0)
+	{
+		srcword = be_swap16(*src++);
+		r = ((srcword >> 8) & 0xf8) | (srcword >> 13);
+		g = ((srcword >> 3) & 0xfc) | ((srcword >> 9) & 0x3);
+		b = ((srcword << 3) & 0xf8) | ((srcword >> 2) & 0x07);
+		*dst++ = format->base | (r << format->rshift) | (g << format->gshift) | (b << format->bshift);
+	}
+}
+
+
+#ifdef SIMD_HOST_X86
+
+/*-----------------------------------------------------------------------*/
+/* x86 SSE2 / AVX2 */
+
+/* Bit of each pixel in the bytes of a plane (pixel 0 is the msb) */
+#define X86_PIXEL_BITS \
+	_mm_set_epi8(1, 2, 4, 8, 16, 32, 64, -128, 1, 2, 4, 8, 16, 32, 64, -128)
+
+/* Plane 'k' of the palette indexes, 'v' being a plane repeated 8 times per byte */
+#define X86_PLANE_BITS(v, k) \
+	_mm_and_si128(_mm_cmpeq_epi8(_mm_and_si128(v, bits), bits), _mm_set1_epi8((char)(1 << (k))))
+
+/* 8 bytes of low res planes -> 16 indexes, in pixel order */
+#define X86_LOW_INDEXES(p, idx) \
+{ \
+	const __m128i bits = X86_PIXEL_BITS; \
+	__m128i v = _mm_loadl_epi64((const __m128i *)(p)); \
+	__m128i p01, p23; \
+	v = _mm_unpacklo_epi8(v, v); \
+	p01 = _mm_unpacklo_epi16(v, v); \
+	p23 = _mm_unpackhi_epi16(v, v); \
+	idx = _mm_or_si128( \
+		_mm_or_si128(X86_PLANE_BITS(_mm_unpacklo_epi32(p01, p01), 0), \
+		             X86_PLANE_BITS(_mm_unpackhi_epi32(p01, p01), 1)), \
+		_mm_or_si128(X86_PLANE_BITS(_mm_unpacklo_epi32(p23, p23), 2), \
+		             X86_PLANE_BITS(_mm_unpackhi_epi32(p23, p23), 3))); \
+}
+
+/* 4 bytes of medium res planes -> 16 indexes, in pixel order */
+#define X86_MED_INDEXES(p, idx) \
+{ \
+	const __m128i bits = X86_PIXEL_BITS; \
+	uint32_t planes32; \
+	__m128i v, p01; \
+	memcpy(&planes32, p, sizeof(planes32)); \
+	v = _mm_cvtsi32_si128(planes32); \
+	v = _mm_unpacklo_epi8(v, v); \
+	p01 = _mm_unpacklo_epi16(v, v); \
+	idx = _mm_or_si128(X86_PLANE_BITS(_mm_unpacklo_epi32(p01, p01), 0), \
+	                   X86_PLANE_BITS(_mm_unpackhi_epi32(p01, p01), 1)); \
+}
+
+
+static TARGET_SSE2 void Sse2_LowPixels(const uint32_t *st, uint8_t *pixels, int blocks)
+{
+	__m128i idx;
+
+	for ( ; blocks > 0; blocks--, st += 2, pixels += 16)
+	{
+		X86_LOW_INDEXES(st, idx);
+		_mm_storeu_si128((__m128i *)pixels, idx);
+	}
+}
+
+static TARGET_SSE2 void Sse2_MedPixels(const uint32_t *st, uint8_t *pixels, int blocks)
+{
+	__m128i idx;
+
+	for ( ; blocks > 0; blocks--, st++, pixels += 16)
+	{
+		X86_MED_INDEXES(st, idx);
+		_mm_storeu_si128((__m128i *)pixels, idx);
+	}
+}
+
+
+/**
+ * Split the 16 colors of the palette in 4 tables of 16 bytes,
+ * table 'k' holding the byte 'k' (in memory order) of each color.
+ */
+static inline TARGET_AVX2 void Avx2_SplitPalette(const uint32_t *palette, __m128i *tables)
+{
+	const __m128i transpose = _mm_setr_epi8(0, 4, 8, 12, 1, 5, 9, 13, 2, 6, 10, 14, 3, 7, 11, 15);
+	__m128i c0, c1, c2, c3;
+	__m128i a, b, c, d;
+
+	c0 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)&palette[0]), transpose);
+	c1 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)&palette[4]), transpose);
+	c2 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)&palette[8]), transpose);
+	c3 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)&palette[12]), transpose);
+	a = _mm_unpacklo_epi32(c0, c1);
+	b = _mm_unpackhi_epi32(c0, c1);
+	c = _mm_unpacklo_epi32(c2, c3);
+	d = _mm_unpackhi_epi32(c2, c3);
+	tables[0] = _mm_unpacklo_epi64(a, c);
+	tables[1] = _mm_unpackhi_epi64(a, c);
+	tables[2] = _mm_unpacklo_epi64(b, d);
+	tables[3] = _mm_unpackhi_epi64(b, d);
+}
+
+/* Map 16 indexes to 16 colors */
+static inline TARGET_AVX2 void Avx2_Plot16(__m128i idx, uint32_t *dst, const __m128i *tables)
+{
+	__m128i b0 = _mm_shuffle_epi8(tables[0], idx);
+	__m128i b1 = _mm_shuffle_epi8(tables[1], idx);
+	__m128i b2 = _mm_shuffle_epi8(tables[2], idx);
+	__m128i b3 = _mm_shuffle_epi8(tables[3], idx);
+	__m128i lo01 = _mm_unpacklo_epi8(b0, b1);
+	__m128i hi01 = _mm_unpackhi_epi8(b0, b1);
+	__m128i lo23 = _mm_unpacklo_epi8(b2, b3);
+	__m128i hi23 = _mm_unpackhi_epi8(b2, b3);
+
+	_mm_storeu_si128((__m128i *)&dst[0], _mm_unpacklo_epi16(lo01, lo23));
+	_mm_storeu_si128((__m128i *)&dst[4], _mm_unpackhi_epi16(lo01, lo23));
+	_mm_storeu_si128((__m128i *)&dst[8], _mm_unpacklo_epi16(hi01, hi23));
+	_mm_storeu_si128((__m128i *)&dst[12], _mm_unpackhi_epi16(hi01, hi23));
+}
+
+/* Map 16 indexes to 32 colors, each pixel being doubled on X */
+static inline TARGET_AVX2 void Avx2_Plot32(__m128i idx, uint32_t *dst, const __m256i *tables)
+{
+	__m256i dbl = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_unpacklo_epi8(idx, idx)),
+	                                      _mm_unpackhi_epi8(idx, idx), 1);
+	__m256i b0 = _mm256_shuffle_epi8(tables[0], dbl);
+	__m256i b1 = _mm256_shuffle_epi8(tables[1], dbl);
+	__m256i b2 = _mm256_shuffle_epi8(tables[2], dbl);
+	__m256i b3 = _mm256_shuffle_epi8(tables[3], dbl);
+	__m256i lo01 = _mm256_unpacklo_epi8(b0, b1);
+	__m256i hi01 = _mm256_unpackhi_epi8(b0, b1);
+	__m256i lo23 = _mm256_unpacklo_epi8(b2, b3);
+	__m256i hi23 = _mm256_unpackhi_epi8(b2, b3);
+	/* Each 128 bit lane holds colors [0..3], [4..7], [8..11] or [12..15] of 16 colors */
+	__m256i c0 = _mm256_unpacklo_epi16(lo01, lo23);
+	__m256i c1 = _mm256_unpackhi_epi16(lo01, lo23);
+	__m256i c2 = _mm256_unpacklo_epi16(hi01, hi23);
+	__m256i c3 = _mm256_unpackhi_epi16(hi01, hi23);
+
+	_mm256_storeu_si256((__m256i *)&dst[0], _mm256_permute2x128_si256(c0, c1, 0x20));
+	_mm256_storeu_si256((__m256i *)&dst[8], _mm256_permute2x128_si256(c2, c3, 0x20));
+	_mm256_storeu_si256((__m256i *)&dst[16], _mm256_permute2x128_si256(c0, c1, 0x31));
+	_mm256_storeu_si256((__m256i *)&dst[24], _mm256_permute2x128_si256(c2, c3, 0x31));
+}
+
+static TARGET_AVX2 bool Avx2_LowLine(const uint32_t *st, const uint32_t *copy, uint32_t *dst,
+                                     int blocks, bool update, const uint32_t *palette, bool doubled)
+{
+	bool changed = false;
+	__m128i tables[4];
+	__m256i tables256[4];
+	__m128i idx;
+	int i;
+
+	Avx2_SplitPalette(palette, tables);
+	for (i = 0; i < 4; i++)
+		tables256[i] = _mm256_broadcastsi128_si256(tables[i]);
+
+	for ( ; blocks > 0; blocks--, st += 2, copy += 2, dst += doubled ? 32 : 16)
+	{
+		if (!update && st[0] == copy[0] && st[1] == copy[1])
+			continue;
+		changed = true;
+		X86_LOW_INDEXES(st, idx);
+		if (doubled)
+			Avx2_Plot32(idx, dst, tables256);
+		else
+			Avx2_Plot16(idx, dst, tables);
+	}
+	return changed;
+}
+
+static TARGET_AVX2 bool Avx2_MedLine(const uint32_t *st, const uint32_t *copy, uint32_t *dst,
+                                     int blocks, bool update, const uint32_t *palette)
+{
+	bool changed = false;
+	__m128i tables[4];
+	__m128i idx;
+
+	Avx2_SplitPalette(palette, tables);
+
+	for ( ; blocks > 0; blocks--, st++, copy++, dst += 16)
+	{
+		if (!update && *st == *copy)
+			continue;
+		changed = true;
+		X86_MED_INDEXES(st, idx);
+		Avx2_Plot16(idx, dst, tables);
+	}
+	return changed;
+}
+
+/* 2 bytes of a single plane -> 16 indexes, in pixel order */
+#define X86_MONO_INDEXES(p, idx) \
+{ \
+	const __m128i bits = X86_PIXEL_BITS; \
+	uint16_t plane16; \
+	__m128i v; \
+	memcpy(&plane16, p, sizeof(plane16)); \
+	v = _mm_cvtsi32_si128(plane16); \
+	v = _mm_unpacklo_epi8(v, v); \
+	v = _mm_unpacklo_epi16(v, v); \
+	idx = X86_PLANE_BITS(_mm_unpacklo_epi32(v, v), 0); \
+}
+
+/* 16 bytes of 8 planes -> 16 indexes, in pixel order */
+#define X86_8PLANES_INDEXES(p, idx) \
+{ \
+	const __m128i bits = X86_PIXEL_BITS; \
+	__m128i v = _mm_loadu_si128((const __m128i *)(p)); \
+	__m128i lo = _mm_unpacklo_epi8(v, v); \
+	__m128i hi = _mm_unpackhi_epi8(v, v); \
+	__m128i p01 = _mm_unpacklo_epi16(lo, lo); \
+	__m128i p23 = _mm_unpackhi_epi16(lo, lo); \
+	__m128i p45 = _mm_unpacklo_epi16(hi, hi); \
+	__m128i p67 = _mm_unpackhi_epi16(hi, hi); \
+	idx = _mm_or_si128( \
+		_mm_or_si128( \
+			_mm_or_si128(X86_PLANE_BITS(_mm_unpacklo_epi32(p01, p01), 0), \
+			             X86_PLANE_BITS(_mm_unpackhi_epi32(p01, p01), 1)), \
+			_mm_or_si128(X86_PLANE_BITS(_mm_unpacklo_epi32(p23, p23), 2), \
+			             X86_PLANE_BITS(_mm_unpackhi_epi32(p23, p23), 3))), \
+		_mm_or_si128( \
+			_mm_or_si128(X86_PLANE_BITS(_mm_unpacklo_epi32(p45, p45), 4), \
+			             X86_PLANE_BITS(_mm_unpackhi_epi32(p45, p45), 5)), \
+			_mm_or_si128(X86_PLANE_BITS(_mm_unpacklo_epi32(p67, p67), 6), \
+			             X86_PLANE_BITS(_mm_unpackhi_epi32(p67, p67), 7)))); \
+}
+
+static TARGET_SSE2 void Sse2_BitplanePixels(const uint16_t *planes, int bpp, uint8_t *pixels, int blocks)
+{
+	__m128i idx;
+
+	for ( ; blocks > 0; blocks--, planes += bpp, pixels += 16)
+	{
+		switch (bpp)
+		{
+		 case 1: X86_MONO_INDEXES(planes, idx); break;
+		 case 2: X86_MED_INDEXES(planes, idx); break;
+		 case 4: X86_LOW_INDEXES(planes, idx); break;
+		 default: X86_8PLANES_INDEXES(planes, idx); break;
+		}
+		_mm_storeu_si128((__m128i *)pixels, idx);
+	}
+}
+
+/* Components of Falcon 16 bit pixels, same as in conv_gen.c ('pfx' / 'sfx'
+ * are the intrinsics prefix / suffix of the vector size)
+ */
+#define X86_HICOLOR_RGB(w, r, g, b, pfx, sfx) \
+{ \
+	w = pfx##_or_##sfx(pfx##_slli_epi16(w, 8), pfx##_srli_epi16(w, 8)); \
+	r = pfx##_or_##sfx(pfx##_and_##sfx(pfx##_srli_epi16(w, 8), pfx##_set1_epi16(0xf8)), \
+	                   pfx##_srli_epi16(w, 13)); \
+	g = pfx##_or_##sfx(pfx##_and_##sfx(pfx##_srli_epi16(w, 3), pfx##_set1_epi16(0xfc)), \
+	                   pfx##_and_##sfx(pfx##_srli_epi16(w, 9), pfx##_set1_epi16(0x03))); \
+	b = pfx##_or_##sfx(pfx##_and_##sfx(pfx##_slli_epi16(w, 3), pfx##_set1_epi16(0xf8)), \
+	                   pfx##_and_##sfx(pfx##_srli_epi16(w, 2), pfx##_set1_epi16(0x07))); \
+}
+
+static TARGET_SSE2 void Sse2_HiColorLine(const uint16_t *src, uint32_t *dst, int count,
+                                         const CONVSIMD_RGB *format)
+{
+	const __m128i rshift = _mm_cvtsi32_si128(format->rshift);
+	const __m128i gshift = _mm_cvtsi32_si128(format->gshift);
+	const __m128i bshift = _mm_cvtsi32_si128(format->bshift);
+	const __m128i base = _mm_set1_epi32(format->base);
+	const __m128i zero = _mm_setzero_si128();
+	__m128i w, r, g, b;
+
+	for ( ; count >= 8; count -= 8, src += 8, dst += 8)
+	{
+		w = _mm_loadu_si128((const __m128i *)src);
+		X86_HICOLOR_RGB(w, r, g, b, _mm, si128);
+		_mm_storeu_si128((__m128i *)&dst[0], _mm_or_si128(_mm_or_si128(base,
+			_mm_sll_epi32(_mm_unpacklo_epi16(r, zero), rshift)),
+			_mm_or_si128(_mm_sll_epi32(_mm_unpacklo_epi16(g, zero), gshift),
+			             _mm_sll_epi32(_mm_unpacklo_epi16(b, zero), bshift))));
+		_mm_storeu_si128((__m128i *)&dst[4], _mm_or_si128(_mm_or_si128(base,
+			_mm_sll_epi32(_mm_unpackhi_epi16(r, zero), rshift)),
+			_mm_or_si128(_mm_sll_epi32(_mm_unpackhi_epi16(g, zero), gshift),
+			             _mm_sll_epi32(_mm_unpackhi_epi16(b, zero), bshift))));
+	}
+	Generic_HiColorLine(src, dst, count, format);
+}
+
+static TARGET_AVX2 void Avx2_HiColorLine(const uint16_t *src, uint32_t *dst, int count,
+                                         const CONVSIMD_RGB *format)
+{
+	const __m128i rshift = _mm_cvtsi32_si128(format->rshift);
+	const __m128i gshift = _mm_cvtsi32_si128(format->gshift);
+	const __m128i bshift = _mm_cvtsi32_si128(format->bshift);
+	const __m256i base = _mm256_set1_epi32(format->base);
+	__m256i w, r, g, b;
+
+	for ( ; count >= 16; count -= 16, src += 16, dst += 16)
+	{
+		w = _mm256_loadu_si256((const __m256i *)src);
+		X86_HICOLOR_RGB(w, r, g, b, _mm256, si256);
+		_mm256_storeu_si256((__m256i *)&dst[0], _mm256_or_si256(_mm256_or_si256(base,
+			_mm256_sll_epi32(_mm256_cvtepu16_epi32(_mm256_castsi256_si128(r)), rshift)),
+			_mm256_or_si256(_mm256_sll_epi32(_mm256_cvtepu16_epi32(_mm256_castsi256_si128(g)), gshift),
+			                _mm256_sll_epi32(_mm256_cvtepu16_epi32(_mm256_castsi256_si128(b)), bshift))));
+		_mm256_storeu_si256((__m256i *)&dst[8], _mm256_or_si256(_mm256_or_si256(base,
+			_mm256_sll_epi32(_mm256_cvtepu16_epi32(_mm256_extracti128_si256(r, 1)), rshift)),
+			_mm256_or_si256(_mm256_sll_epi32(_mm256_cvtepu16_epi32(_mm256_extracti128_si256(g, 1)), gshift),
+			                _mm256_sll_epi32(_mm256_cvtepu16_epi32(_mm256_extracti128_si256(b, 1)), bshift))));
+	}
+	Sse2_HiColorLine(src, dst, count, format);
+}
+
+static TARGET_AVX2 void Avx2_PaletteLine(const uint8_t *pixels, uint32_t *dst, int count,
+                                         const uint32_t *palette)
+{
+	__m256i idx;
+
+	for ( ; count >= 8; count -= 8, pixels += 8, dst += 8)
+	{
+		idx = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i *)pixels));
+		_mm256_storeu_si256((__m256i *)dst, _mm256_i32gather_epi32((const int *)palette, idx, 4));
+	}
+	Generic_PaletteLine(pixels, dst, count, palette);
+}
+
+static TARGET_AVX2 void Avx2_ZoomLine(const uint32_t *src, uint32_t *dst, int count, const int *xtable)
+{
+	__m256i idx;
+
+	for ( ; count >= 8; count -= 8, xtable += 8, dst += 8)
+	{
+		idx = _mm256_loadu_si256((const __m256i *)xtable);
+		_mm256_storeu_si256((__m256i *)dst, _mm256_i32gather_epi32((const int *)src, idx, 4));
+	}
+	while (count-- > 0)
+		*dst++ = src[*xtable++];
+}
+
+static TARGET_SSE2 void Sse2_ScaleLine(const uint32_t *src, uint32_t *dst, int count, int factor)
+{
+	__m128i v;
+
+	switch (factor)
+	{
+	 case 2:
+		for ( ; count >= 4; count -= 4, src += 4, dst += 8)
+		{
+			v = _mm_loadu_si128((const __m128i *)src);
+			_mm_storeu_si128((__m128i *)&dst[0], _mm_unpacklo_epi32(v, v));
+			_mm_storeu_si128((__m128i *)&dst[4], _mm_unpackhi_epi32(v, v));
+		}
+		break;
+	 case 3:
+		for ( ; count >= 4; count -= 4, src += 4, dst += 12)
+		{
+			v = _mm_loadu_si128((const __m128i *)src);
+			_mm_storeu_si128((__m128i *)&dst[0], _mm_shuffle_epi32(v, _MM_SHUFFLE(1, 0, 0, 0)));
+			_mm_storeu_si128((__m128i *)&dst[4], _mm_shuffle_epi32(v, _MM_SHUFFLE(2, 2, 1, 1)));
+			_mm_storeu_si128((__m128i *)&dst[8], _mm_shuffle_epi32(v, _MM_SHUFFLE(3, 3, 3, 2)));
+		}
+		break;
+	 case 4:
+		for ( ; count >= 4; count -= 4, src += 4, dst += 16)
+		{
+			v = _mm_loadu_si128((const __m128i *)src);
+			_mm_storeu_si128((__m128i *)&dst[0], _mm_shuffle_epi32(v, _MM_SHUFFLE(0, 0, 0, 0)));
+			_mm_storeu_si128((__m128i *)&dst[4], _mm_shuffle_epi32(v, _MM_SHUFFLE(1, 1, 1, 1)));
+			_mm_storeu_si128((__m128i *)&dst[8], _mm_shuffle_epi32(v, _MM_SHUFFLE(2, 2, 2, 2)));
+			_mm_storeu_si128((__m128i *)&dst[12], _mm_shuffle_epi32(v, _MM_SHUFFLE(3, 3, 3, 3)));
+		}
+		break;
+	}
+	Generic_ScaleLine(src, dst, count, factor);
+}
+
+static TARGET_SSE2 void Sse2_HalveLine(const uint32_t *src, uint32_t *dst, int count, uint32_t mask)
+{
+	const __m128i m = _mm_set1_epi32((int)mask);
+	__m128i v;
+
+	for ( ; count >= 4; count -= 4, src += 4, dst += 4)
+	{
+		v = _mm_loadu_si128((const __m128i *)src);
+		_mm_storeu_si128((__m128i *)dst, _mm_and_si128(_mm_srli_epi32(v, 1), m));
+	}
+	Generic_HalveLine(src, dst, count, mask);
+}
+
+#endif /* SIMD_HOST_X86 */
+
+
+#ifdef CONVSIMD_NEON
+
+/*-----------------------------------------------------------------------*/
+/* aarch64 NEON */
+
+static const uint8_t Neon_PixelBits[16] =
+{
+	0x80, 0x40, 0x20, 0x10, 0x08, 0x04, 0x02, 0x01,
+	0x80, 0x40, 0x20, 0x10, 0x08, 0x04, 0x02, 0x01
+};
+
+/* Select the 2 bytes of plane 'k', each one repeated 8 times */
+static const uint8_t Neon_PlaneBytes[8][16] =
+{
+	{  0,  0,  0,  0,  0,  0,  0,  0,  1,  1,  1,  1,  1,  1,  1,  1 },
+	{  2,  2,  2,  2,  2,  2,  2,  2,  3,  3,  3,  3,  3,  3,  3,  3 },
+	{  4,  4,  4,  4,  4,  4,  4,  4,  5,  5,  5,  5,  5,  5,  5,  5 },
+	{  6,  6,  6,  6,  6,  6,  6,  6,  7,  7,  7,  7,  7,  7,  7,  7 },
+	{  8,  8,  8,  8,  8,  8,  8,  8,  9,  9,  9,  9,  9,  9,  9,  9 },
+	{ 10, 10, 10, 10, 10, 10, 10, 10, 11, 11, 11, 11, 11, 11, 11, 11 },
+	{ 12, 12, 12, 12, 12, 12, 12, 12, 13, 13, 13, 13, 13, 13, 13, 13 },
+	{ 14, 14, 14, 14, 14, 14, 14, 14, 15, 15, 15, 15, 15, 15, 15, 15 }
+};
+
+static inline uint8x16_t Neon_PlaneBits(uint8x16_t planes, int k)
+{
+	uint8x16_t v = vqtbl1q_u8(planes, vld1q_u8(Neon_PlaneBytes[k]));
+
+	return vandq_u8(vtstq_u8(v, vld1q_u8(Neon_PixelBits)), vdupq_n_u8(1 << k));
+}
+
+/* 8 bytes of low res planes -> 16 indexes, in pixel order */
+static inline uint8x16_t Neon_LowIndexes(const uint32_t *st)
+{
+	uint8x8_t v = vld1_u8((const uint8_t *)st);
+	uint8x16_t planes = vcombine_u8(v, v);
+
+	return vorrq_u8(vorrq_u8(Neon_PlaneBits(planes, 0), Neon_PlaneBits(planes, 1)),
+	                vorrq_u8(Neon_PlaneBits(planes, 2), Neon_PlaneBits(planes, 3)));
+}
+
+/* 4 bytes of medium res planes -> 16 indexes, in pixel order */
+static inline uint8x16_t Neon_MedIndexes(const uint32_t *st)
+{
+	uint32_t bytes;
+	uint8x16_t planes;
+
+	memcpy(&bytes, st, sizeof(bytes));
+	planes = vreinterpretq_u8_u32(vdupq_n_u32(bytes));
+
+	return vorrq_u8(Neon_PlaneBits(planes, 0), Neon_PlaneBits(planes, 1));
+}
+
+/* Map 16 indexes to 16 colors, the 4 bytes tables being interleaved by vst4q */
+static inline void Neon_Plot16(uint8x16_t idx, uint32_t *dst, const uint8x16x4_t *tables)
+{
+	uint8x16x4_t colors;
+
+	colors.val[0] = vqtbl1q_u8(tables->val[0], idx);
+	colors.val[1] = vqtbl1q_u8(tables->val[1], idx);
+	colors.val[2] = vqtbl1q_u8(tables->val[2], idx);
+	colors.val[3] = vqtbl1q_u8(tables->val[3], idx);
+	vst4q_u8((uint8_t *)dst, colors);
+}
+
+static bool Neon_LowLine(const uint32_t *st, const uint32_t *copy, uint32_t *dst,
+                         int blocks, bool update, const uint32_t *palette, bool doubled)
+{
+	uint8x16x4_t tables = vld4q_u8((const uint8_t *)palette);
+	bool changed = false;
+	uint8x16_t idx;
+
+	for ( ; blocks > 0; blocks--, st += 2, copy += 2, dst += doubled ? 32 : 16)
+	{
+		if (!update && st[0] == copy[0] && st[1] == copy[1])
+			continue;
+		changed = true;
+		idx = Neon_LowIndexes(st);
+		if (doubled)
+		{
+			Neon_Plot16(vzip1q_u8(idx, idx), dst, &tables);
+			Neon_Plot16(vzip2q_u8(idx, idx), dst + 16, &tables);
+		}
+		else
+			Neon_Plot16(idx, dst, &tables);
+	}
+	return changed;
+}
+
+static bool Neon_MedLine(const uint32_t *st, const uint32_t *copy, uint32_t *dst,
+                         int blocks, bool update, const uint32_t *palette)
+{
+	uint8x16x4_t tables = vld4q_u8((const uint8_t *)palette);
+	bool changed = false;
+
+	for ( ; blocks > 0; blocks--, st++, copy++, dst += 16)
+	{
+		if (!update && *st == *copy)
+			continue;
+		changed = true;
+		Neon_Plot16(Neon_MedIndexes(st), dst, &tables);
+	}
+	return changed;
+}
+
+static void Neon_LowPixels(const uint32_t *st, uint8_t *pixels, int blocks)
+{
+	for ( ; blocks > 0; blocks--, st += 2, pixels += 16)
+		vst1q_u8(pixels, Neon_LowIndexes(st));
+}
+
+static void Neon_MedPixels(const uint32_t *st, uint8_t *pixels, int blocks)
+{
+	for ( ; blocks > 0; blocks--, st++, pixels += 16)
+		vst1q_u8(pixels, Neon_MedIndexes(st));
+}
+
+static void Neon_BitplanePixels(const uint16_t *planes, int bpp, uint8_t *pixels, int blocks)
+{
+	uint8x16_t v, idx;
+	uint32_t plane32;
+	uint16_t plane16;
+	int k;
+
+	for ( ; blocks > 0; blocks--, planes += bpp, pixels += 16)
+	{
+		switch (bpp)
+		{
+		 case 1:
+			memcpy(&plane16, planes, sizeof(plane16));
+			v = vreinterpretq_u8_u16(vdupq_n_u16(plane16));
+			break;
+		 case 2:
+			memcpy(&plane32, planes, sizeof(plane32));
+			v = vreinterpretq_u8_u32(vdupq_n_u32(plane32));
+			break;
+		 case 4:
+			v = vcombine_u8(vld1_u8((const uint8_t *)planes), vdup_n_u8(0));
+			break;
+		 default:
+			v = vld1q_u8((const uint8_t *)planes);
+			break;
+		}
+		idx = Neon_PlaneBits(v, 0);
+		for (k = 1; k < bpp; k++)
+			idx = vorrq_u8(idx, Neon_PlaneBits(v, k));
+		vst1q_u8(pixels, idx);
+	}
+}
+
+static void Neon_HiColorLine(const uint16_t *src, uint32_t *dst, int count,
+                             const CONVSIMD_RGB *format)
+{
+	const int32x4_t rshift = vdupq_n_s32(format->rshift);
+	const int32x4_t gshift = vdupq_n_s32(format->gshift);
+	const int32x4_t bshift = vdupq_n_s32(format->bshift);
+	const uint32x4_t base = vdupq_n_u32(format->base);
+	uint16x8_t w, r, g, b;
+
+	for ( ; count >= 8; count -= 8, src += 8, dst += 8)
+	{
+		w = vreinterpretq_u16_u8(vrev16q_u8(vld1q_u8((const uint8_t *)src)));
+		r = vorrq_u16(vandq_u16(vshrq_n_u16(w, 8), vdupq_n_u16(0xf8)), vshrq_n_u16(w, 13));
+		g = vorrq_u16(vandq_u16(vshrq_n_u16(w, 3), vdupq_n_u16(0xfc)),
+		              vandq_u16(vshrq_n_u16(w, 9), vdupq_n_u16(0x03)));
+		b = vorrq_u16(vandq_u16(vshlq_n_u16(w, 3), vdupq_n_u16(0xf8)),
+		              vandq_u16(vshrq_n_u16(w, 2), vdupq_n_u16(0x07)));
+		vst1q_u32(&dst[0], vorrq_u32(vorrq_u32(base,
+			vshlq_u32(vmovl_u16(vget_low_u16(r)), rshift)),
+			vorrq_u32(vshlq_u32(vmovl_u16(vget_low_u16(g)), gshift),
+			          vshlq_u32(vmovl_u16(vget_low_u16(b)), bshift))));
+		vst1q_u32(&dst[4], vorrq_u32(vorrq_u32(base,
+			vshlq_u32(vmovl_u16(vget_high_u16(r)), rshift)),
+			vorrq_u32(vshlq_u32(vmovl_u16(vget_high_u16(g)), gshift),
+			          vshlq_u32(vmovl_u16(vget_high_u16(b)), bshift))));
+	}
+	Generic_HiColorLine(src, dst, count, format);
+}
+
+/* The interleaving stores write each pixel 2, 3 or 4 times in a row */
+static void Neon_ScaleLine(const uint32_t *src, uint32_t *dst, int count, int factor)
+{
+	uint32x4_t v;
+
+	switch (factor)
+	{
+	 case 2:
+		for ( ; count >= 4; count -= 4, src += 4, dst += 8)
+		{
+			v = vld1q_u32(src);
+			vst2q_u32(dst, (uint32x4x2_t){ { v, v } });
+		}
+		break;
+	 case 3:
+		for ( ; count >= 4; count -= 4, src += 4, dst += 12)
+		{
+			v = vld1q_u32(src);
+			vst3q_u32(dst, (uint32x4x3_t){ { v, v, v } });
+		}
+		break;
+	 case 4:
+		for ( ; count >= 4; count -= 4, src += 4, dst += 16)
+		{
+			v = vld1q_u32(src);
+			vst4q_u32(dst, (uint32x4x4_t){ { v, v, v, v } });
+		}
+		break;
+	}
+	Generic_ScaleLine(src, dst, count, factor);
+}
+
+static void Neon_HalveLine(const uint32_t *src, uint32_t *dst, int count, uint32_t mask)
+{
+	const uint32x4_t m = vdupq_n_u32(mask);
+
+	for ( ; count >= 4; count -= 4, src += 4, dst += 4)
+		vst1q_u32(dst, vandq_u32(vshrq_n_u32(vld1q_u32(src), 1), m));
+	Generic_HalveLine(src, dst, count, mask);
+}
+
+#endif /* CONVSIMD_NEON */
+
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Select the kernels of 'level' (or the best ones for SIMD_BEST).
+ * Return the selected level, SIMD_NONE if 'level' is not supported
+ * by the host cpu (the scalar routines must then be used).
+ */
+int ConvSimd_Init(int level)
+{
+	level = Simd_Select(level, CONVSIMD_LEVELS);
+
+	ConvSimd_LowLine = NULL;
+	ConvSimd_MedLine = NULL;
+	ConvSimd_LowPixels = NULL;
+	ConvSimd_MedPixels = NULL;
+	ConvSimd_BitplanePixels = NULL;
+	ConvSimd_PaletteLine = NULL;
+	ConvSimd_HiColorLine = NULL;
+	ConvSimd_ZoomLine = NULL;
+	ConvSimd_ScaleLine = NULL;
+	ConvSimd_HalveLine = NULL;
+
+	switch (level)
+	{
+#ifdef SIMD_HOST_X86
+	 case SIMD_AVX2:
+		ConvSimd_LowLine = Avx2_LowLine;
+		ConvSimd_MedLine = Avx2_MedLine;
+		/* Only the palette mapping differs from SSE2 */
+		ConvSimd_LowPixels = Sse2_LowPixels;
+		ConvSimd_MedPixels = Sse2_MedPixels;
+		ConvSimd_BitplanePixels = Sse2_BitplanePixels;
+		ConvSimd_PaletteLine = Avx2_PaletteLine;
+		ConvSimd_HiColorLine = Avx2_HiColorLine;
+		ConvSimd_ZoomLine = Avx2_ZoomLine;
+		ConvSimd_ScaleLine = Sse2_ScaleLine;
+		ConvSimd_HalveLine = Sse2_HalveLine;
+		break;
+	 case SIMD_SSE2:
+		/* Without byte shuffles, the palette mapping of the scalar */
+		/* routines is faster than anything SSE2 can do */
+		ConvSimd_LowPixels = Sse2_LowPixels;
+		ConvSimd_MedPixels = Sse2_MedPixels;
+		ConvSimd_BitplanePixels = Sse2_BitplanePixels;
+		ConvSimd_PaletteLine = Generic_PaletteLine;
+		ConvSimd_HiColorLine = Sse2_HiColorLine;
+		ConvSimd_ScaleLine = Sse2_ScaleLine;
+		ConvSimd_HalveLine = Sse2_HalveLine;
+		break;
+#endif
+#ifdef CONVSIMD_NEON
+	 case SIMD_NEON:
+		ConvSimd_LowLine = Neon_LowLine;
+		ConvSimd_MedLine = Neon_MedLine;
+		ConvSimd_LowPixels = Neon_LowPixels;
+		ConvSimd_MedPixels = Neon_MedPixels;
+		ConvSimd_BitplanePixels = Neon_BitplanePixels;
+		ConvSimd_PaletteLine = Generic_PaletteLine;
+		ConvSimd_HiColorLine = Neon_HiColorLine;
+		ConvSimd_ScaleLine = Neon_ScaleLine;
+		ConvSimd_HalveLine = Neon_HalveLine;
+		break;
+#endif
+	 default:
+		level = SIMD_NONE;
+		break;
+	}
+
+	return level;
+}
+
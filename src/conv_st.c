@@ -26,11 +26,14 @@
 */
 
 #include <assert.h>
+#include <limits.h>
 
 #include "main.h"
 #include "configuration.h"
 #include "conv_gen.h"
+#include "conv_simd.h"
 #include "conv_st.h"
+#include "simd.h"
 #include "avi_record.h"
 #include "file.h"
 #include "log.h"
@@ -92,10 +95,40 @@ static uint16_t HBLPalette[16], PrevHBLPalette[16]; /* Current palette for line,
 
 static void (*ScreenDrawFunctionsNormal[3])(void);  /* Screen draw functions */
 
+/* Last complete frame in headless mode, converted only when needed */
+enum
+{
+	SAVED_NONE,     /* host screen is up to date */
+	SAVED_ST,       /* ST / STE frame lines & palettes saved below */
+	SAVED_LIVE      /* TT / Falcon / VDI frame, converted from RAM */
+};
+static struct
+{
+	int state;
+	uint8_t *pSTScreen;
+	uint16_t HBLPalettes[HBL_PALETTE_LINES];
+	uint32_t HBLPaletteMasks[HBL_PALETTE_MASKS];
+	int VerticalOverscan;
+	int nStartHBL;
+	int nScanlinesPerFrame;
+} SavedFrame;
+
 static bool bScreenContentsChanged;     /* true if buffer changed and requires blitting */
+static bool bUpdateCopy;                /* true if pSTScreenCopy is updated while converting */
 static bool bScrDoubleY;                /* true if double on Y */
+static bool bSpec512Compare;            /* true if Spec512 lines can be compared with previous frame */
 static int ScrUpdateFlag;               /* Bit mask of how to update screen */
 
+/* Host screen lines changed by the last ConvST_DrawFrame(), in bands
+ * of consecutive lines ('top' to 'bottom' - 1) from top to bottom */
+static struct
+{
+	int top[CONVST_DIRTY_BANDS];
+	int bottom[CONVST_DIRTY_BANDS];
+	int count;
+} DirtyBands;
+static uint32_t *pPCScreenPixels;       /* Host screen, for the dirty lines numbers */
+
 
 /**
  * Create ST 0x777 / STe 0xfff color format to 16 or 32 bits per pixel
@@ -130,15 +163,65 @@ static void ConvST_SetupRGBTable(void)
 }
 
 
+/**
+ * Copy the lines which were left in ST RAM during the frame (see
+ * Video_SetLineSource()) to the 'screen', for the conversions which
+ * can only read the 'screen'.
+ */
+static void ConvST_CopyLineSources(void)
+{
+	uint8_t *src;
+	int y;
+
+	if (!pFrameBuffer->nLineSources)
+		return;
+
+	for (y = 0; y < MAX_SOURCE_LINES; y++)
+	{
+		src = pFrameBuffer->pLineSource[y];
+		if (!src)
+			continue;
+		if (bUseHighRes)
+			memcpy(pFrameBuffer->pSTScreen + y * SCREENBYTES_MONOLINE, src, SCREENBYTES_MONOLINE);
+		else
+			memcpy(pFrameBuffer->pSTScreen + y * SCREENBYTES_LINE + SCREENBYTES_LEFT, src, SCREENBYTES_MIDDLE);
+		pFrameBuffer->pLineSource[y] = NULL;
+	}
+	pFrameBuffer->nLineSources = 0;
+}
+
+
 /**
  * Convert 640x400 monochrome screen
  */
 static void ConvST_ConvertHighRes(void)
 {
 	int linewidth = 640 / 16;
+	uint8_t *fvram = pSTScreen;
+	int y;
+
+	/* Whole screen left in ST RAM in one piece? Then convert it from there */
+	if (pFrameBuffer->nLineSources == 400)
+	{
+		fvram = pFrameBuffer->pLineSource[0];
+		for (y = 1; y < 400; y++)
+		{
+			if (pFrameBuffer->pLineSource[y] != fvram + y * SCREENBYTES_MONOLINE)
+			{
+				fvram = pSTScreen;
+				break;
+			}
+		}
+	}
+	if (fvram == pSTScreen)
+		ConvST_CopyLineSources();
+
+	bScreenContentsChanged = ConvGen_Convert(VideoBase, fvram, 640, 400, 1,
+	                                         linewidth, 0, 0, 0, 0, 0);
 
-	ConvGen_Convert(VideoBase, pSTScreen, 640, 400, 1, linewidth, 0, 0, 0, 0, 0);
-	bScreenContentsChanged = true;
+	/* Lines changed by the generic conversion are already host lines */
+	if (ConvGen_GetDirtyLines(&DirtyBands.top[0], &DirtyBands.bottom[0]))
+		DirtyBands.count = 1;
 }
 
 /**
@@ -334,7 +417,8 @@ void ConvST_Init(void)
 	assert(MAX_VDI8_BYTES >= MAX_VDI_BYTES);
 	FrameBuffer.pSTScreen = malloc(MAX_VDI8_BYTES);
 	FrameBuffer.pSTScreenCopy = malloc(MAX_VDI8_BYTES);
-	if (!FrameBuffer.pSTScreen || !FrameBuffer.pSTScreenCopy)
+	SavedFrame.pSTScreen = malloc(MAX_VDI8_BYTES);
+	if (!FrameBuffer.pSTScreen || !FrameBuffer.pSTScreenCopy || !SavedFrame.pSTScreen)
 	{
 		Main_ErrorExit("Failed to allocate frame buffer memory", NULL, -1);
 	}
@@ -342,6 +426,10 @@ void ConvST_Init(void)
 
 	ScreenDrawFunctionsNormal[ST_HIGH_RES] = ConvST_ConvertHighRes;
 
+	/* Select the SIMD conversion kernels for the host cpu, if any */
+	Log_Printf(LOG_DEBUG, "Screen conversion: %s kernels\n",
+	           Simd_Name(ConvSimd_Init(SIMD_BEST)));
+
 	Video_SetScreenRasters();                       /* Set rasters ready for first screen */
 }
 
@@ -354,8 +442,11 @@ void ConvST_UnInit(void)
 	/* Free memory used for copies */
 	free(FrameBuffer.pSTScreen);
 	free(FrameBuffer.pSTScreenCopy);
+	free(SavedFrame.pSTScreen);
 	FrameBuffer.pSTScreen = NULL;
 	FrameBuffer.pSTScreenCopy = NULL;
+	SavedFrame.pSTScreen = NULL;
+	SavedFrame.state = SAVED_NONE;
 }
 
 
@@ -395,6 +486,7 @@ void ConvST_SetFullUpdate(void)
 {
 	/* Update frame buffers */
 	FrameBuffer.bFullUpdate = true;
+	ConvGen_SetFullUpdate();
 }
 
 
@@ -405,6 +497,8 @@ void ConvST_SetFullUpdate(void)
  */
 void ConvST_Refresh(bool force_flip)
 {
+	SavedFrame.state = SAVED_NONE;
+
 	if (bUseVDIRes)
 	{
 		ConvGen_Draw(VideoBase, VDIWidth, VDIHeight, VDIPlanes,
@@ -420,10 +514,11 @@ void ConvST_Refresh(bool force_flip)
 	}
 	else
 	{
-		if (Screen_Draw(force_flip))
+		/* Swap copy/raster buffers in screen, unless the copy
+		 * was already updated while converting */
+		if (Screen_Draw(force_flip) && !bUpdateCopy)
 		{
 			unsigned char *pTmpScreen;
-			/* Swap copy/raster buffers in screen. */
 			pTmpScreen = pFrameBuffer->pSTScreenCopy;
 			pFrameBuffer->pSTScreenCopy = pFrameBuffer->pSTScreen;
 			pFrameBuffer->pSTScreen = pTmpScreen;
@@ -432,6 +527,111 @@ void ConvST_Refresh(bool force_flip)
 }
 
 
+/**
+ * Called at VBL instead of ConvST_Refresh() in headless mode: keep the
+ * emulated state of the frame which was just completed, so that it can
+ * be converted later with ConvST_RefreshOnDemand() if needed.
+ * ST / STE lines and palettes are swapped / copied, as the next frame
+ * overwrites them, TT / Falcon / VDI screens are converted directly
+ * from the emulated RAM.
+ */
+void ConvST_SaveFrame(void)
+{
+	uint8_t *pTmpScreen;
+
+	if (bUseVDIRes || Config_IsMachineTT() || Config_IsMachineFalcon())
+	{
+		SavedFrame.state = SAVED_LIVE;
+		return;
+	}
+
+	/* Lines are read from ST RAM only at the end of the frame */
+	ConvST_CopyLineSources();
+
+	/* Next frame is copied to the previously saved buffer */
+	pTmpScreen = pFrameBuffer->pSTScreen;
+	pFrameBuffer->pSTScreen = SavedFrame.pSTScreen;
+	SavedFrame.pSTScreen = pTmpScreen;
+
+	memcpy(SavedFrame.HBLPalettes, HBLPalettes, sizeof(HBLPalettes));
+	memcpy(SavedFrame.HBLPaletteMasks, HBLPaletteMasks, sizeof(HBLPaletteMasks));
+	SavedFrame.VerticalOverscan = VerticalOverscan;
+	SavedFrame.nStartHBL = nStartHBL;
+	SavedFrame.nScanlinesPerFrame = nScanlinesPerFrame;
+	Spec512_SwapFrame();
+
+	SavedFrame.state = SAVED_ST;
+}
+
+
+/**
+ * Convert the frame saved by ConvST_SaveFrame() to the host screen,
+ * if it isn't there yet (e.g. before a screenshot). This can be called
+ * in the middle of a frame, so all the state of the current frame used
+ * by the conversion is restored afterwards.
+ */
+void ConvST_RefreshOnDemand(void)
+{
+	static uint16_t CurHBLPalettes[HBL_PALETTE_LINES];
+	static uint32_t CurHBLPaletteMasks[HBL_PALETTE_MASKS];
+	static uint8_t *CurLineSource[MAX_SOURCE_LINES];
+	uint8_t *pCurFrameScreen, *pCurLine;
+	uint16_t *pCurHBLPalettes;
+	int CurVerticalOverscan, CurStartHBL, CurScanlinesPerFrame, CurLineSources;
+
+	if (SavedFrame.state == SAVED_NONE)
+		return;
+	if (SavedFrame.state == SAVED_LIVE)
+	{
+		ConvST_Refresh(true);
+		return;
+	}
+
+	/* Put the saved frame in place of the current one */
+	memcpy(CurHBLPalettes, HBLPalettes, sizeof(HBLPalettes));
+	memcpy(CurHBLPaletteMasks, HBLPaletteMasks, sizeof(HBLPaletteMasks));
+	memcpy(HBLPalettes, SavedFrame.HBLPalettes, sizeof(HBLPalettes));
+	memcpy(HBLPaletteMasks, SavedFrame.HBLPaletteMasks, sizeof(HBLPaletteMasks));
+	pCurFrameScreen = pFrameBuffer->pSTScreen;
+	pFrameBuffer->pSTScreen = SavedFrame.pSTScreen;
+	memcpy(CurLineSource, pFrameBuffer->pLineSource, sizeof(CurLineSource));
+	memset(pFrameBuffer->pLineSource, 0, sizeof(pFrameBuffer->pLineSource));
+	CurLineSources = pFrameBuffer->nLineSources;
+	pFrameBuffer->nLineSources = 0;
+	pCurLine = pSTScreen;
+	pCurHBLPalettes = pHBLPalettes;
+	CurVerticalOverscan = VerticalOverscan;
+	CurStartHBL = nStartHBL;
+	CurScanlinesPerFrame = nScanlinesPerFrame;
+	VerticalOverscan = SavedFrame.VerticalOverscan;
+	nStartHBL = SavedFrame.nStartHBL;
+	nScanlinesPerFrame = SavedFrame.nScanlinesPerFrame;
+	Spec512_SwapFrame();
+
+	if (Screen_Draw(true))
+	{
+		/* Converted frame is the one to compare the next one with */
+		SavedFrame.pSTScreen = pFrameBuffer->pSTScreenCopy;
+		pFrameBuffer->pSTScreenCopy = pFrameBuffer->pSTScreen;
+	}
+
+	/* And restore the current frame */
+	Spec512_SwapFrame();
+	nScanlinesPerFrame = CurScanlinesPerFrame;
+	nStartHBL = CurStartHBL;
+	VerticalOverscan = CurVerticalOverscan;
+	pHBLPalettes = pCurHBLPalettes;
+	pSTScreen = pCurLine;
+	pFrameBuffer->nLineSources = CurLineSources;
+	memcpy(pFrameBuffer->pLineSource, CurLineSource, sizeof(CurLineSource));
+	pFrameBuffer->pSTScreen = pCurFrameScreen;
+	memcpy(HBLPalettes, CurHBLPalettes, sizeof(HBLPalettes));
+	memcpy(HBLPaletteMasks, CurHBLPaletteMasks, sizeof(HBLPaletteMasks));
+
+	SavedFrame.state = SAVED_NONE;
+}
+
+
 /**
  * Have we changed between low/med/high res?
  */
@@ -597,6 +797,7 @@ static void ConvST_SetFullUpdateMask(void)
 static void ConvST_SetConvertDetails(void)
 {
 	Screen_GetDimension(&pPCScreenDest, NULL, NULL, &PCScreenBytesPerLine);
+	pPCScreenPixels = pPCScreenDest;
 
 	pSTScreen = pFrameBuffer->pSTScreen;          /* Source in ST memory */
 	pSTScreenCopy = pFrameBuffer->pSTScreenCopy;  /* Previous ST screen */
@@ -605,8 +806,9 @@ static void ConvST_SetConvertDetails(void)
 	pPCScreenDest += PCScreenOffsetY * PCScreenBytesPerLine / sizeof(*pPCScreenDest) + PCScreenOffsetX;
 
 	pHBLPalettes = pFrameBuffer->HBLPalettes;     /* HBL palettes pointer */
-	/* Not in TV-Mode? Then double up on Y: */
-	bScrDoubleY = !(ConfigureParams.Screen.nMonitorType == MONITOR_TYPE_TV);
+	/* Not in TV-Mode or with scanlines? Then double up on Y: */
+	bScrDoubleY = !(ConfigureParams.Screen.nMonitorType == MONITOR_TYPE_TV
+	                || ConfigureParams.Screen.bScanlines);
 
 	if (ConfigureParams.Screen.bAllowOverscan)  /* Use borders? */
 	{
@@ -646,6 +848,7 @@ bool ConvST_DrawFrame(void)
 	int new_res;
 	void (*pDrawFunction)(void);
 	static bool bPrevFrameWasSpec512 = false;
+	static void (*pPrevSpec512Function)(void);
 
 	assert(!bUseVDIRes);
 
@@ -664,19 +867,30 @@ bool ConvST_DrawFrame(void)
 	}
 
 	bScreenContentsChanged = false;      /* Did change (ie needs blit?) */
+	bUpdateCopy = false;
+	DirtyBands.count = 0;
 
 	/* Set details */
 	ConvST_SetConvertDetails();
 
 	/* Clear screen on full update to clear out borders and also interleaved lines */
 	if (pFrameBuffer->bFullUpdate)
+	{
 		Screen_ClearScreen();
+		ConvGen_SetFullUpdate();
+		DirtyBands.top[0] = 0;
+		DirtyBands.bottom[0] = INT_MAX;
+		DirtyBands.count = 1;
+		bScreenContentsChanged = true;
+	}
 
 	/* Call drawing for full-screen */
 	pDrawFunction = ScreenDrawFunctionsNormal[STRes];
 	/* Check if is Spec512 image */
 	if (Spec512_IsImage())
 	{
+		/* Spec512 routines only read the 'screen' */
+		ConvST_CopyLineSources();
 		bPrevFrameWasSpec512 = true;
 		/* What mode were we in? Keep to 320xH or 640xH */
 		if (pDrawFunction==ConvertLowRes_320x32Bit)
@@ -685,6 +899,11 @@ bool ConvST_DrawFrame(void)
 			pDrawFunction = ConvertLowRes_640x32Bit_Spec;
 		else if (pDrawFunction==ConvertMediumRes_640x32Bit)
 			pDrawFunction = ConvertMediumRes_640x32Bit_Spec;
+		/* Lines which didn't change since the previous Spec512
+		 * frame are kept, unless whole screen needs an update */
+		bSpec512Compare = (pDrawFunction == pPrevSpec512Function
+		                   && !pFrameBuffer->bFullUpdate);
+		pPrevSpec512Function = pDrawFunction;
 	}
 	else if (bPrevFrameWasSpec512)
 	{
@@ -693,6 +912,7 @@ bool ConvST_DrawFrame(void)
 		 * a full update of the screen. */
 		ConvST_SetFullUpdateMask();
 		bPrevFrameWasSpec512 = false;
+		pPrevSpec512Function = NULL;
 	}
 
 	/* Store palette for screenshots
@@ -700,6 +920,11 @@ bool ConvST_DrawFrame(void)
 	ConvertPalette = STRGBPalette;
 	ConvertPaletteSize = (STRes == ST_MEDIUM_RES) ? 4 : 16;
 
+	/* Lines left in ST RAM aren't in the 'screen', so it can't become the
+	 * copy of the next frame : Convert_Line() updates the copy instead */
+	if (STRes != ST_HIGH_RES && pFrameBuffer->nLineSources)
+		bUpdateCopy = true;
+
 	if (pDrawFunction)
 		CALL_VAR(pDrawFunction);
 
@@ -758,6 +983,48 @@ static int AdjustLinePaletteRemap(int y)
 }
 
 
+/**
+ * Get the bands of host screen lines changed by the last ConvST_DrawFrame()
+ * in the 'top' and 'bottom' arrays of CONVST_DIRTY_BANDS elements (lines
+ * 'top' to 'bottom' - 1, 'bottom' can be bigger than the host screen
+ * height). Return the number of bands.
+ */
+int ConvST_GetDirtyBands(int *top, int *bottom)
+{
+	int i;
+
+	for (i = 0; i < DirtyBands.count; i++)
+	{
+		top[i] = DirtyBands.top[i];
+		bottom[i] = DirtyBands.bottom[i];
+	}
+	return DirtyBands.count;
+}
+
+
+/**
+ * Mark 'count' host screen lines starting at 'line' as changed. Lines
+ * are converted from top to bottom, so they extend the last band, or
+ * start a new one after it (or extend the last one when there are
+ * already CONVST_DIRTY_BANDS bands).
+ */
+static void Convert_SetDirty(uint32_t *line, int count)
+{
+	int y = (line - pPCScreenPixels) / (PCScreenBytesPerLine / sizeof(*line));
+	int n = DirtyBands.count;
+
+	if (n > 0 && (y <= DirtyBands.bottom[n-1] || n == CONVST_DIRTY_BANDS))
+	{
+		if (y + count > DirtyBands.bottom[n-1])
+			DirtyBands.bottom[n-1] = y + count;
+		return;
+	}
+	DirtyBands.top[n] = y;
+	DirtyBands.bottom[n] = y + count;
+	DirtyBands.count++;
+}
+
+
 /**
  * Run updates to palette(STRGBPalette[]) until get to screen line
  * we are to convert from
@@ -774,7 +1041,8 @@ static void Convert_StartFrame(void)
 
 /**
  * Copy given line (address) of given length, to line below it
- * as-is, or halve its intensity, depending on bScrDoubleY.
+ * as-is, or halve its intensity (TV mode / scanlines), depending
+ * on bScrDoubleY.
  *
  * Source line is already in host format, so we don't need to
  * care about endianness.
@@ -801,6 +1069,11 @@ static uint32_t *Double_ScreenLine32(uint32_t *line, int size)
 	mask = ((rmask >> 1) & rmask)
 	     | ((gmask >> 1) & gmask)
 	     | ((bmask >> 1) & bmask);
+	if (ConvSimd_HalveLine)
+	{
+		ConvSimd_HalveLine(line, next, fmt_size, mask);
+		return next + fmt_size;
+	}
 	do {
 		*next++ = (*line++ >> 1) & mask;
 	}
@@ -810,6 +1083,87 @@ static uint32_t *Double_ScreenLine32(uint32_t *line, int size)
 }
 
 
+/**
+ * Return true if Spec512 line (started by Spec512_StartScanLine()) has
+ * the same pixels 'st' as in the copy of the previous frame, and the same
+ * palettes : it's still on the host screen and doesn't need a conversion.
+ */
+static bool Spec512_LineUnchanged(const uint32_t *st, const uint32_t *copy)
+{
+	return bSpec512Compare && !Spec512_LineChanged()
+	       && !memcmp(st, copy, STScreenWidthBytes);
+}
+
+
+/**
+ * Update 'size' bytes of the copy of the previous frame with 'line'
+ */
+static void Convert_UpdateCopy(uint32_t *copy, const uint32_t *line, int size)
+{
+	if (memcmp(copy, line, size) != 0)
+		memcpy(copy, line, size);
+}
+
+
+/**
+ * Convert screen line 'y' to 'esi' with the 'convline' routine, which
+ * writes 'pixels' PC pixels per ST byte. The middle of the lines without
+ * any border or scroll effect can still be in ST RAM (see
+ * Video_SetLineSource()), the borders of such lines are color 0 in the
+ * 'screen'.
+ * Return true if the converted line changed.
+ */
+static bool Convert_Line(int y, uint32_t *esi, int pixels,
+                         void (*convline)(uint32_t *edi, uint32_t *ebp, uint32_t *esi, int nBytes))
+{
+	int offset = STScreenLineOffset[y] + STScreenLeftSkipBytes;
+	uint32_t *edi = (uint32_t *)(pSTScreen + offset);      /* ST format screen */
+	uint32_t *ebp = (uint32_t *)(pSTScreenCopy + offset);  /* Previous ST format screen */
+	uint32_t *src = (uint32_t *)pFrameBuffer->pLineSource[y];
+	bool bChanged = bScreenContentsChanged;
+	int left, right;
+
+	bScreenContentsChanged = false;
+	if (!src)
+	{
+		convline(edi, ebp, esi, STScreenWidthBytes);
+		if (bUpdateCopy)
+			Convert_UpdateCopy(ebp, edi, STScreenWidthBytes);
+	}
+	else
+	{
+		left = SCREENBYTES_LEFT - STScreenLeftSkipBytes;
+		right = STScreenWidthBytes - left - SCREENBYTES_MIDDLE;
+		if (left > 0)
+		{
+			convline(edi, ebp, esi, left);
+			Convert_UpdateCopy(ebp, edi, left);
+		}
+		edi += (left + SCREENBYTES_MIDDLE) / 4;
+		ebp += left / 4;
+		esi += left * pixels;
+
+		convline(src, ebp, esi, SCREENBYTES_MIDDLE);
+		Convert_UpdateCopy(ebp, src, SCREENBYTES_MIDDLE);
+		if (right > 0)
+		{
+			ebp += SCREENBYTES_MIDDLE / 4;
+			esi += SCREENBYTES_MIDDLE * pixels;
+			convline(edi, ebp, esi, right);
+			Convert_UpdateCopy(ebp, edi, right);
+		}
+	}
+
+	/* Converted pixels differ from the previous frame? */
+	if (!bScreenContentsChanged)
+	{
+		bScreenContentsChanged = bChanged;
+		return false;
+	}
+	return true;
+}
+
+
 /* lookup tables and conversion macros */
 #include "convert/macros.h"
 
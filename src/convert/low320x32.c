@@ -7,68 +7,77 @@
   Screen Conversion, Low Res to 320x32Bit
 */
 
-static void ConvertLowRes_320x32Bit(void)
+static void Line_ConvertLowRes_320x32Bit(uint32_t *edi, uint32_t *ebp, uint32_t *esi, int nBytes)
 {
-	uint32_t *edi, *ebp;
-	uint32_t *esi;
 	uint32_t eax, edx;
 	uint32_t ebx, ecx;
-	int y, x, update;
+	int x, update;
 
-	Convert_StartFrame();            /* Start frame, track palettes */
+	x = nBytes>>3;             /* Amount to draw across in 16-pixels (8 bytes) */
+	update = ScrUpdateFlag & PALETTEMASK_UPDATEMASK;
 
-	for (y = STScreenStartHorizLine; y < STScreenEndHorizLine; y++)
+	if (ConvSimd_LowLine)
 	{
+		if (ConvSimd_LowLine(edi, ebp, esi, x, update, STRGBPalette, false))
+			bScreenContentsChanged = true;
+		return;
+	}
 
-		eax = STScreenLineOffset[y] + STScreenLeftSkipBytes;  /* Offset for this line + Amount to skip on left hand side */
-		edi = (uint32_t *)((uint8_t *)pSTScreen + eax);       /* ST format screen 4-plane 16 colors */
-		ebp = (uint32_t *)((uint8_t *)pSTScreenCopy + eax);   /* Previous ST format screen */
-		esi = pPCScreenDest;                                  /* PC format screen */
-
-		update = AdjustLinePaletteRemap(y) & PALETTEMASK_UPDATEMASK;
-
-		x = STScreenWidthBytes>>3; /* Amount to draw across in 16-pixels (8 bytes) */
+	do    /* x-loop */
+	{
+		/* Do 16 pixels at one time */
+		ebx = *edi;
+		ecx = *(edi+1);
 
-		do    /* x-loop */
+		if (update || ebx!=*ebp || ecx!=*(ebp+1))    /* Does differ? */
 		{
-			/* Do 16 pixels at one time */
-			ebx = *edi;
-			ecx = *(edi+1);
-
-			if (update || ebx!=*ebp || ecx!=*(ebp+1))    /* Does differ? */
-			{
-				/* copy word */
+			/* copy word */
 
-				bScreenContentsChanged = true;
+			bScreenContentsChanged = true;
 
 #if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
-				/* Plot pixels */
-				LOW_BUILD_PIXELS_0 ;      /* Generate 'ecx' as pixels [12,13,14,15] */
-				PLOT_LOW_320_32BIT(12) ;
-				LOW_BUILD_PIXELS_1 ;      /* Generate 'ecx' as pixels [4,5,6,7] */
-				PLOT_LOW_320_32BIT(4) ;
-				LOW_BUILD_PIXELS_2 ;      /* Generate 'ecx' as pixels [8,9,10,11] */
-				PLOT_LOW_320_32BIT(8) ;
-				LOW_BUILD_PIXELS_3 ;      /* Generate 'ecx' as pixels [0,1,2,3] */
-				PLOT_LOW_320_32BIT(0) ;
+			/* Plot pixels */
+			LOW_BUILD_PIXELS_0 ;      /* Generate 'ecx' as pixels [12,13,14,15] */
+			PLOT_LOW_320_32BIT(12) ;
+			LOW_BUILD_PIXELS_1 ;      /* Generate 'ecx' as pixels [4,5,6,7] */
+			PLOT_LOW_320_32BIT(4) ;
+			LOW_BUILD_PIXELS_2 ;      /* Generate 'ecx' as pixels [8,9,10,11] */
+			PLOT_LOW_320_32BIT(8) ;
+			LOW_BUILD_PIXELS_3 ;      /* Generate 'ecx' as pixels [0,1,2,3] */
+			PLOT_LOW_320_32BIT(0) ;
 #else
-				/* Plot pixels */
-				LOW_BUILD_PIXELS_0 ;      /* Generate 'ecx' as pixels [4,5,6,7] */
-				PLOT_LOW_320_32BIT(4) ;
-				LOW_BUILD_PIXELS_1 ;      /* Generate 'ecx' as pixels [12,13,14,15] */
-				PLOT_LOW_320_32BIT(12) ;
-				LOW_BUILD_PIXELS_2 ;      /* Generate 'ecx' as pixels [0,1,2,3] */
-				PLOT_LOW_320_32BIT(0) ;
-				LOW_BUILD_PIXELS_3 ;      /* Generate 'ecx' as pixels [8,9,10,11] */
-				PLOT_LOW_320_32BIT(8) ;
+			/* Plot pixels */
+			LOW_BUILD_PIXELS_0 ;      /* Generate 'ecx' as pixels [4,5,6,7] */
+			PLOT_LOW_320_32BIT(4) ;
+			LOW_BUILD_PIXELS_1 ;      /* Generate 'ecx' as pixels [12,13,14,15] */
+			PLOT_LOW_320_32BIT(12) ;
+			LOW_BUILD_PIXELS_2 ;      /* Generate 'ecx' as pixels [0,1,2,3] */
+			PLOT_LOW_320_32BIT(0) ;
+			LOW_BUILD_PIXELS_3 ;      /* Generate 'ecx' as pixels [8,9,10,11] */
+			PLOT_LOW_320_32BIT(8) ;
 #endif
-			}
-
-			esi += 16;                        /* Next PC pixels */
-			edi += 2;                         /* Next ST pixels */
-			ebp += 2;                         /* Next ST copy pixels */
 		}
-		while (--x);                      /* Loop on X */
+
+		esi += 16;                        /* Next PC pixels */
+		edi += 2;                         /* Next ST pixels */
+		ebp += 2;                         /* Next ST copy pixels */
+	}
+	while (--x);                      /* Loop on X */
+}
+
+static void ConvertLowRes_320x32Bit(void)
+{
+	int y;
+
+	Convert_StartFrame();            /* Start frame, track palettes */
+
+	for (y = STScreenStartHorizLine; y < STScreenEndHorizLine; y++)
+	{
+		AdjustLinePaletteRemap(y);
+
+		/* 2 PC pixels per ST byte */
+		if (Convert_Line(y, pPCScreenDest, 2, Line_ConvertLowRes_320x32Bit))
+			Convert_SetDirty(pPCScreenDest, 1);
 
 		/* Offset to next line: */
 		pPCScreenDest = pPCScreenDest + PCScreenBytesPerLine / sizeof(*pPCScreenDest);
@@ -7,9 +7,83 @@
   Screen Conversion, Low Res Spec512 to 320x32Bit
 */
 
+/* Palette indexes of a line, when converted by ConvSimd_LowPixels / ConvSimd_MedPixels */
+static uint8_t Spec512Pixels[NUM_VISIBLE_LINE_PIXELS * 2];
+/* Low res line before it's doubled by ConvSimd_ScaleLine */
+static uint32_t Spec512Line[NUM_VISIBLE_LINE_PIXELS];
+
+/**
+ * Plot 'count' pixels from their palette indexes with the current palette
+ */
+static void Spec512_PlotSpan(const uint8_t *pixels, uint32_t *esi, int count, int zoom)
+{
+	int i;
+
+	if (zoom == 1 && count >= 16 && ConvSimd_PaletteLine)
+	{
+		ConvSimd_PaletteLine(pixels, esi, count, STRGBPalette);
+	}
+	else if (zoom == 2)
+	{
+		for (i = 0; i < count; i++)
+			esi[2*i] = esi[2*i+1] = STRGBPalette[pixels[i]];
+	}
+	else
+	{
+		for (i = 0; i < count; i++)
+			esi[i] = STRGBPalette[pixels[i]];
+	}
+}
+
+/**
+ * Plot the 'blocks' blocks of 16 pixels of a Spec512 line from their palette
+ * indexes, doubling them when 'zoom' is 2. As in the routines below, the palette
+ * is updated every 4 pixels in low res and every 8 pixels in medium res,
+ * starting after the first pixel of each block : the pixels are plotted in
+ * spans between the palette changes of the line (see Spec512_GetLineChanges).
+ */
+static void Spec512_PlotPixels(const uint8_t *pixels, uint32_t *esi, int blocks, int zoom, bool medium)
+{
+	const SPEC512CHANGE *pChange;
+	uint32_t *dst = esi;
+	int count = blocks * 16;
+	int nChanges, x, next;
+
+	/* Plot at native resolution first, and double the whole line at the end */
+	if (zoom == 2 && ConvSimd_ScaleLine)
+	{
+		dst = Spec512Line;
+		zoom = 1;
+	}
+
+	nChanges = Spec512_GetLineChanges(&pChange);
+	for (x = 0; x < count; x = next)
+	{
+		next = count;
+		if (nChanges > 0)
+		{
+			next = medium ? pChange->Span * 8 + 5 : pChange->Span * 4 + 1;
+			if (next > count)
+				next = count;
+		}
+
+		Spec512_PlotSpan(pixels + x, dst + x * zoom, next - x, zoom);
+
+		if (next < count)
+		{
+			STRGBPalette[pChange->Index] = ST2RGB[pChange->Colour];
+			pChange++;
+			nChanges--;
+		}
+	}
+
+	if (dst != esi)
+		ConvSimd_ScaleLine(Spec512Line, esi, count, 2);
+}
+
 static void ConvertLowRes_320x32Bit_Spec(void)
 {
-	uint32_t *edi;
+	uint32_t *edi, *ebp;
 	uint32_t *esi;
 	uint32_t eax, ebx, ecx, edx;
 	uint32_t pixelspace[5]; /* Workspace to store pixels to so can print in right order for Spec512 */
@@ -20,21 +94,39 @@ static void ConvertLowRes_320x32Bit_Spec(void)
 	 */
 	pixelspace[4] = 0;
 
-	Spec512_StartFrame();            /* Start frame, track palettes */
+	/* Start frame, compact palettes of the lines */
+	Spec512_StartFrame(STScreenEndHorizLine - STScreenStartHorizLine, STScreenWidthBytes / 2);
 
 	for (y = STScreenStartHorizLine; y < STScreenEndHorizLine; y++)
 	{
 
-		Spec512_StartScanLine();        /* Build up palettes for every 4 pixels, store in 'ScanLinePalettes' */
+		Spec512_StartScanLine(false);   /* Set palette of the first pixel, changes for the line */
 
 		/* Get screen addresses, 'edi'-ST screen, 'esi'-PC screen */
 		eax = STScreenLineOffset[y] + STScreenLeftSkipBytes;  /* Offset for this line + Amount to skip on left hand side */
 		edi = (uint32_t *)((uint8_t *)pSTScreen + eax);       /* ST format screen 4-plane 16 colors */
+		ebp = (uint32_t *)((uint8_t *)pSTScreenCopy + eax);   /* Previous ST format screen */
 		esi = pPCScreenDest;                                  /* PC format screen */
 
+		/* Same line as in the previous frame ? */
+		if (Spec512_LineUnchanged(edi, ebp))
+		{
+			pPCScreenDest = pPCScreenDest + PCScreenBytesPerLine / sizeof(*pPCScreenDest);
+			continue;
+		}
+		bScreenContentsChanged = true;
+		Convert_SetDirty(esi, 1);
+
 		x = STScreenWidthBytes >> 3;    /* Amount to draw across in 16-pixels (8 bytes) */
 
-		do  /* x-loop */
+		if (ConvSimd_LowPixels)
+		{
+			ConvSimd_LowPixels(edi, Spec512Pixels, x);
+			Spec512_PlotPixels(Spec512Pixels, esi, x, 1, false);
+			x = 0;
+		}
+
+		while (x--)  /* x-loop */
 		{
 			ebx = *edi;                 /* Do 16 pixels at one time */
 			ecx = *(edi+1);
@@ -84,13 +176,8 @@ static void ConvertLowRes_320x32Bit_Spec(void)
 			esi += 16;                  /* Next PC pixels */
 			edi += 2;                   /* Next ST pixels */
 		}
-		while (--x);                    /* Loop on X */
-
-		Spec512_EndScanLine();
 
 		/* Offset to next line */
 		pPCScreenDest = pPCScreenDest + PCScreenBytesPerLine / sizeof(*pPCScreenDest);
 	}
-
-	bScreenContentsChanged = true;
 }
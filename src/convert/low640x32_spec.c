@@ -15,7 +15,8 @@ static void ConvertLowRes_640x32Bit_Spec(void)
 	uint32_t eax;
 	int y;
 
-	Spec512_StartFrame();            /* Start frame, track palettes */
+	/* Start frame, compact palettes of the lines */
+	Spec512_StartFrame(STScreenEndHorizLine - STScreenStartHorizLine, STScreenWidthBytes / 2);
 
 	for (y = STScreenStartHorizLine; y < STScreenEndHorizLine; y++)
 	{
@@ -24,12 +25,21 @@ static void ConvertLowRes_640x32Bit_Spec(void)
 		ebp = (uint32_t *)((uint8_t *)pSTScreenCopy + eax);   /* Previous ST format screen */
 		esi = PCScreen;                                    /* PC format screen */
 
+		Spec512_StartScanLine(false);   /* Set palette of the first pixel, changes for the line */
+
+		/* Same line as in the previous frame ? */
+		if (Spec512_LineUnchanged(edi, ebp))
+		{
+			PCScreen += 2 * PCScreenBytesPerLine / sizeof(*PCScreen);
+			continue;
+		}
+		bScreenContentsChanged = true;
+		Convert_SetDirty(esi, 2);
+
 		Line_ConvertLowRes_640x32Bit_Spec(edi, ebp, esi, eax);
 
 		PCScreen = Double_ScreenLine32(PCScreen, PCScreenBytesPerLine);
 	}
-
-        bScreenContentsChanged = true;
 }
 
 
@@ -44,10 +54,15 @@ static void Line_ConvertLowRes_640x32Bit_Spec(uint32_t *edi, uint32_t *ebp, uint
 	 */
 	pixelspace[4] = 0;
 
-	Spec512_StartScanLine();        /* Build up palettes for every 4 pixels, store in 'ScanLinePalettes' */
-
 	x = STScreenWidthBytes >> 3;   /* Amount to draw across in 16-pixels (8 bytes) */
 
+	if (ConvSimd_LowPixels)
+	{
+		ConvSimd_LowPixels(edi, Spec512Pixels, x);
+		Spec512_PlotPixels(Spec512Pixels, esi, x, 2, false);
+		return;
+	}
+
 	do  /* x-loop */
 	{
 		ebx = *edi;                 /* Do 16 pixels at one time */
@@ -100,6 +115,4 @@ static void Line_ConvertLowRes_640x32Bit_Spec(uint32_t *edi, uint32_t *ebp, uint
 		ebp += 2;                   /* Next ST copy pixels */
 	}
 	while (--x);                    /* Loop on X */
-
-	Spec512_EndScanLine();
 }
@@ -10,39 +10,46 @@
 static void ConvertMediumRes_640x32Bit(void)
 {
 	uint32_t *PCScreen = pPCScreenDest;
-	uint32_t *edi, *ebp;
-	uint32_t *esi;
-	uint32_t eax;
+	bool bChanged;
 	int y;
 
 	Convert_StartFrame();            /* Start frame, track palettes */
 
 	for (y = STScreenStartHorizLine; y < STScreenEndHorizLine; y++)
 	{
-
-		eax = STScreenLineOffset[y] + STScreenLeftSkipBytes;  /* Offset for this line + Amount to skip on left hand side */
-		edi = (uint32_t *)((uint8_t *)pSTScreen + eax);       /* ST format screen 4-plane 16 colors */
-		ebp = (uint32_t *)((uint8_t *)pSTScreenCopy + eax);   /* Previous ST format screen */
-		esi = PCScreen;                                    /* PC format screen */
-
+		/* 4 PC pixels per ST byte */
 		if (AdjustLinePaletteRemap(y) & 0x00030000)        /* Change palette table */
-			Line_ConvertMediumRes_640x32Bit(edi, ebp, esi, eax);
+			bChanged = Convert_Line(y, PCScreen, 4, Line_ConvertMediumRes_640x32Bit);
 		else
-			Line_ConvertLowRes_640x32Bit(edi, ebp, esi, eax);
+			bChanged = Convert_Line(y, PCScreen, 4, Line_ConvertLowRes_640x32Bit);
 
-		PCScreen = Double_ScreenLine32(PCScreen, PCScreenBytesPerLine);
+		/* Unchanged lines are already doubled on the host screen */
+		if (bChanged)
+		{
+			Convert_SetDirty(PCScreen, 2);
+			PCScreen = Double_ScreenLine32(PCScreen, PCScreenBytesPerLine);
+		}
+		else
+			PCScreen += 2 * PCScreenBytesPerLine / sizeof(*PCScreen);
 	}
 }
 
 
-static void Line_ConvertMediumRes_640x32Bit(uint32_t *edi, uint32_t *ebp, uint32_t *esi, uint32_t eax)
+static void Line_ConvertMediumRes_640x32Bit(uint32_t *edi, uint32_t *ebp, uint32_t *esi, int nBytes)
 {
-	uint32_t ebx, ecx;
+	uint32_t eax, ebx, ecx;
 	int x, update;
 
-	x = STScreenWidthBytes >> 2;   /* Amount to draw across in 16-pixels (4 bytes) */
+	x = nBytes >> 2;               /* Amount to draw across in 16-pixels (4 bytes) */
 	update = ScrUpdateFlag & PALETTEMASK_UPDATEMASK;
 
+	if (ConvSimd_MedLine)
+	{
+		if (ConvSimd_MedLine(edi, ebp, esi, x, update, STRGBPalette))
+			bScreenContentsChanged = true;
+		return;
+	}
+
 	do  /* x-loop */
 	{
 		/* Do 16 pixels at one time */
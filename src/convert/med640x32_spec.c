@@ -14,8 +14,10 @@ static void ConvertMediumRes_640x32Bit_Spec(void)
 	uint32_t *esi;
 	uint32_t eax;
 	int y;
+	bool bMedium;
 
-	Spec512_StartFrame();            /* Start frame, track palettes */
+	/* Start frame, compact palettes of the lines */
+	Spec512_StartFrame(STScreenEndHorizLine - STScreenStartHorizLine, STScreenWidthBytes / 2);
 
 	for (y = STScreenStartHorizLine; y < STScreenEndHorizLine; y++)
 	{
@@ -24,15 +26,25 @@ static void ConvertMediumRes_640x32Bit_Spec(void)
 		ebp = (uint32_t *)((uint8_t *)pSTScreenCopy + eax);   /* Previous ST format screen */
 		esi = PCScreen;                                    /* PC format screen */
 
-		if (HBLPaletteMasks[y] & 0x00030000)               /* Test resolution */
+		bMedium = (HBLPaletteMasks[y] & 0x00030000) != 0;  /* Test resolution */
+		Spec512_StartScanLine(bMedium);  /* Set palette of the first pixel, changes for the line */
+
+		/* Same line as in the previous frame ? */
+		if (Spec512_LineUnchanged(edi, ebp))
+		{
+			PCScreen += 2 * PCScreenBytesPerLine / sizeof(*PCScreen);
+			continue;
+		}
+		bScreenContentsChanged = true;
+		Convert_SetDirty(esi, 2);
+
+		if (bMedium)
 			Line_ConvertMediumRes_640x32Bit_Spec(edi, ebp, esi, eax);	/* med res line */
 		else
 			Line_ConvertLowRes_640x32Bit_Spec(edi, ebp, esi, eax);		/* low res line (double on X) */
 
 		PCScreen = Double_ScreenLine32(PCScreen, PCScreenBytesPerLine);
 	}
-
-        bScreenContentsChanged = true;
 }
 
 
@@ -47,10 +59,15 @@ static void Line_ConvertMediumRes_640x32Bit_Spec(uint32_t *edi, uint32_t *ebp, u
 	 */
 	pixelspace[4] = 0;
 
-	Spec512_StartScanLine();        /* Build up palettes for every 4 pixels, store in 'ScanLinePalettes' */
-
 	x = STScreenWidthBytes >> 2;   /* Amount to draw across in 16-pixels (4 bytes) */
 
+	if (ConvSimd_MedPixels)
+	{
+		ConvSimd_MedPixels(edi, Spec512Pixels, x);
+		Spec512_PlotPixels(Spec512Pixels, esi, x, 1, true);
+		return;
+	}
+
 	do  /* x-loop */
 	{
 		/* Do 16 pixels at one time */
@@ -106,6 +123,4 @@ static void Line_ConvertMediumRes_640x32Bit_Spec(uint32_t *edi, uint32_t *ebp, u
 		ebp += 1;                       /* Next ST copy pixels */
 	}
 	while (--x);                        /* Loop on X */
-
-	Spec512_EndScanLine();
 }
@@ -15,7 +15,7 @@ static void ConvertLowRes_640x32Bit(void);
 static void ConvertLowRes_320x32Bit_Spec(void);
 static void Line_ConvertLowRes_640x32Bit_Spec(uint32_t *edi, uint32_t *ebp, uint32_t *esi, uint32_t eax);
 static void ConvertLowRes_640x32Bit_Spec(void);
-static void Line_ConvertMediumRes_640x32Bit(uint32_t *edi, uint32_t *ebp, uint32_t *esi, uint32_t eax);
+static void Line_ConvertMediumRes_640x32Bit(uint32_t *edi, uint32_t *ebp, uint32_t *esi, int nBytes);
 static void ConvertMediumRes_640x32Bit(void);
 static void Line_ConvertMediumRes_640x32Bit_Spec(uint32_t *edi, uint32_t *ebp, uint32_t *esi, uint32_t eax);
 static void ConvertMediumRes_640x32Bit_Spec(void);
@@ -0,0 +1,241 @@
+/*
+  Hatari - blockcache.c
+
+  This file is distributed under the GNU General Public License, version 2
+  or at your option any later version. Read the file gpl.txt for details.
+
+  Pre-decoded block cache for the non cycle exact / non prefetch 68000 cpu
+  core (m68k_run_2_000).
+
+  Each block records a run of instructions starting at a given PC (address,
+  opcode and handler from cpufunctbl[]), so straight-line code can be
+  dispatched again without fetching and decoding the opcodes. Handlers still
+  read their extension words and return their cycles as usual, so the
+  emulation and the timings are the same as without the cache.
+
+  Blocks are recorded while they are executed for the first time and end
+  on a control flow change, an exception / interrupt or when they reach
+  BLOCKCACHE_MAX_INSN instructions or BLOCKCACHE_MAX_BYTES bytes, so a
+  block always covers at most 2 pages of 2^BLOCKCACHE_PAGE_SHIFT bytes.
+  When replaying a block, the PC of each instruction is compared with the
+  recorded one, so a branch taken differently simply ends the block.
+
+  Writes to RAM pages used by some blocks increment the generation of
+  the page, which invalidates these blocks ; the same is done for the
+  memory written by the host (M68000_Flush_xxx_Cache). Changes to the
+  cpu tables and to the memory banks flush the whole cache.
+
+  The extension words and cycles are not stored in the blocks : this core
+  reads the extension words with a direct load through regs.pc_p (as
+  cheap as reading a cached copy) and the cycles returned by a handler
+  depend on the EA and on the branch taken.
+*/
+const char BlockCache_fileid[] = "Hatari blockcache.c";
+
+#include "main.h"
+#include "sysconfig.h"
+#include "sysdeps.h"
+#include "blockcache.h"
+
+
+#define BLOCKCACHE_HASH_BITS	12
+#define BLOCKCACHE_HASH_SIZE	( 1 << BLOCKCACHE_HASH_BITS )
+#define BLOCKCACHE_MAX_INSN	32
+#define BLOCKCACHE_MAX_INSN_BYTES	10			/* Longest 68000 instruction */
+#define BLOCKCACHE_MAX_BYTES	( ( 1 << BLOCKCACHE_PAGE_SHIFT ) - BLOCKCACHE_MAX_INSN_BYTES )
+
+typedef struct
+{
+	uaecptr		start_pc;
+	int		nb_insn;			/* 0 if the block is not valid */
+	uae_u32		flush_gen;			/* BlockCache_FlushGen when recorded */
+	uae_u32		page_gen[ 2 ];			/* BlockCache_PageGen[] when recorded */
+	BLOCKCACHE_INSN	insn[ BLOCKCACHE_MAX_INSN + 1 ];	/* +1 for the end marker */
+} BLOCKCACHE_BLOCK;
+
+
+bool			BlockCache_Enabled = false;
+uae_u8			BlockCache_PageUsed[ BLOCKCACHE_PAGES ];
+uae_u32			BlockCache_PageGen[ BLOCKCACHE_PAGES ];
+
+/* Instructions never have an odd address, so this never matches a pc */
+BLOCKCACHE_INSN		BlockCache_EndMarker = { 0xffffffff , NULL , 0 };
+BLOCKCACHE_INSN		*BlockCache_Cursor = &BlockCache_EndMarker;
+
+static BLOCKCACHE_BLOCK	*BlockCache_Blocks;
+static BLOCKCACHE_BLOCK	*BlockCache_Rec;		/* Block being recorded or NULL */
+static uae_u32		BlockCache_FlushGen;
+
+
+/**
+ * Allocate the blocks
+ */
+void BlockCache_Init ( void )
+{
+	if ( BlockCache_Blocks == NULL )
+		BlockCache_Blocks = calloc ( BLOCKCACHE_HASH_SIZE , sizeof ( BLOCKCACHE_BLOCK ) );
+
+	BlockCache_Flush ();
+}
+
+
+void BlockCache_UnInit ( void )
+{
+	free ( BlockCache_Blocks );
+	BlockCache_Blocks = NULL;
+	BlockCache_Cursor = &BlockCache_EndMarker;
+	BlockCache_Rec = NULL;
+}
+
+
+/**
+ * Invalidate all the blocks (memory was changed by the host, cpu tables
+ * were patched, memory banks were remapped, ...)
+ */
+void BlockCache_Flush ( void )
+{
+	BlockCache_FlushGen++;
+	BlockCache_Cursor = &BlockCache_EndMarker;
+	BlockCache_Rec = NULL;
+	memset ( BlockCache_PageUsed , 0 , sizeof ( BlockCache_PageUsed ) );
+}
+
+
+/**
+ * Invalidate the blocks using the 'size' bytes at 'addr' (memory was
+ * written by the host, for example by GEMDOS HD emulation)
+ */
+void BlockCache_Invalidate ( uaecptr addr , int size )
+{
+	uae_u32 page, last;
+
+	if ( !BlockCache_Enabled || size <= 0 )
+		return;
+
+	if ( size >= 0x1000000 )
+	{
+		BlockCache_Flush ();
+		return;
+	}
+
+	page = ( addr & 0xffffff ) >> BLOCKCACHE_PAGE_SHIFT;
+	last = ( ( addr + size - 1 ) & 0xffffff ) >> BLOCKCACHE_PAGE_SHIFT;
+	for ( ; ; page = ( page + 1 ) & ( BLOCKCACHE_PAGES - 1 ) )
+	{
+		if ( BlockCache_PageUsed[ page ] )
+		{
+			BlockCache_PageUsed[ page ] = 0;
+			BlockCache_PageGen[ page ]++;
+			BlockCache_Cursor = &BlockCache_EndMarker;
+		}
+		if ( page == last )
+			break;
+	}
+}
+
+
+/**
+ * End the recording of the current block. If some pages were written to
+ * during the recording, the block is discarded.
+ */
+static void BlockCache_EndRecord ( void )
+{
+	BLOCKCACHE_BLOCK *b = BlockCache_Rec;
+	uae_u32 page = ( b->start_pc & 0xffffff ) >> BLOCKCACHE_PAGE_SHIFT;
+
+	BlockCache_Rec = NULL;
+
+	if ( b->page_gen[ 0 ] != BlockCache_PageGen[ page ]
+	  || b->page_gen[ 1 ] != BlockCache_PageGen[ ( page + 1 ) & ( BLOCKCACHE_PAGES - 1 ) ] )
+	{
+		b->nb_insn = 0;
+		return;
+	}
+
+	b->insn[ b->nb_insn ] = BlockCache_EndMarker;
+}
+
+
+/**
+ * Start recording a new block at 'pc', replacing the previous block
+ * with the same hash
+ */
+static void BlockCache_StartRecord ( BLOCKCACHE_BLOCK *b , uaecptr pc )
+{
+	uae_u32 page = ( pc & 0xffffff ) >> BLOCKCACHE_PAGE_SHIFT;
+	uae_u32 page2 = ( page + 1 ) & ( BLOCKCACHE_PAGES - 1 );
+
+	BlockCache_PageUsed[ page ] = 1;
+	BlockCache_PageUsed[ page2 ] = 1;
+
+	b->start_pc = pc;
+	b->nb_insn = 0;
+	b->flush_gen = BlockCache_FlushGen;
+	b->page_gen[ 0 ] = BlockCache_PageGen[ page ];
+	b->page_gen[ 1 ] = BlockCache_PageGen[ page2 ];
+
+	BlockCache_Rec = b;
+}
+
+
+/**
+ * Fetch and decode the instruction at 'pc' the usual way and add it
+ * to the block being recorded
+ */
+static cpuop_func *BlockCache_RecordInsn ( uaecptr pc )
+{
+	BLOCKCACHE_BLOCK *b = BlockCache_Rec;
+	BLOCKCACHE_INSN *insn = &b->insn[ b->nb_insn++ ];
+
+	regs.opcode = x_get_iword ( 0 );
+	insn->pc = pc;
+	insn->opcode = regs.opcode;
+	insn->func = cpufunctbl[ regs.opcode ];
+
+	if ( b->nb_insn == BLOCKCACHE_MAX_INSN )
+		BlockCache_EndRecord ();
+
+	return insn->func;
+}
+
+
+/**
+ * The instruction at 'pc' is not the next one in the current block :
+ * continue the recording of the current block if 'pc' follows the previous
+ * instruction, else use the block starting at 'pc' or record a new one.
+ */
+cpuop_func *BlockCache_Miss ( uaecptr pc )
+{
+	BLOCKCACHE_BLOCK *b;
+
+	BlockCache_Cursor = &BlockCache_EndMarker;
+
+	if ( BlockCache_Rec )
+	{
+		b = BlockCache_Rec;
+		if ( b->flush_gen == BlockCache_FlushGen
+		  && pc > b->insn[ b->nb_insn - 1 ].pc
+		  && pc <= b->insn[ b->nb_insn - 1 ].pc + BLOCKCACHE_MAX_INSN_BYTES
+		  && pc - b->start_pc <= BLOCKCACHE_MAX_BYTES )
+			return BlockCache_RecordInsn ( pc );
+
+		BlockCache_EndRecord ();
+	}
+
+	b = &BlockCache_Blocks[ ( pc >> 1 ) & ( BLOCKCACHE_HASH_SIZE - 1 ) ];
+	if ( b->nb_insn > 0 && b->start_pc == pc && b->flush_gen == BlockCache_FlushGen )
+	{
+		uae_u32 page = ( pc & 0xffffff ) >> BLOCKCACHE_PAGE_SHIFT;
+
+		if ( b->page_gen[ 0 ] == BlockCache_PageGen[ page ]
+		  && b->page_gen[ 1 ] == BlockCache_PageGen[ ( page + 1 ) & ( BLOCKCACHE_PAGES - 1 ) ] )
+		{
+			BlockCache_Cursor = &b->insn[ 1 ];
+			regs.opcode = b->insn[ 0 ].opcode;
+			return b->insn[ 0 ].func;
+		}
+	}
+
+	BlockCache_StartRecord ( b , pc );
+	return BlockCache_RecordInsn ( pc );
+}
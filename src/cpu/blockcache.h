@@ -0,0 +1,77 @@
+/*
+  Hatari - blockcache.h
+
+  This file is distributed under the GNU General Public License, version 2
+  or at your option any later version. Read the file gpl.txt for details.
+*/
+
+#ifndef HATARI_BLOCKCACHE_H
+#define HATARI_BLOCKCACHE_H
+
+#include "sysdeps.h"
+#include "newcpu.h"
+
+#define BLOCKCACHE_PAGE_SHIFT	8			/* Invalidation granularity is 256 bytes */
+#define BLOCKCACHE_PAGES	( 0x1000000 >> BLOCKCACHE_PAGE_SHIFT )	/* 24 bit address space */
+
+typedef struct
+{
+	uaecptr		pc;				/* Address of this instruction (odd for the end marker) */
+	cpuop_func	*func;				/* Handler from cpufunctbl[] */
+	uae_u16		opcode;
+} BLOCKCACHE_INSN;
+
+extern bool			BlockCache_Enabled;
+extern uae_u8			BlockCache_PageUsed[ BLOCKCACHE_PAGES ];
+extern uae_u32			BlockCache_PageGen[ BLOCKCACHE_PAGES ];
+extern BLOCKCACHE_INSN		*BlockCache_Cursor;
+extern BLOCKCACHE_INSN		BlockCache_EndMarker;
+
+extern void	BlockCache_Init ( void );
+extern void	BlockCache_UnInit ( void );
+extern void	BlockCache_Flush ( void );
+extern void	BlockCache_Invalidate ( uaecptr addr , int size );
+extern cpuop_func *BlockCache_Miss ( uaecptr pc );
+
+
+/**
+ * Return the handler for the instruction at 'pc' and set regs.opcode.
+ * When the instruction is the next one in the current cached block, this
+ * avoids fetching and decoding the opcode again.
+ */
+static inline cpuop_func *BlockCache_Fetch ( uaecptr pc )
+{
+	BLOCKCACHE_INSN *insn = BlockCache_Cursor;
+
+	if ( insn->pc == pc )
+	{
+		BlockCache_Cursor = insn + 1;
+		regs.opcode = insn->opcode;
+		return insn->func;
+	}
+	return BlockCache_Miss ( pc );
+}
+
+
+/**
+ * Called for every write to RAM : if some cached blocks use this page,
+ * they are invalidated (cheap test when the page has no cached code,
+ * a single predictable branch when the cache is disabled)
+ */
+static inline void BlockCache_Write ( uaecptr addr )
+{
+	uae_u32 page;
+
+	if ( !BlockCache_Enabled )
+		return;
+
+	page = ( addr & 0xffffff ) >> BLOCKCACHE_PAGE_SHIFT;
+	if ( BlockCache_PageUsed[ page ] )
+	{
+		BlockCache_PageUsed[ page ] = 0;
+		BlockCache_PageGen[ page ]++;
+		BlockCache_Cursor = &BlockCache_EndMarker;
+	}
+}
+
+#endif /* HATARI_BLOCKCACHE_H */
@@ -27,6 +27,7 @@
 #include "sysconfig.h"
 #include "sysdeps.h"
 
+#include <inttypes.h>
 #include "main.h"
 #include "hatari-glue.h"
 
@@ -51,7 +52,14 @@
 bool mmu_debugger;
 uae_u32 mmu_is_super;
 uae_u32 mmu_tagmask, mmu_pagemask, mmu_pagemaski;
+#ifndef WINUAE_FOR_HATARI
 struct mmu_atc_line mmu_atc_array[ATC_TYPE][ATC_SLOTS][ATC_WAYS];
+#else
+struct mmu_atc_line mmu_atc_array[ATC_TYPE][ATC_SLOTS_MAX][ATC_WAYS];
+int mmu_atc_slots = ATC_REAL_SLOTS;
+static uae_u8 mmu_atc_slot_way[ATC_TYPE][ATC_SLOTS_MAX];	/* last way used in each host ATC slot */
+uae_u64 mmu_atc_hits, mmu_atc_misses;
+#endif
 bool mmu_pagesize_8k;
 int mmu_pageshift, mmu_pageshift1m;
 uae_u8 mmu_cache_state;
@@ -73,6 +81,23 @@ uae_u32 mmu040_move16[4];
 
 static struct mmu_debug_data mddm;
 
+#ifdef WINUAE_FOR_HATARI
+/* Hatari : ATC slot for a logical address, in the real or the host ATC */
+static inline int mmu_atc_index(uaecptr addr, bool super)
+{
+	uae_u32 page;
+
+	if (mmu_atc_slots == ATC_REAL_SLOTS) {
+		if (mmu_pagesize_8k)
+			return (addr & 0x0001E000) >> 13;
+		return (addr & 0x0000F000) >> 12;
+	}
+	page = addr >> mmu_pageshift;
+	page ^= (page >> 8) ^ (page >> 16);
+	return (page & (ATC_HOST_SLOTS / 2 - 1)) | (super ? ATC_HOST_SLOTS / 2 : 0);
+}
+#endif
+
 #if MMU_ICACHE
 struct mmu_icache mmu_icache_data[MMU_ICACHE_SZ];
 #endif
@@ -911,6 +936,7 @@ uaecptr mmu_translate(uaecptr addr, uae_u32 val, bool super, bool data, bool wri
 	uae_u32 status060 = 0;
 	uae_u32 tag = ((super ? 0x80000000 : 0x00000000) | (addr >> 1)) & mmu_tagmask;
 
+#ifndef WINUAE_FOR_HATARI
 	if (mmu_pagesize_8k)
 		index=(addr & 0x0001E000)>>13;
 	else
@@ -918,6 +944,19 @@ uaecptr mmu_translate(uaecptr addr, uae_u32 val, bool super, bool data, bool wri
 	way_invalid = ATC_WAYS;
 	way_random++;
 	way = mmu_atc_ways[data];
+#else
+	int hit = 1;
+
+	index = mmu_atc_index(addr, super);
+	way_invalid = ATC_WAYS;
+	way_random++;
+	/* in the host ATC, start with the last way used in this slot, */
+	/* so most accesses only compare one entry */
+	if (mmu_atc_slots == ATC_REAL_SLOTS)
+		way = mmu_atc_ways[data];
+	else
+		way = mmu_atc_slot_way[data][index];
+#endif
 
 	for (i = 0; i < ATC_WAYS; i++) {
 		// if we have this
@@ -948,6 +987,10 @@ atc_retry:
 
 				// save way for next access (likely in same page)
 				mmu_atc_ways[data] = way;
+#ifdef WINUAE_FOR_HATARI
+				mmu_atc_slot_way[data][index] = way;
+				mmu_atc_hits += hit;
+#endif
 
 				if (l->status & MMU_MMUSR_CM_DISABLE) {
 					mmu_cache_state = CACHE_DISABLE_MMU;
@@ -975,6 +1018,10 @@ atc_retry:
 	
 	// then initiate table search and create a new entry
 	l = &mmu_atc_array[data][index][way];
+#ifdef WINUAE_FOR_HATARI
+	mmu_atc_misses++;
+	hit = 0;
+#endif
 	mmu_fill_atc(addr, super, tag, write, l, &status060);
 
 	if (status060 && currprefs.mmu_model == 68060) {
@@ -1440,10 +1487,14 @@ void REGPARAM2 mmu_op_real(uae_u32 opcode, uae_u16 extra)
 			int way;
 			uae_u32 index;
 			uae_u32 tag = ((super ? 0x80000000 : 0x00000000) | (addr >> 1)) & mmu_tagmask;
+#ifndef WINUAE_FOR_HATARI
 			if (mmu_pagesize_8k)
 				index=(addr & 0x0001E000)>>13;
 			else
 				index=(addr & 0x0000F000)>>12;
+#else
+			index = mmu_atc_index(addr, super);
+#endif
 			for (way = 0; way < ATC_WAYS; way++) {
 				if (!mmu_atc_array[data][index][way].valid)
 					break;
@@ -1489,10 +1540,14 @@ void REGPARAM2 mmu_flush_atc(uaecptr addr, bool super, bool global)
 	int way,type,index;
 
 	uaecptr tag = ((super ? 0x80000000 : 0) | (addr >> 1)) & mmu_tagmask;
+#ifndef WINUAE_FOR_HATARI
 	if (mmu_pagesize_8k)
 		index=(addr & 0x0001E000)>>13;
 	else
 		index=(addr & 0x0000F000)>>12;
+#else
+	index = mmu_atc_index(addr, super);
+#endif
 	for (type=0;type<ATC_TYPE;type++) {
 		for (way=0;way<ATC_WAYS;way++) {
 			struct mmu_atc_line *l = &mmu_atc_array[type][index][way];
@@ -1525,11 +1580,56 @@ void REGPARAM2 mmu_flush_atc_all(bool global)
 	mmu_flush_cache();
 }
 
+#ifdef WINUAE_FOR_HATARI
+/* Hatari : use the real ATC in cycle exact mode or if the host ATC is */
+/* disabled by the user, else the host ATC */
+static void mmu_atc_set_mode(bool host)
+{
+	int slots = host ? ATC_HOST_SLOTS : ATC_REAL_SLOTS;
+
+	if (slots == mmu_atc_slots)
+		return;
+
+	mmu_atc_slots = slots;
+	memset(mmu_atc_array, 0, sizeof(mmu_atc_array));
+	memset(mmu_atc_slot_way, 0, sizeof(mmu_atc_slot_way));
+	flush_shortcut_cache(0xffffffff, 0);
+	mmu_flush_cache();
+	mmu_atc_hits = mmu_atc_misses = 0;
+}
+
+/* Hatari : for the debugger's "info mmu" */
+void mmu_atc_info(FILE *fp)
+{
+	uae_u64 total = mmu_atc_hits + mmu_atc_misses;
+	int type, slot, way, used = 0;
+
+	for (type = 0; type < ATC_TYPE; type++) {
+		for (slot = 0; slot < ATC_SLOTS; slot++) {
+			for (way = 0; way < ATC_WAYS; way++) {
+				if (mmu_atc_array[type][slot][way].valid)
+					used++;
+			}
+		}
+	}
+	fprintf(fp, "ATC:\t%s, %d/%d entries used\n",
+		mmu_atc_slots == ATC_REAL_SLOTS ? "real" : "host (hashed)",
+		used, ATC_TYPE * ATC_SLOTS * ATC_WAYS);
+	fprintf(fp, "ATC hits:\t%" PRIu64 " (%.2f%%)\n", (uint64_t)mmu_atc_hits,
+		total ? 100.0 * mmu_atc_hits / total : 0.0);
+	fprintf(fp, "ATC misses:\t%" PRIu64 "\n", (uint64_t)mmu_atc_misses);
+}
+#endif
+
 void REGPARAM2 mmu_set_funcs(void)
 {
 	if (currprefs.mmu_model != 68040 && currprefs.mmu_model != 68060)
 		return;
 
+#ifdef WINUAE_FOR_HATARI
+	mmu_atc_set_mode(currprefs.mmu_host_atc && !currprefs.cpu_cycle_exact);
+#endif
+
 	x_phys_get_iword = phys_get_word;
 	x_phys_get_ilong = phys_get_long;
 	x_phys_get_byte = phys_get_byte;
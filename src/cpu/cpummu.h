@@ -164,12 +164,31 @@ struct mmu_atc_line {
  */
 
 #define ATC_WAYS 4
+#ifndef WINUAE_FOR_HATARI
 #define ATC_SLOTS 16
+#else
+/* Hatari : when not in cycle exact mode, a bigger host side ATC with
+ * ATC_HOST_SLOTS slots is used instead of the 16 slots of the real one.
+ * The first half of the slots is used for user accesses, the second half
+ * for supervisor accesses, and the slot in each half is given by a hash
+ * of the logical page instead of its 4 low bits. */
+#define ATC_REAL_SLOTS 16
+#define ATC_HOST_SLOTS 512
+#define ATC_SLOTS_MAX ATC_HOST_SLOTS
+#define ATC_SLOTS mmu_atc_slots
+#endif
 #define ATC_TYPE 2
 
 extern uae_u32 mmu_is_super;
 extern uae_u32 mmu_tagmask, mmu_pagemask, mmu_pagemaski;
+#ifndef WINUAE_FOR_HATARI
 extern struct mmu_atc_line mmu_atc_array[ATC_TYPE][ATC_SLOTS][ATC_WAYS];
+#else
+extern struct mmu_atc_line mmu_atc_array[ATC_TYPE][ATC_SLOTS_MAX][ATC_WAYS];
+extern int mmu_atc_slots;
+extern uae_u64 mmu_atc_hits, mmu_atc_misses;
+extern void mmu_atc_info(FILE *fp);
+#endif
 
 extern void mmu_tt_modified(void);
 extern int mmu_match_ttr_ins(uaecptr addr, bool super);
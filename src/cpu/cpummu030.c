@@ -32,6 +32,7 @@
 #include "sysdeps.h"
 
 #ifdef WINUAE_FOR_HATARI
+#include <inttypes.h>
 #include "main.h"
 #include "hatari-glue.h"
 #include "log.h"
@@ -114,7 +115,27 @@ uae_u32 tt0_030, tt1_030, tc_030;
 uae_u16 mmusr_030;
 
 /* ATC struct */
+#ifndef WINUAE_FOR_HATARI
 #define ATC030_NUM_ENTRIES  22
+#else
+/* Hatari : when not in cycle exact mode, the 22 entries of the real ATC are
+ * replaced by a bigger host side ATC with ATC030_HOST_SETS sets of
+ * ATC030_HOST_WAYS entries, indexed by a hash of the logical page and
+ * function code. Its entries are created and flushed like the real ATC's
+ * ones, they're just kept longer and found without a linear search. */
+#define ATC030_REAL_ENTRIES	22
+#define ATC030_HOST_SETS	256
+#define ATC030_HOST_WAYS	4
+#define ATC030_MAX_ENTRIES	( ATC030_HOST_SETS * ATC030_HOST_WAYS )
+#define ATC030_NUM_ENTRIES	atc030_num_entries
+
+static int atc030_num_entries = ATC030_REAL_ENTRIES;
+static bool atc030_host;
+static uae_u8 atc030_host_next[ATC030_HOST_SETS];	/* next way to replace in each set */
+static bool atc030_refill;				/* entry created by a table search */
+
+uae_u64 mmu030_atc_hits, mmu030_atc_misses;
+#endif
 
 typedef struct {
     struct {
@@ -163,7 +184,11 @@ static struct {
     } transparent;
     
     /* Address translation cache */
+#ifndef WINUAE_FOR_HATARI
     MMU030_ATC_LINE atc[ATC030_NUM_ENTRIES];
+#else
+    MMU030_ATC_LINE atc[ATC030_MAX_ENTRIES];
+#endif
     
     /* Condition */
     bool enabled;
@@ -181,6 +206,52 @@ static struct {
 
 } mmu030;
 
+#ifdef WINUAE_FOR_HATARI
+/* Hatari : first entry of the host ATC's set for a logical page / function code */
+static inline int atc030_host_set(uaecptr maddr, uae_u32 fc)
+{
+	uae_u32 page = maddr >> mmu030.translation.page.size;
+
+	return ( ( page ^ ( page >> 8 ) ^ ( fc << 5 ) ) & ( ATC030_HOST_SETS - 1 ) ) * ATC030_HOST_WAYS;
+}
+
+/* Hatari : use the real ATC in cycle exact mode or if the host ATC is */
+/* disabled by the user, else the host ATC */
+static void mmu030_atc_set_mode(bool host)
+{
+	int i;
+
+	if (host == atc030_host)
+		return;
+
+	atc030_host = host;
+	atc030_num_entries = host ? ATC030_MAX_ENTRIES : ATC030_REAL_ENTRIES;
+	for (i = 0; i < ATC030_MAX_ENTRIES; i++) {
+		mmu030.atc[i].logical.valid = false;
+		mmu030.atc[i].mru = 0;
+	}
+	memset(atc030_host_next, 0, sizeof(atc030_host_next));
+	mmu030_atc_hits = mmu030_atc_misses = 0;
+}
+
+/* Hatari : for the debugger's "info mmu" */
+void mmu030_atc_info(FILE *fp)
+{
+	uae_u64 total = mmu030_atc_hits + mmu030_atc_misses;
+	int i, used = 0;
+
+	for (i = 0; i < ATC030_NUM_ENTRIES; i++) {
+		if (mmu030.atc[i].logical.valid)
+			used++;
+	}
+	fprintf(fp, "ATC:\t%s, %d/%d entries used\n",
+		atc030_host ? "host (hashed)" : "real", used, ATC030_NUM_ENTRIES);
+	fprintf(fp, "ATC hits:\t%" PRIu64 " (%.2f%%)\n", (uint64_t)mmu030_atc_hits,
+		total ? 100.0 * mmu030_atc_hits / total : 0.0);
+	fprintf(fp, "ATC misses:\t%" PRIu64 "\n", (uint64_t)mmu030_atc_misses);
+}
+#endif
+
 /* MMU Status Register
  *
  * ---x ---x x-xx x---
@@ -534,6 +605,9 @@ static bool mmu_op30_pload (uaecptr pc, uae_u32 opcode, uae_u16 next, uaecptr ex
 
     mmu030_flush_atc_page(extra);
     mmu030_table_search(extra, fc, write, 0);
+#ifdef WINUAE_FOR_HATARI
+	atc030_refill = false;
+#endif
 	return false;
 }
 
@@ -1615,6 +1689,21 @@ static uae_u32 mmu030_table_search(uaecptr addr, uae_u32 fc, bool write, int lev
         return descr_num ? descr_addr[descr_num] : 0;
     }
     
+#ifdef WINUAE_FOR_HATARI
+    atc030_refill = true;
+    if (atc030_host) {
+        /* Replace an invalid entry of the set, else the next one in turn */
+        int set = atc030_host_set(addr & mmu030.translation.page.imask, fc);
+        for (i = set; i < set + ATC030_HOST_WAYS; i++) {
+            if (!mmu030.atc[i].logical.valid)
+                break;
+        }
+        if (i == set + ATC030_HOST_WAYS) {
+            i = set + atc030_host_next[set / ATC030_HOST_WAYS];
+            atc030_host_next[set / ATC030_HOST_WAYS] = (atc030_host_next[set / ATC030_HOST_WAYS] + 1) % ATC030_HOST_WAYS;
+        }
+    } else {
+#endif
     /* Find an ATC entry to replace */
     /* Search for invalid entry */
     for (i=0; i<ATC030_NUM_ENTRIES; i++) {
@@ -1640,6 +1729,9 @@ static uae_u32 mmu030_table_search(uaecptr addr, uae_u32 fc, bool write, int lev
 	}
 
     mmu030_atc_handle_history_bit(i);
+#ifdef WINUAE_FOR_HATARI
+    }
+#endif
     
     /* Create ATC entry */
     mmu030.atc[i].logical.addr = addr & mmu030.translation.page.imask; /* delete page index bits */
@@ -2072,6 +2164,30 @@ static int mmu030_logical_is_in_atc(uaecptr addr, uae_u32 fc, bool write) {
     int offset = (maddr >> mmu030.translation.page.size) & 0x1f;
 
     int i, index;
+#ifdef WINUAE_FOR_HATARI
+	/* Don't count the search of the entry just created by a table search */
+	/* (this access was already counted as a miss) */
+	int count = atc030_refill ? 0 : 1;
+	atc030_refill = false;
+	if (atc030_host) {
+		index = atc030_host_set(maddr, fc);
+		for (i = 0; i < ATC030_HOST_WAYS; i++, index++) {
+			if (maddr == mmu030.atc[index].logical.addr &&
+			    mmu030.atc[index].logical.fc == fc &&
+			    mmu030.atc[index].logical.valid) {
+				if (!write || mmu030.atc[index].physical.modified ||
+				    mmu030.atc[index].physical.write_protect ||
+				    mmu030.atc[index].physical.bus_error) {
+					mmu030_atc_hits += count;
+					return index;
+				}
+				mmu030.atc[index].logical.valid = false;
+			}
+		}
+		mmu030_atc_misses += count;
+		return -1;
+	}
+#endif
 	index = atcindextable[offset];
     for (i=0; i<ATC030_NUM_ENTRIES; i++) {
         logical_addr = mmu030.atc[index].logical.addr;
@@ -2087,6 +2203,9 @@ static int mmu030_logical_is_in_atc(uaecptr addr, uae_u32 fc, bool write) {
                 /* Maintain history bit */
 					mmu030_atc_handle_history_bit(index);
 					atcindextable[offset] = index;
+#ifdef WINUAE_FOR_HATARI
+					mmu030_atc_hits += count;
+#endif
 					return index;
 				} else {
 					mmu030.atc[index].logical.valid = false;
@@ -2096,6 +2215,9 @@ static int mmu030_logical_is_in_atc(uaecptr addr, uae_u32 fc, bool write) {
 		if (index >= ATC030_NUM_ENTRIES)
 			index = 0;
     }
+#ifdef WINUAE_FOR_HATARI
+	mmu030_atc_misses += count;
+#endif
     return -1;
 }
 
@@ -2712,6 +2834,10 @@ void mmu030_set_funcs(void)
 {
 	if (currprefs.mmu_model != 68030)
 		return;
+#ifdef WINUAE_FOR_HATARI
+	/* Always keep the real ATC behaviour in cycle exact mode */
+	mmu030_atc_set_mode(currprefs.mmu_host_atc && !currprefs.cpu_cycle_exact);
+#endif
 	if (currprefs.cpu_memory_cycle_exact) {
 		x_phys_get_iword = mem_access_delay_wordi_read_ce020;
 		x_phys_get_ilong = mem_access_delay_longi_read_ce020;
@@ -3694,6 +3820,8 @@ void mmu030_dump_tables(int fc)
 
 void restore_mmu030_finish ( void )
 {
+	mmu030_flush_atc_all();
+
 	mmu030.transparent.tt0 = mmu030_decode_tt(tt0_030);
 	mmu030.transparent.tt1 = mmu030_decode_tt(tt1_030);
 	tt_enabled = (tt0_030 & TT_ENABLE) || (tt1_030 & TT_ENABLE);
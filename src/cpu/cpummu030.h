@@ -929,5 +929,9 @@ extern void m68k_do_rte_mmu030c(uaecptr a7);
 extern void m68k_do_bsr_mmu030c(uaecptr oldpc, uae_s32 offset);
 
 extern void restore_mmu030_finish(void);
+#ifdef WINUAE_FOR_HATARI
+extern uae_u64 mmu030_atc_hits, mmu030_atc_misses;
+extern void mmu030_atc_info(FILE *fp);
+#endif
 
 #endif /* UAE_CPUMMU030_H */
@@ -2,7 +2,9 @@
  * events.c
  *
  * Event stuff - currently just simplified to the bare minimum
- * in Hatari, but we might want to extend this one day...
+ * in Hatari : all the events are handled by the scheduler in cycInt.c,
+ * only 'currcycle' is used to count the cycles inside an instruction
+ * in cycle exact mode.
  */
 
 #include "main.h"
@@ -84,6 +84,22 @@ static int func_noret;
 #ifdef WINUAE_FOR_HATARI
 static int CurrentInstrCycles;		/* Hatari only : Number of cycles for the current instruction in cpuemu_xx */
 static int CurrentInstrCycles_pos;	/* Hatari only : Stores where we have to patch in the current cycles value */
+
+/* Hatari only : pairs of opcodes for which fused handlers are generated in */
+/* the generic 68020+ cpu cores (read from the file given on the command line) */
+#define MAX_FUSED_PAIRS		1024
+#define MAX_FUSED_SECOND	8	/* Max number of second opcodes for the same first opcode */
+static struct {
+	uae_u16 first, second;
+} fused_pairs[MAX_FUSED_PAIRS];
+static int fused_count;
+static int *opcode_fn_postfix;		/* Hatari only : postfix of the function handling each opcode for the current cpu */
+
+/* Hatari only : lazy flags in the generic cpu cores (see lazy_flags_fixup()) */
+static int using_lazy_flags;
+static char lazy_flags_code[1000];	/* Replacement for the code between the markers */
+#define LAZY_FLAGS_BEGIN	"/* LAZY_FLAGS_BEGIN */"
+#define LAZY_FLAGS_END		"/* LAZY_FLAGS_END */"
 #endif
 
 #define GF_APDI		0x00001
@@ -366,6 +382,97 @@ static void read_counts (void)
 		term();
 }
 
+#ifdef WINUAE_FOR_HATARI
+/* Hatari : return 1 if the code between 'start' and 'end' may use the flags */
+static int lazy_flags_used (const char *start, const char *end)
+{
+	static const char *tokens[] = {
+		"FLG(", "CZNV", "COPY_CARRY", "cctrue", "regflags", "flgs", "flgo", "flgn", "SR(",
+		"divbyzero_special", "setdiv", "setchk", "m68k_divl", "m68k_mull", NULL
+	};
+	const char *p;
+	int i;
+
+	for (i = 0; tokens[i]; i++) {
+		p = strstr (start, tokens[i]);
+		if (p && p < end)
+			return 1;
+	}
+	return 0;
+}
+
+/* Hatari : remove the lines from 'start' (in a line) to 'end' (in the same or a later line) */
+static char *lazy_flags_cut (char *start, char *end)
+{
+	char *eol;
+
+	while (start > outbuffer && start[-1] != '\n')
+		start--;
+	eol = strchr (end, '\n');
+	end = eol ? eol + 1 : end + strlen (end);
+	memmove (start, end, strlen (end) + 1);
+	return start;
+}
+
+/* Hatari : insert 'code' at 'pos', indented with 'tabs' tabulations */
+static void lazy_flags_insert (char *pos, const char *code, int tabs)
+{
+	char buf[1000];
+	int len;
+
+	buf[0] = 0;
+	while (*code) {
+		const char *eol = strchr (code, '\n');
+		int i;
+		for (i = 0; i < tabs; i++)
+			strcat (buf, "\t");
+		strncat (buf, code, eol - code + 1);
+		code = eol + 1;
+	}
+	len = strlen (buf);
+	memmove (pos + len, pos, strlen (pos) + 1);
+	memcpy (pos, buf, len);
+}
+
+/*
+ * Hatari : with lazy flags, when the flags of the current opcode are only
+ * set by a single genflags() call of a supported type and the opcode doesn't
+ * read or modify them otherwise, replace this normal flags code by the code
+ * only storing the operation and its operands.
+ * Else keep the normal code, and if the opcode uses the flags in any way,
+ * compute the pending lazy flags at the start of its handler.
+ */
+static void lazy_flags_fixup (unsigned int opcode)
+{
+	char *begin, *end, *p;
+	int tabs;
+
+	begin = strstr (outbuffer, LAZY_FLAGS_BEGIN);
+	end = begin ? strstr (begin, LAZY_FLAGS_END) : NULL;
+	if (end && !strstr (end, LAZY_FLAGS_BEGIN) && table68k[opcode].flaglive == 0
+		&& !lazy_flags_used (outbuffer, begin)
+		&& !lazy_flags_used (end, end + strlen (end))) {
+		for (tabs = 0; begin - tabs > outbuffer && begin[-tabs - 1] == '\t'; tabs++)
+			;
+		p = lazy_flags_cut (begin, end);
+		lazy_flags_insert (p, lazy_flags_code, tabs);
+		return;
+	}
+
+	while ((p = strstr (outbuffer, LAZY_FLAGS_BEGIN)))
+		lazy_flags_cut (p, p);
+	while ((p = strstr (outbuffer, LAZY_FLAGS_END)))
+		lazy_flags_cut (p, p);
+
+	if (table68k[opcode].flaglive || table68k[opcode].flagdead
+		|| lazy_flags_used (outbuffer, outbuffer + strlen (outbuffer))) {
+		p = strstr (outbuffer, "(uae_u32 opcode)\n{\n");
+		if (p)
+			lazy_flags_insert (p + strlen ("(uae_u32 opcode)\n{\n"), "FLUSH_LAZY_FLAGS();\n", 1);
+	}
+}
+#endif
+
 static int genamode_cnt, genamode8r_offset[2];
 static int set_fpulimit;
 
@@ -1935,6 +2042,31 @@ static void genflags_normal(flagtypes type, wordsizes size, const char *value, c
 		break;
 	}
 
+#ifdef WINUAE_FOR_HATARI
+	/* Hatari : with lazy flags, also prepare the code only storing the operands */
+	/* (X is set directly), it replaces the normal code if possible */
+	if (using_lazy_flags && (type == flag_logical || type == flag_add || type == flag_sub || type == flag_cmp)) {
+		const char *lsize = size == sz_byte ? "LAZY_FLAGS_B" : size == sz_word ? "LAZY_FLAGS_W" : "LAZY_FLAGS_L";
+		switch (type) {
+		case flag_logical:
+			sprintf(lazy_flags_code, "SET_LAZY_FLAGS(LAZY_FLAGS_LOGICAL | %s, 0, %s);\n", lsize, value);
+			break;
+		case flag_add:
+			sprintf(lazy_flags_code, "SET_XFLG(%s < %s);\nSET_LAZY_FLAGS(LAZY_FLAGS_ADD | %s, %s, %s);\n",
+				undstr, usstr, lsize, src, dst);
+			break;
+		case flag_sub:
+			sprintf(lazy_flags_code, "SET_XFLG(%s > %s);\nSET_LAZY_FLAGS(LAZY_FLAGS_SUB | %s, %s, %s);\n",
+				usstr, udstr, lsize, src, dst);
+			break;
+		default:
+			sprintf(lazy_flags_code, "SET_LAZY_FLAGS(LAZY_FLAGS_CMP | %s, %s, %s);\n", lsize, src, dst);
+			break;
+		}
+		out(LAZY_FLAGS_BEGIN "\n");
+	}
+#endif
+
 	switch (type) {
 	case flag_logical_noclobber:
 	case flag_logical:
@@ -2009,6 +2141,11 @@ static void genflags_normal(flagtypes type, wordsizes size, const char *value, c
 		out("SET_NFLG(flgn != 0);\n");
 		break;
 	}
+
+#ifdef WINUAE_FOR_HATARI
+	if (using_lazy_flags && (type == flag_logical || type == flag_add || type == flag_sub || type == flag_cmp))
+		out(LAZY_FLAGS_END "\n");
+#endif
 }
 
 static void genflags(flagtypes type, wordsizes size, const char *value, const char *src, const char *dst)
@@ -9851,6 +9988,10 @@ static void generate_one_opcode (int rp, const char *extra)
 
 	outbuffer[0] = 0;
 
+#ifdef WINUAE_FOR_HATARI
+	opcode_fn_postfix[opcode] = opcode_next_clev[rp] != cpu_level ? opcode_last_postfix[rp] : postfix;
+#endif
+
 	if (opcode_next_clev[rp] != cpu_level) {
 		char *name = ua (lookuptab[idx].name);
 		if (generate_stbl) {
@@ -9996,6 +10137,9 @@ static void generate_one_opcode (int rp, const char *extra)
 		sprintf ( buf_cyc , "%d;", CurrentInstrCycles );
 		memcpy ( outbuffer+CurrentInstrCycles_pos , buf_cyc , strlen(buf_cyc) );
 	}
+
+	if (using_lazy_flags)
+		lazy_flags_fixup (opcode);
 #endif
 
 	printf("%s", outbuffer);
@@ -10079,6 +10223,125 @@ static void generate_func (const char *extra)
 	}
 }
 
+#ifdef WINUAE_FOR_HATARI
+/*
+ * Hatari : read the pairs of opcodes to fuse, one "<first opcode> <second opcode>"
+ * pair in hexadecimal per line (other fields and lines starting with '#' are
+ * ignored). Such a file can be saved with the debugger's "profile pairs" command.
+ */
+static void read_fused_pairs (const char *fname)
+{
+	FILE *file;
+	char line[256];
+	unsigned int first, second;
+	int i, n;
+
+	file = fopen (fname, "r");
+	if (!file) {
+		fprintf (stderr, "gencpu: can't open fused opcodes file '%s'\n", fname);
+		exit (1);
+	}
+	while (fgets (line, sizeof line, file) && fused_count < MAX_FUSED_PAIRS) {
+		if (line[0] == '#' || sscanf (line, "%x %x", &first, &second) != 2)
+			continue;
+		if (first > 0xffff || second > 0xffff
+			|| table68k[first].mnemo == i_ILLG || table68k[second].mnemo == i_ILLG
+			|| table68k[first].unimpclev > 0 || table68k[second].unimpclev > 0)
+			continue;
+		/* The first opcode must continue with the next instruction, so the */
+		/* idle loop check between both opcodes can't end a loop iteration */
+		if (table68k[first].cflow != fl_normal)
+			continue;
+		/* Pairs are sorted by frequency, keep the first ones for each first opcode */
+		n = 0;
+		for (i = 0; i < fused_count; i++) {
+			if (fused_pairs[i].first == first) {
+				if (fused_pairs[i].second == second)
+					break;
+				n++;
+			}
+		}
+		if (i < fused_count || n >= MAX_FUSED_SECOND)
+			continue;
+		fused_pairs[fused_count].first = first;
+		fused_pairs[fused_count].second = second;
+		fused_count++;
+	}
+	fclose (file);
+}
+
+/* Hatari : name of the function handling 'opcode' in the current cpu, or 0 if none */
+static int fused_func_name (char *name, unsigned int opcode)
+{
+	unsigned int rep = table68k[opcode].handler != -1 ? table68k[opcode].handler : opcode;
+
+	if (table68k[opcode].mnemo == i_ILLG || table68k[opcode].clev > cpu_level
+		|| opcode_fn_postfix[rep] < 0)
+		return 0;
+	sprintf (name, "op_%04x_%d_ff", rep, opcode_fn_postfix[rep]);
+	return 1;
+}
+
+/*
+ * Hatari : generate the fused handlers for the current generic cpu and the
+ * op_fusedtbl_xx table used by build_cpufunctbl() to install them.
+ * A fused handler replaces the handler of the first opcode of some pairs.
+ * When the main loop would just fetch and run the next instruction after it
+ * (see m68k_fused_next()) and this one is the second opcode of a pair, it is
+ * run directly, skipping the dispatch of the main loop.
+ */
+static void generate_fused (void)
+{
+	char name1[40], name2[40];
+	unsigned int fused[MAX_FUSED_PAIRS];
+	int i, j, cases, nb_fused = 0;
+
+	fprintf (headerfile, "extern const struct cputbl_fused op_fusedtbl_%d[];\n", postfix);
+	printf ("#ifndef CPUEMU_68000_ONLY\n");
+	for (i = 0; i < fused_count; i++) {
+		unsigned int first = fused_pairs[i].first;
+
+		/* One handler for all the pairs with the same first opcode */
+		for (j = 0; j < i; j++) {
+			if (fused_pairs[j].first == first)
+				break;
+		}
+		if (j < i || !fused_func_name (name1, first))
+			continue;
+
+		cases = 0;
+		for (j = i; j < fused_count; j++) {
+			if (fused_pairs[j].first != first || !fused_func_name (name2, fused_pairs[j].second))
+				continue;
+			if (!cases) {
+				printf ("/* %s (fused) */\n", outopcode (first));
+				printf ("static uae_u32 REGPARAM2 op_%04x_%d_fused(uae_u32 opcode)\n{\n", first, postfix);
+				printf ("\tuae_u32 cycles = %s(opcode);\n", name1);
+				printf ("\tuae_u32 next = get_diword(0);\n");
+				printf ("\tswitch (next) {\n");
+			}
+			printf ("\tcase 0x%04x: /* %s */\n", fused_pairs[j].second, outopcode (fused_pairs[j].second));
+			printf ("\t\tif (m68k_fused_next(cycles, next))\n");
+			printf ("\t\t\treturn %s(next);\n", name2);
+			printf ("\t\tbreak;\n");
+			cases++;
+		}
+		if (cases) {
+			printf ("\t}\n\treturn cycles;\n}\n\n");
+			fused[nb_fused++] = first;
+		}
+	}
+
+	printf ("const struct cputbl_fused op_fusedtbl_%d[] = {\n", postfix);
+	for (i = 0; i < nb_fused; i++) {
+		fused_func_name (name1, fused[i]);
+		printf ("{ 0x%04x, op_%04x_%d_fused, %s },\n", fused[i], fused[i], postfix, name1);
+	}
+	printf ("{ 0, NULL, NULL }};\n");
+	printf ("#endif /* CPUEMU_68000_ONLY */\n\n");
+}
+#endif
+
 #if CPU_TESTER
 
 static void generate_cpu_test(int mode)
@@ -10210,6 +10473,9 @@ static void generate_cpu (int id, int mode)
 	need_exception_oldpc = 0;
 	using_get_word_unswapped = 0;
 	using_noflags = 0;
+#ifdef WINUAE_FOR_HATARI
+	using_lazy_flags = 0;
+#endif
 
 	if (id == 11 || id == 12) { // 11 = 68010 prefetch, 12 = 68000 prefetch
 		cpu_level = id == 11 ? 1 : 0;
@@ -10317,6 +10583,9 @@ static void generate_cpu (int id, int mode)
 		cpu_level = 5 - (id - 0); // "generic"
 		cpu_generic = true;
 		need_special_fixup = 1;
+#if defined(WINUAE_FOR_HATARI) && defined(LAZY_FLAGS_GENCPU)
+		using_lazy_flags = 1;
+#endif
 	} else if (id >= 40 && id < 46) {
 		cpu_level = 5 - (id - 40); // "generic" + direct
 		cpu_generic = true;
@@ -10364,7 +10633,15 @@ static void generate_cpu (int id, int mode)
 			fprintf(stblfile, "#ifndef CPUEMU_68000_ONLY\n");
 		fprintf(stblfile, "const struct cputbl op_smalltbl_%d%s[] = {\n", postfix, extra);
 	}
+#ifdef WINUAE_FOR_HATARI
+	memset (opcode_fn_postfix, -1, 65536 * sizeof *opcode_fn_postfix);
+#endif
 	generate_func (extra);
+#ifdef WINUAE_FOR_HATARI
+	/* Fused handlers for the generic 68020+ cpus (in cpuemu_0.c) */
+	if (id < 4 && !using_tracer)
+		generate_fused ();
+#endif
 	if (generate_stbl) {
 		if ((id > 0 && id < 6) || (id >= 20 && id < 40) || (id > 40 && id < 46) || (id > 50 && id < 56))
 			fprintf(stblfile, "#endif /* CPUEMU_68000_ONLY */\n");
@@ -10383,6 +10660,12 @@ int main(int argc, char *argv[])
 	opcode_next_clev = xmalloc (int, nr_cpuop_funcs);
 	counts = xmalloc (unsigned long, 65536);
 	read_counts();
+#ifdef WINUAE_FOR_HATARI
+	opcode_fn_postfix = xmalloc (int, 65536);
+	/* Optional file with the pairs of opcodes to fuse */
+	if (argc > 1)
+		read_fused_pairs (argv[1]);
+#endif
 
 	/* It would be a lot nicer to put all in one file (we'd also get rid of
 	* cputbl.h that way), but cpuopti can't cope.  That could be fixed, but
@@ -39,6 +39,9 @@ const char HatariGlue_fileid[] = "Hatari hatari-glue.c";
 #include "cpu_prefetch.h"
 #include "savestate.h"
 #include "hatari-glue.h"
+#ifdef JIT
+#include "jit/compemu.h"
+#endif
 
 
 struct uae_prefs currprefs, changed_prefs;
@@ -168,6 +171,9 @@ bool savestate_restore_finish (void)
 int Init680x0(void)
 {
 //fprintf ( stderr , "Init680x0 in\n" );
+#ifdef JIT
+	compiler_init();
+#endif
 	init_m68k();
 //fprintf ( stderr , "Init680x0 out\n" );
 	return true;
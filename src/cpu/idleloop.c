@@ -0,0 +1,317 @@
+/*
+  Hatari - idleloop.c
+
+  This file is distributed under the GNU General Public License, version 2
+  or at your option any later version. Read the file gpl.txt for details.
+
+  Detection of cpu idle loops, to skip them in fast forward / benchmark mode.
+
+  Many programs (and TOS) wait for an interrupt in a small polling loop
+  (waiting for the VBL counter to change, for a MFP GPIP bit, ...) or with
+  the STOP instruction. When such a loop only reads from RAM / ROM or from
+  some IO registers which can't change by themselves (see IdleLoop_IoAccess()),
+  and doesn't change any register, each iteration is the same as the previous
+  one until the next internal interrupt (cycInt) is processed.
+
+  A loop is checked when a backward branch (or an instruction jumping on
+  itself, like STOP) is taken : each iteration executing only allowed
+  instructions (no memory / IO writes), without reading a dynamic IO register
+  and without any internal interrupt being processed during it, is compared
+  with the registers at the start of the loop. When 2 such iterations in a
+  row give the same registers and take the same number of cycles, the loop
+  is idle : the cycles of as many iterations as possible before the next
+  internal interrupt are added at once, instead of running these iterations.
+  The last iteration before the interrupt is always run normally, so the
+  interrupt happens at the same cycle and in the same state as without
+  skipping.
+
+  Skipping is not done in cycle exact mode, where the cpu and the other
+  chips must be run together cycle by cycle.
+*/
+const char IdleLoop_fileid[] = "Hatari idleloop.c";
+
+#include <inttypes.h>
+
+#include "main.h"
+#include "sysconfig.h"
+#include "sysdeps.h"
+#include "configuration.h"
+#include "log.h"
+#include "events.h"
+#include "options.h"
+#include "m68000.h"
+#include "cycInt.h"
+#include "mfp.h"
+#include "blitter.h"
+#include "dsp.h"
+#include "readcpu.h"
+#include "idleloop.h"
+
+
+#define IDLELOOP_MAX_BYTES	64			/* Max size of a loop */
+#define IDLELOOP_MAX_TRIES	4			/* Max iterations with different cycles */
+#define IDLELOOP_REJECT_COUNT	256			/* Backward branches before checking a rejected loop again */
+
+enum
+{
+	IDLELOOP_NONE = 0,				/* No loop being checked */
+	IDLELOOP_CHECK
+};
+
+typedef struct
+{
+	uaecptr		start;				/* Address of the first / last instruction of the loop */
+	uaecptr		end;
+	uae_u32		regs[ 16 ];			/* Registers at the start of the loop */
+	uae_u16		sr;
+	uae_u16		ir , irc;
+	int		stopped;
+	uint64_t	clock;				/* CyclesGlobalClockCounter at the start of the iteration */
+	uint64_t	next_int;			/* CycInt_ActiveInt_Cycles at the start of the iteration */
+	int		cycles;				/* Cycles of the previous clean iteration, or 0 */
+	int		tries;
+	int		nb_insn;			/* Instructions in the current iteration */
+} IDLELOOP;
+
+
+bool		IdleLoop_Enabled;
+int		IdleLoop_State = IDLELOOP_NONE;
+bool		IdleLoop_IoDynamic;
+
+static IDLELOOP	Loop;
+static uaecptr	IdleLoop_RejectPc = 1;			/* Never a valid pc */
+static int	IdleLoop_RejectCount;
+static uint64_t	IdleLoop_SkippedCycles;
+
+
+/**
+ * Stop checking the current loop (and forget the rejected one), for
+ * example when the cpu is reset
+ */
+void IdleLoop_Reset ( void )
+{
+	if ( IdleLoop_SkippedCycles )
+		Log_Printf ( LOG_DEBUG , "Idle loops: %"PRIu64" cycles skipped\n" , IdleLoop_SkippedCycles );
+
+	IdleLoop_State = IDLELOOP_NONE;
+	IdleLoop_RejectPc = 1;
+	IdleLoop_SkippedCycles = 0;
+
+	IdleLoop_UpdateEnabled ();
+}
+
+
+/**
+ * Show how many cycles were skipped since the last reset, when Hatari exits
+ * (used by tests/cycles/idleloop_test.sh)
+ */
+void IdleLoop_UnInit ( void )
+{
+	Log_Printf ( LOG_INFO , "Idle loops: %"PRIu64" cycles skipped\n" , IdleLoop_SkippedCycles );
+}
+
+
+/**
+ * Loops are only checked in fast forward / benchmark mode, when not in
+ * cycle exact mode. As fast forward can be changed at any time (shortcut,
+ * debugger, NatFeats, ...), this is called on each VBL and on reset, so
+ * the cpu cores only need to test IdleLoop_Enabled.
+ */
+void IdleLoop_UpdateEnabled ( void )
+{
+	IdleLoop_Enabled = ConfigureParams.System.bFastForwardIdleSkip
+		&& ( ConfigureParams.System.bFastForward || BenchmarkMode )
+		&& !CpuRunCycleExact;
+
+	if ( !IdleLoop_Enabled )
+		IdleLoop_State = IDLELOOP_NONE;
+}
+
+
+/**
+ * Return true if the instruction 'opcode' can be part of an idle loop :
+ * it doesn't write to memory (only to registers and flags, which will be
+ * compared at the end of each iteration) and doesn't change the cpu mode.
+ */
+static bool IdleLoop_OpcodeAllowed ( uae_u16 opcode )
+{
+	struct instr *insn = &table68k[ opcode ];
+
+	switch ( insn->mnemo )
+	{
+	 /* No destination or read only destination */
+	 case i_TST: case i_CMP: case i_CMPA: case i_CMPM: case i_BTST:
+	 case i_Bcc: case i_DBcc: case i_JMP: case i_NOP: case i_STOP:
+		return true;
+
+	 /* Only allowed with a register destination */
+	 case i_MOVE: case i_MOVEA: case i_AND: case i_OR: case i_EOR:
+	 case i_ADD: case i_ADDA: case i_SUB: case i_SUBA: case i_NOT:
+	 case i_CLR: case i_NEG: case i_EXT: case i_SWAP: case i_EXG:
+	 case i_LEA: case i_Scc: case i_LSL: case i_LSR: case i_ASL:
+	 case i_ASR: case i_ROL: case i_ROR:
+		return !insn->duse || insn->dmode == Dreg || insn->dmode == Areg;
+
+	 default:
+		return false;
+	}
+}
+
+
+/**
+ * Save the registers and start a new iteration of the loop
+ */
+static void IdleLoop_StartIteration ( void )
+{
+	MakeSR ();
+	memcpy ( Loop.regs , regs.regs , sizeof ( Loop.regs ) );
+	Loop.sr = regs.sr;
+	Loop.ir = regs.ir;
+	Loop.irc = regs.irc;
+	Loop.stopped = regs.stopped;
+
+	Loop.clock = CyclesGlobalClockCounter;
+	Loop.next_int = CycInt_ActiveInt_Cycles;
+	Loop.nb_insn = 0;
+	IdleLoop_IoDynamic = false;
+}
+
+
+/**
+ * Return true if the registers are the same as at the start of the loop
+ */
+static bool IdleLoop_SameRegs ( void )
+{
+	MakeSR ();
+	return memcmp ( Loop.regs , regs.regs , sizeof ( Loop.regs ) ) == 0
+		&& Loop.sr == regs.sr && Loop.ir == regs.ir && Loop.irc == regs.irc
+		&& Loop.stopped == regs.stopped;
+}
+
+
+/**
+ * Don't check this loop again before some time (it changes some registers)
+ */
+static void IdleLoop_Reject ( void )
+{
+	IdleLoop_State = IDLELOOP_NONE;
+	IdleLoop_RejectPc = Loop.start;
+	IdleLoop_RejectCount = IDLELOOP_REJECT_COUNT;
+}
+
+
+/**
+ * The loop is idle : add the cycles of all its iterations before the
+ * last one preceding the next internal interrupt.
+ */
+static void IdleLoop_Skip ( void )
+{
+	int64_t remaining;
+	int64_t iterations;
+	int skip;
+
+	/* Some pending work must be done by the normal cpu loop. SPCFLAG_STOP */
+	/* only tells that the cpu is stopped, which is checked like a loop of */
+	/* one instruction (the STOP opcode is run again until an interrupt) */
+	if ( ( regs.spcflags & ~SPCFLAG_STOP ) || MFP_UpdateNeeded || WaitStateCycles
+	  || BlitterPhase )
+		return;
+
+	/* The cpu core can switch to cycle exact mode before the next VBL */
+	if ( CpuRunCycleExact )
+		return;
+
+	remaining = CycInt_CyclesBeforeNextEvent ();
+	iterations = remaining / Loop.cycles - 1;
+	if ( iterations <= 0 )
+		return;
+
+	skip = iterations * Loop.cycles;
+	M68000_AddCycles_CE ( skip );
+	do_cycles ( skip * CYCLE_UNIT / 2 );
+	regs.instruction_cnt += iterations * Loop.nb_insn;
+
+	/* Run DSP 56k code if necessary */
+	if ( bDspEnabled )
+		DSP_Run ( 2 * skip );
+
+	IdleLoop_SkippedCycles += skip;
+}
+
+
+/**
+ * The cpu just reached the start of the loop again
+ */
+static void IdleLoop_EndIteration ( void )
+{
+	int cycles = CyclesGlobalClockCounter - Loop.clock;
+
+	/* Iterations where something could have changed the result of */
+	/* the loop are not compared */
+	if ( IdleLoop_IoDynamic || CycInt_ActiveInt_Cycles != Loop.next_int )
+	{
+		IdleLoop_StartIteration ();
+		return;
+	}
+
+	if ( !IdleLoop_SameRegs () )
+	{
+		IdleLoop_Reject ();
+		return;
+	}
+
+	if ( cycles > 0 && cycles == Loop.cycles )
+	{
+		IdleLoop_Skip ();
+		Loop.tries = 0;
+	}
+	else
+	{
+		if ( ++Loop.tries > IDLELOOP_MAX_TRIES )
+		{
+			IdleLoop_Reject ();
+			return;
+		}
+		Loop.cycles = cycles;
+	}
+
+	IdleLoop_StartIteration ();
+}
+
+
+/**
+ * Called after a backward branch, or after each instruction while
+ * a loop is checked. 'pc' is the address of the next instruction.
+ */
+void IdleLoop_Update ( uaecptr pc )
+{
+	uaecptr insn_pc = regs.instruction_pc;
+
+	if ( IdleLoop_State == IDLELOOP_CHECK )
+	{
+		Loop.nb_insn++;
+		if ( insn_pc < Loop.start || insn_pc > Loop.end )
+			IdleLoop_State = IDLELOOP_NONE;		/* Exception in the previous instruction */
+		else if ( !IdleLoop_OpcodeAllowed ( regs.opcode ) )
+			IdleLoop_Reject ();
+		else if ( pc == Loop.start )
+			IdleLoop_EndIteration ();
+		else if ( pc < Loop.start || pc > Loop.end )
+			IdleLoop_State = IDLELOOP_NONE;		/* Exit from the loop or exception */
+		return;
+	}
+
+	/* Backward branch */
+	if ( insn_pc - pc > IDLELOOP_MAX_BYTES || regs.t0 || regs.t1 )
+		return;
+
+	if ( pc == IdleLoop_RejectPc && --IdleLoop_RejectCount > 0 )
+		return;
+
+	IdleLoop_State = IDLELOOP_CHECK;
+	Loop.start = pc;
+	Loop.end = insn_pc;
+	Loop.cycles = 0;
+	Loop.tries = 0;
+	IdleLoop_StartIteration ();
+}
@@ -0,0 +1,68 @@
+/*
+  Hatari - idleloop.h
+
+  This file is distributed under the GNU General Public License, version 2
+  or at your option any later version. Read the file gpl.txt for details.
+*/
+
+#ifndef HATARI_IDLELOOP_H
+#define HATARI_IDLELOOP_H
+
+#include "sysdeps.h"
+#include "newcpu.h"
+
+extern bool	IdleLoop_Enabled;
+extern int	IdleLoop_State;
+extern bool	IdleLoop_IoDynamic;
+
+extern void	IdleLoop_Reset ( void );
+extern void	IdleLoop_UnInit ( void );
+extern void	IdleLoop_UpdateEnabled ( void );
+extern void	IdleLoop_Update ( uaecptr pc );
+
+
+/**
+ * Called by the cpu cores after each instruction (and after the pending
+ * interrupts / exceptions were processed) : cheap test for the common case
+ * where no loop is being checked and the instruction was not a backward
+ * branch, nothing is done when skipping is disabled.
+ */
+static inline void IdleLoop_Check ( void )
+{
+	uaecptr pc;
+
+	if ( !IdleLoop_Enabled )
+		return;
+
+	pc = m68k_getpc ();
+	if ( IdleLoop_State || pc <= regs.instruction_pc )
+		IdleLoop_Update ( pc );
+}
+
+
+/**
+ * Called for every IO register access while a loop is checked : only reads
+ * from registers which can't change between two internal interrupts allow
+ * to skip the loop (MFP control / status registers and ACIA status)
+ */
+static inline void IdleLoop_IoAccess ( uint32_t addr , int size , bool write )
+{
+	uint32_t end;
+
+	if ( !IdleLoop_Enabled || !IdleLoop_State )
+		return;
+
+	end = addr + size - 1;
+
+	if ( write )
+		IdleLoop_IoDynamic = true;
+	else if ( ( addr >= 0xfffa00 && end <= 0xfffa17 )	/* MFP GPIP .. VR */
+	  || ( addr >= 0xfffa80 && end <= 0xfffa97 )		/* TT MFP GPIP .. VR */
+	  || ( addr == 0xfffc00 && size == 1 )			/* IKBD ACIA status */
+	  || ( addr == 0xfffc04 && size == 1 ) )		/* MIDI ACIA status */
+		return;
+	else
+		IdleLoop_IoDynamic = true;
+}
+
+#endif /* HATARI_IDLELOOP_H */
@@ -1,3 +1,5 @@
+#include "compemu_hatari.h"
+
 #if defined(CPU_arm) || defined(CPU_AARCH64) || defined(__aarch64__) || \
     defined(_M_ARM64) || defined(_M_ARM64EC)
 #include "arm/compemu_fpp_arm.cpp"
@@ -0,0 +1,35 @@
+/*
+ * Hatari - compemu_hatari.h
+ *
+ * This file is distributed under the GNU General Public License, version 2
+ * or at your option any later version. Read the file gpl.txt for details.
+ *
+ * The JIT sources are C++, while the rest of the cpu core and Hatari are
+ * compiled as C. This header is included first by the JIT wrappers to get
+ * the declarations of the C parts with C linkage ; when the JIT sources
+ * include them later, the include guards turn them into no-ops.
+ */
+
+#ifndef HATARI_JIT_COMPEMU_HATARI_H
+#define HATARI_JIT_COMPEMU_HATARI_H
+
+#include <string>
+
+extern "C" {
+#include "sysconfig.h"
+#include "sysdeps.h"
+#include "main.h"
+#include "log.h"
+#include "options_cpu.h"
+#include "events.h"
+#include "custom.h"
+#include "memory.h"
+#include "readcpu.h"
+#include "newcpu.h"
+#include "fpp.h"
+#include "debug.h"
+#include "uae/vm.h"
+#include "stMemory.h"
+}
+
+#endif /* HATARI_JIT_COMPEMU_HATARI_H */
@@ -52,9 +52,11 @@ bool check_prefs_changed_comp (bool checkonly)
 		changed = 1;
 	}
 
+#ifndef WINUAE_FOR_HATARI
 	// Turn off illegal-mem logging when using JIT...
 	if(currprefs.cachesize)
 		currprefs.illegal_mem = changed_prefs.illegal_mem;// = 0;
+#endif
 
 	if ((!canbang || !currprefs.cachesize) && currprefs.comptrustbyte != 1) {
 		// Set all of these to indirect when canbang == 0
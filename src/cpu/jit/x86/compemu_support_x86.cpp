@@ -547,7 +547,9 @@ void *jit_vm_acquire(uae_u32 size, int options)
 }
 
 #define UNUSED(x)
+#ifndef WINUAE_FOR_HATARI
 #include "uae.h"
+#endif
 #include "uae/log.h"
 #define jit_log(format, ...) \
 	write_log("JIT: " format "\n", ##__VA_ARGS__);
@@ -3210,7 +3212,15 @@ static void align_target(uae_u32 a)
 
 static inline int isinrom(uintptr addr)
 {
-#ifdef UAE
+#ifdef WINUAE_FOR_HATARI
+	/* TOS ROM at E00000-EFFFFF, cartridge and TOS ROM at FA0000-FEFFFF */
+	/* (see memory_init(), ROMmemory maps E00000-FFFFFF) */
+	if (addr >= (uintptr)ROMmemory && addr < (uintptr)ROMmemory + 0x100000)
+		return 1;
+	if (addr >= (uintptr)ROMmemory + 0x1a0000 && addr < (uintptr)ROMmemory + 0x1f0000)
+		return 1;
+	return 0;
+#elif defined(UAE)
 	if (addr >= (uintptr)kickmem_bank.baseaddr &&
 		addr < (uintptr)kickmem_bank.baseaddr + 8 * 65536) {
 		return 1;
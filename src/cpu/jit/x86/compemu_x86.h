@@ -35,6 +35,13 @@
 #include "sysconfig.h"
 #include "newcpu.h"
 
+#ifdef WINUAE_FOR_HATARI
+/* newcpu.c is compiled as C in Hatari, give the interface C linkage */
+#ifdef __cplusplus
+extern "C" {
+#endif
+#endif
+
 #ifdef UAE
 #ifdef CPU_64_BIT
 typedef uae_u64 uintptr;
@@ -52,7 +59,11 @@ typedef uae_u32 uintptr;
 
 /* Allocate memory near the JIT cache / .data segment for RIP-relative access.
  * options=0 uses anchor-based allocation; options=1 forces low 2GB (MAP_32BIT). */
+#ifdef __cplusplus
 extern void *jit_vm_acquire(uae_u32 size, int options = 0);
+#else
+extern void *jit_vm_acquire(uae_u32 size, int options);
+#endif
 
 #ifdef JIT_DEBUG
 /* dump some information (m68k block, x86 block addresses) about the compiler state */
@@ -72,16 +83,16 @@ extern uae_u32 start_pc;
 
 struct blockinfo_t;
 
-struct cpu_history {
+typedef struct cpu_history {
 	uae_u16* location;
 #ifdef UAE
 	uae_u8  specmem;
 #endif
-};
+} cpu_history;
 
 union cacheline {
 	cpuop_func *handler;
-	blockinfo_t * bi;
+	struct blockinfo_t * bi;
 };
 
 /* Use new spill/reload strategy when calling external functions */
@@ -525,12 +536,12 @@ extern void compile_block(cpu_history* pc_hist, int blocklen, int totcyles);
 #define MAXCYCLES (1000 * CYCLE_UNIT)
 #define scaled_cycles(x) (currprefs.m68k_speed<0?(((x)/SCALE)?(((x)/SCALE<MAXCYCLES?((x)/SCALE):MAXCYCLES)):1):(x))
 
-struct op_properties {
+typedef struct op_properties {
 	uae_u8 use_flags;
 	uae_u8 set_flags;
 	uae_u8 is_addx;
 	uae_u8 cflow;
-};
+} op_properties;
 extern op_properties prop[65536];
 static inline int end_block(uae_u32 opcode)
 {
@@ -574,4 +585,10 @@ void jit_abort(const char *format,...) __attribute__((format(printf, 1, 2))) __a
    32-bit pointers where it shouldn't. */
 #define uae_p32(x) ((uintptr)(x))
 
+#ifdef WINUAE_FOR_HATARI
+#ifdef __cplusplus
+}
+#endif
+#endif
+
 #endif /* COMPEMU_X86_H */
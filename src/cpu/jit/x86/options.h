@@ -0,0 +1,8 @@
+#ifndef UAE_JIT_OPTIONS_H
+#define UAE_JIT_OPTIONS_H
+
+/* The JIT sources include WinUAE's "options.h", which is named */
+/* options_cpu.h in Hatari (options.h is Hatari's command line parser) */
+#include "options_cpu.h"
+
+#endif /* UAE_JIT_OPTIONS_H */
@@ -3,6 +3,50 @@
 #include "sysdeps.h"
 #include "m68k.h"
 
+#ifdef WINUAE_FOR_HATARI
+/*
+ * Hatari : Z flag of the operation stored with SET_LAZY_FLAGS(), without
+ * computing the other flags (EQ / NE are the most frequent conditions
+ * after a compare, a test or a subtraction)
+ */
+static inline int lazy_flags_zero(void)
+{
+    uae_u32 op = regflags_lazy.op;
+    uae_u32 mask;
+
+    switch (op & 0xf0) {
+    case LAZY_FLAGS_B: mask = 0xff; break;
+    case LAZY_FLAGS_W: mask = 0xffff; break;
+    default: mask = 0xffffffff; break;
+    }
+
+    switch (op & 0x0f) {
+    case LAZY_FLAGS_ADD:
+        return ((regflags_lazy.dst + regflags_lazy.src) & mask) == 0;
+    case LAZY_FLAGS_SUB:
+    case LAZY_FLAGS_CMP:
+        return ((regflags_lazy.dst - regflags_lazy.src) & mask) == 0;
+    default:
+        return (regflags_lazy.dst & mask) == 0;
+    }
+}
+
+/*
+ * Hatari : with pending lazy flags, T / F (bra, dbra) don't read any flag
+ * and EQ / NE only need Z : the other flags stay pending.
+ */
+#define CCTRUE_LAZY_FLAGS(cc) \
+    do { \
+        if (regflags_lazy.op) { \
+            if (cc < 2) \
+                return cc == 0; \
+            if (cc == 6 || cc == 7) \
+                return lazy_flags_zero() == (cc == 7); \
+            m68k_flush_lazy_flags(); \
+        } \
+    } while (0)
+#endif
+
 /*
  * Test CCR condition
  */
@@ -11,6 +55,9 @@
 
 int cctrue(int cc)
 {
+#ifdef WINUAE_FOR_HATARI
+    CCTRUE_LAZY_FLAGS(cc);
+#endif
     uae_u32 cznv = regflags.cznv;
 
     switch (cc) {
@@ -49,6 +96,9 @@ int cctrue(int cc)
 
 int cctrue(int cc)
 {
+#ifdef WINUAE_FOR_HATARI
+    CCTRUE_LAZY_FLAGS(cc);
+#endif
     uae_u32 cznv = regflags.cznv;
 
     switch (cc) {
@@ -84,3 +134,61 @@ int cctrue(int cc)
 }
 
 #endif
+
+#ifdef WINUAE_FOR_HATARI
+
+struct lazy_flag_struct regflags_lazy;
+
+/*
+ * Hatari : compute the CZNV flags for the operation stored with SET_LAZY_FLAGS(),
+ * the same way as the code generated by genflags_normal() in gencpu.c
+ */
+void m68k_flush_lazy_flags(void)
+{
+    uae_u32 op = regflags_lazy.op;
+    uae_u32 src = regflags_lazy.src;
+    uae_u32 dst = regflags_lazy.dst;
+    uae_u32 mask, sign, res;
+    int flgs, flgo, flgn;
+
+    regflags_lazy.op = 0;
+
+    switch (op & 0xf0) {
+    case LAZY_FLAGS_B: mask = 0xff; sign = 0x80; break;
+    case LAZY_FLAGS_W: mask = 0xffff; sign = 0x8000; break;
+    default: mask = 0xffffffff; sign = 0x80000000; break;
+    }
+    src &= mask;
+    dst &= mask;
+
+    switch (op & 0x0f) {
+    case LAZY_FLAGS_LOGICAL:
+        CLEAR_CZNV();
+        SET_ZFLG(dst == 0);
+        SET_NFLG((dst & sign) != 0);
+        break;
+    case LAZY_FLAGS_ADD:
+        res = (dst + src) & mask;
+        flgs = (src & sign) != 0;
+        flgo = (dst & sign) != 0;
+        flgn = (res & sign) != 0;
+        SET_ZFLG(res == 0);
+        SET_VFLG((flgs ^ flgn) & (flgo ^ flgn));
+        SET_CFLG((~dst & mask) < src);
+        SET_NFLG(flgn);
+        break;
+    case LAZY_FLAGS_SUB:
+    case LAZY_FLAGS_CMP:
+        res = (dst - src) & mask;
+        flgs = (src & sign) != 0;
+        flgo = (dst & sign) != 0;
+        flgn = (res & sign) != 0;
+        SET_ZFLG(res == 0);
+        SET_VFLG((flgs ^ flgo) & (flgn ^ flgo));
+        SET_CFLG(src > dst);
+        SET_NFLG(flgn);
+        break;
+    }
+}
+
+#endif
@@ -126,3 +126,32 @@ extern struct flag_struct regflags;
 #define COPY_CARRY()	(regflags.x = regflags.cznv >> (FLAGBIT_C - FLAGBIT_X))
 
 #endif
+
+#ifdef WINUAE_FOR_HATARI
+/*
+ * Hatari : lazy flags for the generic cpu cores (when gencpu is built with
+ * LAZY_FLAGS_GENCPU). The most frequent instructions only store their kind
+ * of operation and their operands, the CZNV flags are computed from them by
+ * m68k_flush_lazy_flags() before they're read or partially modified.
+ * X is always set directly.
+ */
+struct lazy_flag_struct {
+    uae_u32 op;		/* LAZY_FLAGS_xxx | size, 0 if the flags are up to date */
+    uae_u32 src;
+    uae_u32 dst;	/* Result for LAZY_FLAGS_LOGICAL */
+};
+
+extern struct lazy_flag_struct regflags_lazy;
+extern void m68k_flush_lazy_flags(void);
+
+#define LAZY_FLAGS_LOGICAL	0x01
+#define LAZY_FLAGS_ADD		0x02
+#define LAZY_FLAGS_SUB		0x03
+#define LAZY_FLAGS_CMP		0x04
+#define LAZY_FLAGS_B		0x00
+#define LAZY_FLAGS_W		0x10
+#define LAZY_FLAGS_L		0x20
+
+#define SET_LAZY_FLAGS(o, s, d)	(regflags_lazy.op = (o), regflags_lazy.src = (uae_u32)(s), regflags_lazy.dst = (uae_u32)(d))
+#define FLUSH_LAZY_FLAGS()	do { if (regflags_lazy.op) m68k_flush_lazy_flags(); } while (0)
+#endif
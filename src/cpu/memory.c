@@ -29,6 +29,7 @@ const char Memory_fileid[] = "Hatari memory.c";
 #include "video.h"
 
 #include "newcpu.h"
+#include "blockcache.h"
 
 
 /* Set illegal_mem to 1 for debug output: */
@@ -73,15 +74,25 @@ static uae_u8 * REGPARAM3 STmem_xlate (uaecptr addr) REGPARAM;
 #ifdef NATMEM_OFFSET
 bool canbang;
 int candirect = -1;
+#elif defined(JIT)
+/* No direct memory access for the JIT in Hatari, everything goes through the banks */
+bool canbang;
+uae_u8 *natmem_offset;
 #endif
 
 #ifdef JIT
 /* Set by each memory handler that does not simply access real memory. */
 int special_mem, special_mem_default;
 /* do not use get_n_addr */
+#ifdef WINUAE_FOR_HATARI
+/* Hatari's banks don't map to host memory : always use the bank handlers */
+int jit_n_addr_unsafe = 1;
+int jit_n_addr_bank_unsafe = 1;
+#else
 int jit_n_addr_unsafe;
 int jit_n_addr_bank_unsafe;
 #endif
+#endif
 
 #ifdef NATMEM_OFFSET
 static bool isdirectjit (void)
@@ -133,6 +144,17 @@ case, bit 0 is set (the memory access routines will take care of it).  */
 
 uae_u8 *baseaddr[MEMORY_BANKS];
 
+#ifdef WINUAE_FOR_HATARI
+/* Hatari : for each 64 KB page, host address of the page when it's in a bank */
+/* with ABFLAG_DIRECTACCESS, else NULL. This allows get_xxx / put_xxx to access */
+/* ST RAM, TT RAM and ROM without calling the bank's functions. */
+uae_u8 *mem_direct_r[MEMORY_BANKS];
+uae_u8 *mem_direct_w[MEMORY_BANKS];
+/* 64 KB pages of the 24 bit address space which are never written directly */
+static uae_u8 mem_watch_w[ 0x100 ];
+static bool mem_watch_any;
+#endif
+
 #ifdef NO_INLINE_MEMORY_ACCESS
 __inline__ uae_u32 longget (uaecptr addr)
 {
@@ -584,6 +606,10 @@ static void REGPARAM3 STmem_lput(uaecptr addr, uae_u32 l)
 {
 	addr -= STmem_start & STmem_mask;
 	addr &= STmem_mask;
+	BlockCache_Write(addr);
+	BlockCache_Write(addr + 2);
+	Video_LineSourceWrite(addr);
+	Video_LineSourceWrite(addr + 2);
 	do_put_mem_long(STmemory + addr, l);
 }
 
@@ -591,6 +617,8 @@ static void REGPARAM3 STmem_wput(uaecptr addr, uae_u32 w)
 {
 	addr -= STmem_start & STmem_mask;
 	addr &= STmem_mask;
+	BlockCache_Write(addr);
+	Video_LineSourceWrite(addr);
 	do_put_mem_word(STmemory + addr, w);
 }
 
@@ -598,6 +626,8 @@ static void REGPARAM3 STmem_bput(uaecptr addr, uae_u32 b)
 {
 	addr -= STmem_start & STmem_mask;
 	addr &= STmem_mask;
+	BlockCache_Write(addr);
+	Video_LineSourceWrite(addr);
 	STmemory[addr] = b;
 }
 
@@ -645,7 +675,11 @@ static void REGPARAM3 STmem_lput_MMU(uaecptr addr, uae_u32 l)
 {
 	addr -= STmem_start & STmem_mask;
 	addr &= STmem_mask;
+	BlockCache_Write(addr);
+	BlockCache_Write(addr + 2);			/* blocks use logical addresses */
 	addr = STMemory_MMU_Translate_Addr ( addr );
+	Video_LineSourceWrite(addr);
+	Video_LineSourceWrite(addr + 2);
 	do_put_mem_long(STmemory + addr, l);
 }
 
@@ -653,7 +687,9 @@ static void REGPARAM3 STmem_wput_MMU(uaecptr addr, uae_u32 w)
 {
 	addr -= STmem_start & STmem_mask;
 	addr &= STmem_mask;
+	BlockCache_Write(addr);			/* blocks use logical addresses */
 	addr = STMemory_MMU_Translate_Addr ( addr );
+	Video_LineSourceWrite(addr);
 	do_put_mem_word(STmemory + addr, w);
 }
 
@@ -661,7 +697,9 @@ static void REGPARAM3 STmem_bput_MMU(uaecptr addr, uae_u32 b)
 {
 	addr -= STmem_start & STmem_mask;
 	addr &= STmem_mask;
+	BlockCache_Write(addr);			/* blocks use logical addresses */
 	addr = STMemory_MMU_Translate_Addr ( addr );
+	Video_LineSourceWrite(addr);
 	STmemory[addr] = b;
 }
 
@@ -737,6 +775,10 @@ static void REGPARAM3 SysMem_lput(uaecptr addr, uae_u32 l)
 		return;
 	}
 
+	BlockCache_Write(addr);
+	BlockCache_Write(addr + 2);
+	Video_LineSourceWrite(addr);
+	Video_LineSourceWrite(addr + 2);
 	do_put_mem_long(STmemory + addr, l);
 }
 
@@ -762,6 +804,8 @@ static void REGPARAM3 SysMem_wput(uaecptr addr, uae_u32 w)
 		}
 	}
 
+	BlockCache_Write(addr);
+	Video_LineSourceWrite(addr);
 	do_put_mem_word(STmemory + addr, w);
 }
 
@@ -778,6 +822,8 @@ static void REGPARAM3 SysMem_bput(uaecptr addr, uae_u32 b)
 		return;
 	}
 
+	BlockCache_Write(addr);
+	Video_LineSourceWrite(addr);
 	STmemory[addr] = b;
 }
 
@@ -848,7 +894,11 @@ static void REGPARAM3 SysMem_lput_MMU(uaecptr addr, uae_u32 l)
 		return;
 	}
 
+	BlockCache_Write(addr);
+	BlockCache_Write(addr + 2);			/* blocks use logical addresses */
 	addr = STMemory_MMU_Translate_Addr ( addr );
+	Video_LineSourceWrite(addr);
+	Video_LineSourceWrite(addr + 2);
 	do_put_mem_long(STmemory + addr, l);
 }
 
@@ -874,7 +924,9 @@ static void REGPARAM3 SysMem_wput_MMU(uaecptr addr, uae_u32 w)
 		}
 	}
 
+	BlockCache_Write(addr);			/* blocks use logical addresses */
 	addr = STMemory_MMU_Translate_Addr ( addr );
+	Video_LineSourceWrite(addr);
 	do_put_mem_word(STmemory + addr, w);
 }
 
@@ -891,7 +943,9 @@ static void REGPARAM3 SysMem_bput_MMU(uaecptr addr, uae_u32 b)
 		return;
 	}
 
+	BlockCache_Write(addr);			/* blocks use logical addresses */
 	addr = STMemory_MMU_Translate_Addr ( addr );
+	Video_LineSourceWrite(addr);
 	STmemory[addr] = b;
 }
 
@@ -1488,6 +1542,9 @@ static void init_mem_banks (void)
 	// unsigned so i << 16 won't overflow to negative when i >= 32768
 	for (unsigned int i = 0; i < MEMORY_BANKS; i++)
 		put_mem_bank (i << 16, &dummy_bank, 0);
+#ifdef WINUAE_FOR_HATARI
+	memory_update_direct_pages ( 0 , MEMORY_BANKS );
+#endif
 #ifdef NATMEM_OFFSET
 	delete_shmmaps (0, 0xFFFF0000);
 #endif
@@ -1506,6 +1563,80 @@ static void init_bank (addrbank *ab , uae_u32 size)
 
 
 #ifdef WINUAE_FOR_HATARI
+/*
+ * Update the direct access pointers for 'size' pages of 64 KB starting at
+ * page 'start', after these pages were mapped to a new bank or when the
+ * bank's memory changed.
+ * Only banks with ABFLAG_DIRECTACCESS can be accessed directly : RAM/ROM
+ * with no side effect (no MMU/MCU translation, no bus error, no IO)
+ * When the block cache is enabled, writes must go through the bank's
+ * functions to invalidate the cached blocks.
+ */
+void memory_update_direct_pages ( int start , int size )
+{
+	int i;
+
+	for ( i = start ; i < start + size && i < MEMORY_BANKS ; i++ )
+	{
+		addrbank *ab = mem_banks[ i ];
+		uae_u32 offset;
+
+		mem_direct_r[ i ] = NULL;
+		mem_direct_w[ i ] = NULL;
+		if ( ab == NULL || !ab->baseaddr_direct_r || ( ab->mask & 0xffff ) != 0xffff )
+			continue;
+
+		offset = ( ( (uae_u32)i << 16 ) - ab->startaccessmask ) & ab->mask;
+		mem_direct_r[ i ] = ab->baseaddr_direct_r + offset;
+		if ( ab->baseaddr_direct_w && !BlockCache_Enabled && !mem_watch_w[ i & 0xff ] )
+			mem_direct_w[ i ] = ab->baseaddr_direct_w + offset;
+	}
+}
+
+
+/*
+ * Make the writes to the 64 KB page of 'addr' (and to its mirrors) go
+ * through the bank's functions, until memory_unwatch_writes() is called.
+ * The video emulation uses this to copy the screen lines which are still
+ * read from ST RAM before they're modified (see Video_LineSourceWrite())
+ */
+void memory_watch_writes ( uaecptr addr )
+{
+	int page = bankindex ( addr & 0xffffff );
+	int i;
+
+	if ( mem_watch_w[ page ] )
+		return;
+
+	mem_watch_w[ page ] = 1;
+	mem_watch_any = true;
+	for ( i = page ; i < MEMORY_BANKS ; i += 0x100 )
+		mem_direct_w[ i ] = NULL;
+}
+
+
+/*
+ * Allow direct writes again to all the pages from memory_watch_writes()
+ */
+void memory_unwatch_writes ( void )
+{
+	int page, i;
+
+	if ( !mem_watch_any )
+		return;
+
+	mem_watch_any = false;
+	for ( page = 0 ; page < 0x100 ; page++ )
+	{
+		if ( !mem_watch_w[ page ] )
+			continue;
+		mem_watch_w[ page ] = 0;
+		for ( i = page ; i < MEMORY_BANKS ; i += 0x100 )
+			memory_update_direct_pages ( i , 1 );
+	}
+}
+
+
 /*
  * Check if an address points to a memory region that causes bus error
  * Returns true if region gives bus error
@@ -1850,6 +1981,9 @@ void memory_init(uae_u32 NewSTMemSize, uae_u32 NewTTMemSize, uae_u32 NewRomMemSt
 		}
 	}
 
+	/* Some banks were mapped before their memory was set */
+	memory_update_direct_pages ( 0 , MEMORY_BANKS );
+
 	illegal_count = 0;
 }
 
@@ -1896,6 +2030,9 @@ static void map_banks2 (addrbank *bank, int start, int size, int realsize, int q
 		old = debug_bankchange (-1);
 #endif
 	flush_icache(3); /* Sure don't want to keep any old mappings around! */
+#ifdef WINUAE_FOR_HATARI
+	BlockCache_Flush();
+#endif
 #ifdef NATMEM_OFFSET
 	if (!quick)
 		delete_shmmaps (start << 16, size << 16);
@@ -1938,6 +2075,8 @@ static void map_banks2 (addrbank *bank, int start, int size, int realsize, int q
 #ifndef WINUAE_FOR_HATARI
 		if (quick <= 0)
 			debug_bankchange (old);
+#else
+		memory_update_direct_pages (start, size);
 #endif
 		return;
 	}
@@ -1966,6 +2105,9 @@ static void map_banks2 (addrbank *bank, int start, int size, int realsize, int q
 //printf ( "ce copy %x %x\n" , ce_banktype[ (bnr + hioffs) ] , ce_cachable[ (bnr + hioffs) ] );
 			real_left--;
 		}
+#ifdef WINUAE_FOR_HATARI
+		memory_update_direct_pages (start + hioffs, size);
+#endif
 	}
 #ifndef WINUAE_FOR_HATARI
 	if (quick <= 0)
@@ -2020,6 +2162,14 @@ void memory_clear (void)
 
 uae_u32 memory_get_longi(uaecptr addr)
 {
+#ifdef WINUAE_FOR_HATARI
+	uae_u8 *m = memory_direct_r(addr);
+	if (m) {
+		m += addr & 0xffff;
+		return do_get_mem_long((uae_u32 *)m);
+	}
+	return call_mem_get_func(get_mem_bank(addr).lgeti, addr);
+#else
 	addrbank *ab = &get_mem_bank(addr);
 	if (!ab->baseaddr_direct_r) {
 		return call_mem_get_func(ab->lgeti, addr);
@@ -2030,9 +2180,18 @@ uae_u32 memory_get_longi(uaecptr addr)
 		m = ab->baseaddr_direct_r + addr;
 		return do_get_mem_long((uae_u32 *)m);
 	}
+#endif
 }
 uae_u32 memory_get_wordi(uaecptr addr)
 {
+#ifdef WINUAE_FOR_HATARI
+	uae_u8 *m = memory_direct_r(addr);
+	if (m) {
+		m += addr & 0xffff;
+		return do_get_mem_word((uae_u16*)m);
+	}
+	return call_mem_get_func(get_mem_bank(addr).wgeti, addr);
+#else
 	addrbank *ab = &get_mem_bank(addr);
 	if (!ab->baseaddr_direct_r) {
 		return call_mem_get_func(ab->wgeti, addr);
@@ -2043,9 +2202,18 @@ uae_u32 memory_get_wordi(uaecptr addr)
 		m = ab->baseaddr_direct_r + addr;
 		return do_get_mem_word((uae_u16*)m);
 	}
+#endif
 }
 uae_u32 memory_get_long(uaecptr addr)
 {
+#ifdef WINUAE_FOR_HATARI
+	uae_u8 *m = memory_direct_r(addr);
+	if (m) {
+		m += addr & 0xffff;
+		return do_get_mem_long((uae_u32*)m);
+	}
+	return call_mem_get_func(get_mem_bank(addr).lget, addr);
+#else
 	addrbank *ab = &get_mem_bank(addr);
 	if (!ab->baseaddr_direct_r) {
 		return call_mem_get_func(ab->lget, addr);
@@ -2056,9 +2224,18 @@ uae_u32 memory_get_long(uaecptr addr)
 		m = ab->baseaddr_direct_r + addr;
 		return do_get_mem_long((uae_u32*)m);
 	}
+#endif
 }
 uae_u32 memory_get_word(uaecptr addr)
 {
+#ifdef WINUAE_FOR_HATARI
+	uae_u8 *m = memory_direct_r(addr);
+	if (m) {
+		m += addr & 0xffff;
+		return do_get_mem_word((uae_u16*)m);
+	}
+	return call_mem_get_func(get_mem_bank(addr).wget, addr);
+#else
 	addrbank *ab = &get_mem_bank(addr);
 	if (!ab->baseaddr_direct_r) {
 		return call_mem_get_func(ab->wget, addr);
@@ -2069,9 +2246,18 @@ uae_u32 memory_get_word(uaecptr addr)
 		m = ab->baseaddr_direct_r + addr;
 		return do_get_mem_word((uae_u16*)m);
 	}
+#endif
 }
 uae_u32 memory_get_byte(uaecptr addr)
 {
+#ifdef WINUAE_FOR_HATARI
+	uae_u8 *m = memory_direct_r(addr);
+	if (m) {
+		m += addr & 0xffff;
+		return *m;
+	}
+	return call_mem_get_func(get_mem_bank(addr).bget, addr);
+#else
 	addrbank *ab = &get_mem_bank(addr);
 	if (!ab->baseaddr_direct_r) {
 		return call_mem_get_func(ab->bget, addr);
@@ -2082,10 +2268,20 @@ uae_u32 memory_get_byte(uaecptr addr)
 		m = ab->baseaddr_direct_r + addr;
 		return *m;
 	}
+#endif
 }
 
 void memory_put_long(uaecptr addr, uae_u32 v)
 {
+#ifdef WINUAE_FOR_HATARI
+	uae_u8 *m = memory_direct_w(addr);
+	if (m) {
+		m += addr & 0xffff;
+		do_put_mem_long((uae_u32*)m, v);
+		return;
+	}
+	call_mem_put_func(get_mem_bank(addr).lput, addr, v);
+#else
 	addrbank *ab = &get_mem_bank(addr);
 	if (!ab->baseaddr_direct_w) {
 		call_mem_put_func(ab->lput, addr, v);
@@ -2096,9 +2292,19 @@ void memory_put_long(uaecptr addr, uae_u32 v)
 		m = ab->baseaddr_direct_w + addr;
 		do_put_mem_long((uae_u32*)m, v);
 	}
+#endif
 }
 void memory_put_word(uaecptr addr, uae_u32 v)
 {
+#ifdef WINUAE_FOR_HATARI
+	uae_u8 *m = memory_direct_w(addr);
+	if (m) {
+		m += addr & 0xffff;
+		do_put_mem_word((uae_u16*)m, v);
+		return;
+	}
+	call_mem_put_func(get_mem_bank(addr).wput, addr, v);
+#else
 	addrbank *ab = &get_mem_bank(addr);
 	if (!ab->baseaddr_direct_w) {
 		call_mem_put_func(ab->wput, addr, v);
@@ -2109,9 +2315,19 @@ void memory_put_word(uaecptr addr, uae_u32 v)
 		m = ab->baseaddr_direct_w + addr;
 		do_put_mem_word((uae_u16*)m, v);
 	}
+#endif
 }
 void memory_put_byte(uaecptr addr, uae_u32 v)
 {
+#ifdef WINUAE_FOR_HATARI
+	uae_u8 *m = memory_direct_w(addr);
+	if (m) {
+		m += addr & 0xffff;
+		*m = (uae_u8)v;
+		return;
+	}
+	call_mem_put_func(get_mem_bank(addr).bput, addr, v);
+#else
 	addrbank *ab = &get_mem_bank(addr);
 	if (!ab->baseaddr_direct_w) {
 		call_mem_put_func(ab->bput, addr, v);
@@ -2122,6 +2338,7 @@ void memory_put_byte(uaecptr addr, uae_u32 v)
 		m = ab->baseaddr_direct_w + addr;
 		*m = (uae_u8)v;
 	}
+#endif
 }
 
 uae_u8 *memory_get_real_address(uaecptr addr)
@@ -521,6 +521,16 @@ extern addrbank *get_mem_bank_real(uaecptr);
 extern bool memory_region_bus_error ( uaecptr addr );
 extern bool memory_region_iomem ( uaecptr addr );
 extern void memory_map_Standard_RAM ( uint32_t MMU_Bank0_Size , uint32_t MMU_Bank1_Size );
+
+/* Host address of each 64 KB page of RAM/ROM that can be accessed directly */
+/* (NULL if the page must be accessed with the bank's functions) */
+extern uae_u8 *mem_direct_r[MEMORY_BANKS];
+extern uae_u8 *mem_direct_w[MEMORY_BANKS];
+extern void memory_update_direct_pages ( int start , int size );
+extern void memory_watch_writes ( uaecptr addr );
+extern void memory_unwatch_writes ( void );
+#define memory_direct_r(addr) mem_direct_r[bankindex(addr)]
+#define memory_direct_w(addr) mem_direct_w[bankindex(addr)]
 #endif
 extern void memory_init(uae_u32 NewSTMemSize, uae_u32 NewTTMemSize, uae_u32 NewRomMemStart);
 extern void memory_uninit (void);
@@ -558,22 +568,47 @@ uae_u32 memory_get_wordi(uaecptr);
 
 STATIC_INLINE uae_u32 get_long(uaecptr addr)
 {
+#ifdef WINUAE_FOR_HATARI
+	uae_u8 *m = memory_direct_r(addr);
+	if (m)
+		return do_get_mem_long((uae_u32 *)(m + (addr & 0xffff)));
+#endif
 	return memory_get_long(addr);
 }
 STATIC_INLINE uae_u32 get_word (uaecptr addr)
 {
+#ifdef WINUAE_FOR_HATARI
+	uae_u8 *m = memory_direct_r(addr);
+	if (m)
+		return do_get_mem_word((uae_u16 *)(m + (addr & 0xffff)));
+#endif
 	return memory_get_word(addr);
 }
 STATIC_INLINE uae_u32 get_byte (uaecptr addr)
 {
+#ifdef WINUAE_FOR_HATARI
+	uae_u8 *m = memory_direct_r(addr);
+	if (m)
+		return m[addr & 0xffff];
+#endif
 	return memory_get_byte(addr);
 }
 STATIC_INLINE uae_u32 get_longi(uaecptr addr)
 {
+#ifdef WINUAE_FOR_HATARI
+	uae_u8 *m = memory_direct_r(addr);
+	if (m)
+		return do_get_mem_long((uae_u32 *)(m + (addr & 0xffff)));
+#endif
 	return memory_get_longi(addr);
 }
 STATIC_INLINE uae_u32 get_wordi(uaecptr addr)
 {
+#ifdef WINUAE_FOR_HATARI
+	uae_u8 *m = memory_direct_r(addr);
+	if (m)
+		return do_get_mem_word((uae_u16 *)(m + (addr & 0xffff)));
+#endif
 	return memory_get_wordi(addr);
 }
 
@@ -705,14 +740,35 @@ void memory_put_byte(uaecptr, uae_u32);
 
 STATIC_INLINE void put_long (uaecptr addr, uae_u32 l)
 {
+#ifdef WINUAE_FOR_HATARI
+	uae_u8 *m = memory_direct_w(addr);
+	if (m) {
+		do_put_mem_long((uae_u32 *)(m + (addr & 0xffff)), l);
+		return;
+	}
+#endif
 	memory_put_long(addr, l);
 }
 STATIC_INLINE void put_word (uaecptr addr, uae_u32 w)
 {
+#ifdef WINUAE_FOR_HATARI
+	uae_u8 *m = memory_direct_w(addr);
+	if (m) {
+		do_put_mem_word((uae_u16 *)(m + (addr & 0xffff)), w);
+		return;
+	}
+#endif
 	memory_put_word(addr, w);
 }
 STATIC_INLINE void put_byte (uaecptr addr, uae_u32 b)
 {
+#ifdef WINUAE_FOR_HATARI
+	uae_u8 *m = memory_direct_w(addr);
+	if (m) {
+		m[addr & 0xffff] = (uae_u8)b;
+		return;
+	}
+#endif
 	memory_put_byte(addr, b);
 }
 
@@ -62,6 +62,8 @@
 #include "stMemory.h"
 #include "blitter.h"
 #include "scc.h"
+#include "blockcache.h"
+#include "idleloop.h"
 #endif
 
 
@@ -1976,6 +1978,14 @@ static const struct cputbl *cputbls[6][8] =
 	{ op_smalltbl_0, op_smalltbl_40, op_smalltbl_50, op_smalltbl_24, op_smalltbl_24, op_smalltbl_33, op_smalltbl_33, op_smalltbl_33 }
 };
 
+#if defined(WINUAE_FOR_HATARI) && !defined(CPUEMU_68000_ONLY)
+/* Hatari : fused handlers for the generic 68020/68030/68040/68060 cpus */
+static const struct cputbl_fused *fusedtbls[4] =
+{
+	op_fusedtbl_3, op_fusedtbl_2, op_fusedtbl_1, op_fusedtbl_0
+};
+#endif
+
 #ifdef JIT
 
 const struct cputbl *uaegetjitcputbl(void)
@@ -2124,6 +2134,19 @@ static void build_cpufunctbl (void)
 
 	}
 
+#if defined(WINUAE_FOR_HATARI) && !defined(CPUEMU_68000_ONLY)
+	/* Hatari : replace the handlers of the first opcode of frequent pairs */
+	/* by the fused handlers, only for the generic 68020+ cpus (m68k_run_2_020) */
+	if (mode == 0 && lvl >= 2) {
+		const struct cputbl_fused *ftbl = fusedtbls[lvl - 2];
+		for (i = 0; ftbl[i].handler_fused != NULL; i++) {
+			opcode = ftbl[i].opcode;
+			if (cpufunctbl[opcode] == ftbl[i].handler_ff)
+				cpufunctbl[opcode] = ftbl[i].handler_fused;
+		}
+	}
+#endif
+
 	need_opcode_swap = 0;
 #ifdef HAVE_GET_WORD_UNSWAPPED
 	if (jit) {
@@ -2334,6 +2357,9 @@ static void prefs_changed_cpu (void)
 		}
 	}
 	currprefs.mmu_ec = changed_prefs.mmu_ec;
+#ifdef WINUAE_FOR_HATARI
+	currprefs.mmu_host_atc = changed_prefs.mmu_host_atc;
+#endif
 	if (currprefs.cpu_compatible != changed_prefs.cpu_compatible) {
 		currprefs.cpu_compatible = changed_prefs.cpu_compatible;
 		flush_cpu_caches(true);
@@ -2366,6 +2392,7 @@ static int check_prefs_changed_cpu2(void)
 		|| currprefs.fpu_revision != changed_prefs.fpu_revision
 		|| currprefs.mmu_model != changed_prefs.mmu_model
 		|| currprefs.mmu_ec != changed_prefs.mmu_ec
+		|| currprefs.mmu_host_atc != changed_prefs.mmu_host_atc  /* WINUAE_FOR_HATARI */
 		|| currprefs.cpu_data_cache != changed_prefs.cpu_data_cache
 		|| currprefs.address_space_24 != changed_prefs.address_space_24  /* WINUAE_FOR_HATARI */
 		|| currprefs.int_no_unimplemented != changed_prefs.int_no_unimplemented
@@ -2546,6 +2573,9 @@ void checkint(void)
 
 void REGPARAM2 MakeSR(void)
 {
+#ifdef WINUAE_FOR_HATARI
+	FLUSH_LAZY_FLAGS();
+#endif
 	regs.sr = ((regs.t1 << 15) | (regs.t0 << 14)
 		| (regs.s << 13) | (regs.m << 12) | (regs.intmask << 8)
 		| (GET_XFLG() << 4) | (GET_NFLG() << 3)
@@ -2555,6 +2585,9 @@ void REGPARAM2 MakeSR(void)
 
 static void SetSR(uae_u16 sr)
 {
+#ifdef WINUAE_FOR_HATARI
+	FLUSH_LAZY_FLAGS();
+#endif
 	regs.sr &= 0xff00;
 	regs.sr |= sr;
 
@@ -2572,6 +2605,9 @@ static void MakeFromSR_x(int t0trace)
 	int oldt0 = regs.t0;
 	int oldt1 = regs.t1;
 
+#ifdef WINUAE_FOR_HATARI
+	FLUSH_LAZY_FLAGS();
+#endif
 	SET_XFLG((regs.sr >> 4) & 1);
 	SET_NFLG((regs.sr >> 3) & 1);
 	SET_ZFLG((regs.sr >> 2) & 1);
@@ -2927,7 +2963,7 @@ static int iack_cycle(int nr)
 			if (cycle_exact)
 			{
 				/* In CE mode, the cycles before reaching IACK are already counted, no need to call x_do_cycles() */
-				/* Flush all CE cycles so far to update PendingInterruptCount */
+				/* Flush all CE cycles so far to update CyclesGlobalClockCounter */
 				M68000_AddCycles_CE ( currcycle * 2 / CYCLE_UNIT );
 				currcycle=0;
 			}
@@ -2987,7 +3023,7 @@ static int iack_cycle(int nr)
 		if (cycle_exact)
 		{
 			x_do_cycles ( e_cycles * cpucycleunit );
-			/* Flush all CE cycles so far to update PendingInterruptCount */
+			/* Flush all CE cycles so far to update CyclesGlobalClockCounter */
 			M68000_AddCycles_CE ( currcycle * 2 / CYCLE_UNIT );
 			currcycle = 0;
 		}
@@ -3980,6 +4016,9 @@ static void maybe_disable_fpu(void)
 
 static void m68k_reset_sr(void)
 {
+#ifdef WINUAE_FOR_HATARI
+	FLUSH_LAZY_FLAGS();
+#endif
 	SET_XFLG ((regs.sr >> 4) & 1);
 	SET_NFLG ((regs.sr >> 3) & 1);
 	SET_ZFLG ((regs.sr >> 2) & 1);
@@ -4049,6 +4088,9 @@ static void m68k_reset2(bool hardreset)
 	regs.stopped = 0;
 	regs.t1 = 0;
 	regs.t0 = 0;
+#ifdef WINUAE_FOR_HATARI
+	FLUSH_LAZY_FLAGS();
+#endif
 	SET_ZFLG(0);
 	SET_XFLG(0);
 	SET_CFLG(0);
@@ -5499,7 +5541,7 @@ static void m68k_run_1 (void)
 				/* We must check for pending interrupt and call do_specialties() only */
 				/* if the cpu is not in the STOP state. Else, the int could be acknowledged now */
 				/* and prevent exiting the STOP state when calling do_specialties() after. */
-				/* For performance, we first test PendingInterruptCount, then regs.spcflags */
+				/* For performance, we first test CycInt_NextEventClock, then regs.spcflags */
 				CycInt_Process_stop(regs.spcflags & SPCFLAG_STOP);
 				if ( MFP_UpdateNeeded == true )
 					MFP_UpdateIRQ_All ( 0 );
@@ -5512,6 +5554,9 @@ static void m68k_run_1 (void)
 				regs.ipl[0] = regs.ipl_pin;
 
 #ifdef WINUAE_FOR_HATARI
+				/* Skip the idle loops in fast forward mode */
+				IdleLoop_Check();
+
 				if ( savestate_state == STATE_SAVE )
 					save_state ( NULL , NULL );
 #endif
@@ -5661,7 +5706,7 @@ static void m68k_run_1_ce (void)
 				wait_memory_cycles();			// TODO NP : ici, ou plus bas ?
 #ifdef WINUAE_FOR_HATARI
 //fprintf ( stderr, "cyc_1ce %d\n" , currcycle );
-				/* Flush all CE cycles so far to update PendingInterruptCount */
+				/* Flush all CE cycles so far to update CyclesGlobalClockCounter */
 				M68000_AddCycles_CE ( currcycle * 2 / CYCLE_UNIT );
 				currcycle = 0;
 
@@ -5694,6 +5739,9 @@ cont:
 				regs.ipl[1] = 0;
 
 #ifdef WINUAE_FOR_HATARI
+				/* Skip the idle loops in fast forward mode */
+				IdleLoop_Check();
+
 				if ( savestate_state == STATE_SAVE )
 					save_state ( NULL , NULL );
 #endif
@@ -6033,6 +6081,54 @@ static void custom_reset_cpu(bool hardreset, bool keyboardreset)
 
 #ifdef JIT  /* Completely different run_2 replacement */
 
+/* Cycles left before the compiled code must return to m68k_run_jit() */
+int countdown;
+
+#ifdef WINUAE_FOR_HATARI
+/* Don't run the compiled code for more than this number of cpu cycles */
+#define JIT_MAX_SLICE_CYCLES	20000
+
+static int jit_countdown_start;
+
+/*
+ * The compiled blocks and the JIT's own interpreter loops (execute_normal,
+ * exec_nostats) decrement 'countdown' (in CYCLE_UNIT) and return to
+ * m68k_run_jit() once it becomes negative. Convert the elapsed cycles to
+ * Hatari's cycles, process the internal interrupts that are due and reload
+ * 'countdown' with the number of cycles until the next one.
+ */
+static void m68k_jit_do_cycles_hatari(void)
+{
+	int cycles = ( jit_countdown_start - countdown ) * 2 / CYCLE_UNIT;
+	int64_t next;
+
+	if (cycles > 0) {
+		M68000_AddCycles(cycles);
+
+		if ( WaitStateCycles ) {
+			M68000_AddCycles(WaitStateCycles);
+			WaitStateCycles = 0;
+		}
+
+		CycInt_Process_stop(regs.spcflags & SPCFLAG_STOP);
+		if ( MFP_UpdateNeeded == true )
+			MFP_UpdateIRQ_All ( 0 );
+
+		/* Run DSP 56k code if necessary */
+		if (bDspEnabled)
+			DSP_Run(2 * cycles);
+	}
+
+	next = CycInt_CyclesBeforeNextEvent();
+	if (next < 4)
+		next = 4;
+	else if (next > JIT_MAX_SLICE_CYCLES)
+		next = JIT_MAX_SLICE_CYCLES;
+
+	countdown = jit_countdown_start = (int)next * CYCLE_UNIT / 2;
+}
+#endif
+
 #ifdef CPU_AARCH64
 void execute_exception(uae_u32 cycles)
 {
@@ -6085,6 +6181,9 @@ void exec_nostats (void)
 
 		if (!currprefs.cpu_thread) {
 			do_cycles(cpu_cycles);
+#ifdef WINUAE_FOR_HATARI
+			countdown -= cpu_cycles;
+#endif
 
 #ifdef WITH_PPC
 			if (ppc_state)
@@ -6137,6 +6236,9 @@ void execute_normal(void)
 //		cpu_cycles = adjust_cycles(cpu_cycles);
 		if (!currprefs.cpu_thread) {
 			do_cycles(cpu_cycles);
+#ifdef WINUAE_FOR_HATARI
+			countdown -= cpu_cycles;
+#endif
 		}
 		total_cycles += cpu_cycles;
 
@@ -6234,6 +6336,11 @@ static void m68k_run_jit(void)
 		}
 	}
 
+#ifdef WINUAE_FOR_HATARI
+	jit_countdown_start = countdown;
+	m68k_jit_do_cycles_hatari();
+#endif
+
 	for (;;) {
 #ifdef USE_STRUCTURED_EXCEPTION_HANDLING
 		__try {
@@ -6258,8 +6365,12 @@ static void m68k_run_jit(void)
 #endif
 
 				((compiled_handler*)(pushall_call_handler))();
+#ifdef WINUAE_FOR_HATARI
+				m68k_jit_do_cycles_hatari();
+#else
 				/* Whenever we return from that, we should check spcflags */
 				check_uae_int_request();
+#endif
 				if (regs.spcflags) {
 #if defined(JIT_HAS_BUS_ERROR_RECOVERY)
 					jit_in_compiled_code = false;
@@ -6287,6 +6398,10 @@ static void m68k_run_jit(void)
 						(*cpufunctbl[r->opcode])(r->opcode);
 						count_instr(r->opcode);
 						do_cycles(4 * CYCLE_UNIT);
+#ifdef WINUAE_FOR_HATARI
+						countdown -= 4 * CYCLE_UNIT;
+						m68k_jit_do_cycles_hatari();
+#endif
 						if (r->spcflags) {
 							if (do_specialties(cpu_cycles))
 								exit = true;
@@ -6545,7 +6660,7 @@ static void m68k_run_mmu040 (void)
 				/* We must check for pending interrupt and call do_specialties() only */
 				/* if the cpu is not in the STOP state. Else, the int could be acknowledged now */
 				/* and prevent exiting the STOP state when calling do_specialties() after. */
-				/* For performance, we first test PendingInterruptCount, then regs.spcflags */
+				/* For performance, we first test CycInt_NextEventClock, then regs.spcflags */
 				CycInt_Process_stop(regs.spcflags & SPCFLAG_STOP);
 				if ( MFP_UpdateNeeded == true )
 					MFP_UpdateIRQ_All ( 0 );
@@ -6711,7 +6826,7 @@ insretry:
 					/* We must check for pending interrupt and call do_specialties() only */
 					/* if the cpu is not in the STOP state. Else, the int could be acknowledged now */
 					/* and prevent exiting the STOP state when calling do_specialties() after. */
-					/* For performance, we first test PendingInterruptCount, then regs.spcflags */
+					/* For performance, we first test CycInt_NextEventClock, then regs.spcflags */
 					CycInt_Process_stop(regs.spcflags & SPCFLAG_STOP);
 					if ( MFP_UpdateNeeded == true )
 						MFP_UpdateIRQ_All ( 0 );
@@ -6734,7 +6849,7 @@ insretry:
 
 #ifdef WINUAE_FOR_HATARI
 //fprintf ( stderr, "cyc_2ce %d\n" , currcycle );
-					/* Flush all CE cycles so far to update PendingInterruptCount */
+					/* Flush all CE cycles so far to update CyclesGlobalClockCounter */
 					M68000_AddCycles_CE ( currcycle * 2 / CYCLE_UNIT );
 					int dsp_cycles = 2 * currcycle * 2 / CYCLE_UNIT;	// FIXME : remove this when using DSP_CyclesGlobalClockCounter in DSP_Run
 					currcycle = 0;
@@ -6743,7 +6858,7 @@ insretry:
 					/* We must check for pending interrupt and call do_specialties() only */
 					/* if the cpu is not in the STOP state. Else, the int could be acknowledged now */
 					/* and prevent exiting the STOP state when calling do_specialties() after. */
-					/* For performance, we first test PendingInterruptCount, then regs.spcflags */
+					/* For performance, we first test CycInt_NextEventClock, then regs.spcflags */
 					CycInt_Process_stop(regs.spcflags & SPCFLAG_STOP);
 					if ( MFP_UpdateNeeded == true )
 						MFP_UpdateIRQ_All ( 0 );
@@ -6850,7 +6965,7 @@ static void m68k_run_3ce (void)
 
 #ifdef WINUAE_FOR_HATARI
 //fprintf ( stderr, "cyc_3ce %ld\n" , currcycle );
-				/* Flush all CE cycles so far to update PendingInterruptCount */
+				/* Flush all CE cycles so far to update CyclesGlobalClockCounter */
 				M68000_AddCycles_CE ( currcycle * 2 / CYCLE_UNIT );
 				int dsp_cycles = 2 * currcycle * 2 / CYCLE_UNIT;	// FIXME : remove this when using DSP_CyclesGlobalClockCounter in DSP_Run
 				currcycle = 0;
@@ -6859,7 +6974,7 @@ static void m68k_run_3ce (void)
 				/* We must check for pending interrupt and call do_specialties() only */
 				/* if the cpu is not in the STOP state. Else, the int could be acknowledged now */
 				/* and prevent exiting the STOP state when calling do_specialties() after. */
-				/* For performance, we first test PendingInterruptCount, then regs.spcflags */
+				/* For performance, we first test CycInt_NextEventClock, then regs.spcflags */
 				CycInt_Process_stop(regs.spcflags & SPCFLAG_STOP);
 				if ( MFP_UpdateNeeded == true )
 					MFP_UpdateIRQ_All ( 0 );
@@ -6891,6 +7006,9 @@ static void m68k_run_3ce (void)
 //					DSP_Run ( DSP_CPU_FREQ_RATIO * ( CyclesGlobalClockCounter - DSP_CyclesGlobalClockCounter ) );
 				}
 
+				/* Skip the idle loops in fast forward mode */
+				IdleLoop_Check();
+
 				if ( savestate_state == STATE_SAVE )
 					save_state ( NULL , NULL );
 #endif
@@ -6966,7 +7084,7 @@ static void m68k_run_3p(void)
 				/* We must check for pending interrupt and call do_specialties() only */
 				/* if the cpu is not in the STOP state. Else, the int could be acknowledged now */
 				/* and prevent exiting the STOP state when calling do_specialties() after. */
-				/* For performance, we first test PendingInterruptCount, then regs.spcflags */
+				/* For performance, we first test CycInt_NextEventClock, then regs.spcflags */
 				CycInt_Process_stop(regs.spcflags & SPCFLAG_STOP);
 				if ( MFP_UpdateNeeded == true )
 					MFP_UpdateIRQ_All ( 0 );
@@ -6984,6 +7102,9 @@ static void m68k_run_3p(void)
 //					DSP_Run ( DSP_CPU_FREQ_RATIO * ( CyclesGlobalClockCounter - DSP_CyclesGlobalClockCounter ) );
 				}
 
+				/* Skip the idle loops in fast forward mode */
+				IdleLoop_Check();
+
 				if ( savestate_state == STATE_SAVE )
 					save_state ( NULL , NULL );
 #endif
@@ -7151,7 +7272,7 @@ fprintf ( stderr , "cache valid %d tag1 %x lws1 %x ctag %x data %x mem=%x\n" , c
 
 #ifdef WINUAE_FOR_HATARI
 //fprintf ( stderr, "cyc_2ce %d\n" , currcycle );
-				/* Flush all CE cycles so far to update PendingInterruptCount */
+				/* Flush all CE cycles so far to update CyclesGlobalClockCounter */
 				M68000_AddCycles_CE ( currcycle * 2 / CYCLE_UNIT );
 				int dsp_cycles = 2 * currcycle * 2 / CYCLE_UNIT;	// FIXME : remove this when using DSP_CyclesGlobalClockCounter in DSP_Run
 				currcycle = 0;
@@ -7160,7 +7281,7 @@ fprintf ( stderr , "cache valid %d tag1 %x lws1 %x ctag %x data %x mem=%x\n" , c
 				/* We must check for pending interrupt and call do_specialties() only */
 				/* if the cpu is not in the STOP state. Else, the int could be acknowledged now */
 				/* and prevent exiting the STOP state when calling do_specialties() after. */
-				/* For performance, we first test PendingInterruptCount, then regs.spcflags */
+				/* For performance, we first test CycInt_NextEventClock, then regs.spcflags */
 				CycInt_Process_stop(regs.spcflags & SPCFLAG_STOP);
 				if ( MFP_UpdateNeeded == true )
 					MFP_UpdateIRQ_All ( 0 );
@@ -7182,6 +7303,9 @@ fprintf ( stderr , "cache valid %d tag1 %x lws1 %x ctag %x data %x mem=%x\n" , c
 //					DSP_Run ( DSP_CPU_FREQ_RATIO * ( CyclesGlobalClockCounter - DSP_CyclesGlobalClockCounter ) );
 				}
 
+				/* Skip the idle loops in fast forward mode */
+				IdleLoop_Check();
+
 				if ( savestate_state == STATE_SAVE )
 					save_state ( NULL , NULL );
 #endif
@@ -7356,7 +7480,7 @@ cont:
 				/* We must check for pending interrupt and call do_specialties() only */
 				/* if the cpu is not in the STOP state. Else, the int could be acknowledged now */
 				/* and prevent exiting the STOP state when calling do_specialties() after. */
-				/* For performance, we first test PendingInterruptCount, then regs.spcflags */
+				/* For performance, we first test CycInt_NextEventClock, then regs.spcflags */
 				CycInt_Process_stop(regs.spcflags & SPCFLAG_STOP);
 				if ( MFP_UpdateNeeded == true )
 					MFP_UpdateIRQ_All ( 0 );
@@ -7377,6 +7501,9 @@ cont:
 //					DSP_Run ( DSP_CPU_FREQ_RATIO * ( CyclesGlobalClockCounter - DSP_CyclesGlobalClockCounter ) );
 				}
 
+				/* Skip the idle loops in fast forward mode */
+				IdleLoop_Check();
+
 				if ( savestate_state == STATE_SAVE )
 					save_state ( NULL , NULL );
 #endif
@@ -7437,10 +7564,14 @@ static void m68k_run_2_000(void)
 {
 	struct regstruct *r = &regs;
 	bool exit = false;
-
 #ifdef WINUAE_FOR_HATARI
-	Log_Printf(LOG_DEBUG, "m68k_run_2_000\n");
+	cpuop_func *func;
+	bool blockcache = BlockCache_Enabled;
+
+	Log_Printf(LOG_DEBUG, "m68k_run_2_000 blockcache=%d\n", blockcache);
 	CpuRunFuncNoret = false;
+	if (blockcache)
+		BlockCache_Init();
 #endif
 
 	while (!exit) {
@@ -7456,7 +7587,17 @@ static void m68k_run_2_000(void)
 #endif
 				r->instruction_pc = m68k_getpc ();
 
+#ifdef WINUAE_FOR_HATARI
+				/* Use the pre-decoded opcode/handler if available */
+				if (blockcache) {
+					func = BlockCache_Fetch(r->instruction_pc);
+				} else {
+					r->opcode = x_get_iword(0);
+					func = cpufunctbl[r->opcode];
+				}
+#else
 				r->opcode = x_get_iword(0);
+#endif
 				count_instr (r->opcode);
 
 #ifndef WINUAE_FOR_HATARI
@@ -7467,7 +7608,11 @@ static void m68k_run_2_000(void)
 #endif
 #endif
 
+#ifdef WINUAE_FOR_HATARI
+				cpu_cycles = (*func)(r->opcode) & 0xffff;
+#else
 				cpu_cycles = (*cpufunctbl[r->opcode])(r->opcode) & 0xffff;
+#endif
 				cpu_cycles = adjust_cycles (cpu_cycles);
 				do_cycles(cpu_cycles);
 #ifdef WINUAE_FOR_HATARI
@@ -7484,7 +7629,7 @@ static void m68k_run_2_000(void)
 				/* We must check for pending interrupt and call do_specialties() only */
 				/* if the cpu is not in the STOP state. Else, the int could be acknowledged now */
 				/* and prevent exiting the STOP state when calling do_specialties() after. */
-				/* For performance, we first test PendingInterruptCount, then regs.spcflags */
+				/* For performance, we first test CycInt_NextEventClock, then regs.spcflags */
 				CycInt_Process_stop(regs.spcflags & SPCFLAG_STOP);
 				if ( MFP_UpdateNeeded == true )
 					MFP_UpdateIRQ_All ( 0 );
@@ -7502,6 +7647,9 @@ static void m68k_run_2_000(void)
 //					DSP_Run ( DSP_CPU_FREQ_RATIO * ( CyclesGlobalClockCounter - DSP_CyclesGlobalClockCounter ) );
 				}
 
+				/* Skip the idle loops in fast forward mode */
+				IdleLoop_Check();
+
 				if ( savestate_state == STATE_SAVE )
 					save_state ( NULL , NULL );
 #endif
@@ -7516,6 +7664,49 @@ static void m68k_run_2_000(void)
 	}
 }
 
+#ifdef WINUAE_FOR_HATARI
+/*
+ * Hatari : called by the fused handlers generated by gencpu, after running
+ * the first instruction of a pair which returned 'cycles', when the next
+ * instruction is 'opcode', the second one of the pair.
+ * Return false if m68k_run_2_020() must run the next instruction itself
+ * (special flag, MFP update, wait state or cycInt handler to call after
+ * adding the cycles of the first instruction). Else, do the same as
+ * m68k_run_2_020() at the end of the first instruction and at the start
+ * of 'opcode', and return true.
+ */
+bool m68k_fused_next(uae_u32 cycles, uae_u32 opcode)
+{
+	int max_cycles;
+
+	if (regs.spcflags || MFP_UpdateNeeded || WaitStateCycles
+		|| savestate_state == STATE_SAVE || LOG_TRACE_LEVEL(TRACE_CPU_DISASM))
+		return false;
+
+	/* M68000_AddCyclesWithPairing() adds at most the rounded cycles + the bus penalty */
+	cpu_cycles = adjust_cycles(cycles >> 16);
+	max_cycles = cpu_cycles * 2 / CYCLE_UNIT;
+	max_cycles = (max_cycles + BusCyclePenalty + 3) & ~3;
+	if (CycInt_CyclesBeforeNextEvent() <= max_cycles)
+		return false;
+
+	do_cycles(cpu_cycles);
+	M68000_AddCyclesWithPairing(cpu_cycles * 2 / CYCLE_UNIT);
+
+	if (bDspEnabled)
+		DSP_Run(2 * cpu_cycles * 2 / CYCLE_UNIT);
+
+	/* The first instruction never branches (see read_fused_pairs() in */
+	/* gencpu.c), this can't skip cycles, but a checked loop must see it */
+	IdleLoop_Check();
+
+	regs.instruction_pc = m68k_getpc();
+	regs.opcode = opcode;
+	count_instr(opcode);
+	return true;
+}
+#endif
+
 static void m68k_run_2_020(void)
 {
 #ifdef WITH_THREADED_CPU
@@ -7573,7 +7764,7 @@ static void m68k_run_2_020(void)
 				/* We must check for pending interrupt and call do_specialties() only */
 				/* if the cpu is not in the STOP state. Else, the int could be acknowledged now */
 				/* and prevent exiting the STOP state when calling do_specialties() after. */
-				/* For performance, we first test PendingInterruptCount, then regs.spcflags */
+				/* For performance, we first test CycInt_NextEventClock, then regs.spcflags */
 				CycInt_Process_stop(regs.spcflags & SPCFLAG_STOP);
 				if ( MFP_UpdateNeeded == true )
 					MFP_UpdateIRQ_All ( 0 );
@@ -7591,6 +7782,9 @@ static void m68k_run_2_020(void)
 //					DSP_Run ( DSP_CPU_FREQ_RATIO * ( CyclesGlobalClockCounter - DSP_CyclesGlobalClockCounter ) );
 				}
 
+				/* Skip the idle loops in fast forward mode */
+				IdleLoop_Check();
+
 				if ( savestate_state == STATE_SAVE )
 					save_state ( NULL , NULL );
 #endif
@@ -7692,6 +7886,10 @@ void m68k_run(void)
 		currprefs.cpu_model < 68020 ? m68k_run_2_000 : m68k_run_2_020;
 
 	run_func();
+#ifdef WINUAE_FOR_HATARI
+	/* Next cpu core might not use lazy flags */
+	FLUSH_LAZY_FLAGS();
+#endif
 
 #ifdef WITH_THREADED_CPU
 	cpu_thread_tid = 0;
@@ -8074,6 +8272,9 @@ void m68k_dumpstate(uaecptr *nextpc, uaecptr prevpc)
 #endif
 	if (j > 0)
 		console_out_f (_T("\n"));
+#ifdef WINUAE_FOR_HATARI
+	FLUSH_LAZY_FLAGS();
+#endif
 		console_out_f (_T("SR=%04X T=%d%d S=%d M=%d X=%d N=%d Z=%d V=%d C=%d IM=%d STP=%d\n"),
 		regs.sr, regs.t1, regs.t0, regs.s, regs.m,
 		GET_XFLG(), GET_NFLG(), GET_ZFLG(),
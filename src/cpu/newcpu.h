@@ -91,6 +91,16 @@ struct cputbl {
 #endif
 };
 
+#ifdef WINUAE_FOR_HATARI
+/* Hatari : fused handlers of the generic 68020+ cpus, generated by gencpu */
+struct cputbl_fused {
+	uae_u16 opcode;
+	cpuop_func *handler_fused;
+	cpuop_func *handler_ff;		/* Normal handler replaced by handler_fused */
+};
+extern bool m68k_fused_next(uae_u32 cycles, uae_u32 opcode);
+#endif
+
 #ifdef JIT
 #define MIN_JIT_CACHE 128
 #define MAX_JIT_CACHE 16384
@@ -940,6 +950,7 @@ extern cpuop_func *cpufunctbl[65536] ASM_SYM_FOR_FUNC("cpufunctbl");
 #ifdef JIT
 extern void (*flush_icache)(int);
 extern void compemu_reset(void);
+extern int countdown;
 #else
 #define flush_icache(int) do {} while (0)
 #define flush_icache_hard(int) do {} while (0)
@@ -773,6 +773,9 @@ struct uae_prefs {
 	int cpu_model;
 	int mmu_model;
 	bool mmu_ec;
+#ifdef WINUAE_FOR_HATARI
+	bool mmu_host_atc;
+#endif
 	int cpu060_revision;
 	int fpu_model;
 	int fpu_revision;
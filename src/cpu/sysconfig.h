@@ -39,7 +39,9 @@
 
 #ifndef UAE_MINI
 
-//#define JIT /* JIT compiler support */
+#if defined(ENABLE_JIT) && (defined(__x86_64__) || defined(_M_AMD64))
+#define JIT /* JIT compiler support */
+#endif
 //#define USE_JIT_FPU
 
 #define DEBUGGER
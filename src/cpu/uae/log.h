@@ -0,0 +1,7 @@
+#ifndef UAE_LOG_H
+#define UAE_LOG_H
+
+/* write_log() is mapped to Hatari's Log_Printf() in sysdeps.h */
+#include "log.h"
+
+#endif /* UAE_LOG_H */
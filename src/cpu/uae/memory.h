@@ -0,0 +1,8 @@
+#ifndef UAE_UAE_MEMORY_H
+#define UAE_UAE_MEMORY_H
+
+/* The JIT sources include the WinUAE path "uae/memory.h", Hatari keeps */
+/* the memory banks declarations in cpu/memory.h */
+#include "../memory.h"
+
+#endif /* UAE_UAE_MEMORY_H */
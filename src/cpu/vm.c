@@ -0,0 +1,137 @@
+/*
+ * Multi-platform virtual memory functions for UAE.
+ * Copyright (C) 2015 Frode Solheim
+ *
+ * Licensed under the terms of the GNU General Public License version 2.
+ * See the file 'COPYING' for full license text.
+ *
+ * Hatari only needs the allocation functions used by the JIT compiler
+ * for its translation cache, reserve/commit are not implemented.
+ */
+
+#include "main.h"
+#include "log.h"
+#include "sysconfig.h"
+#include "sysdeps.h"
+
+#include "uae/vm.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#if !defined(MAP_ANONYMOUS) && defined(MAP_ANON)
+#define MAP_ANONYMOUS MAP_ANON
+#endif
+
+
+#ifdef _WIN32
+static DWORD protect_to_native(int protect)
+{
+	if (protect == UAE_VM_NO_ACCESS) return PAGE_NOACCESS;
+	if (protect == UAE_VM_READ) return PAGE_READONLY;
+	if (protect == UAE_VM_READ_WRITE) return PAGE_READWRITE;
+	if (protect == UAE_VM_READ_EXECUTE) return PAGE_EXECUTE_READ;
+	if (protect == UAE_VM_READ_WRITE_EXECUTE) return PAGE_EXECUTE_READWRITE;
+	write_log("VM: Invalid protect value %d\n", protect);
+	return PAGE_NOACCESS;
+}
+#else
+static int protect_to_native(int protect)
+{
+	if (protect == UAE_VM_NO_ACCESS) return PROT_NONE;
+	if (protect == UAE_VM_READ) return PROT_READ;
+	if (protect == UAE_VM_READ_WRITE) return PROT_READ | PROT_WRITE;
+	if (protect == UAE_VM_READ_EXECUTE) return PROT_READ | PROT_EXEC;
+	if (protect == UAE_VM_READ_WRITE_EXECUTE) return PROT_READ | PROT_WRITE | PROT_EXEC;
+	write_log("VM: Invalid protect value %d\n", protect);
+	return PROT_NONE;
+}
+#endif
+
+
+int uae_vm_page_size(void)
+{
+	static int page_size = 0;
+
+	if (page_size == 0) {
+#ifdef _WIN32
+		SYSTEM_INFO si;
+		GetSystemInfo(&si);
+		page_size = si.dwPageSize;
+#else
+		page_size = sysconf(_SC_PAGESIZE);
+#endif
+	}
+	return page_size;
+}
+
+
+void *uae_vm_alloc(uae_u32 size, int flags, int protect)
+{
+	void *address;
+
+#ifdef _WIN32
+	address = VirtualAlloc(NULL, size, MEM_COMMIT | MEM_RESERVE, protect_to_native(protect));
+	if (address == NULL) {
+		write_log("VM: VirtualAlloc failed, error %lu\n", (unsigned long)GetLastError());
+		return UAE_VM_ALLOC_FAILED;
+	}
+	if ((flags & UAE_VM_32BIT) && (uintptr_t)address + size > 0x80000000) {
+		write_log("VM: Allocated memory is not in the 32-bit range\n");
+		VirtualFree(address, 0, MEM_RELEASE);
+		return UAE_VM_ALLOC_FAILED;
+	}
+#else
+	int mmap_flags = MAP_PRIVATE | MAP_ANONYMOUS;
+#ifdef MAP_32BIT
+	/* The JIT needs its cache in the low 2 GB to use 32-bit displacements */
+	if (flags & UAE_VM_32BIT)
+		mmap_flags |= MAP_32BIT;
+#endif
+	address = mmap(NULL, size, protect_to_native(protect), mmap_flags, -1, 0);
+	if (address == MAP_FAILED) {
+		write_log("VM: mmap failed for %u bytes\n", size);
+		return UAE_VM_ALLOC_FAILED;
+	}
+#endif
+	return address;
+}
+
+
+bool uae_vm_protect(void *address, int size, int protect)
+{
+#ifdef _WIN32
+	DWORD old;
+	if (VirtualProtect(address, size, protect_to_native(protect), &old) == 0) {
+		write_log("VM: VirtualProtect %p failed\n", address);
+		return false;
+	}
+#else
+	if (mprotect(address, size, protect_to_native(protect)) != 0) {
+		write_log("VM: mprotect %p failed\n", address);
+		return false;
+	}
+#endif
+	return true;
+}
+
+
+bool uae_vm_free(void *address, int size)
+{
+#ifdef _WIN32
+	if (VirtualFree(address, 0, MEM_RELEASE) == 0) {
+		write_log("VM: VirtualFree %p failed\n", address);
+		return false;
+	}
+#else
+	if (munmap(address, size) != 0) {
+		write_log("VM: munmap %p failed\n", address);
+		return false;
+	}
+#endif
+	return true;
+}
@@ -36,3 +36,27 @@ void f_out (void *f, const TCHAR *format, ...)
 	vfprintf (f, format, parms);
 	va_end (parms);
 }
+
+#ifdef JIT
+/* TCHAR is plain char in Hatari, so the conversions are just copies */
+TCHAR *au (const char *s)
+{
+	return strdup (s);
+}
+
+char *ua (const TCHAR *s)
+{
+	return strdup (s);
+}
+
+void jit_abort (const char *format, ...)
+{
+	va_list parms;
+
+	va_start (parms, format);
+	vfprintf (stderr, format, parms);
+	va_end (parms);
+	fprintf (stderr, "\nJIT: fatal error, aborting\n");
+	abort ();
+}
+#endif
@@ -5,12 +5,14 @@
   or at your option any later version. Read the file gpl.txt for details.
 
   This code handles our table with callbacks for cycle accurate program
-  interruption. We add any pending callback handler into a table so that we do
-  not need to test for every possible interrupt event. We then scan
-  the list if used entries in the table and copy the one with the least cycle
-  count into the global 'PendingInterruptCount' variable. This is then
-  decremented by the execution loop - rather than decrement each and every
-  entry (as the others cannot occur before this one).
+  interruption. This is the only scheduler of the emulation : the cpu cores
+  and the other components (video, MFP, sound, SCC, ...) add their events to
+  it, and the cpu cores only compare the main clock with 'CycInt_NextEventClock'
+  (the cpu cycle of the next event) after each instruction, rather than
+  decrement each and every entry (as the others cannot occur before this one).
+  The active interrupts are kept in a binary heap sorted by their Cycles value,
+  the next one to occur being the root of the heap ; interrupts with the same
+  Cycles value occur in the reverse order of their insertion.
   We have two methods of adding interrupts; Absolute and Relative.
   Absolute will set values from the time of the previous interrupt (e.g., add
   HBL every 512 cycles), and Relative will add from the current cycle time.
@@ -75,10 +77,8 @@ const char CycInt_fileid[] = "Hatari cycInt.c";
 //#define	CYCINT_DEBUG
 
 
-void (*PendingInterruptFunction)(void);		// TODO rename to CycInt_ActiveInt_Function
-int PendingInterruptCount;
-
-static int CycInt_DelayedCycles;
+int	CycInt_DelayedCycles;			/* Internal cycles (<= 0) between the active interrupt and the current clock */
+uint64_t CycInt_NextEventClock;			/* Cpu cycle when the active interrupt must be processed */
 
 /* List of possible interrupt handlers to be stored in 'InterruptHandlers[]'
  * The list should be in the same order than the enum type 'interrupt_id' */
@@ -121,17 +121,31 @@ typedef struct
 	bool	Active;				/* Is interrupt active? */
 	uint64_t Cycles;
 	void	(*pFunction)(void);
-	int	IntList_Prev;		/* Number of previous interrupt sorted by 'Cycles' value (or -1 if none) */
-	int	IntList_Next;		/* Number of next interrupt sorted by 'Cycles' value (or -1 if none) */
-					/* NOTE : type should be 'int' not 'interrupt_id' else compiler might internally */
-					/* use 'unsigned int' which will fail when storing value '-1' */
+	int	HeapPos;		/* Position in CycInt_Heap[] when active */
 } INTERRUPTHANDLER;
 
 static INTERRUPTHANDLER InterruptHandlers[MAX_INTERRUPTS];
 static interrupt_id	CycInt_ActiveInt = 0;
 uint64_t			CycInt_ActiveInt_Cycles;
 
+/* Active interrupts as a binary heap (INTERRUPT_NULL is never in the heap, */
+/* it's the active interrupt when the heap is empty). Cycles and Order are */
+/* copied in each entry to compare the entries without going through */
+/* InterruptHandlers[] */
+typedef struct
+{
+	uint64_t Cycles;
+	uint64_t Order;			/* CycInt_InsertCount when inserted (the last one inserted occurs first for the same Cycles) */
+	int	IntId;
+} CYCINT_HEAP_ENTRY;
+
+static CYCINT_HEAP_ENTRY	CycInt_Heap[MAX_INTERRUPTS];
+static int		CycInt_HeapSize;
+static uint64_t		CycInt_InsertCount;
+
+static void CycInt_SetActiveInt ( void );
 static void CycInt_InsertInt ( interrupt_id IntId );
+static void CycInt_RemoveInt ( interrupt_id IntId );
 
 /* TEMP : to update CYCLES_COUNTER_VIDEO during an opcode */
 /* This is a temporary case needed to handle updating CYCLES_COUNTER_VIDEO */
@@ -151,7 +165,6 @@ void CycInt_Reset(void)
 	int i;
 
 	/* Reset counts */
-	PendingInterruptCount = 0;
 	CycInt_DelayedCycles = 0;
 
 	/* Reset interrupt table */
@@ -160,17 +173,18 @@ void CycInt_Reset(void)
 		InterruptHandlers[i].Active = false;
 		InterruptHandlers[i].Cycles = 0;
 		InterruptHandlers[i].pFunction = pIntHandlerFunctions[i];
-		InterruptHandlers[i].IntList_Prev = -1;
-		InterruptHandlers[i].IntList_Next = -1;
+		InterruptHandlers[i].HeapPos = -1;
 	}
 
 	/* Interrupt 0 should always be active, but it will never trigger, */
-	/* it will always be the last of the list */
+	/* it will always be the last one */
 	InterruptHandlers[ 0 ].Active = true;
 	InterruptHandlers[ 0 ].Cycles = UINT64_MAX;
 
+	CycInt_HeapSize = 0;
+	CycInt_InsertCount = 0;
 	CycInt_ActiveInt = 0;
-	CycInt_ActiveInt_Cycles = InterruptHandlers[0].Cycles;
+	CycInt_SetActiveInt ();
 }
 
 
@@ -216,14 +230,33 @@ static void ( *CycInt_IDToHandlerFunction(int ID) )( void )
 void CycInt_MemorySnapShot_Capture(bool bSave)
 {
 	int i,ID;
+	int IntList[MAX_INTERRUPTS];
+	int IntList_Prev[MAX_INTERRUPTS];
+	int IntList_Next[MAX_INTERRUPTS];
+	int Count;
+
+	/* Snapshots store the active interrupts as a linked list sorted by */
+	/* Cycles values (previous / next interrupt, or -1 if none), ending */
+	/* with INTERRUPT_NULL */
+	if (bSave)
+	{
+		Count = CycInt_GetSortedInts ( IntList );
+		for (i=0; i<MAX_INTERRUPTS; i++)
+			IntList_Prev[i] = IntList_Next[i] = -1;
+		for (i=0; i<Count; i++)
+		{
+			IntList_Prev[ IntList[i] ] = ( i > 0 ) ? IntList[i-1] : -1;
+			IntList_Next[ IntList[i] ] = ( i < Count-1 ) ? IntList[i+1] : -1;
+		}
+	}
 
 	/* Save/Restore details */
 	for (i=0; i<MAX_INTERRUPTS; i++)
 	{
 		MemorySnapShot_Store(&InterruptHandlers[i].Active, sizeof(InterruptHandlers[i].Active));
 		MemorySnapShot_Store(&InterruptHandlers[i].Cycles, sizeof(InterruptHandlers[i].Cycles));
-		MemorySnapShot_Store(&InterruptHandlers[i].IntList_Prev, sizeof(InterruptHandlers[i].IntList_Prev));
-		MemorySnapShot_Store(&InterruptHandlers[i].IntList_Next, sizeof(InterruptHandlers[i].IntList_Next));
+		MemorySnapShot_Store(&IntList_Prev[i], sizeof(IntList_Prev[i]));
+		MemorySnapShot_Store(&IntList_Next[i], sizeof(IntList_Next[i]));
 		if (bSave)
 		{
 			/* Convert function to ID */
@@ -240,78 +273,194 @@ void CycInt_MemorySnapShot_Capture(bool bSave)
 	MemorySnapShot_Store(&CycInt_DelayedCycles, sizeof(CycInt_DelayedCycles));
 	MemorySnapShot_Store(&CycInt_ActiveInt, sizeof(CycInt_ActiveInt));
 	MemorySnapShot_Store(&CycInt_ActiveInt_Cycles, sizeof(CycInt_ActiveInt_Cycles));
-	MemorySnapShot_Store(&PendingInterruptCount, sizeof(PendingInterruptCount));
+	/* Old PendingInterruptCount (same value as CycInt_DelayedCycles) and */
+	/* PendingInterruptFunction (unused) are still stored for compatibility */
+	ID = CycInt_DelayedCycles;
+	MemorySnapShot_Store(&ID, sizeof(int));
 	MemorySnapShot_Store(&CycInt_From_Opcode, sizeof(CycInt_From_Opcode));
-	if (bSave)
+	ID = 0;
+	MemorySnapShot_Store(&ID, sizeof(int));
+
+	if (!bSave)
+	{
+		/* Rebuild the heap from the list, the interrupts inserted from */
+		/* the end of the list keep their order for the same Cycles */
+		Count = 0;
+		for (i=CycInt_ActiveInt; i>0 && i<MAX_INTERRUPTS && Count<MAX_INTERRUPTS; i=IntList_Next[i])
+			IntList[ Count++ ] = i;
+
+		CycInt_HeapSize = 0;
+		for (i=0; i<MAX_INTERRUPTS; i++)
+		{
+			InterruptHandlers[i].Active = false;
+			InterruptHandlers[i].HeapPos = -1;
+		}
+		InterruptHandlers[ 0 ].Active = true;
+		InterruptHandlers[ 0 ].Cycles = UINT64_MAX;
+		while (Count > 0)
+		{
+			InterruptHandlers[ IntList[ --Count ] ].Active = true;
+			CycInt_InsertInt ( IntList[ Count ] );
+		}
+		CycInt_SetActiveInt ();
+	}
+}
+
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Set the values depending on the active interrupt (the root of the heap,
+ * or INTERRUPT_NULL if the heap is empty) : its cycles and the cpu cycle
+ * when it must be processed (the first cpu cycle which is not before the
+ * interrupt's internal cycles)
+ */
+static void CycInt_SetActiveInt ( void )
+{
+	CycInt_ActiveInt = CycInt_HeapSize > 0 ? CycInt_Heap[ 0 ].IntId : INTERRUPT_NULL;
+	CycInt_ActiveInt_Cycles = InterruptHandlers[ CycInt_ActiveInt ].Cycles;
+
+	CycInt_NextEventClock = CycInt_ActiveInt_Cycles >> CYCINT_SHIFT;
+	if ( CycInt_ActiveInt_Cycles & ( ( 1 << CYCINT_SHIFT ) - 1 ) )
+		CycInt_NextEventClock++;
+}
+
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Return true if heap entry 'a' must occur before heap entry 'b'
+ */
+static inline bool CycInt_Before ( const CYCINT_HEAP_ENTRY *a , const CYCINT_HEAP_ENTRY *b )
+{
+	if ( a->Cycles != b->Cycles )
+		return a->Cycles < b->Cycles;
+	return a->Order > b->Order;
+}
+
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Move the entry at position 'pos' in the heap towards the root or
+ * towards the leaves until the heap is sorted again.
+ * Return the new position of the entry.
+ */
+static int CycInt_HeapUp ( int pos )
+{
+	CYCINT_HEAP_ENTRY Entry = CycInt_Heap[ pos ];
+	int parent;
+
+	while ( pos > 0 )
 	{
-		/* Convert function to ID */
-		ID = CycInt_HandlerFunctionToID(PendingInterruptFunction);
-		MemorySnapShot_Store(&ID, sizeof(int));
+		parent = ( pos - 1 ) / 2;
+		if ( !CycInt_Before ( &Entry , &CycInt_Heap[ parent ] ) )
+			break;
+		CycInt_Heap[ pos ] = CycInt_Heap[ parent ];
+		InterruptHandlers[ CycInt_Heap[ pos ].IntId ].HeapPos = pos;
+		pos = parent;
 	}
-	else
+	CycInt_Heap[ pos ] = Entry;
+	InterruptHandlers[ Entry.IntId ].HeapPos = pos;
+	return pos;
+}
+
+static int CycInt_HeapDown ( int pos )
+{
+	CYCINT_HEAP_ENTRY Entry = CycInt_Heap[ pos ];
+	int child;
+
+	while ( ( child = 2 * pos + 1 ) < CycInt_HeapSize )
 	{
-		/* Convert ID to function */
-		MemorySnapShot_Store(&ID, sizeof(int));
-		PendingInterruptFunction = CycInt_IDToHandlerFunction(ID);
+		if ( child + 1 < CycInt_HeapSize && CycInt_Before ( &CycInt_Heap[ child + 1 ] , &CycInt_Heap[ child ] ) )
+			child++;
+		if ( !CycInt_Before ( &CycInt_Heap[ child ] , &Entry ) )
+			break;
+		CycInt_Heap[ pos ] = CycInt_Heap[ child ];
+		InterruptHandlers[ CycInt_Heap[ pos ].IntId ].HeapPos = pos;
+		pos = child;
 	}
+	CycInt_Heap[ pos ] = Entry;
+	InterruptHandlers[ Entry.IntId ].HeapPos = pos;
+	return pos;
 }
 
 
+#ifdef CYCINT_DEBUG
+static void CycInt_PrintHeap ( const char *pText )
+{
+	int i;
+
+	fprintf ( stderr , "int %s active=%02d active_cyc=%"PRIu64" clock=%"PRIu64"\n" , pText , CycInt_ActiveInt , CycInt_ActiveInt_Cycles , Cycles_GetClockCounterImmediate() );
+	for ( i = 0 ; i < CycInt_HeapSize ; i++ )
+		fprintf ( stderr , "  heap %02d int %02d order=%"PRIu64" cyc=%"PRIu64"\n" , i , CycInt_Heap[ i ].IntId , CycInt_Heap[ i ].Order , CycInt_Heap[ i ].Cycles );
+}
+#endif
+
+
 /*-----------------------------------------------------------------------*/
 /**
  * When the interrupt handler for IntId becomes active, we insert IntId
- * in the linked list of active interrupts sorted by Cycles values
+ * in the heap of active interrupts sorted by Cycles values
  */
 static void CycInt_InsertInt ( interrupt_id IntId )
 {
-	int	n, prev;
+	CYCINT_HEAP_ENTRY *pEntry = &CycInt_Heap[ CycInt_HeapSize ];
+
+	pEntry->Cycles = InterruptHandlers[ IntId ].Cycles;
+	pEntry->Order = ++CycInt_InsertCount;
+	pEntry->IntId = IntId;
+	CycInt_HeapUp ( CycInt_HeapSize++ );
+
+	CycInt_SetActiveInt ();
 
 #ifdef CYCINT_DEBUG
-	fprintf ( stderr , "int before active=%02d active_cyc=%"PRIu64" new=%02d cyc=%"PRIu64" clock=%"PRIu64"\n" , CycInt_ActiveInt , CycInt_ActiveInt_Cycles , IntId , InterruptHandlers[ IntId ].Cycles , Cycles_GetClockCounterImmediate() );
-	n = CycInt_ActiveInt;
-	do
-	{
-		fprintf ( stderr , "  int %02d prev=%02d next=%02d cyc=%"PRIu64"\n" , n , InterruptHandlers[ n ].IntList_Prev , InterruptHandlers[ n ].IntList_Next , InterruptHandlers[ n ].Cycles );
-		n = InterruptHandlers[ n ].IntList_Next;
-	} while ( n >= 0 );
+	CycInt_PrintHeap ( "insert" );
 #endif
+}
 
-	/* Search for the position to insert IntId in the linked list ; we insert just before interrupt 'n'  */
-	n = CycInt_ActiveInt;
-	prev = InterruptHandlers[ n ].IntList_Prev;
-	while (InterruptHandlers[ IntId ].Cycles > InterruptHandlers[ n ].Cycles)
-	{
-		n = InterruptHandlers[ n ].IntList_Next;
-		assert (n >= 0);
-		prev = InterruptHandlers[ n ].IntList_Prev;
-	}
 
-	InterruptHandlers[ IntId ].IntList_Next = n;
-	InterruptHandlers[ n ].IntList_Prev = IntId;
+/*-----------------------------------------------------------------------*/
+/**
+ * Remove IntId from the heap of active interrupts (the last entry of
+ * the heap takes its place)
+ */
+static void CycInt_RemoveInt ( interrupt_id IntId )
+{
+	int pos = InterruptHandlers[ IntId ].HeapPos;
 
-	if ( n == (int)CycInt_ActiveInt )		/* Add as the first entry from list */
-	{
-		/* Set the new ActiveInt */
-		CycInt_ActiveInt = IntId;
-		CycInt_ActiveInt_Cycles = InterruptHandlers[ CycInt_ActiveInt ].Cycles;
-		/* New ActiveInt is first of the list */
-		InterruptHandlers[ CycInt_ActiveInt ].IntList_Prev = -1;
-	}
-	else						/* Insert in middle of the list */
+	if ( pos < 0 )					/* INTERRUPT_NULL */
+		return;
+
+	InterruptHandlers[ IntId ].HeapPos = -1;
+	if ( pos != --CycInt_HeapSize )
 	{
-		InterruptHandlers[ IntId ].IntList_Prev = prev;
-		InterruptHandlers[ prev ].IntList_Next = IntId;
+		CycInt_Heap[ pos ] = CycInt_Heap[ CycInt_HeapSize ];
+		if ( CycInt_HeapDown ( pos ) == pos )
+			CycInt_HeapUp ( pos );
 	}
 
-#ifdef CYCINT_DEBUG
-	fprintf ( stderr , "int after active=%02d active_cyc=%"PRIu64" new=%02d cyc=%"PRIu64" clock=%"PRIu64"\n" , CycInt_ActiveInt , CycInt_ActiveInt_Cycles , IntId , InterruptHandlers[ IntId ].Cycles , Cycles_GetClockCounterImmediate() );
-	n = CycInt_ActiveInt;
-	do
+	CycInt_SetActiveInt ();
+}
+
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Fill 'IntList' with the active interrupts, sorted in the order they
+ * will occur and ending with INTERRUPT_NULL. Return their number.
+ */
+int CycInt_GetSortedInts ( int *IntList )
+{
+	CYCINT_HEAP_ENTRY Sorted[ MAX_INTERRUPTS ];
+	int i, j;
+
+	for ( i = 0 ; i < CycInt_HeapSize ; i++ )
 	{
-		fprintf ( stderr , "  int %02d prev=%02d next=%02d cyc=%"PRIu64"\n" , n , InterruptHandlers[ n ].IntList_Prev , InterruptHandlers[ n ].IntList_Next , InterruptHandlers[ n ].Cycles );
-		n = InterruptHandlers[ n ].IntList_Next;
-	} while ( n >= 0 );
-#endif
+		for ( j = i ; j > 0 && CycInt_Before ( &CycInt_Heap[ i ] , &Sorted[ j - 1 ] ) ; j-- )
+			Sorted[ j ] = Sorted[ j - 1 ];
+		Sorted[ j ] = CycInt_Heap[ i ];
+	}
+	for ( i = 0 ; i < CycInt_HeapSize ; i++ )
+		IntList[ i ] = Sorted[ i ].IntId;
+	IntList[ i++ ] = INTERRUPT_NULL;
+	return i;
 }
 
 
@@ -325,15 +474,12 @@ void CycInt_AcknowledgeInterrupt(void)
 	/* Disable interrupt's entry which has just occurred */
 	InterruptHandlers[ CycInt_ActiveInt ].Active = false;
 
-	/* Set the new ActiveInt as the next in list (it can be INTERRUPT_NULL (=0) ) */
-	CycInt_ActiveInt = InterruptHandlers[ CycInt_ActiveInt ].IntList_Next;
-	CycInt_ActiveInt_Cycles = InterruptHandlers[ CycInt_ActiveInt ].Cycles;
-	/* New ActiveInt is first of the list */
-	InterruptHandlers[ CycInt_ActiveInt ].IntList_Prev = -1;
+	/* Set the new ActiveInt as the next one (it can be INTERRUPT_NULL (=0) ) */
+	CycInt_RemoveInt ( CycInt_ActiveInt );
 
-	LOG_TRACE(TRACE_INT, "int ack video_cyc=%d active_int=%d clock=%"PRIu64" active_cyc=%"PRIu64" pending_count=%d\n",
+	LOG_TRACE(TRACE_INT, "int ack video_cyc=%d active_int=%d clock=%"PRIu64" active_cyc=%"PRIu64" delayed_cyc=%d\n",
 			Video_GetCyclesSinceVbl(), CycInt_ActiveInt,
-			Cycles_GetClockCounterImmediate() , InterruptHandlers[CycInt_ActiveInt].Cycles, PendingInterruptCount );
+			Cycles_GetClockCounterImmediate() , InterruptHandlers[CycInt_ActiveInt].Cycles, CycInt_DelayedCycles );
 }
 
 
@@ -357,9 +503,9 @@ void CycInt_AddAbsoluteInterrupt(int CycleTime, int CycleType, interrupt_id Hand
 
 	CycInt_InsertInt ( Handler );
 
-	LOG_TRACE(TRACE_INT, "int add abs video_cyc=%d handler=%d clock=%"PRIu64" handler_cyc=%"PRIu64" pending_count=%d\n",
+	LOG_TRACE(TRACE_INT, "int add abs video_cyc=%d handler=%d clock=%"PRIu64" handler_cyc=%"PRIu64" delayed_cyc=%d\n",
 	          Video_GetCyclesSinceVbl(), Handler,
-	          Cycles_GetClockCounterImmediate() , InterruptHandlers[Handler].Cycles, PendingInterruptCount );
+	          Cycles_GetClockCounterImmediate() , InterruptHandlers[Handler].Cycles, CycInt_DelayedCycles );
 }
 
 
@@ -396,9 +542,9 @@ void CycInt_AddRelativeInterruptWithOffset(int CycleTime, int CycleType, interru
 
 	CycInt_InsertInt ( Handler );
 
-	LOG_TRACE(TRACE_INT, "int add rel offset video_cyc=%d handler=%d clock=%"PRIu64" handler_cyc=%"PRIu64" offset_cyc=%d pending_count=%d\n",
+	LOG_TRACE(TRACE_INT, "int add rel offset video_cyc=%d handler=%d clock=%"PRIu64" handler_cyc=%"PRIu64" offset_cyc=%d delayed_cyc=%d\n",
 	          Video_GetCyclesSinceVbl(), Handler,
-	          Cycles_GetClockCounterImmediate() , InterruptHandlers[Handler].Cycles, CycleOffset, PendingInterruptCount);
+	          Cycles_GetClockCounterImmediate() , InterruptHandlers[Handler].Cycles, CycleOffset, CycInt_DelayedCycles);
 }
 
 
@@ -420,9 +566,9 @@ void CycInt_ModifyInterrupt(int CycleTime, int CycleType, interrupt_id Handler)
 
 	CycInt_InsertInt ( Handler );
 
-	LOG_TRACE(TRACE_INT, "int modify video_cyc=%d handler=%d clock=%"PRIu64" handler_cyc=%"PRIu64" pending_count=%d\n",
+	LOG_TRACE(TRACE_INT, "int modify video_cyc=%d handler=%d clock=%"PRIu64" handler_cyc=%"PRIu64" delayed_cyc=%d\n",
 	          Video_GetCyclesSinceVbl(), Handler,
-	          Cycles_GetClockCounterImmediate() , InterruptHandlers[Handler].Cycles, PendingInterruptCount );
+	          Cycles_GetClockCounterImmediate() , InterruptHandlers[Handler].Cycles, CycInt_DelayedCycles );
 }
 
 
@@ -436,42 +582,23 @@ void CycInt_RemovePendingInterrupt(interrupt_id Handler)
 	/* Check interrupt is not already disabled ; if so, don't do anything */
 	if ( InterruptHandlers[ Handler ].Active == false )
 	{
-		LOG_TRACE(TRACE_INT, "int remove pending already disabled video_cyc=%d handler=%d clock=%"PRIu64" handler_cyc=%"PRIu64" pending_count=%d\n",
+		LOG_TRACE(TRACE_INT, "int remove pending already disabled video_cyc=%d handler=%d clock=%"PRIu64" handler_cyc=%"PRIu64" delayed_cyc=%d\n",
 			Video_GetCyclesSinceVbl(), Handler,
-			Cycles_GetClockCounterImmediate() , InterruptHandlers[Handler].Cycles, PendingInterruptCount);
+			Cycles_GetClockCounterImmediate() , InterruptHandlers[Handler].Cycles, CycInt_DelayedCycles);
 		return;
 	}
 
 	/* Disable interrupt's entry */
 	InterruptHandlers[Handler].Active = false;
 
-	if ( Handler == CycInt_ActiveInt )	/* Remove first entry from list */
-	{
-		/* Set the new ActiveInt as the next in list (it can be INTERRUPT_NULL) */
-		CycInt_ActiveInt = InterruptHandlers[ CycInt_ActiveInt ].IntList_Next;
-		CycInt_ActiveInt_Cycles = InterruptHandlers[ CycInt_ActiveInt ].Cycles;
-		/* New ActiveInt is first of the list */
-		InterruptHandlers[ CycInt_ActiveInt ].IntList_Prev = -1;
-	}
+	/* If Handler == CycInt_ActiveInt, this also sets the new ActiveInt (it can be INTERRUPT_NULL) */
+	CycInt_RemoveInt ( Handler );
 
-	else					/* Remove an entry 'n' in middle of the list */
-	{
-		/* Update prev/next for the entries n-1 and n+1 */
-		InterruptHandlers[ InterruptHandlers[Handler].IntList_Prev ].IntList_Next = InterruptHandlers[ Handler ].IntList_Next;
-		InterruptHandlers[ InterruptHandlers[Handler].IntList_Next ].IntList_Prev = InterruptHandlers[ Handler ].IntList_Prev;
-	}
-
-	LOG_TRACE(TRACE_INT, "int remove pending video_cyc=%d handler=%d clock=%"PRIu64" handler_cyc=%"PRIu64" pending_count=%d\n",
+	LOG_TRACE(TRACE_INT, "int remove pending video_cyc=%d handler=%d clock=%"PRIu64" handler_cyc=%"PRIu64" delayed_cyc=%d\n",
 	          Video_GetCyclesSinceVbl(), Handler,
-	          Cycles_GetClockCounterImmediate() , InterruptHandlers[Handler].Cycles, PendingInterruptCount);
+	          Cycles_GetClockCounterImmediate() , InterruptHandlers[Handler].Cycles, CycInt_DelayedCycles);
 #ifdef CYCINT_DEBUG
-	fprintf ( stderr , "int remove after active=%02d active_cyc=%"PRIu64" clock=%"PRIu64"\n" , CycInt_ActiveInt , CycInt_ActiveInt_Cycles , Cycles_GetClockCounterImmediate() );
-	int n = CycInt_ActiveInt;
-	do
-	{
-		fprintf ( stderr , "  int %02d prev=%02d next=%02d cyc=%"PRIu64"\n" , n , InterruptHandlers[ n ].IntList_Prev , InterruptHandlers[ n ].IntList_Next , InterruptHandlers[ n ].Cycles );
-		n = InterruptHandlers[ n ].IntList_Next;
-	} while ( n >= 0 );
+	CycInt_PrintHeap ( "remove" );
 #endif
 }
 
@@ -526,27 +653,17 @@ int	CycInt_GetActiveInt(void)
 /**
  * Call the handler associated with the active interrupt (it should never be NULL)
  * Clock is the time when the active interrupt triggered and it's used to
- * compute PendingInterruptCount
+ * compute CycInt_DelayedCycles
  */
 void	CycInt_CallActiveHandler(uint64_t Clock)
 {
 #ifdef CYCINT_DEBUG
-	fprintf ( stderr , "int remove after active=%02d active_cyc=%"PRIu64" clock=%"PRIu64"\n" , CycInt_ActiveInt , CycInt_ActiveInt_Cycles , Clock );
-	int n = CycInt_ActiveInt;
-	do
-	{
-		fprintf ( stderr , "  int %02d prev=%02d next=%02d cyc=%"PRIu64"\n" , n , InterruptHandlers[ n ].IntList_Prev , InterruptHandlers[ n ].IntList_Next , InterruptHandlers[ n ].Cycles );
-		n = InterruptHandlers[ n ].IntList_Next;
-	} while ( n >= 0 );
+	CycInt_PrintHeap ( "call" );
 #endif
-	/* For compatibility with old cycInt code, we compute a value of PendingInterruptCount */
-	/* at the time the interrupt happens. PendingInterruptCount will be <= 0 */
+	/* Compute the delay at the time the interrupt happens. CycInt_DelayedCycles will be <= 0 */
 	/* A value <0 indicates that the interrupt was delayed by some cycles */
-	/* TODO : rename this variable later to sthg more explicit when old cycInt code is removed */
-	/* (keep only CycInt_DelayedCycles for example) */
-	PendingInterruptCount = CycInt_ActiveInt_Cycles - INT_CONVERT_TO_INTERNAL(Clock,INT_CPU_CYCLE);
-	CycInt_DelayedCycles = PendingInterruptCount;
-//fprintf ( stderr , "int call handler pending=%d\n" , PendingInterruptCount );
+	CycInt_DelayedCycles = CycInt_ActiveInt_Cycles - INT_CONVERT_TO_INTERNAL(Clock,INT_CPU_CYCLE);
+//fprintf ( stderr , "int call handler delayed=%d\n" , CycInt_DelayedCycles );
 
 	CALL_VAR ( InterruptHandlers[CycInt_ActiveInt].pFunction );
 }
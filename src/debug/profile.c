@@ -650,7 +650,7 @@ char *Profile_Match(const char *text, int state)
 {
 	static const char *subs[] = {
 		"addresses", "callers", "caches", "counts", "cycles", "d-hits", "i-misses",
-		"loops", "off", "on", "save", "stack", "stats", "symbols"
+		"loops", "off", "on", "pairs", "save", "stack", "stats", "symbols"
 	};
 
 	char *ret = DebugUI_MatchHelper(subs, ARRAY_SIZE(subs), text, state);
@@ -677,6 +677,7 @@ const char Profile_Description[] =
 	"\t- stack\n"
 	"\t- stats\n"
 	"\t- save <file>\n"
+	"\t- pairs <file> [count]\n"
 	"\t- loops <file> [CPU limit] [DSP limit]\n"
 	"\n"
 	"\t'on' & 'off' enable and disable profiling.  Data is collected\n"
@@ -702,6 +703,9 @@ const char Profile_Description[] =
 	"\tProfile address and callers information can be saved with\n"
 	"\tthe 'save' command.\n"
 	"\n"
+	"\t'pairs' saves the most frequent CPU opcode pairs, for\n"
+	"\tgenerating fused instruction handlers with gencpu.\n"
+	"\n"
 	"\tDetailed (spin) looping information can be collected by\n"
 	"\tspecifying to which file it should be saved, with optional\n"
 	"\tlimit(s) on how many bytes first and last instruction\n"
@@ -745,6 +749,27 @@ static bool Profile_Save(const char *fname, bool bForDsp)
 	return true;
 }
 
+/**
+ * Save most frequent CPU opcode pairs.
+ */
+static bool Profile_SavePairs(const char *fname, int count, bool bForDsp)
+{
+	FILE *out;
+
+	if (bForDsp) {
+		fprintf(stderr, "Opcode pairs are saved only for CPU, not DSP.\n");
+		return false;
+	}
+	if (!(out = fopen(fname, "w"))) {
+		fprintf(stderr, "ERROR: opening '%s' for writing failed!\n", fname);
+		perror(NULL);
+		return false;
+	}
+	Profile_CpuSavePairs(out, count);
+	fclose(out);
+	return true;
+}
+
 /**
  * function CPU & DSP profiling functionality can call to
  * reset loop information log by truncating it.  Only portable
@@ -904,6 +929,13 @@ int Profile_Command(int nArgc, char *psArgs[], bool bForDsp)
 	} else if (strcmp(psArgs[1], "save") == 0) {
 		Profile_Save(psArgs[2], bForDsp);
 
+	} else if (strcmp(psArgs[1], "pairs") == 0) {
+		if (nArgc < 3) {
+			DebugUI_PrintCmdHelp(psArgs[0]);
+			return DEBUGGER_CMDDONE;
+		}
+		Profile_SavePairs(psArgs[2], nArgc > 3 ? atoi(psArgs[3]) : 64, bForDsp);
+
 	} else if (strcmp(psArgs[1], "loops") == 0) {
 		Profile_Loops(nArgc, psArgs);
 
@@ -101,6 +101,7 @@ extern void Profile_CpuShowCaches(void);
 extern void Profile_CpuShowStats(void);
 extern void Profile_CpuShowCallers(FILE *fp);
 extern void Profile_CpuSave(FILE *out);
+extern void Profile_CpuSavePairs(FILE *out, int show);
 
 /* internal DSP profile results */
 extern uint16_t Profile_DspShowAddresses(uint32_t lower, uint32_t upper, FILE *out, paging_t use_paging);
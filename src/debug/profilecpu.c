@@ -802,6 +802,116 @@ void Profile_CpuShowCallers(FILE *fp)
 	Profile_ShowCallers(fp, cpu_callinfo.sites, cpu_callinfo.site, addr2name);
 }
 
+/**
+ * compare function for qsort() to sort opcode pairs by opcodes
+ */
+static int cmp_pair_opcodes(const void *p1, const void *p2)
+{
+	uint32_t op1 = ((const uint64_t*)p1)[0] >> 32;
+	uint32_t op2 = ((const uint64_t*)p2)[0] >> 32;
+	if (op1 < op2) {
+		return -1;
+	}
+	if (op1 > op2) {
+		return 1;
+	}
+	return 0;
+}
+
+/**
+ * compare function for qsort() to sort opcode pairs by descending counts
+ */
+static int cmp_pair_counts(const void *p1, const void *p2)
+{
+	uint32_t count1 = ((const uint64_t*)p1)[0] & 0xffffffff;
+	uint32_t count2 = ((const uint64_t*)p2)[0] & 0xffffffff;
+	if (count1 > count2) {
+		return -1;
+	}
+	if (count1 < count2) {
+		return 1;
+	}
+	return 0;
+}
+
+/**
+ * Save the most frequent pairs of consecutive instruction opcodes to
+ * given file, in the format expected by gencpu for generating fused
+ * instruction handlers.
+ *
+ * Profiler doesn't record the control flow between the instructions,
+ * so the count of a pair is estimated as the smaller execution count
+ * of its two instructions. Opcodes are read from the memory as it's
+ * currently, like for the 'addresses' command.
+ */
+void Profile_CpuSavePairs(FILE *out, int show)
+{
+	cpu_profile_item_t *data = cpu_profile.data;
+	uint64_t *pairs, *end;
+	uint32_t idx, next, addr, nextpc, count, opcodes;
+	int used, i;
+
+	if (!data) {
+		fprintf(stderr, "ERROR: no CPU profiling data available!\n");
+		return;
+	}
+	pairs = malloc(cpu_profile.active * sizeof(*pairs));
+	if (!pairs) {
+		perror("ERROR, new CPU profile pairs");
+		return;
+	}
+
+	/* <opcode 1> <opcode 2> <count> in a single value for sorting */
+	used = 0;
+	for (idx = 0; idx < cpu_profile.size && used < cpu_profile.active; idx++) {
+		if (!data[idx].count) {
+			continue;
+		}
+		addr = index2address(idx);
+		nextpc = Disasm_GetNextPC(addr);
+		next = idx + (nextpc - addr) / 2;
+		if (nextpc <= addr || next >= cpu_profile.size || index2address(next) != nextpc) {
+			continue;
+		}
+		count = data[next].count;
+		if (count > data[idx].count) {
+			count = data[idx].count;
+		}
+		if (!count) {
+			continue;
+		}
+		opcodes = STMemory_ReadWord(addr) << 16 | STMemory_ReadWord(nextpc);
+		pairs[used++] = (uint64_t)opcodes << 32 | count;
+	}
+
+	/* merge the counts of the same opcode pairs */
+	qsort(pairs, used, sizeof(*pairs), cmp_pair_opcodes);
+	for (i = 0, end = pairs; i < used; i++) {
+		if (end > pairs && (end[-1] >> 32) == (pairs[i] >> 32)) {
+			count = (end[-1] & 0xffffffff) + (pairs[i] & 0xffffffff);
+			if (count < (end[-1] & 0xffffffff)) {
+				count = MAX_CPU_PROFILE_VALUE;
+			}
+			end[-1] = (end[-1] & ~0xffffffffULL) | count;
+		} else {
+			*end++ = pairs[i];
+		}
+	}
+	used = end - pairs;
+	qsort(pairs, used, sizeof(*pairs), cmp_pair_counts);
+
+	show = (show < used ? show : used);
+	fprintf(out, "# Hatari CPU profile opcode pairs\n");
+	fprintf(out, "# <first opcode> <second opcode> <estimated count>\n");
+	for (i = 0; i < show; i++) {
+		fprintf(out, "%04x %04x %u\n",
+			(uint32_t)(pairs[i] >> 48), (uint32_t)(pairs[i] >> 32) & 0xffff,
+			(uint32_t)(pairs[i] & 0xffffffff));
+	}
+	fprintf(stderr, "%d CPU opcode pairs saved.\n", show);
+	free(pairs);
+}
+
 /**
  * Save CPU profile information to given file.
  */
@@ -111,6 +111,8 @@ const char DmaSnd_fileid[] = "Hatari dmaSnd.c";
 #include "video.h"
 #include "m68000.h"
 #include "clocks_timings.h"
+#include "resample.h"
+#include "lmc1992.h"
 
 #define TONE_STEPS 13
 
@@ -122,13 +124,11 @@ const char DmaSnd_fileid[] = "Hatari dmaSnd.c";
 
 static void DmaSnd_Apply_LMC(int nMixBufIdx, int nSamplesToGenerate);
 static void DmaSnd_Set_Tone_Level(int set_bass, int set_treb);
-static float DmaSnd_IIRfilterL(float xn);
-static float DmaSnd_IIRfilterR(float xn);
 static struct first_order_s *DmaSnd_Treble_Shelf(float g, float fc, float Fs);
 static struct first_order_s *DmaSnd_Bass_Shelf(float g, float fc, float Fs);
-static int16_t DmaSnd_LowPassFilterLeft(int16_t in);
-static int16_t DmaSnd_LowPassFilterRight(int16_t in);
+static void DmaSnd_LowPassFilter(int16_t left, int16_t right);
 static bool DmaSnd_LowPass;
+static void DmaSnd_GenerateSamples_Sinc(int nMixBufIdx, int nSamplesToGenerate, int64_t FreqRatio);
 
 
 uint16_t nDmaSoundControl;              /* Sound control register */
@@ -156,6 +156,14 @@ struct dma_s {
 static int64_t	frameCounter_float = 0;
 static bool	DmaInitSample = false;
 
+/* Latest samples read from the FIFO, for the "sinc" resampling method */
+#define DMASND_RESAMPLE_SIZE	512			/* must be >= RESAMPLE_TAPS_MAX */
+#define DMASND_RESAMPLE_MASK	(DMASND_RESAMPLE_SIZE-1)
+static int16_t	DmaSnd_ResampleLeft[ DMASND_RESAMPLE_SIZE ];
+static int16_t	DmaSnd_ResampleRight[ DMASND_RESAMPLE_SIZE ];
+static int	DmaSnd_ResamplePos;
+static RESAMPLE_FILTER	DmaSnd_Resampler;
+
 
 struct microwire_s {
 	uint16_t data;			/* Microwire Data register */
@@ -181,6 +189,7 @@ struct lmc1992_s {
 static struct dma_s dma;
 static struct microwire_s microwire;
 static struct lmc1992_s lmc1992;
+static LMC1992_CHAIN DmaSnd_LmcChain;		/* HPF / volume / tone filters and their state (see lmc1992.c) */
 
 /* dB = 20log(gain)  :  gain = antilog(dB/20)                                */
 /* Table gain values = (int)(powf(10.0, dB/20.0)*65536.0 + 0.5)  2dB steps   */
@@ -322,6 +331,16 @@ uint8_t	DmaSnd_Get_XSINT_Line ( void )
 }
 
 
+/*-----------------------------------------------------------------------*/
+/**
+ * Return true if DMA sound is ON or if the FIFO still has bytes to play
+ */
+bool	DmaSnd_IsPlaying ( void )
+{
+	return ( nDmaSoundControl & DMASNDCTRL_PLAY ) || ( dma.FIFO_NbBytes > 0 );
+}
+
+
 /*-----------------------------------------------------------------------*/
 /**
  * This function is called on every HBL to ensure the DMA Audio's FIFO
@@ -573,8 +592,9 @@ void DmaSnd_GenerateSamples(int nMixBufIdx, int nSamplesToGenerate)
 		return;
 	}
 
-	/* DMA Anti-alias filter */
-	if (DmaSnd_DetectSampleRate() >  nAudioFrequency)
+	/* DMA Anti-alias filter (not needed with the band limited resampling) */
+	if (DmaSnd_DetectSampleRate() >  nAudioFrequency
+	    && YM2149_Resample_Method != YM2149_RESAMPLE_METHOD_SINC)
 		DmaSnd_LowPass = true;
 	else
 		DmaSnd_LowPass = false;
@@ -586,6 +606,13 @@ void DmaSnd_GenerateSamples(int nMixBufIdx, int nSamplesToGenerate)
 	/* use << 32 to simulate floating point precision */
 	FreqRatio = ( ((int64_t)DmaSnd_DetectSampleRate()) << 32 ) / nAudioFrequency;
 
+	if ( YM2149_Resample_Method == YM2149_RESAMPLE_METHOD_SINC )
+	{
+		DmaSnd_GenerateSamples_Sinc ( nMixBufIdx , nSamplesToGenerate , FreqRatio );
+		DmaSnd_Apply_LMC ( nMixBufIdx , nSamplesToGenerate );
+		return;
+	}
+
 	if (dma.soundMode & DMASNDMODE_MONO)
 	{
 		/* Mono 8-bit */
@@ -594,8 +621,7 @@ void DmaSnd_GenerateSamples(int nMixBufIdx, int nSamplesToGenerate)
 			if ( DmaInitSample )
 			{
 				MonoByte = DmaSnd_FIFO_PullByte ();
-				dma.FrameLeft  = DmaSnd_LowPassFilterLeft( (int16_t)MonoByte );
-				dma.FrameRight = DmaSnd_LowPassFilterRight( (int16_t)MonoByte );
+				DmaSnd_LowPassFilter( (int16_t)MonoByte , (int16_t)MonoByte );
 				DmaInitSample = false;
 			}
 
@@ -622,8 +648,7 @@ void DmaSnd_GenerateSamples(int nMixBufIdx, int nSamplesToGenerate)
 			while ( n > 0 )						/* pull as many bytes from the FIFO as needed */
 			{
 				MonoByte = DmaSnd_FIFO_PullByte ();
-				dma.FrameLeft  = DmaSnd_LowPassFilterLeft( (int16_t)MonoByte );
-				dma.FrameRight = DmaSnd_LowPassFilterRight( (int16_t)MonoByte );
+				DmaSnd_LowPassFilter( (int16_t)MonoByte , (int16_t)MonoByte );
 				n--;
 			}
 			frameCounter_float &= 0xffffffff;			/* only keep the fractional part */
@@ -638,8 +663,7 @@ void DmaSnd_GenerateSamples(int nMixBufIdx, int nSamplesToGenerate)
 			{
 				LeftByte = DmaSnd_FIFO_PullByte ();
 				RightByte = DmaSnd_FIFO_PullByte ();
-				dma.FrameLeft  = DmaSnd_LowPassFilterLeft( (int16_t)LeftByte );
-				dma.FrameRight = DmaSnd_LowPassFilterRight( (int16_t)RightByte );
+				DmaSnd_LowPassFilter( (int16_t)LeftByte , (int16_t)RightByte );
 				DmaInitSample = false;
 			}
 
@@ -667,8 +691,7 @@ void DmaSnd_GenerateSamples(int nMixBufIdx, int nSamplesToGenerate)
 			{
 				LeftByte = DmaSnd_FIFO_PullByte ();
 				RightByte = DmaSnd_FIFO_PullByte ();
-				dma.FrameLeft  = DmaSnd_LowPassFilterLeft( (int16_t)LeftByte );
-				dma.FrameRight = DmaSnd_LowPassFilterRight( (int16_t)RightByte );
+				DmaSnd_LowPassFilter( (int16_t)LeftByte , (int16_t)RightByte );
 				n--;
 			}
 			frameCounter_float &= 0xffffffff;			/* only keep the fractional part */
@@ -680,36 +703,112 @@ void DmaSnd_GenerateSamples(int nMixBufIdx, int nSamplesToGenerate)
 }
 
 
+/*-----------------------------------------------------------------------*/
+/**
+ * Pull the next mono or stereo sample from the FIFO and store it in the
+ * resampling buffers
+ */
+static void DmaSnd_ResamplePull(bool bMono)
+{
+	int8_t LeftByte , RightByte;
+
+	LeftByte = DmaSnd_FIFO_PullByte ();
+	RightByte = bMono ? LeftByte : DmaSnd_FIFO_PullByte ();
+	DmaSnd_LowPassFilter( (int16_t)LeftByte , (int16_t)RightByte );
+
+	DmaSnd_ResamplePos = ( DmaSnd_ResamplePos + 1 ) & DMASND_RESAMPLE_MASK;
+	DmaSnd_ResampleLeft[ DmaSnd_ResamplePos ] = dma.FrameLeft;
+	DmaSnd_ResampleRight[ DmaSnd_ResamplePos ] = dma.FrameRight;
+}
+
+/**
+ * Same as DmaSnd_GenerateSamples() when DMA sound is playing, but with
+ * a band limited resampling of the DMA samples (see resample.c) instead
+ * of repeating / skipping them.
+ */
+static void DmaSnd_GenerateSamples_Sinc(int nMixBufIdx, int nSamplesToGenerate, int64_t FreqRatio)
+{
+	bool bMono = dma.soundMode & DMASNDMODE_MONO;
+	int16_t left , right;
+	int i, nBufIdx;
+	unsigned n;
+
+	Resample_SetRates ( &DmaSnd_Resampler , DmaSnd_DetectSampleRate() , nAudioFrequency );
+
+	for (i = 0; i < nSamplesToGenerate; i++)
+	{
+		if ( DmaInitSample )
+		{
+			DmaSnd_ResamplePull ( bMono );
+			DmaInitSample = false;
+		}
+
+		left = Resample_Sample ( &DmaSnd_Resampler , DmaSnd_ResampleLeft , DMASND_RESAMPLE_MASK ,
+				DmaSnd_ResamplePos , (uint32_t)frameCounter_float );
+		if ( bMono )
+			right = left;
+		else
+			right = Resample_Sample ( &DmaSnd_Resampler , DmaSnd_ResampleRight , DMASND_RESAMPLE_MASK ,
+					DmaSnd_ResamplePos , (uint32_t)frameCounter_float );
+
+		nBufIdx = (nMixBufIdx + i) & AUDIOMIXBUFFER_SIZE_MASK;
+
+		switch (microwire.mixing) {
+			case 1:
+				/* DMA and YM2149 mixing */
+				AudioMixBuffer[nBufIdx][0] = AudioMixBuffer[nBufIdx][0] + left * -((256*3/4)/4)/4;
+				AudioMixBuffer[nBufIdx][1] = AudioMixBuffer[nBufIdx][1] + right * -((256*3/4)/4)/4;
+				break;
+			default:
+				/* mixing=0 DMA only */
+				/* mixing=2 DMA and input 2 (YM2149 LPF) -> DMA */
+				/* mixing=3 DMA and input 3 -> DMA */
+				AudioMixBuffer[nBufIdx][0] = left * -((256*3/4)/4)/4;
+				AudioMixBuffer[nBufIdx][1] = right * -((256*3/4)/4)/4;
+				break;
+		}
+
+		/* Increase freq counter */
+		frameCounter_float += FreqRatio;
+		n = frameCounter_float >> 32;				/* number of samples to skip */
+		while ( n > 0 )						/* pull as many samples from the FIFO as needed */
+		{
+			DmaSnd_ResamplePull ( bMono );
+			n--;
+		}
+		frameCounter_float &= 0xffffffff;			/* only keep the fractional part */
+	}
+}
+
+
 /*-----------------------------------------------------------------------*/
 /**
  * Apply LMC1992 sound modifications (Bass and Treble)
  * The Bass and Treble get samples at nAudioFrequency rate.
  * The tone control's sampling frequency must be at least 22050 Hz to sound good.
+ * The filters are applied to whole blocks of AudioMixBuffer (see lmc1992.c).
  */
 static void DmaSnd_Apply_LMC(int nMixBufIdx, int nSamplesToGenerate)
 {
-	int nBufIdx;
-	int i;
-	int32_t sample;
+	int n;
 
-	/* Apply LMC1992 sound modifications (Left, Right and Master Volume) */
-	for (i = 0; i < nSamplesToGenerate; i++) {
-		nBufIdx = (nMixBufIdx + i) & AUDIOMIXBUFFER_SIZE_MASK;
+	/* Current settings, kept in registers for the whole block */
+	memcpy(DmaSnd_LmcChain.coef, lmc1992.coef, sizeof(DmaSnd_LmcChain.coef));
+	DmaSnd_LmcChain.gain[0] = lmc1992.left_gain;
+	DmaSnd_LmcChain.gain[1] = lmc1992.right_gain;
+	DmaSnd_LmcChain.bHPF = ( YM2149_HPF_Filter != YM2149_HPF_FILTER_NONE );
 
-		sample = DmaSnd_IIRfilterL( Subsonic_IIR_HPF_Left( AudioMixBuffer[nBufIdx][0]));
-		if (sample<-32767)						/* check for overflow to clip waveform */
-			sample = -32767;
-		else if (sample>32767)
-			sample = 32767;
-		AudioMixBuffer[nBufIdx][0] = sample;
-
-		sample = DmaSnd_IIRfilterR( Subsonic_IIR_HPF_Right(AudioMixBuffer[nBufIdx][1]));
-		if (sample<-32767)						/* check for overflow to clip waveform */
-			sample = -32767;
-		else if (sample>32767)
-			sample = 32767;
-		AudioMixBuffer[nBufIdx][1] = sample;
- 	}
+	/* Filter the contiguous parts of the ring buffer */
+	nMixBufIdx &= AUDIOMIXBUFFER_SIZE_MASK;
+	while (nSamplesToGenerate > 0)
+	{
+		n = AUDIOMIXBUFFER_SIZE - nMixBufIdx;
+		if (n > nSamplesToGenerate)
+			n = nSamplesToGenerate;
+		Lmc1992_Filter(&DmaSnd_LmcChain, &AudioMixBuffer[nMixBufIdx], n);
+		nMixBufIdx = (nMixBufIdx + n) & AUDIOMIXBUFFER_SIZE_MASK;
+		nSamplesToGenerate -= n;
+	}
 }
 
 
@@ -733,7 +832,7 @@ void DmaSnd_STE_HBL_Update(void)
 	DmaSnd_FIFO_Refill ();
 
 	/* If DMA sound is ON or FIFO is not empty, update sound */
-	if  ( (nDmaSoundControl & DMASNDCTRL_PLAY) || ( dma.FIFO_NbBytes > 0 ) )
+	if ( DmaSnd_IsPlaying() )
 		Sound_Update ( CyclesGlobalClockCounter );
 
 	/* As long as display is OFF, the DMA will refill the FIFO after playing some samples during the HBL */
@@ -1048,7 +1147,7 @@ void DmaSnd_InterruptHandler_Microwire(void)
 	}
 	
 	/* How many cycle was this sound interrupt delayed (>= 0) */
-	microwire.pendingCyclesOver += -INT_CONVERT_FROM_INTERNAL ( PendingInterruptCount , INT_CPU_CYCLE );
+	microwire.pendingCyclesOver += -INT_CONVERT_FROM_INTERNAL ( CycInt_DelayedCycles , INT_CPU_CYCLE );
 
 	/* Remove this interrupt from list and re-order */
 	CycInt_AcknowledgeInterrupt();
@@ -1257,94 +1356,28 @@ void DmaSnd_MicrowireMask_WriteWord(void)
 /*-------------------Bass / Treble filter ---------------------------*/
 
 /**
- * Left voice Filter for Bass/Treble.
- */
-static float DmaSnd_IIRfilterL(float xn)
-{
-	static float data[2] = { 0.0, 0.0 };
-	float a, yn;
-
-	/* Input coefficients */
-	/* biquad1  Note: 'a' coefficients are subtracted */
-	a  = lmc1992.left_gain * xn;		/* a=g*xn;               */
-	a -= lmc1992.coef[0] * data[0];		/* a1;  wn-1             */
-	a -= lmc1992.coef[1] * data[1];		/* a2;  wn-2             */
-						/* If coefficient scale  */
-						/* factor = 0.5 then     */
-						/* multiply by 2         */
-	/* Output coefficients */
-	yn  = lmc1992.coef[2] * a;		/* b0;                   */
-	yn += lmc1992.coef[3] * data[0];	/* b1;                   */
-	yn += lmc1992.coef[4] * data[1];	/* b2;                   */
-
-	data[1] = data[0];			/* wn-1 -> wn-2;         */
-	data[0] = a;				/* wn -> wn-1            */
-	return yn;
-}
-
-
-/**
- * Right voice Filter for Bass/Treble.
+ * Stereo low pass filter for the samples read from the FIFO, the result
+ * is stored in dma.FrameLeft and dma.FrameRight (filter gain = 4)
  */
-static float DmaSnd_IIRfilterR(float xn)
+static void DmaSnd_LowPassFilter(int16_t left, int16_t right)
 {
-	static float data[2] = { 0.0, 0.0 };
-	float a, yn;
-
-	/* Input coefficients */
-	/* biquad1  Note: 'a' coefficients are subtracted */
-	a  = lmc1992.right_gain * xn;		/* a=g*xn;               */
-	a -= lmc1992.coef[0]*data[0];		/* a1;  wn-1             */
-	a -= lmc1992.coef[1]*data[1];		/* a2;  wn-2             */
-						/* If coefficient scale  */
-						/* factor = 0.5 then     */
-						/* multiply by 2         */
-	/* Output coefficients */
-	yn  = lmc1992.coef[2]*a;		/* b0;                   */
-	yn += lmc1992.coef[3]*data[0];		/* b1;                   */
-	yn += lmc1992.coef[4]*data[1];		/* b2;                   */
-
-	data[1] = data[0];			/* wn-1 -> wn-2;         */
-	data[0] = a;				/* wn -> wn-1            */
-	return yn;
-}
-
-/**
- * LowPass Filter Left
- */
-static int16_t DmaSnd_LowPassFilterLeft(int16_t in)
-{
-	static	int16_t	lowPassFilter[2] = { 0, 0 };
-	static	int16_t	out = 0;
+	static	int16_t	lowPassFilter[2][2];		/* [left/right][n-2, n-1] */
 
 	if (DmaSnd_LowPass)
-		out = lowPassFilter[0] + (lowPassFilter[1]<<1) + in;
-	else
-		out = lowPassFilter[1] << 2;
-
-	lowPassFilter[0] = lowPassFilter[1];
-	lowPassFilter[1] = in;
-
-	return out; /* Filter Gain = 4 */
-}
-
-/**
- * LowPass Filter Right
- */
-static int16_t DmaSnd_LowPassFilterRight(int16_t in)
-{
-	static	int16_t	lowPassFilter[2] = { 0, 0 };
-	static	int16_t	out = 0;
-
-	if (DmaSnd_LowPass)
-		out = lowPassFilter[0] + (lowPassFilter[1]<<1) + in;
+	{
+		dma.FrameLeft  = lowPassFilter[0][0] + (lowPassFilter[0][1]<<1) + left;
+		dma.FrameRight = lowPassFilter[1][0] + (lowPassFilter[1][1]<<1) + right;
+	}
 	else
-		out = lowPassFilter[1] << 2;
-
-	lowPassFilter[0] = lowPassFilter[1];
-	lowPassFilter[1] = in;
+	{
+		dma.FrameLeft  = lowPassFilter[0][1] << 2;
+		dma.FrameRight = lowPassFilter[1][1] << 2;
+	}
 
-	return out; /* Filter Gain = 4 */
+	lowPassFilter[0][0] = lowPassFilter[0][1];
+	lowPassFilter[0][1] = left;
+	lowPassFilter[1][0] = lowPassFilter[1][1];
+	lowPassFilter[1][1] = right;
 }
 
 /**
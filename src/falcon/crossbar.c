@@ -141,6 +141,7 @@ const char crossbar_fileid[] = "Hatari Crossbar.c";
 #include "dsp.h"
 #include "clocks_timings.h"
 #include "video.h"
+#include "resample.h"
 
 
 
@@ -342,6 +343,7 @@ static struct codec_s dac;
 static struct codec_s adc;
 static struct dsp_s dspXmit;
 static struct dsp_s dspReceive;
+static RESAMPLE_FILTER Crossbar_Resampler;	/* DAC -> host rate, for the "sinc" resampling method */
 
 /**
  * Reset Crossbar variables.
@@ -1418,7 +1420,7 @@ void Crossbar_InterruptHandler_25Mhz(void)
 {
 //fprintf ( stderr , "int25 %x\n" , crossbar.pendingCyclesOver25 );
 	/* How many cycle was this sound interrupt delayed (>= 0) */
-	crossbar.pendingCyclesOver25 += -INT_CONVERT_FROM_INTERNAL ( PendingInterruptCount , INT_CPU_CYCLE );
+	crossbar.pendingCyclesOver25 += -INT_CONVERT_FROM_INTERNAL ( CycInt_DelayedCycles , INT_CPU_CYCLE );
 
 	/* Remove this interrupt from list and re-order */
 	CycInt_AcknowledgeInterrupt();
@@ -1457,7 +1459,7 @@ void Crossbar_InterruptHandler_32Mhz(void)
 {
 //fprintf ( stderr , "int32 %x\n" , crossbar.pendingCyclesOver32 );
 	/* How many cycle was this sound interrupt delayed (>= 0) */
-	crossbar.pendingCyclesOver32 += -INT_CONVERT_FROM_INTERNAL ( PendingInterruptCount , INT_CPU_CYCLE );
+	crossbar.pendingCyclesOver32 += -INT_CONVERT_FROM_INTERNAL ( CycInt_DelayedCycles , INT_CPU_CYCLE );
 
 	/* Remove this interrupt from list and re-order */
 	CycInt_AcknowledgeInterrupt();
@@ -1974,6 +1976,9 @@ void Crossbar_GenerateSamples(int nMixBufIdx, int nSamplesToGenerate)
 		return;
 	}
 
+	if ( YM2149_Resample_Method == YM2149_RESAMPLE_METHOD_SINC )
+		Resample_SetRates ( &Crossbar_Resampler , Crossbar_DetectSampleRate(25) , nAudioFrequency );
+
 	for (i = 0; i < nSamplesToGenerate; i++)
 	{
 		nBufIdx = (nMixBufIdx + i) & AUDIOMIXBUFFER_SIZE_MASK;
@@ -2010,6 +2015,13 @@ void Crossbar_GenerateSamples(int nMixBufIdx, int nSamplesToGenerate)
 			dac_read_left = 0;
 			dac_read_right = 0;
 		}
+		else if ( YM2149_Resample_Method == YM2149_RESAMPLE_METHOD_SINC )
+		{
+			dac_read_left = Resample_Sample ( &Crossbar_Resampler , dac.buffer_left , DACBUFFER_SIZE-1 ,
+					dac.readPosition , (uint32_t)dac.readPosition_float );
+			dac_read_right = Resample_Sample ( &Crossbar_Resampler , dac.buffer_right , DACBUFFER_SIZE-1 ,
+					dac.readPosition , (uint32_t)dac.readPosition_float );
+		}
 		else
 		{
 			dac_read_left = dac.buffer_left[dac.readPosition];
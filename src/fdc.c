@@ -2311,7 +2311,7 @@ void FDC_InterruptHandler_Update ( void )
 
 	/* Number of internal cycles we went over for this timer ( <= 0 ) */
 	/* Used to restart the next timer and keep a constant rate (important for DMA transfers) */
-	PendingCyclesOver = -PendingInterruptCount;			/* >= 0 */
+	PendingCyclesOver = -CycInt_DelayedCycles;			/* >= 0 */
 
 //fprintf ( stderr , "fdc int handler %lld delay %d\n" , CyclesGlobalClockCounter, PendingCyclesOver );
 
@@ -16,8 +16,11 @@ extern int pulse_swallowing_count;
 
 extern void Audio_Init(void);
 extern void Audio_UnInit(void);
-extern void Audio_Lock(void);
-extern void Audio_Unlock(void);
+extern void Audio_NewSamples(void);
+extern bool Audio_StartSynthThread(void);
+extern void Audio_StopSynthThread(void);
+extern void Audio_WakeSynthThread(void);
+extern void Audio_WaitSynthThread(void);
 extern void Audio_FreeSoundBuffer(void);
 extern void Audio_EnableAudio(bool bEnable);
 
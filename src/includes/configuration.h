@@ -83,6 +83,8 @@ typedef struct
   int SdlAudioBufferSize;
   char szYMCaptureFileName[FILENAME_MAX];
   int YmVolumeMixing;
+  int ResampleMethod;
+  bool bSynthThread;
 } CNF_SOUND;
 
 
@@ -323,6 +325,9 @@ typedef struct
   bool bResizable;
   bool bUseVsync;
   bool bUseSdlRenderer;
+  bool bHeadless;                 /* convert screen only for screenshots / recording */
+  bool bDirectLines;              /* convert lines without effects from ST RAM */
+  bool bScanlines;                /* half intensity for every other zoomed line */
   int ScreenShotFormat;
   char szScreenShotDir[FILENAME_MAX];
   float nZoomFactor;
@@ -403,6 +408,7 @@ typedef struct
   bool bPatchTimerD;
   bool bFastBoot;                 /* Enable to patch TOS for fast boot */
   bool bFastForward;
+  bool bFastForwardIdleSkip;      /* TRUE to skip cpu idle loops in fast forward mode */
   bool bAddressSpace24;           /* true if using a 24-bit address bus */
   VIDEOTIMINGMODE VideoTimingMode;
 
@@ -412,6 +418,9 @@ typedef struct
   bool bCompatibleFPU;            /* More compatible FPU */
   bool bSoftFloatFPU;
   bool bMMU;                      /* TRUE if MMU is enabled */
+  bool bMmuHostAtc;               /* TRUE to use the bigger hashed MMU ATC (not cycle exact) */
+  bool bJIT;                      /* TRUE if the 68020+ JIT compiler is enabled */
+  bool bBlockCache;               /* TRUE to use the pre-decoded block cache (68000) */
 } CNF_SYSTEM;
 
 typedef struct
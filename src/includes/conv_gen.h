@@ -13,7 +13,9 @@ void ConvGen_SetPaletteColor(uint8_t idx, uint8_t red, uint8_t green, uint8_t bl
 void ConvGen_GetPaletteColor(int idx, uint8_t *r, uint8_t *g, uint8_t *b);
 void ConvGen_MemorySnapShot_Capture(bool bSave);
 
-void ConvGen_Convert(uint32_t vaddr, void *fvram, int vw, int vh,
+void ConvGen_SetFullUpdate(void);
+bool ConvGen_GetDirtyLines(int *top, int *bottom);
+bool ConvGen_Convert(uint32_t vaddr, void *fvram, int vw, int vh,
                      int vbpp, int nextline, int hscroll,
                      int leftBorderSize, int rightBorderSize,
                      int upperBorderSize, int lowerBorderSize);
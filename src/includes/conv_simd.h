@@ -0,0 +1,67 @@
+/*
+  Hatari - conv_simd.h
+
+  This file is distributed under the GNU General Public License, version 2
+  or at your option any later version. Read the file gpl.txt for details.
+*/
+
+#ifndef HATARI_CONV_SIMD_H
+#define HATARI_CONV_SIMD_H
+
+/* Convert and palette-map 'blocks' blocks of 16 pixels of a line, skipping
+ * the blocks which are the same in 'st' and 'copy' unless 'update' is set.
+ * Low res pixels are doubled on X when 'doubled' is set.
+ * Return true if at least one block was drawn.
+ * NULL if there's no kernel for the host cpu.
+ */
+extern bool (*ConvSimd_LowLine)(const uint32_t *st, const uint32_t *copy, uint32_t *dst,
+                                int blocks, bool update, const uint32_t *palette, bool doubled);
+extern bool (*ConvSimd_MedLine)(const uint32_t *st, const uint32_t *copy, uint32_t *dst,
+                                int blocks, bool update, const uint32_t *palette);
+
+/* Convert 'blocks' blocks of 16 pixels of a line to 1 byte per pixel
+ * (palette index), for the Spec512 converters which change the palette
+ * while plotting the line. NULL if there's no kernel for the host cpu.
+ */
+extern void (*ConvSimd_LowPixels)(const uint32_t *st, uint8_t *pixels, int blocks);
+extern void (*ConvSimd_MedPixels)(const uint32_t *st, uint8_t *pixels, int blocks);
+
+/* Host screen pixel format for ConvSimd_HiColorLine : 8 bits per component,
+ * 'base' holding the bits set for a black pixel (alpha)
+ */
+typedef struct
+{
+	uint32_t base;
+	int rshift, gshift, bshift;
+} CONVSIMD_RGB;
+
+/* Convert 'blocks' blocks of 16 pixels of TT / Falcon interleaved bitplanes
+ * ('bpp' = 1, 2, 4 or 8 planes) to 1 byte per pixel. NULL if there's no
+ * kernel for the host cpu.
+ */
+extern void (*ConvSimd_BitplanePixels)(const uint16_t *planes, int bpp, uint8_t *pixels, int blocks);
+/* Map 'count' palette indexes to colors (always set with ConvSimd_BitplanePixels) */
+extern void (*ConvSimd_PaletteLine)(const uint8_t *pixels, uint32_t *dst, int count,
+                                    const uint32_t *palette);
+/* Convert 'count' Falcon 16 bit (big endian RGB565) pixels. NULL if there's
+ * no kernel for the host cpu.
+ */
+extern void (*ConvSimd_HiColorLine)(const uint16_t *src, uint32_t *dst, int count,
+                                    const CONVSIMD_RGB *format);
+/* dst[i] = src[xtable[i]] for 'count' pixels. NULL if there's no kernel
+ * faster than a plain loop for the host cpu.
+ */
+extern void (*ConvSimd_ZoomLine)(const uint32_t *src, uint32_t *dst, int count, const int *xtable);
+/* Write each of 'count' pixels 'factor' times (integer zoom on X, kernels
+ * for factors 2, 3 and 4). NULL if there's no kernel for the host cpu.
+ */
+extern void (*ConvSimd_ScaleLine)(const uint32_t *src, uint32_t *dst, int count, int factor);
+/* dst[i] = (src[i] >> 1) & mask for 'count' pixels, i.e. half intensity
+ * for TV mode / scanlines. NULL if there's no kernel for the host cpu.
+ */
+extern void (*ConvSimd_HalveLine)(const uint32_t *src, uint32_t *dst, int count, uint32_t mask);
+
+/* Select the kernels of a SIMD_* level (simd.h) */
+extern int ConvSimd_Init(int level);
+
+#endif /* HATARI_CONV_SIMD_H */
@@ -30,6 +30,9 @@
 /* Number of visible screen lines including top/bottom borders */
 #define NUM_VISIBLE_LINES  (OVERSCAN_TOP+200+MAX_OVERSCAN_BOTTOM)
 
+/* Lines of the 'screen' which can be left in ST RAM (color or mono lines) */
+#define MAX_SOURCE_LINES  400
+
 /* Number of visible pixels on each screen line including left/right borders */
 #define NUM_VISIBLE_LINE_PIXELS (48+320+48)
 
@@ -47,6 +50,8 @@ typedef struct
   uint8_t *pSTScreen;           /* Copy of screen built up during frame (copy each line on HBL to simulate monitor raster) */
   uint8_t *pSTScreenCopy;       /* Previous frames copy of above  */
   int VerticalOverscanCopy;     /* Previous screen overscan mode */
+  uint8_t *pLineSource[MAX_SOURCE_LINES];  /* ST RAM of the lines not copied to pSTScreen, else NULL */
+  int nLineSources;             /* Number of lines left in ST RAM during the frame */
   bool bFullUpdate;             /* Set TRUE to cause full update on next draw */
 } FRAMEBUFFER;
 
@@ -91,6 +96,9 @@ extern uint32_t HBLPaletteMasks[HBL_PALETTE_MASKS];
 extern uint32_t *pHBLPaletteMasks;
 extern int STScreenLineOffset[NUM_VISIBLE_LINES];
 
+/* Max number of separate bands of changed host screen lines */
+#define CONVST_DIRTY_BANDS 8
+
 void ConvST_Init(void);
 void ConvST_UnInit(void);
 void ConvST_Reset(void);
@@ -98,6 +106,9 @@ void ConvST_SetSTResolution(bool bForceChange);
 void ConvST_ChangeResolution(bool bForceChange);
 void ConvST_SetFullUpdate(void);
 void ConvST_Refresh(bool force_flip);
+void ConvST_SaveFrame(void);
+void ConvST_RefreshOnDemand(void);
 bool ConvST_DrawFrame(void);
+int ConvST_GetDirtyBands(int *top, int *bottom);
 
 #endif  /* ifndef HATARI_SCRCONVST_H */
@@ -63,9 +63,9 @@ typedef enum
 						(cyc) >> ( nCpuFreqShift + CYCINT_SHIFT ) )
 
 
-extern void (*PendingInterruptFunction)(void);
-extern int PendingInterruptCount;
+extern int	CycInt_DelayedCycles;
 extern uint64_t	CycInt_ActiveInt_Cycles;
+extern uint64_t	CycInt_NextEventClock;
 
 extern void	CycInt_Reset(void);
 extern void	CycInt_MemorySnapShot_Capture(bool bSave);
@@ -80,22 +80,29 @@ extern int	CycInt_FindCyclesRemaining(interrupt_id Handler, int CycleType);
 
 extern bool	CycInt_InterruptActive(interrupt_id Handler);
 extern int	CycInt_GetActiveInt(void);
+extern int	CycInt_GetSortedInts(int *IntList);
 extern void	CycInt_CallActiveHandler(uint64_t Clock);
 
+/* Number of cpu cycles before the next event must be processed (<= 0 if it's already pending) */
+static inline int64_t CycInt_CyclesBeforeNextEvent(void)
+{
+	return (int64_t)( CycInt_NextEventClock - CyclesGlobalClockCounter );
+}
+
 static inline void CycInt_Process(void)
 {
-	while ( CycInt_ActiveInt_Cycles <= ( CyclesGlobalClockCounter << CYCINT_SHIFT ) )
+	while ( CyclesGlobalClockCounter >= CycInt_NextEventClock )
 		CycInt_CallActiveHandler( CyclesGlobalClockCounter );
 }
 static inline void CycInt_Process_stop(int stop_cond)
 {
-	while ( ( CycInt_ActiveInt_Cycles <= ( CyclesGlobalClockCounter << CYCINT_SHIFT ) ) && ( stop_cond == 0 ) )
+	while ( ( CyclesGlobalClockCounter >= CycInt_NextEventClock ) && ( stop_cond == 0 ) )
 		CycInt_CallActiveHandler( CyclesGlobalClockCounter );
 }
 /* Same as CycInt_Process but use a specific cycles clock value */
 static inline void CycInt_Process_Clock(uint64_t Clock)
 {
-	while ( CycInt_ActiveInt_Cycles <= ( Clock << CYCINT_SHIFT ) )
+	while ( Clock >= CycInt_NextEventClock )
 		CycInt_CallActiveHandler( Clock );
 }
 
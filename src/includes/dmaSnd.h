@@ -18,6 +18,7 @@ extern void DmaSnd_Reset(bool bCold);
 extern void DmaSnd_MemorySnapShot_Capture(bool bSave);
 
 extern uint8_t DmaSnd_Get_XSINT_Line(void);
+extern bool DmaSnd_IsPlaying(void);
 
 extern void DmaSnd_GenerateSamples(int nMixBufIdx, int nSamplesToGenerate);
 extern void DmaSnd_STE_HBL_Update(void);
@@ -0,0 +1,37 @@
+/*
+  Hatari - lmc1992.h
+
+  This file is distributed under the GNU General Public License, version 2
+  or at your option any later version. Read the file gpl.txt for details.
+*/
+
+#ifndef HATARI_LMC1992_H
+#define HATARI_LMC1992_H
+
+/* Max difference with the scalar code (only when the compiler fuses */
+/* the multiply-adds of the scalar code, else the result is the same) */
+#define LMC1992_TOLERANCE	2
+
+/* Subsonic high pass filter, volume and bass / treble biquad for both */
+/* channels (index 0 is the left channel, 1 the right channel) */
+typedef struct
+{
+	/* Settings */
+	float		coef[5];		/* biquad : a1 a2 b0 b1 b2 */
+	float		gain[2];		/* left / right volume * master volume */
+	bool		bHPF;			/* apply the subsonic high pass filter */
+
+	/* State */
+	int32_t		hpf_x1[2];
+	int32_t		hpf_y1[2];
+	int32_t		hpf_y0[2];
+	float		w1[2];			/* biquad's wn-1 */
+	float		w2[2];			/* biquad's wn-2 */
+} LMC1992_CHAIN;
+
+/* Select the kernel of a SIMD_* level (simd.h) */
+extern int Lmc1992_Init(int level);
+
+extern void Lmc1992_Filter(LMC1992_CHAIN *lc, int16_t (*buf)[2], int count);
+
+#endif  /* HATARI_LMC1992_H */
@@ -0,0 +1,36 @@
+/*
+  Hatari - resample.h
+
+  This file is distributed under the GNU General Public License, version 2
+  or at your option any later version. Read the file gpl.txt for details.
+*/
+
+#ifndef HATARI_RESAMPLE_H
+#define HATARI_RESAMPLE_H
+
+#define RESAMPLE_PHASES_BITS	9		/* 512 phases between 2 input samples */
+#define RESAMPLE_PHASES		( 1 << RESAMPLE_PHASES_BITS )
+#define RESAMPLE_TAPS_MAX	256		/* must be <= the size of the input ring buffers */
+
+/* Polyphase windowed-sinc filter converting from 'in_rate' to 'out_rate' */
+typedef struct
+{
+	int		in_rate;		/* Hz */
+	int		out_rate;		/* Hz */
+	int		taps;			/* coefficients per phase, multiple of 8 */
+	int16_t		*coefs;			/* RESAMPLE_PHASES rows of 'taps' coefficients (Q15) */
+	uint64_t	step;			/* input samples per output sample (32.32 fixed point) */
+} RESAMPLE_FILTER;
+
+/* Select the dot product kernel of a SIMD_* level (simd.h) */
+extern int Resample_Init(int level);
+
+extern void Resample_SetRates(RESAMPLE_FILTER *rf, int in_rate, int out_rate);
+extern void Resample_Free(RESAMPLE_FILTER *rf);
+
+extern int16_t Resample_Sample(const RESAMPLE_FILTER *rf, const int16_t *ring, int mask,
+                               int end, uint32_t frac);
+extern int Resample_Block(const RESAMPLE_FILTER *rf, const int16_t *ring, int mask,
+                          int *read, uint32_t *frac, int avail, int16_t *out, int count);
+
+#endif  /* HATARI_RESAMPLE_H */
@@ -33,6 +33,8 @@ bool Screen_SetVideoSize(int width, int height, bool bForceChange);
 void Screen_GenConvUpdate(bool update_statusbar);
 uint32_t Screen_GetGenConvWidth(void);
 uint32_t Screen_GetGenConvHeight(void);
+int Screen_GetWorkerCount(void);
+void Screen_RunWorkers(void (*func)(int idx, void *data), int jobs, void *data);
 int Screen_SaveBMP(const char *filename);
 void Screen_StatusbarMessage(const char *msg, uint32_t msecs);
 int Screen_GetUISocket(void);
@@ -0,0 +1,44 @@
+/*
+  Hatari - simd.h
+
+  Host SIMD instruction sets used by the kernels of conv_simd.c,
+  resample.c and lmc1992.c.
+
+  This file is distributed under the GNU General Public License, version 2
+  or at your option any later version. Read the file gpl.txt for details.
+*/
+
+#ifndef HATARI_SIMD_H
+#define HATARI_SIMD_H
+
+/* Kernel levels, from the scalar code to the best one for the host cpu */
+enum
+{
+	SIMD_NONE,		/* Scalar code */
+	SIMD_SSE2,
+	SIMD_AVX2,
+	SIMD_NEON,
+	SIMD_BEST		/* Best kernels supported by the host cpu */
+};
+
+/* Bit of a level in the 'levels' mask given to Simd_Select() */
+#define SIMD_LEVEL(level)	( 1 << (level) )
+
+/* The kernels of an instruction set are built when the compiler has its
+ * intrinsics, the x86 ones with a target attribute (as the rest of Hatari
+ * may be built for an older cpu) and used only if the host cpu has them.
+ */
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+# define SIMD_HOST_X86 1
+# include <immintrin.h>
+# define TARGET_SSE2 __attribute__((target("sse2")))
+# define TARGET_AVX2 __attribute__((target("avx2")))
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+# define SIMD_HOST_NEON 1
+# include <arm_neon.h>
+#endif
+
+extern int Simd_Select(int level, int levels);
+extern const char *Simd_Name(int level);
+
+#endif /* HATARI_SIMD_H */
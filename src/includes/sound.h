@@ -16,14 +16,12 @@
 
 extern int nAudioFrequency;
 extern uint8_t SoundRegs[14];		/* store YM regs 0 to 13 */
-extern int	nGeneratedSamples;
 extern bool	bEnvelopeFreqFlag;
 
 #define AUDIOMIXBUFFER_SIZE    16384		/* Size of circular buffer to store samples (eg 44Khz), must be a power of 2 */
 #define AUDIOMIXBUFFER_SIZE_MASK ( AUDIOMIXBUFFER_SIZE - 1 )	/* To limit index values inside AudioMixBuffer[] */
 extern int16_t	AudioMixBuffer[AUDIOMIXBUFFER_SIZE][2];	/* Ring buffer to store mixed audio output (YM2149, DMA sound, ...) */
 extern int	AudioMixBuffer_pos_write;	/* Current writing position into above buffer */
-extern int	AudioMixBuffer_pos_read;	/* Current reading position into above buffer */
 
 extern bool	Sound_BufferIndexNeedReset;
 
@@ -60,23 +58,38 @@ extern int	YM2149_HPF_Filter;
 #define		YM2149_RESAMPLE_METHOD_NEAREST			0
 #define		YM2149_RESAMPLE_METHOD_WEIGHTED_AVERAGE_2	1
 #define		YM2149_RESAMPLE_METHOD_WEIGHTED_AVERAGE_N	2
+#define		YM2149_RESAMPLE_METHOD_SINC			3	/* Also used for DMA / crossbar sound */
 extern int	YM2149_Resample_Method;
 
+#define		YM2149_SYNTH_METHOD_CYCLES		0	/* Step all counters on every 250 kHz cycle */
+#define		YM2149_SYNTH_METHOD_EVENTS		1	/* Go from one counter event to the next (or */
+								/* step all cycles when events are too close) */
+extern int	YM2149_Synth_Method;
+
+/* Average cycles between output events below which the events method */
+/* steps all cycles (measured with tests/unit/test-ym2149, 0 to disable) */
+#define		YM2149_SYNTH_MIN_RUN			8
+extern int	YM2149_Synth_MinRun;
+
 
 extern void Sound_Init(void);
 extern void Sound_Reset(void);
 extern void Sound_ResetBufferIndex(void);
 extern void Sound_MemorySnapShot_Capture(bool bSave);
 extern void Sound_Stats_Show (void);
+extern int Sound_GetBufferedSamples(void);
+extern int Sound_ReadSamples(int16_t (*pBuffer)[2], int len);
 extern void Sound_Update(uint64_t CPU_Clock);
+extern void Sound_UpdateYM(uint64_t CPU_Clock);
 extern void Sound_Update_VBL(void);
 extern void Sound_WriteReg(int reg, uint8_t data);
 extern bool Sound_BeginRecording(char *pszCaptureFileName);
 extern void Sound_EndRecording(void);
 extern bool Sound_AreWeRecording(void);
 extern void Sound_SetYmVolumeMixing(void);
+extern void Sound_SetSynthThread(bool bEnable);
+extern void Sound_RunSynthLog(void);
 extern ymsample Subsonic_IIR_HPF_Left(ymsample x0);
-extern ymsample Subsonic_IIR_HPF_Right(ymsample x0);
 extern void Sound_SetOutputAudioFreq(int Frequency);
 
 #endif  /* HATARI_SOUND_H */
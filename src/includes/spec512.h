@@ -8,13 +8,23 @@
 #ifndef HATARI_SPEC512_H
 #define HATARI_SPEC512_H
 
+/* Palette change within the displayed pixels of a line */
+typedef struct
+{
+	uint16_t Colour;      /* ST Colour value */
+	uint8_t Span;         /* 4 cycles period, from the first displayed pixel */
+	uint8_t Index;        /* Index into 'STRGBPalette' (0...15) */
+}
+SPEC512CHANGE;
+
 extern bool Spec512_IsImage(void);
 extern void Spec512_StartVBL(void);
+extern void Spec512_SwapFrame(void);
 extern void Spec512_StoreCyclePalette(uint16_t col, uint32_t addr);
-extern void Spec512_StartFrame(void);
-extern void Spec512_ScanWholeLine(void);
-extern void Spec512_StartScanLine(void);
-extern void Spec512_EndScanLine(void);
+extern void Spec512_StartFrame(int nLines, int nLineSpans);
+extern void Spec512_StartScanLine(bool bMedium);
+extern bool Spec512_LineChanged(void);
+extern int Spec512_GetLineChanges(const SPEC512CHANGE **ppChanges);
 extern void Spec512_UpdatePaletteSpan(void);
 
 #endif  /* HATARI_SPEC512_H */
@@ -168,6 +168,11 @@ extern int VblJitterIndex;
 extern const int VblJitterArray[VBL_JITTER_ARRAY_SIZE];
 extern const int VblJitterArrayPending[VBL_JITTER_ARRAY_SIZE];
 
+#define VIDEO_LINE_PAGE_SHIFT	8			/* Direct lines are tracked per 256 bytes */
+#define VIDEO_LINE_PAGES	( 0x1000000 >> VIDEO_LINE_PAGE_SHIFT )
+extern uint8_t Video_LinePageGen[ VIDEO_LINE_PAGES ];
+extern uint8_t Video_LineGen;
+
 
 /*--------------------------------------------------------------*/
 /* Functions prototypes						*/
@@ -200,6 +205,8 @@ extern void	Video_InterruptHandler_HBL(void);
 extern void	Video_InterruptHandler_EndLine(void);
 
 extern void	Video_Set_Memcpy ( bool Force_MMU_Translation );
+extern void	Video_LineSourceFlush ( uint32_t addr );
+extern void	Video_LineSourceInvalidate ( uint32_t addr , int size );
 
 extern void	Video_SetScreenRasters(void);
 extern void	Video_GetTTRes(int *width, int *height, int *bpp);
@@ -266,4 +273,16 @@ extern void Video_TTColorRegs_STRegWrite(void);
 
 extern void Video_Info(FILE *fp, uint32_t dummy);
 
+
+/**
+ * Called before every write to ST RAM ('addr' is the physical address) :
+ * if a line displayed during this frame is still read from this page (see
+ * Video_SetLineSource()), it is copied before the RAM changes.
+ */
+static inline void Video_LineSourceWrite ( uint32_t addr )
+{
+	if ( Video_LinePageGen[ ( addr & 0xffffff ) >> VIDEO_LINE_PAGE_SHIFT ] == Video_LineGen )
+		Video_LineSourceFlush ( addr );
+}
+
 #endif  /* HATARI_VIDEO_H */
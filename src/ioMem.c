@@ -42,6 +42,7 @@ const char IoMem_fileid[] = "Hatari ioMem.c";
 #include "scc.h"
 #include "fdc.h"
 #include "scu_vme.h"
+#include "idleloop.h"
 
 
 #define	IO_MEM_INTERCEPT_START		0xff8000
@@ -458,6 +459,7 @@ uae_u32 REGPARAM3 IoMem_bget(uaecptr addr)
 	}
 
 	addr &= 0x00ffffff;                           /* Use a 24 bit address */
+	IdleLoop_IoAccess(addr, 1, false);
 
 	if (addr < IO_MEM_INTERCEPT_START || !is_super_access(true))
 	{
@@ -513,6 +515,7 @@ uae_u32 REGPARAM3 IoMem_wget(uaecptr addr)
 	}
 
 	addr &= 0x00ffffff;                           /* Use a 24 bit address */
+	IdleLoop_IoAccess(addr, 2, false);
 
 	if (addr < IO_MEM_INTERCEPT_START || !is_super_access(true))
 	{
@@ -580,6 +583,7 @@ uae_u32 REGPARAM3 IoMem_lget(uaecptr addr)
 	}
 
 	addr &= 0x00ffffff;                           /* Use a 24 bit address */
+	IdleLoop_IoAccess(addr, 4, false);
 
 	if (addr < IO_MEM_INTERCEPT_START || !is_super_access(true))
 	{
@@ -646,6 +650,7 @@ void REGPARAM3 IoMem_bput(uaecptr addr, uae_u32 val)
 	}
 
 	addr &= 0x00ffffff;                           /* Use a 24 bit address */
+	IdleLoop_IoAccess(addr, 1, true);
 
 	LOG_TRACE(TRACE_IOMEM_WR, "IO write.b $%08x = $%02x pc=%x\n", IoAccessFullAddress, val&0xff, M68000_GetPC());
 
@@ -697,6 +702,7 @@ void REGPARAM3 IoMem_wput(uaecptr addr, uae_u32 val)
 	}
 
 	addr &= 0x00ffffff;                           /* Use a 24 bit address */
+	IdleLoop_IoAccess(addr, 2, true);
 
 	LOG_TRACE(TRACE_IOMEM_WR, "IO write.w $%08x = $%04x pc=%x\n", IoAccessFullAddress, val&0xffff, M68000_GetPC());
 
@@ -760,6 +766,7 @@ void REGPARAM3 IoMem_lput(uaecptr addr, uae_u32 val)
 	}
 
 	addr &= 0x00ffffff;                           /* Use a 24 bit address */
+	IdleLoop_IoAccess(addr, 4, true);
 
 	LOG_TRACE(TRACE_IOMEM_WR, "IO write.l $%08x = $%08x pc=%x\n", IoAccessFullAddress, val, M68000_GetPC());
 
@@ -0,0 +1,261 @@
+/*
+  Hatari - lmc1992.c
+
+  Tone and volume chain of the STE / TT LMC1992, applied to blocks of
+  the audio mix buffer : subsonic high pass filter (same as the YM2149's
+  one in sound.c), left / right volume and a biquad combining the bass
+  and treble shelves, then clipping to 16 bits.
+
+  The filters are recursive, so the samples of a channel can't be
+  computed in parallel ; instead both channels are computed together in
+  the lanes of a SSE2 or NEON register when the host cpu has them, with
+  the settings and the filters' state kept in registers for the whole
+  block. The operations are done in the same order as in the scalar
+  code, so the result is the same (within LMC1992_TOLERANCE if the
+  compiler fuses the multiply-adds of the scalar code).
+
+  This file is distributed under the GNU General Public License, version 2
+  or at your option any later version. Read the file gpl.txt for details.
+*/
+const char Lmc1992_fileid[] = "Hatari lmc1992.c";
+
+#include <string.h>
+
+#include "main.h"
+#include "lmc1992.h"
+#include "simd.h"
+
+#define LMC1992_LEVELS		( SIMD_LEVEL(SIMD_SSE2) | SIMD_LEVEL(SIMD_NEON) )
+
+static void (*Lmc1992_Kernel)(LMC1992_CHAIN *lc, int16_t (*buf)[2], int count);
+
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Scalar code, one channel after the other for each sample.
+ * 6dB/octave first order HPF at 13.7 Hz for 44100 Hz (see sound.c),
+ * its output is truncated to 16 bits as with Subsonic_IIR_HPF_Left().
+ * The clipping is done before the float to int conversion (same result
+ * as clipping after it, without overflow for big values).
+ */
+static void Generic_Filter(LMC1992_CHAIN *lc, int16_t (*buf)[2], int count)
+{
+	int32_t x0, y0;
+	float a, yn;
+	int i, c;
+
+	for (i = 0; i < count; i++)
+	{
+		for (c = 0; c < 2; c++)
+		{
+			x0 = buf[i][c];
+			if (lc->bHPF)
+			{
+				lc->hpf_y1[c] += ((x0 - lc->hpf_x1[c]) * 32768) - (lc->hpf_y0[c] * 64);
+				y0 = lc->hpf_y0[c] = lc->hpf_y1[c] / 32768;
+				lc->hpf_x1[c] = x0;
+				x0 = (int16_t)y0;
+			}
+
+			a  = lc->gain[c] * x0;
+			a -= lc->coef[0] * lc->w1[c];
+			a -= lc->coef[1] * lc->w2[c];
+
+			yn  = lc->coef[2] * a;
+			yn += lc->coef[3] * lc->w1[c];
+			yn += lc->coef[4] * lc->w2[c];
+
+			lc->w2[c] = lc->w1[c];
+			lc->w1[c] = a;
+
+			if (yn < -32767)
+				yn = -32767;
+			else if (yn > 32767)
+				yn = 32767;
+			buf[i][c] = (int32_t)yn;
+		}
+	}
+}
+
+#ifdef SIMD_HOST_X86
+/**
+ * Left and right channels in lanes 0 and 1 (lanes 2 and 3 are unused)
+ */
+TARGET_SSE2
+static void Sse2_Filter(LMC1992_CHAIN *lc, int16_t (*buf)[2], int count)
+{
+	__m128i x0, x1, y0, y1, bias, out;
+	__m128 gain, c0, c1, c2, c3, c4, w1, w2, a, yn, vmin, vmax;
+	uint32_t pair;
+	int i;
+
+	x1 = _mm_setr_epi32(lc->hpf_x1[0], lc->hpf_x1[1], 0, 0);
+	y1 = _mm_setr_epi32(lc->hpf_y1[0], lc->hpf_y1[1], 0, 0);
+	y0 = _mm_setr_epi32(lc->hpf_y0[0], lc->hpf_y0[1], 0, 0);
+	w1 = _mm_setr_ps(lc->w1[0], lc->w1[1], 0, 0);
+	w2 = _mm_setr_ps(lc->w2[0], lc->w2[1], 0, 0);
+	gain = _mm_setr_ps(lc->gain[0], lc->gain[1], 0, 0);
+	c0 = _mm_set1_ps(lc->coef[0]);
+	c1 = _mm_set1_ps(lc->coef[1]);
+	c2 = _mm_set1_ps(lc->coef[2]);
+	c3 = _mm_set1_ps(lc->coef[3]);
+	c4 = _mm_set1_ps(lc->coef[4]);
+	bias = _mm_set1_epi32(32767);
+	vmin = _mm_set1_ps(-32767);
+	vmax = _mm_set1_ps(32767);
+
+	for (i = 0; i < count; i++)
+	{
+		/* Sign extend the left / right samples to 32 bits */
+		memcpy(&pair, buf[i], sizeof(pair));
+		x0 = _mm_cvtsi32_si128(pair);
+		x0 = _mm_srai_epi32(_mm_unpacklo_epi16(x0, x0), 16);
+
+		if (lc->bHPF)
+		{
+			/* y1 += (x0 - x1) * 32768 - y0 * 64 ; y0 = y1 / 32768 */
+			y1 = _mm_add_epi32(y1, _mm_sub_epi32(_mm_slli_epi32(_mm_sub_epi32(x0, x1), 15),
+			                                     _mm_slli_epi32(y0, 6)));
+			y0 = _mm_srai_epi32(_mm_add_epi32(y1, _mm_and_si128(_mm_srai_epi32(y1, 31), bias)), 15);
+			x1 = x0;
+			x0 = _mm_srai_epi32(_mm_slli_epi32(y0, 16), 16);
+		}
+
+		a = _mm_mul_ps(gain, _mm_cvtepi32_ps(x0));
+		a = _mm_sub_ps(a, _mm_mul_ps(c0, w1));
+		a = _mm_sub_ps(a, _mm_mul_ps(c1, w2));
+
+		yn = _mm_mul_ps(c2, a);
+		yn = _mm_add_ps(yn, _mm_mul_ps(c3, w1));
+		yn = _mm_add_ps(yn, _mm_mul_ps(c4, w2));
+
+		w2 = w1;
+		w1 = a;
+
+		yn = _mm_min_ps(_mm_max_ps(yn, vmin), vmax);
+		out = _mm_cvttps_epi32(yn);
+		pair = _mm_cvtsi128_si32(_mm_packs_epi32(out, out));
+		memcpy(buf[i], &pair, sizeof(pair));
+	}
+
+	lc->hpf_x1[0] = _mm_cvtsi128_si32(x1);
+	lc->hpf_x1[1] = _mm_cvtsi128_si32(_mm_srli_si128(x1, 4));
+	lc->hpf_y1[0] = _mm_cvtsi128_si32(y1);
+	lc->hpf_y1[1] = _mm_cvtsi128_si32(_mm_srli_si128(y1, 4));
+	lc->hpf_y0[0] = _mm_cvtsi128_si32(y0);
+	lc->hpf_y0[1] = _mm_cvtsi128_si32(_mm_srli_si128(y0, 4));
+	lc->w1[0] = _mm_cvtss_f32(w1);
+	lc->w1[1] = _mm_cvtss_f32(_mm_shuffle_ps(w1, w1, _MM_SHUFFLE(1, 1, 1, 1)));
+	lc->w2[0] = _mm_cvtss_f32(w2);
+	lc->w2[1] = _mm_cvtss_f32(_mm_shuffle_ps(w2, w2, _MM_SHUFFLE(1, 1, 1, 1)));
+}
+#endif
+
+#ifdef SIMD_HOST_NEON
+/**
+ * Left and right channels in lanes 0 and 1
+ */
+static void Neon_Filter(LMC1992_CHAIN *lc, int16_t (*buf)[2], int count)
+{
+	int32x2_t x0, x1, y0, y1, bias, out;
+	float32x2_t gain, c0, c1, c2, c3, c4, w1, w2, a, yn, vmin, vmax;
+	int i;
+
+	x1 = vld1_s32(lc->hpf_x1);
+	y1 = vld1_s32(lc->hpf_y1);
+	y0 = vld1_s32(lc->hpf_y0);
+	w1 = vld1_f32(lc->w1);
+	w2 = vld1_f32(lc->w2);
+	gain = vld1_f32(lc->gain);
+	c0 = vdup_n_f32(lc->coef[0]);
+	c1 = vdup_n_f32(lc->coef[1]);
+	c2 = vdup_n_f32(lc->coef[2]);
+	c3 = vdup_n_f32(lc->coef[3]);
+	c4 = vdup_n_f32(lc->coef[4]);
+	bias = vdup_n_s32(32767);
+	vmin = vdup_n_f32(-32767);
+	vmax = vdup_n_f32(32767);
+
+	for (i = 0; i < count; i++)
+	{
+		x0 = vset_lane_s32(buf[i][1], vdup_n_s32(buf[i][0]), 1);
+
+		if (lc->bHPF)
+		{
+			/* y1 += (x0 - x1) * 32768 - y0 * 64 ; y0 = y1 / 32768 */
+			y1 = vadd_s32(y1, vsub_s32(vshl_n_s32(vsub_s32(x0, x1), 15), vshl_n_s32(y0, 6)));
+			y0 = vshr_n_s32(vadd_s32(y1, vand_s32(vshr_n_s32(y1, 31), bias)), 15);
+			x1 = x0;
+			x0 = vshr_n_s32(vshl_n_s32(y0, 16), 16);
+		}
+
+		/* Separate multiplies and adds, as in the scalar code */
+		a = vmul_f32(gain, vcvt_f32_s32(x0));
+		a = vsub_f32(a, vmul_f32(c0, w1));
+		a = vsub_f32(a, vmul_f32(c1, w2));
+
+		yn = vmul_f32(c2, a);
+		yn = vadd_f32(yn, vmul_f32(c3, w1));
+		yn = vadd_f32(yn, vmul_f32(c4, w2));
+
+		w2 = w1;
+		w1 = a;
+
+		yn = vmin_f32(vmax_f32(yn, vmin), vmax);
+		out = vcvt_s32_f32(yn);
+		buf[i][0] = vget_lane_s32(out, 0);
+		buf[i][1] = vget_lane_s32(out, 1);
+	}
+
+	vst1_s32(lc->hpf_x1, x1);
+	vst1_s32(lc->hpf_y1, y1);
+	vst1_s32(lc->hpf_y0, y0);
+	vst1_f32(lc->w1, w1);
+	vst1_f32(lc->w2, w2);
+}
+#endif
+
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Select the kernel of 'level' (or the best one for SIMD_BEST).
+ * Return the selected level, SIMD_NONE if 'level' is not supported
+ * by the host cpu.
+ */
+int Lmc1992_Init(int level)
+{
+	level = Simd_Select(level, LMC1992_LEVELS);
+
+	switch (level)
+	{
+#ifdef SIMD_HOST_X86
+	 case SIMD_SSE2:
+		Lmc1992_Kernel = Sse2_Filter;
+		break;
+#endif
+#ifdef SIMD_HOST_NEON
+	 case SIMD_NEON:
+		Lmc1992_Kernel = Neon_Filter;
+		break;
+#endif
+	 default:
+		Lmc1992_Kernel = Generic_Filter;
+		level = SIMD_NONE;
+		break;
+	}
+	return level;
+}
+
+
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Apply the chain 'lc' to 'count' stereo samples of 'buf' (in place)
+ */
+void Lmc1992_Filter(LMC1992_CHAIN *lc, int16_t (*buf)[2], int count)
+{
+	if (!Lmc1992_Kernel)
+		Lmc1992_Init(SIMD_BEST);
+
+	Lmc1992_Kernel(lc, buf, count);
+}
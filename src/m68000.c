@@ -94,6 +94,8 @@ const char M68000_fileid[] = "Hatari m68000.c";
 #include "cart.h"
 #include "cpu/cpummu.h"
 #include "cpu/cpummu030.h"
+#include "cpu/blockcache.h"
+#include "cpu/idleloop.h"
 #include "scc.h"
 #include "scu_vme.h"
 #include "blitter.h"
@@ -291,6 +293,8 @@ void M68000_Reset(bool bCold)
 	BusMode = BUS_MODE_CPU;
 	CPU_IACK = false;
 
+	IdleLoop_Reset();
+
 	//fprintf( stderr,"M68000_Reset out cold=%d\n" , bCold );
 }
 
@@ -428,13 +432,44 @@ void M68000_CheckCpuSettings(void)
 		changed_prefs.mmu_model = 0;				/* MMU disabled */
 	else
 		changed_prefs.mmu_model = changed_prefs.cpu_model;	/* MMU enabled */
+	/* The real ATC sizes are always used in cycle exact mode (see cpummu*.c) */
+	changed_prefs.mmu_host_atc = ConfigureParams.System.bMmuHostAtc;
 
 	/* Set cpu speed to default values (only used in WinUAE, not in Hatari) */
 	changed_prefs.m68k_speed = 0;
 	changed_prefs.cpu_clock_multiplier = 2 << 8;
 
-	/* We don't use JIT */
+	/* JIT is only used for 68020+ in non cycle exact / non prefetch modes */
+	/* and without MMU. Memory is always accessed through the banks ("indirect") */
+	/* and self-modifying code is detected with checksums on the next flush. */
 	changed_prefs.cachesize = 0;
+	if ( ConfigureParams.System.bJIT )
+	{
+#ifdef JIT
+		if ( changed_prefs.cpu_model >= 68020 && !changed_prefs.cpu_compatible
+		    && !changed_prefs.cpu_cycle_exact && !changed_prefs.mmu_model )
+		{
+			changed_prefs.cachesize = MAX_JIT_CACHE;
+			changed_prefs.comp_hardflush = false;
+			changed_prefs.comp_constjump = true;
+			changed_prefs.compfpu = false;
+			changed_prefs.compnf = true;
+		}
+		else
+			Log_Printf(LOG_WARN, "JIT requires a 68020+ CPU without prefetch, "
+			                     "cycle exact or MMU mode, JIT disabled\n");
+#else
+		Log_Printf(LOG_WARN, "This version of Hatari was built without JIT support\n");
+#endif
+	}
+
+	/* Pre-decoded block cache, only used by the 68000 core without prefetch / cycle exact */
+	if ( BlockCache_Enabled != ConfigureParams.System.bBlockCache )
+	{
+		BlockCache_Enabled = ConfigureParams.System.bBlockCache;
+		memory_update_direct_pages ( 0 , MEMORY_BANKS );	/* writes to RAM must check the cache */
+		set_special(SPCFLAG_MODE_CHANGE);		/* re-select the cpu run loop */
+	}
 
 	/* while 020 had i-cache, only 030+ had also d-cache */
 	if (changed_prefs.cpu_model < 68030 ||
@@ -457,6 +492,9 @@ void M68000_CheckCpuSettings(void)
  */
 void M68000_PatchCpuTables(void)
 {
+	/* Blocks in the cache still point to the previous handlers */
+	BlockCache_Flush();
+
 	if (Cart_UseBuiltinCartridge())
 	{
 		/* Hatari's specific illegal opcodes */
@@ -879,6 +917,11 @@ void	M68000_Flush_All_Caches ( uaecptr addr , int size )
 	flush_cpu_caches(true);
 	invalidate_cpu_data_caches();
 
+	/* Translated JIT blocks might not match the new memory content */
+	if ( currprefs.cachesize )
+		flush_icache(0);
+	BlockCache_Invalidate ( addr , size );
+
 	/* For the MegaSTE, we also flush the external cache */
 	if ( ConfigureParams.System.nMachineType == MACHINE_MEGA_STE )
 		MegaSTE_Cache_Flush ();
@@ -891,6 +934,11 @@ void	M68000_Flush_Instr_Cache ( uaecptr addr , int size )
 	/* Instruction cache for cpu >= 68020 */
 	flush_cpu_caches(true);
 
+	/* Translated JIT blocks might not match the new memory content */
+	if ( currprefs.cachesize )
+		flush_icache(0);
+	BlockCache_Invalidate ( addr , size );
+
 	/* For the MegaSTE, we also flush the external cache */
 	if ( ConfigureParams.System.nMachineType == MACHINE_MEGA_STE )
 		MegaSTE_Cache_Flush ();
@@ -903,6 +951,9 @@ void	M68000_Flush_Data_Cache ( uaecptr addr , int size )
 	/* Data cache for cpu >= 68030 */
 	invalidate_cpu_data_caches();
 
+	/* Memory written by the host might contain cached instructions */
+	BlockCache_Invalidate ( addr , size );
+
 	/* For the MegaSTE, we also flush the external cache */
 	if ( ConfigureParams.System.nMachineType == MACHINE_MEGA_STE )
 		MegaSTE_Cache_Flush ();
@@ -1032,6 +1083,7 @@ void M68000_MMU_Info(FILE *fp, uint32_t flags)
 		fprintf(fp, "TC:\t0x%08x\n", tc_030);
 		fprintf(fp, "TT0:\t0x%08x\n", tt0_030);
 		fprintf(fp, "TT1:\t0x%08x\n", tt1_030);
+		mmu030_atc_info(fp);
 	}
 	else	/* 68040 / 68060 mode */
 	{
@@ -1043,6 +1095,7 @@ void M68000_MMU_Info(FILE *fp, uint32_t flags)
 		fprintf(fp, "DTT1:\t0x%08x\n", regs.dtt1);
 		fprintf(fp, "ITT0:\t0x%08x\n", regs.itt0);
 		fprintf(fp, "ITT0:\t0x%08x\n", regs.itt1);
+		mmu_atc_info(fp);
 		/* TODO: Also call mmu_dump_tables() here? */
 	}
 }
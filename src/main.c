@@ -35,6 +35,7 @@ const char Main_fileid[] = "Hatari main.c";
 #include "keymap.h"
 #include "log.h"
 #include "m68000.h"
+#include "idleloop.h"
 #include "midi.h"
 #include "ncr5380.h"
 #include "nvram.h"
@@ -231,10 +232,12 @@ static void Main_UnInitSubsystems(void)
 	JoyUI_UnInit();
 	if (Sound_AreWeRecording())
 		Sound_EndRecording();
+	Sound_SetSynthThread(false);
 	Audio_UnInit();
 	DSP_UnInit();
 	Screen_UnInit();
 	ConvST_UnInit();
+	IdleLoop_UnInit();
 	Exit680x0();
 
 	IPF_Exit();
@@ -20,8 +20,9 @@
 /*			MFP_EnableB_WriteByte, this gives wrong results.		*/
 /* 2007/05/05	[NP]	- When a timer is looping (counter reaches 0), we must use	*/
 /*			PendingCyclesOver to restart it with Int_AddRelativeInterrupt.	*/
-/*			PendingCyclesOver is the value of  PendingInterruptCount when	*/
-/*			the timer expired.						*/
+/*			PendingCyclesOver is the value of  CycInt_DelayedCycles when	*/
+/*			the timer expired (cycles between the scheduled event and	*/
+/*			the current clock, see cycInt.c).				*/
 /*			- MFP_ReadTimer_AB/CD was wrong (returned the elapsed counter	*/
 /*			changes since start, instead of the remaining counter value).	*/
 /*			(ULM DSOTS Demos and Overscan Demos).				*/
@@ -1731,7 +1732,7 @@ static void	MFP_InterruptHandler_TimerA ( MFP_STRUCT *pMFP , interrupt_id Handle
 {
 	/* Number of internal cycles we went over for this timer ( <= 0 ),
 	 * used when timer expires and needs to be restarted */
-	PendingCyclesOver = -PendingInterruptCount;		/* >= 0 */
+	PendingCyclesOver = -CycInt_DelayedCycles;		/* >= 0 */
 
 	/* Remove this interrupt from list and re-order */
 	CycInt_AcknowledgeInterrupt();
@@ -1765,7 +1766,7 @@ static void	MFP_InterruptHandler_TimerB ( MFP_STRUCT *pMFP , interrupt_id Handle
 {
 	/* Number of internal cycles we went over for this timer ( <= 0 ),
 	 * used when timer expires and needs to be restarted */
-	PendingCyclesOver = -PendingInterruptCount;		/* >= 0 */
+	PendingCyclesOver = -CycInt_DelayedCycles;		/* >= 0 */
 
 	/* Remove this interrupt from list and re-order */
 	CycInt_AcknowledgeInterrupt();
@@ -1799,7 +1800,7 @@ static void	MFP_InterruptHandler_TimerC ( MFP_STRUCT *pMFP , interrupt_id Handle
 {
 	/* Number of internal cycles we went over for this timer ( <= 0 ),
 	 * used when timer expires and needs to be restarted */
-	PendingCyclesOver = -PendingInterruptCount;		/* >= 0 */
+	PendingCyclesOver = -CycInt_DelayedCycles;		/* >= 0 */
 
 	/* Remove this interrupt from list and re-order */
 	CycInt_AcknowledgeInterrupt();
@@ -1833,7 +1834,7 @@ static void	MFP_InterruptHandler_TimerD ( MFP_STRUCT *pMFP , interrupt_id Handle
 {
 	/* Number of internal cycles we went over for this timer ( <= 0 ),
 	 * used when timer expires and needs to be restarted */
-	PendingCyclesOver = -PendingInterruptCount;		/* >= 0 */
+	PendingCyclesOver = -CycInt_DelayedCycles;		/* >= 0 */
 
 	/* Remove this interrupt from list and re-order */
 	CycInt_AcknowledgeInterrupt();
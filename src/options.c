@@ -89,6 +89,7 @@ typedef enum {
 	OPT_FASTFORWARD,
 	OPT_AUTOSTART,
 	OPT_FF_KEY_REPEAT,
+	OPT_FF_IDLE_SKIP,
 
 	OPT_MONO,		/* common display options */
 	OPT_MONITOR,
@@ -105,11 +106,14 @@ typedef enum {
 	OPT_MAXWIDTH,
 	OPT_MAXHEIGHT,
 	OPT_ZOOM,
+	OPT_SCANLINES,
 	OPT_VSYNC,
 	OPT_DISABLE_VIDEO,
+	OPT_HEADLESS,
 
 	OPT_BORDERS,		/* ST/STE display options */
 	OPT_SPEC512,
+	OPT_DIRECT_LINES,
 	OPT_VIDEO_TIMING,
 
 	OPT_RESOLUTION,		/* TT/Falcon display options */
@@ -194,6 +198,9 @@ typedef enum {
 /*	OPT_FPU_JIT_COMPAT, */
 	OPT_FPU_SOFTFLOAT,
 	OPT_MMU,
+	OPT_MMU_HOST_ATC,
+	OPT_JIT,
+	OPT_BLOCK_CACHE,
 
 	OPT_MACHINE,		/* system options */
 	OPT_BLITTER,
@@ -207,6 +214,8 @@ typedef enum {
 	OPT_SOUNDBUFFERSIZE,
 	OPT_SOUNDSYNC,
 	OPT_YM_MIXING,
+	OPT_RESAMPLING,
+	OPT_SOUNDTHREAD,
 
 #ifdef WIN32
 	OPT_WINCON,		/* debug options */
@@ -277,6 +286,8 @@ static const opt_t HatariOptions[] = {
 	  "<x>", "Atari program autostarting with Atari path" },
 	{ OPT_FF_KEY_REPEAT, NULL, "--fast-forward-key-repeat",
 	  "<bool>", "Use keyboard auto repeat in fast forward mode" },
+	{ OPT_FF_IDLE_SKIP, NULL, "--fast-forward-idle-skip",
+	  "<bool>", "Skip CPU idle loops in fast forward / benchmark mode (not cycle exact)" },
 
 	{ OPT_HEADER, NULL, NULL, NULL, "Common display" },
 	{ OPT_MONO,      "-m", "--mono",
@@ -309,16 +320,22 @@ static const opt_t HatariOptions[] = {
 	  "<int>", "Maximum Hatari screen height before scaling (200-)" },
 	{ OPT_ZOOM, "-z", "--zoom",
 	  "<x>", "Hatari screen/window scaling factor (1.0 - 8.0)" },
+	{ OPT_SCANLINES, NULL, "--scanlines",
+	  "<bool>", "Half intensity for every other line of zoomed screens" },
 	{ OPT_VSYNC,   NULL, "--vsync",
 	  "<bool>", "Limit screen updates to host monitor refresh rate" },
 	{ OPT_DISABLE_VIDEO,   NULL, "--disable-video",
 	  "<bool>", "Run emulation without displaying video (audio only)" },
+	{ OPT_HEADLESS,   NULL, "--headless",
+	  "<bool>", "Convert screen only for screenshots & video recording" },
 
 	{ OPT_HEADER, NULL, NULL, NULL, "ST/STE specific display" },
 	{ OPT_BORDERS, NULL, "--borders",
 	  "<bool>", "Show screen borders (for overscan demos etc)" },
 	{ OPT_SPEC512, NULL, "--spec512",
 	  "<int>", "Spec512 palette threshold (0-512, 0=disable)" },
+	{ OPT_DIRECT_LINES, NULL, "--direct-lines",
+	  "<bool>", "Convert lines without raster effects directly from RAM" },
 	{ OPT_VIDEO_TIMING,   NULL, "--video-timing",
 	  "<x>", "Wakeup State for MMU/GLUE (x=ws1/ws2/ws3/ws4/random, default ws3)" },
 
@@ -489,6 +506,12 @@ static const opt_t HatariOptions[] = {
 	  "<bool>", "Use full software FPU emulation" },
 	{ OPT_MMU, NULL, "--mmu",
 	  "<bool>", "Use MMU emulation" },
+	{ OPT_MMU_HOST_ATC, NULL, "--mmu-host-atc",
+	  "<bool>", "Use bigger hashed MMU ATC (non cycle exact mode)" },
+	{ OPT_JIT, NULL, "--jit",
+	  "<bool>", "Use 68020+ JIT compiler (non cycle exact modes, experimental)" },
+	{ OPT_BLOCK_CACHE, NULL, "--block-cache",
+	  "<bool>", "Use pre-decoded block cache for 68000 without prefetch" },
 
 	{ OPT_HEADER, NULL, NULL, NULL, "Misc system" },
 	{ OPT_MACHINE,   NULL, "--machine",
@@ -515,6 +538,10 @@ static const opt_t HatariOptions[] = {
 	  "<bool>", "Sound synchronized emulation (on|off, off=default)" },
 	{ OPT_YM_MIXING,   NULL, "--ym-mixing",
 	  "<x>", "YM sound mixing method (x=linear/table/model)" },
+	{ OPT_RESAMPLING,   NULL, "--sound-resampling",
+	  "<x>", "Resampling to sound frequency (x=nearest/linear/average/sinc)" },
+	{ OPT_SOUNDTHREAD,   NULL, "--sound-thread",
+	  "<bool>", "Generate YM sound in its own thread (experimental)" },
 
 	{ OPT_HEADER, NULL, NULL, NULL, "Debug" },
 #ifdef WIN32
@@ -1280,6 +1307,10 @@ bool Opt_ParseParameters(int argc, const char * const argv[], int *exitval)
 			ok = Opt_Bool(arg, OPT_FF_KEY_REPEAT, &ConfigureParams.Keyboard.bFastForwardKeyRepeat);
 			break;
 
+		case OPT_FF_IDLE_SKIP:
+			ok = Opt_Bool(arg, OPT_FF_IDLE_SKIP, &ConfigureParams.System.bFastForwardIdleSkip);
+			break;
+
 		case OPT_CONFIGFILE:
 			ok = Opt_StrCpy(OPT_CONFIGFILE, CHECK_FILE, sConfigFileName,
 					arg, sizeof(sConfigFileName), NULL);
@@ -1384,6 +1415,10 @@ bool Opt_ParseParameters(int argc, const char * const argv[], int *exitval)
 			ok = Opt_Bool(arg, OPT_DRIVE_LED, &ConfigureParams.Screen.bShowDriveLed);
 			break;
 
+		case OPT_SCANLINES:
+			ok = Opt_Bool(arg, OPT_SCANLINES, &ConfigureParams.Screen.bScanlines);
+			break;
+
 		case OPT_VSYNC:
 			ok = Opt_Bool(arg, OPT_VSYNC, &ConfigureParams.Screen.bUseVsync);
 			break;
@@ -1392,6 +1427,10 @@ bool Opt_ParseParameters(int argc, const char * const argv[], int *exitval)
 			ok = Opt_Bool(arg, OPT_DISABLE_VIDEO, &ConfigureParams.Screen.DisableVideo);
 			break;
 
+		case OPT_HEADLESS:
+			ok = Opt_Bool(arg, OPT_HEADLESS, &ConfigureParams.Screen.bHeadless);
+			break;
+
 			/* ST/STE display options */
 		case OPT_BORDERS:
 			ok = Opt_Bool(arg, OPT_BORDERS, &ConfigureParams.Screen.bAllowOverscan);
@@ -1401,6 +1440,10 @@ bool Opt_ParseParameters(int argc, const char * const argv[], int *exitval)
 			ok = Opt_Int(arg, OPT_SLOWDOWN, &ConfigureParams.Screen.nSpec512Threshold, 0, 512, 0);
 			break;
 
+		case OPT_DIRECT_LINES:
+			ok = Opt_Bool(arg, OPT_DIRECT_LINES, &ConfigureParams.Screen.bDirectLines);
+			break;
+
 		case OPT_ZOOM:
 			zoom = atof(arg);
 			if (zoom < 1.0 || zoom > 8.0)
@@ -2052,6 +2095,19 @@ bool Opt_ParseParameters(int argc, const char * const argv[], int *exitval)
 			bLoadAutoSave = false;
 			break;
 
+		case OPT_MMU_HOST_ATC:
+			ok = Opt_Bool(arg, OPT_MMU_HOST_ATC, &ConfigureParams.System.bMmuHostAtc);
+			break;
+
+		case OPT_JIT:
+			ok = Opt_Bool(arg, OPT_JIT, &ConfigureParams.System.bJIT);
+			bLoadAutoSave = false;
+			break;
+
+		case OPT_BLOCK_CACHE:
+			ok = Opt_Bool(arg, OPT_BLOCK_CACHE, &ConfigureParams.System.bBlockCache);
+			break;
+
 			/* system options */
 		case OPT_MACHINE:
 			if (strcasecmp(arg, "st") == 0)
@@ -2181,6 +2237,22 @@ bool Opt_ParseParameters(int argc, const char * const argv[], int *exitval)
 			break;
 		}
 
+		case OPT_RESAMPLING:
+		{
+			static const opt_keyval_t keyval[] = {
+				{"nearest", YM2149_RESAMPLE_METHOD_NEAREST},
+				{"linear",  YM2149_RESAMPLE_METHOD_WEIGHTED_AVERAGE_2},
+				{"average", YM2149_RESAMPLE_METHOD_WEIGHTED_AVERAGE_N},
+				{"sinc",    YM2149_RESAMPLE_METHOD_SINC},
+			};
+			if (!Opt_SetKeyVal(arg, keyval, ARRAY_SIZE(keyval), &val))
+			{
+				return Opt_ShowError(OPT_RESAMPLING, arg, "Unknown resampling method");
+			}
+			ConfigureParams.Sound.ResampleMethod = val;
+			break;
+		}
+
 		case OPT_SOUND:
 			if (strcasecmp(arg, "off") == 0)
 			{
@@ -2217,6 +2289,10 @@ bool Opt_ParseParameters(int argc, const char * const argv[], int *exitval)
 			ok = Opt_Bool(arg, OPT_SOUNDSYNC, &ConfigureParams.Sound.bEnableSoundSync);
 			break;
 
+		case OPT_SOUNDTHREAD:
+			ok = Opt_Bool(arg, OPT_SOUNDTHREAD, &ConfigureParams.Sound.bSynthThread);
+			break;
+
 		case OPT_MICROPHONE:
 			ok = Opt_Bool(arg, OPT_MICROPHONE, &ConfigureParams.Sound.bEnableMicrophone);
 			break;
@@ -339,7 +339,7 @@ void PSG_Set_DataRegister(uint8_t val)
 		return;					/* not valid, ignore write and do nothing */
 
 	/* Create samples up until this point with current values */
-	Sound_Update ( Cycles_GetClockCounterOnWriteAccess() );
+	Sound_UpdateYM ( Cycles_GetClockCounterOnWriteAccess() );
 
 	/* When a read is made from $ff8800 without changing PSGRegisterSelect, we should return */
 	/* the non masked value. */
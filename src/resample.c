@@ -0,0 +1,291 @@
+/*
+  Hatari - resample.c
+
+  Band limited sample rate conversion, used to convert the YM2149 output
+  (250 kHz), the STE/TT DMA sound and the Falcon crossbar DAC to the host
+  audio frequency when the "sinc" resampling method is selected.
+
+  Each output sample is the dot product of the last 'taps' input samples
+  with a Kaiser windowed sinc low pass filter (cutoff at half the lowest of
+  both rates, more than 70 dB of stop band attenuation). The filter is precomputed
+  for RESAMPLE_PHASES fractional positions between 2 input samples (poly
+  phase filter), the nearest phase is used for each output sample.
+  Samples and coefficients (Q15) are 16 bit integers, the dot products
+  are done with SSE2 (pmaddwd) or NEON (vmlal) when the host cpu has
+  them ; the result is the same as with the scalar code.
+
+  As the filter only uses the samples up to the current read position,
+  it adds a delay of 'taps'/2 input samples (0.32 ms for the YM2149).
+
+  This file is distributed under the GNU General Public License, version 2
+  or at your option any later version. Read the file gpl.txt for details.
+*/
+const char Resample_fileid[] = "Hatari resample.c";
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "main.h"
+#include "resample.h"
+#include "simd.h"
+
+#define RESAMPLE_LEVELS		( SIMD_LEVEL(SIMD_SSE2) | SIMD_LEVEL(SIMD_NEON) )
+
+#define RESAMPLE_ATTENUATION	80.0		/* stop band attenuation in dB */
+#define RESAMPLE_TRANSITION	0.18		/* transition band, relative to the lowest rate */
+
+static int32_t (*Resample_Dot)(const int16_t *x, const int16_t *c, int taps);
+
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Dot products of 'taps' samples and coefficients. The sums fit in 32 bits
+ * as the sum of the absolute values of the coefficients of a phase is < 2.
+ */
+static int32_t Generic_Dot(const int16_t *x, const int16_t *c, int taps)
+{
+	int32_t sum = 0;
+	int i;
+
+	for (i = 0; i < taps; i++)
+		sum += x[i] * c[i];
+	return sum;
+}
+
+#ifdef SIMD_HOST_X86
+TARGET_SSE2
+static int32_t Sse2_Dot(const int16_t *x, const int16_t *c, int taps)
+{
+	__m128i sum = _mm_setzero_si128();
+	int i;
+
+	for (i = 0; i < taps; i += 8)
+	{
+		__m128i vx = _mm_loadu_si128((const __m128i *)(x + i));
+		__m128i vc = _mm_loadu_si128((const __m128i *)(c + i));
+		sum = _mm_add_epi32(sum, _mm_madd_epi16(vx, vc));
+	}
+	sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(1, 0, 3, 2)));
+	sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(2, 3, 0, 1)));
+	return _mm_cvtsi128_si32(sum);
+}
+#endif
+
+#ifdef SIMD_HOST_NEON
+static int32_t Neon_Dot(const int16_t *x, const int16_t *c, int taps)
+{
+	int32x4_t sum = vdupq_n_s32(0);
+	int i;
+
+	for (i = 0; i < taps; i += 8)
+	{
+		int16x8_t vx = vld1q_s16(x + i);
+		int16x8_t vc = vld1q_s16(c + i);
+		sum = vmlal_s16(sum, vget_low_s16(vx), vget_low_s16(vc));
+		sum = vmlal_s16(sum, vget_high_s16(vx), vget_high_s16(vc));
+	}
+	return vaddvq_s32(sum);
+}
+#endif
+
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Select the dot product kernel of 'level' (or the best one for
+ * SIMD_BEST). Return the selected level, SIMD_NONE if 'level' is
+ * not supported by the host cpu.
+ */
+int Resample_Init(int level)
+{
+	level = Simd_Select(level, RESAMPLE_LEVELS);
+
+	switch (level)
+	{
+#ifdef SIMD_HOST_X86
+	 case SIMD_SSE2:
+		Resample_Dot = Sse2_Dot;
+		break;
+#endif
+#ifdef SIMD_HOST_NEON
+	 case SIMD_NEON:
+		Resample_Dot = Neon_Dot;
+		break;
+#endif
+	 default:
+		Resample_Dot = Generic_Dot;
+		level = SIMD_NONE;
+		break;
+	}
+	return level;
+}
+
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Modified Bessel function of the first kind, order 0 (for Kaiser window)
+ */
+static double Resample_BesselI0(double x)
+{
+	double sum = 1.0, term = 1.0;
+	int k;
+
+	for (k = 1; k < 50 && term > sum * 1e-12; k++)
+	{
+		term *= (x / (2 * k)) * (x / (2 * k));
+		sum += term;
+	}
+	return sum;
+}
+
+
+/**
+ * Compute the filter's coefficients for converting from 'in_rate' to
+ * 'out_rate' (nothing is done if the rates didn't change).
+ * If the rates are invalid or the memory can't be allocated,
+ * Resample_Sample() returns the input samples without filtering.
+ */
+void Resample_SetRates(RESAMPLE_FILTER *rf, int in_rate, int out_rate)
+{
+	double cutoff, beta, half, t, x, w, h, sum;
+	double row[RESAMPLE_TAPS_MAX];
+	int taps, phase, i, imax, isum;
+	int16_t *c;
+
+	if (rf->coefs && rf->in_rate == in_rate && rf->out_rate == out_rate)
+		return;
+
+	if (!Resample_Dot)
+		Resample_Init(SIMD_BEST);
+
+	Resample_Free(rf);
+	if (in_rate <= 0 || out_rate <= 0)
+		return;
+	rf->in_rate = in_rate;
+	rf->out_rate = out_rate;
+	rf->step = ((uint64_t)in_rate << 32) / out_rate;
+
+	/* Cutoff relative to the input rate, and Kaiser's estimation of */
+	/* the number of taps for the attenuation and transition band */
+	cutoff = (double)(in_rate < out_rate ? in_rate : out_rate) / in_rate;
+	taps = ceil((RESAMPLE_ATTENUATION - 8) / (2.285 * 2 * M_PI * RESAMPLE_TRANSITION * cutoff));
+	taps = (taps + 7) & ~7;
+	if (taps > RESAMPLE_TAPS_MAX)
+		taps = RESAMPLE_TAPS_MAX;
+	beta = 0.1102 * (RESAMPLE_ATTENUATION - 8.7);
+	half = taps / 2;
+
+	rf->coefs = malloc(RESAMPLE_PHASES * taps * sizeof(int16_t));
+	if (!rf->coefs)
+		return;
+	rf->taps = taps;
+
+	for (phase = 0; phase < RESAMPLE_PHASES; phase++)
+	{
+		/* Tap 'i' is the input sample at time i - taps + 1, the output */
+		/* sample is at time -taps/2 + phase/RESAMPLE_PHASES */
+		sum = 0;
+		for (i = 0; i < taps; i++)
+		{
+			t = i - half + 1 - (double)phase / RESAMPLE_PHASES;
+			x = t / half;
+			w = Resample_BesselI0(beta * sqrt(x * x < 1 ? 1 - x * x : 0))
+			    / Resample_BesselI0(beta);
+			h = t == 0 ? 1 : sin(M_PI * cutoff * t) / (M_PI * cutoff * t);
+			row[i] = h * w;
+			sum += row[i];
+		}
+
+		/* Unity gain for DC : the rounding error goes to the biggest tap */
+		/* (except for the phase 0 of upsampling filters, which is 1.0 for */
+		/* a single tap and can't be represented in Q15) */
+		c = rf->coefs + phase * taps;
+		isum = 0;
+		imax = 0;
+		for (i = 0; i < taps; i++)
+		{
+			c[i] = lrint(fmin(row[i] / sum * 32768, 32767));
+			isum += c[i];
+			if (c[i] > c[imax])
+				imax = i;
+		}
+		c[imax] = fmin(c[imax] + 32768 - isum, 32767);
+	}
+}
+
+
+/**
+ * Free the filter's coefficients
+ */
+void Resample_Free(RESAMPLE_FILTER *rf)
+{
+	free(rf->coefs);
+	rf->coefs = NULL;
+	rf->taps = 0;
+}
+
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Return the output sample at fractional position 'frac' (0 to 0xffffffff)
+ * after the input sample ring[end] (delayed by taps/2 input samples).
+ * 'ring' is a ring buffer of 'mask'+1 samples (a power of 2).
+ */
+int16_t Resample_Sample(const RESAMPLE_FILTER *rf, const int16_t *ring, int mask,
+                        int end, uint32_t frac)
+{
+	int16_t linear[RESAMPLE_TAPS_MAX];
+	const int16_t *x;
+	int start, first;
+	int32_t sum;
+
+	if (!rf->coefs)
+		return ring[end & mask];
+
+	/* Samples crossing the end of the ring are copied first */
+	start = (end - rf->taps + 1) & mask;
+	if (start + rf->taps <= mask + 1)
+		x = ring + start;
+	else
+	{
+		first = mask + 1 - start;
+		memcpy(linear, ring + start, first * sizeof(int16_t));
+		memcpy(linear + first, ring, (rf->taps - first) * sizeof(int16_t));
+		x = linear;
+	}
+
+	sum = Resample_Dot(x, rf->coefs + (frac >> (32 - RESAMPLE_PHASES_BITS)) * rf->taps, rf->taps);
+	sum = (sum + 0x4000) >> 15;
+	if (sum > 32767)
+		sum = 32767;
+	else if (sum < -32768)
+		sum = -32768;
+	return sum;
+}
+
+
+/**
+ * Convert up to 'count' samples from the ring buffer 'ring' to 'out',
+ * starting at position '*read' + '*frac', as long as 'avail' is > 0.
+ * After each output sample, '*read' and '*frac' are advanced by the step
+ * between two output samples and 'avail' is decreased by the number of
+ * input samples skipped.
+ * Return the number of converted samples.
+ */
+int Resample_Block(const RESAMPLE_FILTER *rf, const int16_t *ring, int mask,
+                   int *read, uint32_t *frac, int avail, int16_t *out, int count)
+{
+	uint64_t pos;
+	int n;
+
+	for (n = 0; n < count && avail > 0; n++)
+	{
+		out[n] = Resample_Sample(rf, ring, mask, *read, *frac);
+
+		pos = *frac + rf->step;
+		*read = (*read + (int)(pos >> 32)) & mask;
+		avail -= pos >> 32;
+		*frac = pos;
+	}
+	return n;
+}
@@ -62,40 +62,45 @@ void Audio_UnInit(void)
 
 
 /**
- * Lock the audio sub system - currently a no-op with libretro since we
- * don't use the callback there that signals that the buffer is ready.
+ * Some samples have just been generated in the retro core, batch them now
+ * (there's no audio callback with libretro).
  */
-void Audio_Lock(void)
+void Audio_NewSamples(void)
 {
+	int16_t buffer[1024][2];
+	int nb;
+
+	do
+	{
+		nb = Sound_GetBufferedSamples();
+		if (nb > ARRAY_SIZE(buffer))
+			nb = ARRAY_SIZE(buffer);
+		nb = Sound_ReadSamples(buffer, nb);
+		if (nb > 0 && bPlayingBuffer && audio_sample_batch_cb)
+			audio_sample_batch_cb(&buffer[0][0], nb);
+	}
+	while (nb == ARRAY_SIZE(buffer));
 }
 
 
 /**
- * Unlock the audio sub system - we use this as indication in the retro core
- * that some samples have just been generated and we can batch them now.
+ * No YM2149 synthesis thread, the frontend may run several cores
  */
-void Audio_Unlock(void)
+bool Audio_StartSynthThread(void)
 {
-	if (bPlayingBuffer && nGeneratedSamples && audio_sample_batch_cb)
-	{
-		if (AudioMixBuffer_pos_read + nGeneratedSamples <= AUDIOMIXBUFFER_SIZE)
-		{
-			audio_sample_batch_cb(&AudioMixBuffer[AudioMixBuffer_pos_read][0],
-			                      nGeneratedSamples);
-		}
-		else
-		{
-			int samples_at_end = AUDIOMIXBUFFER_SIZE - AudioMixBuffer_pos_read;
-			audio_sample_batch_cb(&AudioMixBuffer[AudioMixBuffer_pos_read][0],
-			                      samples_at_end);
-			audio_sample_batch_cb(&AudioMixBuffer[0][0],
-			                      (nGeneratedSamples - samples_at_end));
-		}
-	}
+	return false;
+}
 
-	AudioMixBuffer_pos_read = (AudioMixBuffer_pos_read + nGeneratedSamples)
-	                          & AUDIOMIXBUFFER_SIZE_MASK;
-	nGeneratedSamples = 0;
+void Audio_StopSynthThread(void)
+{
+}
+
+void Audio_WakeSynthThread(void)
+{
+}
+
+void Audio_WaitSynthThread(void)
+{
 }
 
 
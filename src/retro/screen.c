@@ -168,6 +168,7 @@ void Screen_Init(void)
 
 	/* We want to render each frame with libretro, so disable frameskip */
 	ConfigureParams.Screen.nFrameSkips = 0;
+	ConfigureParams.Screen.bHeadless = false;
 }
 
 
@@ -272,6 +273,22 @@ uint32_t Screen_GetGenConvHeight(void)
 	return screen_height;
 }
 
+/**
+ * No worker threads, the frontend may run several cores
+ */
+int Screen_GetWorkerCount(void)
+{
+	return 0;
+}
+
+void Screen_RunWorkers(void (*func)(int idx, void *data), int jobs, void *data)
+{
+	int i;
+
+	for (i = 0; i < jobs; i++)
+		func(i, data);
+}
+
 /**
  * Wrapper for BPM save function
  * return 1 for success, -1 for fail
@@ -2093,7 +2093,7 @@ static void	SCC_InterruptHandler_BRG ( int Channel )
 
 	/* Number of internal cycles we went over for this timer ( <= 0 ) */
 	/* Used to restart the next timer and keep a constant baud rate */
-	PendingCyclesOver = -PendingInterruptCount;			/* >= 0 */
+	PendingCyclesOver = -CycInt_DelayedCycles;			/* >= 0 */
 
 	LOG_TRACE ( TRACE_SCC, "scc interrupt handler brg channel=%c pending_cyc=%d VBL=%d HBL=%d\n" , 'A'+Channel , PendingCyclesOver , nVBLs , nHBL );
 
@@ -2216,7 +2216,7 @@ static void	SCC_Restart_InterruptHandler_TX_RX ( int Channel , bool is_tx )
 
 	/* Number of internal cycles we went over for this timer ( <= 0 ) */
 	/* Used to restart the next timer and keep a constant baud rate */
-	PendingCyclesOver = -PendingInterruptCount;			/* >= 0 */
+	PendingCyclesOver = -CycInt_DelayedCycles;			/* >= 0 */
 
 	LOG_TRACE ( TRACE_SCC, "scc interrupt handler %s channel=%c pending_cyc=%d VBL=%d HBL=%d\n" , is_tx?"tx":"rx" , 'A'+Channel , PendingCyclesOver , nVBLs , nHBL );
 
@@ -275,6 +275,20 @@ static void ScreenSnapShot_GetInternalFormat(bool *genconv, int *sw, int *sh, in
 }
 
 
+/**
+ * Return the data of line 'y' of the ST screen, the middle of the lines
+ * without effects may still be in ST RAM (see Video_SetLineSource()).
+ */
+static uint8_t *ScreenSnapShot_GetSTLine(int y, bool mono)
+{
+	if (pFrameBuffer->pLineSource[y])
+		return pFrameBuffer->pLineSource[y];
+	if (mono)
+		return pFrameBuffer->pSTScreen + SCREENBYTES_MONOLINE * y;
+	return pFrameBuffer->pSTScreen + STScreenLineOffset[y] + SCREENBYTES_LEFT;
+}
+
+
 /**
  * Save direct video memory dump to NEO file
  * return 1 for success, -1 for fail
@@ -282,10 +296,11 @@ static void ScreenSnapShot_GetInternalFormat(bool *genconv, int *sw, int *sh, in
 static int ScreenSnapShot_SaveNEO(const char *filename)
 {
 	FILE *fp = NULL;
-	int i, res, sw, sh, bpp, offset;
+	int i, res, sw, sh, bpp;
 	bool genconv;
 	uint32_t video_base, line_size;
 	uint16_t header[64];
+	uint8_t *scanline;
 
 	ScreenSnapShot_GetInternalFormat(&genconv, &sw, &sh, &bpp, &line_size);
 	/* Convert BPP to ST resolution number */
@@ -354,10 +369,11 @@ static int ScreenSnapShot_SaveNEO(const char *filename)
 	{
 		for (i = 0; i < sh; i++)
 		{
-			offset = (res == 2) ?
-				(SCREENBYTES_MONOLINE * i) :
-				(STScreenLineOffset[i+OVERSCAN_TOP] + SCREENBYTES_LEFT);
-			fwrite(pFrameBuffer->pSTScreen + offset, 1, line_size, fp);
+			if (res == 2)
+				scanline = ScreenSnapShot_GetSTLine(i, true);
+			else
+				scanline = ScreenSnapShot_GetSTLine(i+OVERSCAN_TOP, false);
+			fwrite(scanline, 1, line_size, fp);
 		}
 	}
 	else /* TT/Falcon bypass Video_EndHBL, so pFrameBuffer is unused.
@@ -465,9 +481,10 @@ static int ScreenSnapShot_SaveXIMG(const char *filename)
 		/* Find line of scanline data */
 		if (!genconv && pFrameBuffer && pFrameBuffer->pSTScreen)
 		{
-			scanline = pFrameBuffer->pSTScreen + (
-				(sh >= 300) ? (SCREENBYTES_MONOLINE * i) :
-				(STScreenLineOffset[i+OVERSCAN_TOP] + SCREENBYTES_LEFT) );
+			if (sh >= 300)
+				scanline = ScreenSnapShot_GetSTLine(i, true);
+			else
+				scanline = ScreenSnapShot_GetSTLine(i+OVERSCAN_TOP, false);
 		}
 		else
 		{
@@ -536,6 +553,9 @@ void ScreenSnapShot_SaveScreen(void)
 
 	if (!szFileName)  return;
 
+	/* In headless mode, the screen may not have been converted yet */
+	ConvST_RefreshOnDemand();
+
 	/* Create our filename */
 	path = Configuration_GetScreenShotDir();
 	ScreenSnapShot_GetNum();
@@ -595,6 +615,7 @@ void ScreenSnapShot_SaveToFile(const char *szFileName)
 		fprintf(stderr, "ERROR: no screen dump file name specified\n");
 		return;
 	}
+	ConvST_RefreshOnDemand();
 #if HAVE_LIBPNG
 	if (File_DoesFileExtensionMatch(szFileName, ".png"))
 	{
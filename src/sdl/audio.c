@@ -38,16 +38,25 @@ int pulse_swallowing_count = 0;			/* Sound disciplined emulation rate controlled
 static SDL_AudioStream *audio_stream;
 #endif
 
+/* Thread replaying the YM2149 register writes (see Sound_RunSynthLog) */
+static struct {
+	SDL_Thread *thread;
+	SDL_mutex *mutex;
+	SDL_cond *wake;		/* new log entries, or quit */
+	SDL_cond *idle;		/* all the log entries were replayed */
+	bool pending;		/* thread was woken for new log entries */
+	bool waiting;		/* thread is waiting, not replaying the log */
+	bool quit;
+} Synth;
+
 
 /**
  * SDL audio callback function - copy emulation sound to audio system.
  */
 static void Audio_CallBack(void *userdata, Uint8 *stream, int len)
 {
-	Sint16 *pBuffer;
-	int i, window, nSamplesPerFrame;
+	int window, nSamplesPerFrame, nBufferedSamples;
 
-	pBuffer = (Sint16 *)stream;
 	len = len / 4;  // Use length in samples (16 bit stereo), not in bytes
 
 	/* Adjust emulation rate within +/- 0.58% (10 cents) occasionally,
@@ -61,7 +70,8 @@ static void Audio_CallBack(void *userdata, Uint8 *stream, int len)
 	 * See: main.c - Main_WaitOnVbl()
 	 */
 
-//fprintf ( stderr , "audio cb in len=%d gensmpl=%d idx=%d\n" , len , nGeneratedSamples , AudioMixBuffer_pos_read );
+	nBufferedSamples = Sound_GetBufferedSamples();
+//fprintf ( stderr , "audio cb in len=%d buffered=%d\n" , len , nBufferedSamples );
 	pulse_swallowing_count = 0;	/* 0 = Unaltered emulation rate */
 
 	if (ConfigureParams.Sound.bEnableSoundSync)
@@ -71,48 +81,20 @@ static void Audio_CallBack(void *userdata, Uint8 *stream, int len)
 		window = (nSamplesPerFrame > SoundBufferSize) ? nSamplesPerFrame : SoundBufferSize;
 
 		/* Window Comparator for SoundBufferSize */
-		if (nGeneratedSamples < window + (window >> 1))
+		if (nBufferedSamples < window + (window >> 1))
 		/* Increase emulation rate to maintain sound synchronization */
 			pulse_swallowing_count = -5793 / nScreenRefreshRate;
 		else
-		if (nGeneratedSamples > (window << 1) + (window >> 2))
+		if (nBufferedSamples > (window << 1) + (window >> 2))
 		/* Decrease emulation rate to maintain sound synchronization */
 			pulse_swallowing_count = 5793 / nScreenRefreshRate;
 
 		/* Otherwise emulation rate is unaltered. */
 	}
 
-	if (nGeneratedSamples >= len)
-	{
-		/* Enough samples available: Pass completed buffer to audio system
-		 * by write samples into sound buffer and by converting them from
-		 * 'signed' to 'unsigned' */
-		for (i = 0; i < len; i++)
-		{
-			*pBuffer++ = AudioMixBuffer[(AudioMixBuffer_pos_read + i) & AUDIOMIXBUFFER_SIZE_MASK][0];
-			*pBuffer++ = AudioMixBuffer[(AudioMixBuffer_pos_read + i) & AUDIOMIXBUFFER_SIZE_MASK][1];
-		}
-		AudioMixBuffer_pos_read += len;
-		nGeneratedSamples -= len;
-	}
-	else  /* Not enough samples available: */
-	{
-		for (i = 0; i < nGeneratedSamples; i++)
-		{
-			*pBuffer++ = AudioMixBuffer[(AudioMixBuffer_pos_read + i) & AUDIOMIXBUFFER_SIZE_MASK][0];
-			*pBuffer++ = AudioMixBuffer[(AudioMixBuffer_pos_read + i) & AUDIOMIXBUFFER_SIZE_MASK][1];
-		}
-		/* Clear rest of the buffer to ensure we don't play random bytes instead */
-		/* of missing samples */
-		memset(pBuffer, 0, (len - nGeneratedSamples) * 4);
-
-		AudioMixBuffer_pos_read += nGeneratedSamples;
-		nGeneratedSamples = 0;
-		
-	}
-
-	AudioMixBuffer_pos_read = AudioMixBuffer_pos_read & AUDIOMIXBUFFER_SIZE_MASK;
-//fprintf ( stderr , "audio cb out len=%d gensmpl=%d idx=%d\n" , len , nGeneratedSamples , AudioMixBuffer_pos_read );
+	/* Pass the samples to the audio system (AudioMixBuffer has the same */
+	/* 16 bit stereo layout), silence is added if not enough are available */
+	Sound_ReadSamples((int16_t (*)[2])stream, len);
 }
 
 
@@ -282,29 +264,116 @@ void Audio_UnInit(void)
 
 /*-----------------------------------------------------------------------*/
 /**
- * Lock the audio sub system so that the callback function will not be called.
+ * New samples were added to AudioMixBuffer : nothing to do, they will be
+ * read by the callback function (which doesn't need any lock).
  */
-void Audio_Lock(void)
+void Audio_NewSamples(void)
 {
-#if ENABLE_SDL3
-	SDL_LockAudioStream(audio_stream);
-#else
-	SDL_LockAudio();
-#endif
 }
 
 
 /*-----------------------------------------------------------------------*/
 /**
- * Unlock the audio sub system so that the callback function will be called again.
+ * Synthesis thread main loop: replay the YM2149 log when new entries
+ * are added
  */
-void Audio_Unlock(void)
+static int Audio_SynthThread(void *data)
 {
-#if ENABLE_SDL3
-	SDL_UnlockAudioStream(audio_stream);
-#else
-	SDL_UnlockAudio();
-#endif
+	SDL_LockMutex(Synth.mutex);
+	while (!Synth.quit)
+	{
+		if (!Synth.pending)
+		{
+			Synth.waiting = true;
+			SDL_CondBroadcast(Synth.idle);
+			SDL_CondWait(Synth.wake, Synth.mutex);
+			continue;
+		}
+		Synth.pending = false;
+		Synth.waiting = false;
+		SDL_UnlockMutex(Synth.mutex);
+		Sound_RunSynthLog();
+		SDL_LockMutex(Synth.mutex);
+	}
+	SDL_UnlockMutex(Synth.mutex);
+	return 0;
+}
+
+/**
+ * Start the YM2149 synthesis thread, return false if it failed
+ * (or if there's only one CPU)
+ */
+bool Audio_StartSynthThread(void)
+{
+	if (SDL_GetCPUCount() < 2)
+	{
+		Log_Printf(LOG_WARN, "Sound thread not started, the host has only one CPU\n");
+		return false;
+	}
+
+	if (!Synth.mutex)
+	{
+		Synth.mutex = SDL_CreateMutex();
+		Synth.wake = SDL_CreateCond();
+		Synth.idle = SDL_CreateCond();
+		if (!Synth.mutex || !Synth.wake || !Synth.idle)
+			Main_ErrorExit("Failed to create sound synthesis mutex:",
+			               SDL_GetError(), -1);
+	}
+
+	Synth.pending = Synth.waiting = Synth.quit = false;
+	Synth.thread = SDL_CreateThread(Audio_SynthThread, "Hatari sound", NULL);
+	if (!Synth.thread)
+	{
+		Log_Printf(LOG_WARN, "Failed to create sound synthesis thread: %s\n",
+		           SDL_GetError());
+		return false;
+	}
+	return true;
+}
+
+/**
+ * Stop the synthesis thread (the log must have been replayed)
+ */
+void Audio_StopSynthThread(void)
+{
+	if (!Synth.thread)
+		return;
+
+	SDL_LockMutex(Synth.mutex);
+	Synth.quit = true;
+	SDL_CondSignal(Synth.wake);
+	SDL_UnlockMutex(Synth.mutex);
+	SDL_WaitThread(Synth.thread, NULL);
+	Synth.thread = NULL;
+}
+
+/**
+ * New entries were added to the YM2149 log
+ */
+void Audio_WakeSynthThread(void)
+{
+	SDL_LockMutex(Synth.mutex);
+	Synth.pending = true;
+	if (Synth.waiting)
+		SDL_CondSignal(Synth.wake);
+	SDL_UnlockMutex(Synth.mutex);
+}
+
+/**
+ * Wait until the synthesis thread is idle, then replay the remaining log
+ * entries here (also the ones it was woken for but didn't take yet) : this
+ * is faster than waking it up and waiting again
+ */
+void Audio_WaitSynthThread(void)
+{
+	SDL_LockMutex(Synth.mutex);
+	while (!Synth.waiting)
+		SDL_CondWait(Synth.idle, Synth.mutex);
+	Synth.pending = false;
+	SDL_UnlockMutex(Synth.mutex);
+
+	Sound_RunSynthLog();
 }
 
 
@@ -65,12 +65,40 @@ static bool bUseSdlRenderer;            /* true when using SDL2 renderer */
 static bool bIsSoftwareRenderer;
 static int desktop_width, desktop_height;
 
+/* Worker threads converting bands of big screens in parallel with the
+ * emulation thread, started when first needed.  The jobs are taken in
+ * any order, each one writes its own part of the screen surface.
+ */
+#define SCREEN_MAX_WORKERS 3
+
+static struct {
+	SDL_Thread *thread[SCREEN_MAX_WORKERS];
+	int started;
+	SDL_mutex *mutex;
+	SDL_cond *start;
+	SDL_cond *done;
+	bool quit;
+	void (*func)(int idx, void *data);
+	void *data;
+	int next;               /* next job to take */
+	int jobs;
+	int pending;            /* jobs not finished yet */
+} Workers;
+
 
 void Screen_UpdateRects(SDL_Surface *screen, int numrects, SDL_Rect *rects)
 {
+	int i;
+
 	if (bUseSdlRenderer)
 	{
-		SDL_UpdateTexture(sdlTexture, NULL, screen->pixels, screen->pitch);
+		/* Upload only the changed parts of the surface to the texture */
+		for (i = 0; i < numrects; i++)
+		{
+			SDL_UpdateTexture(sdlTexture, &rects[i],
+			                  (uint8_t *)screen->pixels + rects[i].y * screen->pitch
+			                  + rects[i].x * sizeof(uint32_t), screen->pitch);
+		}
 		/* Need to clear the renderer context for certain accelerated cards */
 		if (!bIsSoftwareRenderer)
 			SDL_RenderClear(sdlRenderer);
@@ -105,6 +133,128 @@ uint32_t Screen_MapRGB(uint8_t red, uint8_t green, uint8_t blue)
 }
 
 
+/**
+ * Take and run jobs until there are none left. Called with the worker
+ * mutex locked.
+ */
+static void Screen_RunJobs(void)
+{
+	int idx;
+
+	while (Workers.next < Workers.jobs)
+	{
+		idx = Workers.next++;
+		SDL_UnlockMutex(Workers.mutex);
+		Workers.func(idx, Workers.data);
+		SDL_LockMutex(Workers.mutex);
+		if (--Workers.pending == 0)
+			SDL_CondSignal(Workers.done);
+	}
+}
+
+/**
+ * Worker thread main loop: wait for jobs and run them
+ */
+static int Screen_WorkerThread(void *data)
+{
+	SDL_LockMutex(Workers.mutex);
+	while (!Workers.quit)
+	{
+		Screen_RunJobs();
+		if (!Workers.quit)
+			SDL_CondWait(Workers.start, Workers.mutex);
+	}
+	SDL_UnlockMutex(Workers.mutex);
+	return 0;
+}
+
+/**
+ * Return the number of worker threads which can share screen conversion
+ * jobs with the calling thread (0 if there's only one CPU)
+ */
+int Screen_GetWorkerCount(void)
+{
+	static int count = -1;
+
+	if (count < 0)
+	{
+		count = SDL_GetCPUCount() - 1;
+		if (count > SCREEN_MAX_WORKERS)
+			count = SCREEN_MAX_WORKERS;
+		if (count < 0)
+			count = 0;
+	}
+	return count;
+}
+
+/**
+ * Call func(idx, data) for 'jobs' indexes, in the calling thread and the
+ * worker threads, and return when all are done
+ */
+void Screen_RunWorkers(void (*func)(int idx, void *data), int jobs, void *data)
+{
+	int count = Screen_GetWorkerCount();
+
+	if (!Workers.mutex)
+	{
+		Workers.mutex = SDL_CreateMutex();
+		Workers.start = SDL_CreateCond();
+		Workers.done = SDL_CreateCond();
+		if (!Workers.mutex || !Workers.start || !Workers.done)
+			Main_ErrorExit("Failed to create screen worker mutex:",
+			               SDL_GetError(), -1);
+	}
+
+	/* The jobs are run by the calling thread if workers can't be started */
+	while (Workers.started < count)
+	{
+		Workers.thread[Workers.started] = SDL_CreateThread(Screen_WorkerThread,
+		                                                   "Hatari screen", NULL);
+		if (!Workers.thread[Workers.started])
+		{
+			Log_Printf(LOG_WARN, "Failed to create screen worker thread: %s\n",
+			           SDL_GetError());
+			count = Workers.started;
+			break;
+		}
+		Workers.started++;
+	}
+
+	SDL_LockMutex(Workers.mutex);
+	Workers.func = func;
+	Workers.data = data;
+	Workers.next = 0;
+	Workers.jobs = jobs;
+	Workers.pending = jobs;
+	SDL_CondBroadcast(Workers.start);
+	Screen_RunJobs();
+	while (Workers.pending > 0)
+		SDL_CondWait(Workers.done, Workers.mutex);
+	Workers.jobs = 0;
+	SDL_UnlockMutex(Workers.mutex);
+}
+
+/**
+ * Stop the worker threads
+ */
+static void Screen_StopWorkers(void)
+{
+	int i;
+
+	if (!Workers.started)
+		return;
+
+	SDL_LockMutex(Workers.mutex);
+	Workers.quit = true;
+	SDL_CondBroadcast(Workers.start);
+	SDL_UnlockMutex(Workers.mutex);
+	for (i = 0; i < Workers.started; i++)
+		SDL_WaitThread(Workers.thread[i], NULL);
+	Workers.started = 0;
+	Workers.quit = false;
+}
+
+
 static void Screen_FreeSDL2Resources(void)
 {
 	if (sdlTexture)
@@ -730,6 +880,7 @@ void Screen_UnInit(void)
 {
 	SDLGui_UnInit();
 
+	Screen_StopWorkers();
 	Screen_FreeSDL2Resources();
 	if (sdlWindow)
 	{
@@ -888,20 +1039,41 @@ void Screen_UnLock(void)
 
 
 /**
- * Blit our converted ST screen to window/full-screen
+ * Blit our converted ST screen to window/full-screen: only the bands
+ * of lines changed by the conversion, unless 'bWhole' is set
  */
-static void Screen_Blit(SDL_Rect *sbar_rect)
+static void Screen_Blit(SDL_Rect *sbar_rect, bool bWhole)
 {
-	int count = 1;
-	SDL_Rect rects[2];
+	int top[CONVST_DIRTY_BANDS], bottom[CONVST_DIRTY_BANDS];
+	SDL_Rect rects[CONVST_DIRTY_BANDS + 1];
+	int i, bands, count = 0;
 
-	rects[0] = STScreenRect;
+	if (bWhole)
+	{
+		rects[count++] = STScreenRect;
+	}
+	else
+	{
+		bands = ConvST_GetDirtyBands(top, bottom);
+		for (i = 0; i < bands; i++)
+		{
+			rects[count] = STScreenRect;
+			if (top[i] > rects[count].y)
+				rects[count].y = top[i];
+			if (bottom[i] < STScreenRect.y + STScreenRect.h)
+				rects[count].h = bottom[i] - rects[count].y;
+			else
+				rects[count].h = STScreenRect.y + STScreenRect.h - rects[count].y;
+			if (rects[count].h > 0)
+				count++;
+		}
+	}
 	if (sbar_rect)
 	{
-		rects[1] = *sbar_rect;
-		count = 2;
+		rects[count++] = *sbar_rect;
 	}
-	Screen_UpdateRects(sdlscrn, count, rects);
+	if (count)
+		Screen_UpdateRects(sdlscrn, count, rects);
 }
 
 
@@ -933,7 +1105,7 @@ bool Screen_Draw(bool bForceFlip)
 	/* And show to user */
 	if (screen_changed || bForceFlip || sbar_rect)
 	{
-		Screen_Blit(sbar_rect);
+		Screen_Blit(sbar_rect, bForceFlip);
 	}
 
 	return screen_changed;
@@ -943,21 +1115,44 @@ bool Screen_Draw(bool bForceFlip)
 void Screen_GenConvUpdate(bool update_statusbar)
 {
 	SDL_Rect rects[2], *extra = NULL;
-	int count = 1;
+	int count = 0;
+	int top, bottom;
 
 	/* Don't update anything on screen if video output is disabled */
 	if ( ConfigureParams.Screen.DisableVideo )
 		return;
 
+	/* The generic conversion only draws the lines which changed,
+	 * so the area under the overlay led must be saved here */
 	if (update_statusbar)
+	{
+		Statusbar_OverlayBackup(sdlscrn);
 		extra = Statusbar_Update(sdlscrn, false);
+	}
 
-	rects[0] = STScreenRect;
+	/* Only update the lines which changed */
+	if (ConvGen_GetDirtyLines(&top, &bottom))
+	{
+		rects[0] = STScreenRect;
+		if (top > rects[0].y)
+			rects[0].y = top;
+		if (bottom < STScreenRect.y + STScreenRect.h)
+			rects[0].h = bottom - rects[0].y;
+		else
+			rects[0].h = STScreenRect.y + STScreenRect.h - rects[0].y;
+		if (rects[0].h > 0)
+			count = 1;
+	}
 	if (extra) {
-		rects[1] = *extra;
-		count = 2;
+		rects[count++] = *extra;
 	}
-	Screen_UpdateRects(sdlscrn, count, rects);
+	if (count)
+		Screen_UpdateRects(sdlscrn, count, rects);
+
+	/* Remove the overlay led from the converted lines, it's drawn again
+	 * by the next Statusbar_Update() if still needed */
+	if (update_statusbar)
+		Statusbar_OverlayRestore(sdlscrn);
 }
 
 uint32_t Screen_GetGenConvWidth(void)
@@ -761,7 +761,8 @@ static SDL_Rect* Statusbar_OverlayDraw(SDL_Surface *surf)
  * 
  * May not be called when screen is locked (SDL limitation).
  * 
- * Return updated area, or NULL if nothing is drawn.
+ * Return updated area (covering only the changed items), or NULL if
+ * nothing is drawn.
  */
 SDL_Rect* Statusbar_Update(SDL_Surface *surf, bool do_update)
 {
@@ -770,9 +771,9 @@ SDL_Rect* Statusbar_Update(SDL_Surface *surf, bool do_update)
 	static char JoysticksOld[JOYSTICK_COUNT+1] = "";
 	char JoysticksNew[JOYSTICK_COUNT+1];
 	Uint32 color, currentticks;
-	static SDL_Rect rect;
-	SDL_Rect *last_rect;
-	int i, updates;
+	static SDL_Rect dirty;
+	SDL_Rect rect, *last_rect;
+	int i;
 	int BltLed_lines_on_new;
 
 	/* Don't update anything on screen if video output is disabled */
@@ -806,8 +807,10 @@ SDL_Rect* Statusbar_Update(SDL_Surface *surf, bool do_update)
 	assert(surf->h == ScreenHeight + StatusbarHeight);
 
 	currentticks = SDL_GetTicks();
+	dirty.w = dirty.h = 0;
 	last_rect = Statusbar_ShowMessage(surf, currentticks);
-	updates = last_rect ? 1 : 0;
+	if (last_rect)
+		SDL_UnionRect(&dirty, last_rect, &dirty);
 
 	rect = LedRect;
 	for (i = 0; i < MAX_DRIVE_LEDS; i++)
@@ -825,8 +828,7 @@ SDL_Rect* Statusbar_Update(SDL_Surface *surf, bool do_update)
 		rect.x = Led[i].offset;
 		SDL_FillRect(surf, &rect, color);
 		DEBUGPRINT(("LED[%d] = %d\n", i, Led[i].state));
-		last_rect = &rect;
-		updates++;
+		SDL_UnionRect(&dirty, &rect, &dirty);
 	}
 
 	FDC_Get_Statusbar_Text(FdcNew, sizeof(FdcNew));
@@ -835,8 +837,7 @@ SDL_Rect* Statusbar_Update(SDL_Surface *surf, bool do_update)
 		strcpy(FdcOld, FdcNew);
 		SDL_FillRect(surf, &FDCTextRect, GrayBg);
 		SDLGui_Text(FDCTextRect.x, FDCTextRect.y, FdcNew);
-		last_rect = &FDCTextRect;
-		updates++;
+		SDL_UnionRect(&dirty, &FDCTextRect, &dirty);
 	}
 
 	/* joysticks' type */
@@ -846,8 +847,7 @@ SDL_Rect* Statusbar_Update(SDL_Surface *surf, bool do_update)
 		strcpy(JoysticksOld, JoysticksNew);
 		SDL_FillRect(surf, &JoysticksTextRect, GrayBg);
 		SDLGui_Text(JoysticksTextRect.x, JoysticksTextRect.y, JoysticksNew);
-		last_rect = &JoysticksTextRect;
-		updates++;
+		SDL_UnionRect(&dirty, &JoysticksTextRect, &dirty);
 	}
 
 	if (nOldFrameSkips != nFrameSkips ||
@@ -875,8 +875,7 @@ SDL_Rect* Statusbar_Update(SDL_Surface *surf, bool do_update)
 		SDL_FillRect(surf, &FrameSkipsRect, GrayBg);
 		SDLGui_Text(FrameSkipsRect.x, FrameSkipsRect.y, fscount);
 		DEBUGPRINT(("FS = %s\n", fscount));
-		last_rect = &FrameSkipsRect;
-		updates++;
+		SDL_UnionRect(&dirty, &FrameSkipsRect, &dirty);
 	}
 
 	/* Blitter : draw 'BltLed_lines_on_new' lines with color BltColorOn */
@@ -891,16 +890,14 @@ SDL_Rect* Statusbar_Update(SDL_Surface *surf, bool do_update)
 			rect.y += rect.h - BltLed_lines_on;
 			rect.h = BltLed_lines_on;
 			SDL_FillRect(surf, &rect, BltColorOn);
-			last_rect = &rect;
-			updates++;
+			SDL_UnionRect(&dirty, &rect, &dirty);
 		}
 		if ( BltLed_lines_on < BltLedRect.h )
 		{
 			rect = BltLedRect;
 			rect.h -= BltLed_lines_on;
 			SDL_FillRect(surf, &rect, BltColorOff);
-			last_rect = &rect;
-			updates++;
+			SDL_UnionRect(&dirty, &rect, &dirty);
 		}
 	}
 
@@ -917,15 +914,11 @@ SDL_Rect* Statusbar_Update(SDL_Surface *surf, bool do_update)
 		}
 		SDL_FillRect(surf, &RecLedRect, color);
 		DEBUGPRINT(("REC = ON\n"));
-		last_rect = &RecLedRect;
-		updates++;
+		SDL_UnionRect(&dirty, &RecLedRect, &dirty);
 	}
 
-	if (updates > 1)
-	{
-		/* multiple items updated -> update whole statusbar */
-		last_rect = &FullRect;
-	}
+	/* multiple items updated -> update the area covering them */
+	last_rect = dirty.w ? &dirty : NULL;
 	if (do_update && last_rect)
 	{
 		Screen_UpdateRects(surf, 1, last_rect);
@@ -0,0 +1,76 @@
+/*
+  Hatari - simd.c
+
+  Selection of the SIMD kernels depending on the host cpu, shared by
+  the screen conversion (conv_simd.c), the sample rate conversion
+  (resample.c) and the LMC1992 tone / volume chain (lmc1992.c).
+
+  This file is distributed under the GNU General Public License, version 2
+  or at your option any later version. Read the file gpl.txt for details.
+*/
+const char Simd_fileid[] = "Hatari simd.c";
+
+#include "main.h"
+#include "simd.h"
+
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Return true if the host cpu can run the kernels of 'level'
+ */
+static bool Simd_Supported(int level)
+{
+	switch (level)
+	{
+	 case SIMD_NONE:
+		return true;
+#ifdef SIMD_HOST_X86
+	 case SIMD_SSE2:
+		return __builtin_cpu_supports("sse2");
+	 case SIMD_AVX2:
+		return __builtin_cpu_supports("avx2");
+#endif
+#ifdef SIMD_HOST_NEON
+	 case SIMD_NEON:
+		return true;
+#endif
+	 default:
+		return false;
+	}
+}
+
+
+/**
+ * Return the level to use for 'level' (or the best one for SIMD_BEST),
+ * among the 'levels' mask of SIMD_LEVEL() bits for which a module has
+ * kernels. SIMD_NONE (the scalar code) is returned if 'level' is not
+ * in 'levels' or not supported by the host cpu.
+ */
+int Simd_Select(int level, int levels)
+{
+	if (level == SIMD_BEST)
+	{
+		for (level = SIMD_BEST - 1; level > SIMD_NONE; level--)
+			if ((levels & SIMD_LEVEL(level)) && Simd_Supported(level))
+				break;
+	}
+	else if (level < SIMD_NONE || level > SIMD_BEST
+	         || !(levels & SIMD_LEVEL(level)) || !Simd_Supported(level))
+	{
+		level = SIMD_NONE;
+	}
+	return level;
+}
+
+
+/**
+ * Return the name of the kernels of 'level'
+ */
+const char *Simd_Name(int level)
+{
+	static const char * const names[] = { "scalar", "SSE2", "AVX2", "NEON", "best" };
+
+	if (level < SIMD_NONE || level > SIMD_BEST)
+		return "unknown";
+	return names[level];
+}
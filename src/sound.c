@@ -148,6 +148,7 @@ const char Sound_fileid[] = "Hatari sound.c";
 #include "ymFormat.h"
 #include "avi_record.h"
 #include "clocks_timings.h"
+#include "resample.h"
 
 
 
@@ -296,18 +297,53 @@ int		YM2149_HPF_Filter = YM2149_HPF_FILTER_IIR;
 //int		YM2149_Resample_Method = YM2149_RESAMPLE_METHOD_WEIGHTED_AVERAGE_2;
 int		YM2149_Resample_Method = YM2149_RESAMPLE_METHOD_WEIGHTED_AVERAGE_N;
 
+//int		YM2149_Synth_Method = YM2149_SYNTH_METHOD_CYCLES;	/* For debug */
+int		YM2149_Synth_Method = YM2149_SYNTH_METHOD_EVENTS;
+int		YM2149_Synth_MinRun = YM2149_SYNTH_MIN_RUN;
+
 static double	pos_fract_nearest;			/* For YM2149_Next_Resample_Nearest */
 static double	pos_fract_weighted_2;			/* For YM2149_Next_Resample_Weighted_Average_2 */
 static uint32_t	pos_fract_weighted_n;			/* YM2149_Next_Resample_Weighted_Average_N */
+static uint32_t	pos_fract_sinc;				/* For YM2149_Resample_Sinc */
+static RESAMPLE_FILTER	YM2149_Resampler;			/* Polyphase filter for YM2149_Resample_Sinc */
 
 
 bool		bEnvelopeFreqFlag;			/* Cleared each frame for YM saving */
 
 int16_t		AudioMixBuffer[AUDIOMIXBUFFER_SIZE][2];	/* Ring buffer to store mixed audio output (YM2149, DMA sound, ...) */
 int		AudioMixBuffer_pos_write;		/* Current writing position into above buffer */
-int		AudioMixBuffer_pos_read;		/* Current reading position into above buffer */
 
-int		nGeneratedSamples;			/* Generated samples since audio buffer update */
+/* The new samples of AudioMixBuffer[] are copied to AudioPlayBuffer[], */
+/* which is shared without locking between the emulation and the audio */
+/* callback, which plays them : each side only writes its own counter of */
+/* samples (free running, not masked) and reads the other one with an atomic */
+/* load. The samples are written before AudioPlayBuffer_Written is increased, */
+/* and read before AudioPlayBuffer_Read is increased. The emulation never */
+/* writes to the slots between both counters, which the audio callback may */
+/* be reading : when AudioPlayBuffer[] is full, the new samples are dropped */
+static int16_t	AudioPlayBuffer[AUDIOMIXBUFFER_SIZE][2];
+static uint32_t	AudioPlayBuffer_Written;		/* Samples generated (emulation thread) */
+static uint32_t	AudioPlayBuffer_Read;			/* Samples played (audio thread) */
+static uint32_t	AudioPlayBuffer_Keep;			/* If not 0, samples to keep on the next read */
+static uint32_t	Sound_Stats_Underruns;			/* Audio callback found less samples than needed */
+static uint32_t	Sound_Stats_Overruns;			/* New samples dropped, AudioPlayBuffer[] was full */
+
+#if defined(__GNUC__) || defined(__clang__)
+#define AUDIOMIX_LOAD(p)	__atomic_load_n ( p , __ATOMIC_ACQUIRE )
+#define AUDIOMIX_STORE(p,v)	__atomic_store_n ( p , v , __ATOMIC_RELEASE )
+#define AUDIOMIX_TAKE(p)	__atomic_exchange_n ( p , 0 , __ATOMIC_ACQ_REL )
+#else
+#define AUDIOMIX_LOAD(p)	( *(volatile uint32_t *)(p) )
+#define AUDIOMIX_STORE(p,v)	( *(volatile uint32_t *)(p) = (v) )
+#define AUDIOMIX_TAKE(p)	Sound_Take ( p )
+static uint32_t Sound_Take ( uint32_t *p )
+{
+	uint32_t v = *(volatile uint32_t *)p;
+	if ( v )
+		*(volatile uint32_t *)p = 0;
+	return v;
+}
+#endif
 
 static int	AudioMixBuffer_pos_write_avi;		/* Current working index to save an AVI audio frame */
 
@@ -327,6 +363,34 @@ static uint64_t	YM2149_Clock_250;			/* 250 kHz counter */
 static uint64_t	YM2149_Clock_250_CpuClock;		/* Corresponding value of CyclesGlobalClockCounter at the time YM2149_Clock_250 was updated */
 static ymu16	YM2149_Freq_div_2 = 0;			/* Used for noise's generator which uses half the main freq (125 KHz) */
 
+static yms32	LowPassFilter_y0, LowPassFilter_x1;	/* State of the low pass filters applied */
+static yms32	PWMaliasFilter_y0, PWMaliasFilter_x1;	/* to the samples at 250 kHz */
+
+
+/* When the synthesis thread is used, the emulation only logs how many 250 kHz samples */
+/* must be generated and the register writes, which are replayed by the thread */
+#define		YM2149_LOG_SIZE		4096		/* Number of log entries (must be a power of 2) */
+#define		YM2149_LOG_SIZE_MASK	( YM2149_LOG_SIZE - 1 )
+#define		YM2149_LOG_NO_REG	0xff		/* Entry without a register write */
+#define		YM2149_LOG_WAKE_SAMPLES	1024		/* Wake the thread when this many 250 kHz samples (~4 ms) */
+#define		YM2149_LOG_WAKE_ENTRIES	256		/* or this many entries were logged since the last wakeup */
+
+typedef struct
+{
+	int		Samples;			/* Number of 250 kHz samples to generate first */
+	uint8_t		Reg;				/* Then write 'Data' to this register */
+	uint8_t		Data;
+} YM2149_LOG_ENTRY;
+
+static YM2149_LOG_ENTRY	YM2149_Log[ YM2149_LOG_SIZE ];
+static uint32_t	YM2149_Log_Written;			/* Entries logged (emulation thread) */
+static uint32_t	YM2149_Log_Done;			/* Entries replayed (synthesis thread) */
+static uint32_t	YM2149_Log_Woken;			/* Entries logged when the thread was last woken */
+static int	YM2149_Log_WokenSamples;		/* Samples logged since then */
+static bool	YM2149_Threaded = false;		/* True if the synthesis thread is running */
+static uint8_t	YM2149_SynthRegs[ 14 ];			/* Registers used by the synthesis (SoundRegs[] is */
+							/* updated by the emulation when threaded) */
+
 
 
 /* Some variables used for stats / debug */
@@ -363,7 +427,10 @@ static ymu16	YM2149_TonePer		(ymu8 rHigh , ymu8 rLow);
 static ymu16	YM2149_NoisePer		(ymu8 rNoise);
 static ymu16	YM2149_EnvPer		(ymu8 rHigh , ymu8 rLow);
 
-static void	YM2149_Run		( uint64_t CPU_Clock );
+static void	YM2149_WriteReg		( uint8_t *pRegs , int reg , uint8_t data );
+static void	YM2149_LogWrite		( int Samples , uint8_t Reg , uint8_t Data );
+static void	YM2149_SynthSync	( void );
+static void	YM2149_Run		( uint64_t CPU_Clock , bool bDefer );
 static int	Sound_GenerateSamples	( uint64_t CPU_Clock);
 static void	YM2149_DoSamples_250	( int SamplesToGenerate_250 );
 #ifdef YM_250_DEBUG
@@ -396,21 +463,6 @@ ymsample	Subsonic_IIR_HPF_Left(ymsample x0)
 }
 
 
-ymsample	Subsonic_IIR_HPF_Right(ymsample x0)
-{
-	static	yms32	x1 = 0, y1 = 0, y0 = 0;
-
-	if ( YM2149_HPF_Filter == YM2149_HPF_FILTER_NONE )
-		return x0;
-
-	y1 += ((x0 - x1) * 32768) - (y0 * 64);
-	y0 = y1 / 32768;
-	x1 = x0;
-
-	return y0;
-}
-
-
 /*--------------------------------------------------------------*/
 /* Low Pass Filter routines.					*/
 /*--------------------------------------------------------------*/
@@ -452,7 +504,7 @@ ymsample	Subsonic_IIR_HPF_Right(ymsample x0)
  */
 static ymsample	LowPassFilter(ymsample x0)
 {
-	static	yms32 y0 = 0, x1 = 0;
+	yms32 y0 = LowPassFilter_y0, x1 = LowPassFilter_x1;
 
 	if (x0 >= y0)
 	/* YM Pull up:   fc = 7586.1 Hz (44.1 KHz), fc = 8257.0 Hz (48 KHz) */
@@ -461,7 +513,8 @@ static ymsample	LowPassFilter(ymsample x0)
 	/* R8 Pull down: fc = 1992.0 Hz (44.1 KHz), fc = 2168.0 Hz (48 KHz) */
 		y0 = ((x0 + x1) + (6*y0)) >> 3;
 
-	x1 = x0;
+	LowPassFilter_x1 = x0;
+	LowPassFilter_y0 = y0;
 	return y0;
 }
 
@@ -480,7 +533,7 @@ static ymsample	LowPassFilter(ymsample x0)
  */
 static ymsample	PWMaliasFilter(ymsample x0)
 {
-	static	yms32 y0 = 0, x1 = 0;
+	yms32 y0 = PWMaliasFilter_y0, x1 = PWMaliasFilter_x1;
 
 	if (x0 >= y0)
 	/* YM Pull up   */
@@ -489,7 +542,8 @@ static ymsample	PWMaliasFilter(ymsample x0)
 	/* R8 Pull down */
 		y0 = (3*(x0 + x1) + (y0<<1)) >> 3;
 
-	x1 = x0;
+	PWMaliasFilter_x1 = x0;
+	PWMaliasFilter_y0 = y0;
 	return y0;
 }
 
@@ -908,6 +962,8 @@ static void	YM2149_UpdateClock_250 ( uint64_t CpuClock )
  */
 static void	Ym2149_Init(void)
 {
+	YM2149_SynthSync ();
+
 	/* Build the 16 envelope shapes */
 	YM2149_EnvBuild();
 
@@ -920,11 +976,18 @@ static void	Ym2149_Init(void)
 	/* Reset 250 Hz clock */
 	YM2149_Clock_250 = 0;
 	YM2149_Clock_250_CpuClock = CyclesGlobalClockCounter;
+	YM2149_ConvertCycles_250.Remainder = 0;
+	YM2149_Freq_div_2 = 0;
 
 	/* Clear internal YM audio buffer at 250 kHz */
 	memset ( YM_Buffer_250 , 0 , sizeof(YM_Buffer_250) );
 	YM_Buffer_250_pos_write = 0;
 	YM_Buffer_250_pos_read = 0;
+	pos_fract_nearest = pos_fract_weighted_2 = 0;
+	pos_fract_weighted_n = pos_fract_sinc = 0;
+
+	LowPassFilter_y0 = LowPassFilter_x1 = 0;
+	PWMaliasFilter_y0 = PWMaliasFilter_x1 = 0;
 }
 
 
@@ -939,10 +1002,15 @@ static void	Ym2149_Reset(void)
 {
 	int	i;
 
+	/* The synthesis thread must not use the registers / counters meanwhile */
+	YM2149_SynthSync ();
+
 	for ( i=0 ; i<14 ; i++ )
-		Sound_WriteReg ( i , 0 );
+		YM2149_WriteReg ( SoundRegs , i , 0 );
 
-	Sound_WriteReg ( 7 , 0xff );
+	YM2149_WriteReg ( SoundRegs , 7 , 0xff );
+	memcpy ( YM2149_SynthRegs , SoundRegs , sizeof ( YM2149_SynthRegs ) );
+	bEnvelopeFreqFlag = true;				/* register 13 was written */
 
 	/* Reset internal variables and counters */
 	ToneA_per = ToneA_count = 0;
@@ -1012,32 +1080,61 @@ static ymu16	YM2149_EnvPer(ymu8 rHigh , ymu8 rLow)
 
 /*-----------------------------------------------------------------------*/
 /**
- * Main function : compute the value of the next sample.
- * Mixes all 3 voices with tone+noise+env and apply low pass
- * filter if needed.
- * For maximum accuracy, this function emulates all single cycles at 250 kHz
- * As output we get a "raw" 250 kHz signal that will be later downsampled
- * to the chosen output frequency (eg 44.1 kHz)
- * Creating a complete 250 kHz signal allow to emulate effects that require
- * precise cycle accuracy (such as "syncsquare" used in maxYMiser v1.53)
+ * Mix all 3 voices with the current tone/noise/env/volume values and
+ * return the corresponding 16 bits signed sample (before filtering)
  */
-static void	YM2149_DoSamples_250 ( int SamplesToGenerate_250 )
+static inline ymsample	YM2149_MixVoices ( void )
 {
-	ymsample	sample;
 	ymu32		bt;
 	ymu16		Env3Voices;			/* 0x00CCBBAA */
 	ymu16		Tone3Voices;			/* 0x00CCBBAA */
-	int		pos;
-	int		n;
 
+	/* Get the 5 bits volume corresponding to the current envelope's position */
+	Env3Voices = YmEnvWaves[ Env_shape ][ Env_pos ];
+	Env3Voices &= EnvMask3Voices;			/* only keep volumes for voices using envelope */
 
-//fprintf ( stderr , "ym2149_dosamples_250 in nb=%d ym_pos_wr=%d\n",SamplesToGenerate_250 , YM_Buffer_250_pos_write );
+	/* Tone3Voices will contain the output state of each voice : 0 or 0x1f */
+	bt = (ToneA_val | mixerTA) & (Noise_val | mixerNA);	/* 0 or 0xffff */
+	Tone3Voices = bt & YM_MASK_1VOICE;		/* 0 or 0x1f */
 
-	/* We write new samples at position YM_Buffer_250_pos_write while we read them at the same time */
-	/* at position YM_Buffer_250_pos_read (to create the output at YM_REPLAY_FREQ) */
-	/* This means we must ensure YM_Buffer_250[] is large enough to avoid overwriting data */
-	/* that are not read yet */
-	pos = YM_Buffer_250_pos_write;
+	bt = (ToneB_val | mixerTB) & (Noise_val | mixerNB);
+	Tone3Voices |= ( bt & YM_MASK_1VOICE ) << 5;
+
+	bt = (ToneC_val | mixerTC) & (Noise_val | mixerNC);
+	Tone3Voices |= ( bt & YM_MASK_1VOICE ) << 10;
+
+	/* Combine fixed volumes and envelope volumes and keep the resulting */
+	/* volumes depending on the output state of each voice (0 or 0x1f) */
+	Tone3Voices &= ( Env3Voices | Vol3Voices );
+
+	return ymout5[ Tone3Voices ];			/* 16 bits signed value */
+}
+
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Apply low pass filter if needed
+ */
+static inline ymsample	YM2149_Filter ( ymsample sample )
+{
+	if ( YM2149_LPF_Filter == YM2149_LPF_FILTER_LPF_STF )
+		return LowPassFilter ( sample );
+	else if ( YM2149_LPF_Filter == YM2149_LPF_FILTER_PWM )
+		return PWMaliasFilter ( sample );
+	return sample;
+}
+
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Compute the samples by emulating all single cycles at 250 kHz, starting
+ * at position 'pos' in YM_Buffer_250[]. Return the new writing position.
+ * This is the reference for YM2149_DoSamples_250_Events().
+ */
+static int	YM2149_DoSamples_250_Cycles ( int SamplesToGenerate_250 , int pos )
+{
+	ymsample	sample;
+	int		n;
 
 	/* Emulate as many internal YM cycles as needed to generate samples */
 	for ( n=0 ; n<SamplesToGenerate_250 ; n++ )
@@ -1057,12 +1154,10 @@ static void	YM2149_DoSamples_250 ( int SamplesToGenerate_250 )
 			Noise_val = YM2149_RndCompute();/* 0 or 0xffff */
 		}
 
-//fprintf ( stderr , "ym2149_dosamples_250 max=%d n=%d ToneA_count=%d ToneA_per=%d val=%x pos=%d\n",SamplesToGenerate_250,n,ToneA_count,ToneA_per,ToneA_val,pos );
 		/* Other counters are increased on every call, at 250 KHz */
 		ToneA_count++;
 		if ( ToneA_count >= ToneA_per )
 		{
-//fprintf ( stderr , "ym2149_dosamples_250 max=%d n=%d ToneA_count=%d ToneA_per=%d val=%x pos=%d toggle\n",SamplesToGenerate_250,n,ToneA_count,ToneA_per,ToneA_val,pos );
 			ToneA_count = 0;
 			ToneA_val ^= YM_SQUARE_UP;	/* 0 or 0x1f */
 		}
@@ -1091,38 +1186,291 @@ static void	YM2149_DoSamples_250 ( int SamplesToGenerate_250 )
 		}
 
 		/* Build 'sample' value with the values of tone/noise/volume/env */
+		sample = YM2149_Filter ( YM2149_MixVoices () );
 
-		/* Get the 5 bits volume corresponding to the current envelope's position */
-		Env3Voices = YmEnvWaves[ Env_shape ][ Env_pos ];
-		Env3Voices &= EnvMask3Voices;			/* only keep volumes for voices using envelope */
+		/* Store sample */
+		YM_Buffer_250[ pos ] = sample;
+		pos = ( pos + 1 ) & YM_BUFFER_250_SIZE_MASK;
+	}
+
+	return pos;
+}
 
-		/* Tone3Voices will contain the output state of each voice : 0 or 0x1f */
-		bt = (ToneA_val | mixerTA) & (Noise_val | mixerNA);	/* 0 or 0xffff */
-		Tone3Voices = bt & YM_MASK_1VOICE;		/* 0 or 0x1f */
 
-		bt = (ToneB_val | mixerTB) & (Noise_val | mixerNB);
-		Tone3Voices |= ( bt & YM_MASK_1VOICE ) << 5;
+/*-----------------------------------------------------------------------*/
+/**
+ * Return the number of 250 kHz cycles until a tone or envelope counter
+ * reaches its period (counters are incremented first, then compared to per,
+ * so this is at least 1 and per==0 gives the same result as per==1)
+ */
+static inline int	YM2149_CyclesToPeriod ( int count , int per )
+{
+	return count + 1 >= per ? 1 : per - count;
+}
+
+/**
+ * Same for the noise counter, which is incremented only every 2 cycles
+ * (when YM2149_Freq_div_2 goes back to 0), but compared on every cycle
+ */
+static inline int	YM2149_CyclesToNoise ( void )
+{
+	if ( Noise_count >= Noise_per )
+		return 1;
+	return ( YM2149_Freq_div_2 ? 1 : 2 ) + 2 * ( Noise_per - Noise_count - 1 );
+}
 
-		bt = (ToneC_val | mixerTC) & (Noise_val | mixerNC);
-		Tone3Voices |= ( bt & YM_MASK_1VOICE ) << 10;
 
-		/* Combine fixed volumes and envelope volumes and keep the resulting */
-		/* volumes depending on the output state of each voice (0 or 0x1f) */
-		Tone3Voices &= ( Env3Voices | Vol3Voices );
+static inline int	YM2149_MinCycles ( int k1 , int k2 )
+{
+	return k1 < k2 ? k1 : k2;
+}
 
-		sample = ymout5[ Tone3Voices ];			/* 16 bits signed value */
 
-		/* Apply low pass filter ? */
-		if ( YM2149_LPF_Filter == YM2149_LPF_FILTER_LPF_STF )
-			sample = LowPassFilter ( sample );
-		else if ( YM2149_LPF_Filter == YM2149_LPF_FILTER_PWM )
-			sample = PWMaliasFilter ( sample );
+/*-----------------------------------------------------------------------*/
+/**
+ * Advance a tone or envelope counter by 'k' cycles and return the number
+ * of times it reached its period
+ */
+static inline int	YM2149_AdvanceCounter ( ymu16 *count , int per , int k )
+{
+	int	first = YM2149_CyclesToPeriod ( *count , per );
 
-		/* Store sample */
+	if ( k < first )
+	{
+		*count += k;
+		return 0;
+	}
+	if ( k == first )
+	{
+		*count = 0;
+		return 1;
+	}
+	if ( per == 0 )
+		per = 1;
+	*count = ( k - first ) % per;
+	return 1 + ( k - first ) / per;
+}
+
+/**
+ * Advance the noise counter by 'k' cycles, computing a new noise value
+ * each time it reaches its period
+ */
+static void	YM2149_AdvanceNoise ( int k )
+{
+	int	kN;
+
+	while ( k > 0 )
+	{
+		kN = YM2149_CyclesToNoise ();
+		if ( kN > k )
+			kN = k;
+
+		if ( YM2149_Freq_div_2 )
+			Noise_count += ( kN + 1 ) >> 1;
+		else
+			Noise_count += kN >> 1;
+		YM2149_Freq_div_2 ^= kN & 1;
+
+		if ( Noise_count >= Noise_per )
+		{
+			Noise_count = 0;
+			Noise_val = YM2149_RndCompute();/* 0 or 0xffff */
+		}
+		k -= kN;
+	}
+}
+
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Store 'count' times the value 'sample' at position 'pos' in YM_Buffer_250[]
+ * and return the new writing position. The loop on each contiguous part of
+ * the ring buffer is vectorized by the compiler.
+ */
+static int	YM2149_FillSamples ( int pos , ymsample sample , int count )
+{
+	ymsample	*buf;
+	int		len;
+	int		i;
+
+	while ( count > 0 )
+	{
+		len = YM_BUFFER_250_SIZE - pos;
+		if ( len > count )
+			len = count;
+		buf = &YM_Buffer_250[ pos ];
+		for ( i=0 ; i<len ; i++ )
+			buf[ i ] = sample;
+		pos = ( pos + len ) & YM_BUFFER_250_SIZE_MASK;
+		count -= len;
+	}
+	return pos;
+}
+
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Store 'count' samples for an unfiltered value 'raw' at position 'pos'.
+ * The low pass filters are stepped until their output doesn't change
+ * anymore (same input as the previous call and same output), the
+ * remaining samples have the same value.
+ */
+static int	YM2149_StoreRun ( int pos , ymsample raw , int count )
+{
+	ymsample	sample , prev;
+
+	if ( count <= 0 )
+		return pos;
+
+	if ( YM2149_LPF_Filter != YM2149_LPF_FILTER_LPF_STF
+	  && YM2149_LPF_Filter != YM2149_LPF_FILTER_PWM )
+		return YM2149_FillSamples ( pos , raw , count );
+
+	sample = YM2149_Filter ( raw );
+	YM_Buffer_250[ pos ] = sample;
+	pos = ( pos + 1 ) & YM_BUFFER_250_SIZE_MASK;
+	count--;
+
+	while ( count > 0 )
+	{
+		prev = sample;
+		sample = YM2149_Filter ( raw );
 		YM_Buffer_250[ pos ] = sample;
 		pos = ( pos + 1 ) & YM_BUFFER_250_SIZE_MASK;
+		count--;
+		if ( sample == prev )
+			break;
 	}
 
+	return YM2149_FillSamples ( pos , sample , count );
+}
+
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Compute the samples by going directly from one event (tone toggle, new
+ * noise value or envelope step) to the next one, as computed from the
+ * counters and periods. Between events the output of the voices doesn't
+ * change, so the samples are stored in bulk by YM2149_StoreRun().
+ * Only the events which can change the output (tone or noise enabled in
+ * the mixer, envelope used by a voice) end a run, the other counters are
+ * advanced in one go.
+ * The result is the same as with YM2149_DoSamples_250_Cycles().
+ */
+static int	YM2149_DoSamples_250_Events ( int SamplesToGenerate_250 , int pos )
+{
+	ymsample	raw , next;
+	int		run;				/* samples with value 'raw' not stored yet */
+	bool		bNoise;
+	int		k;
+	int		n;
+
+	/* Registers can't change during this call */
+	bNoise = !( mixerNA && mixerNB && mixerNC );
+
+	raw = YM2149_MixVoices ();
+	run = 0;
+	n = SamplesToGenerate_250;
+
+	while ( n > 0 )
+	{
+		/* Cycles until the next event which can change the output */
+		k = n;
+		if ( !mixerTA )
+			k = YM2149_MinCycles ( k , YM2149_CyclesToPeriod ( ToneA_count , ToneA_per ) );
+		if ( !mixerTB )
+			k = YM2149_MinCycles ( k , YM2149_CyclesToPeriod ( ToneB_count , ToneB_per ) );
+		if ( !mixerTC )
+			k = YM2149_MinCycles ( k , YM2149_CyclesToPeriod ( ToneC_count , ToneC_per ) );
+		if ( EnvMask3Voices )
+			k = YM2149_MinCycles ( k , YM2149_CyclesToPeriod ( Env_count , Env_per ) );
+		if ( bNoise )
+			k = YM2149_MinCycles ( k , YM2149_CyclesToNoise () );
+
+		/* Advance all counters by k cycles */
+		YM2149_AdvanceNoise ( k );
+
+		if ( YM2149_AdvanceCounter ( &ToneA_count , ToneA_per , k ) & 1 )
+			ToneA_val ^= YM_SQUARE_UP;	/* 0 or 0x1f */
+		if ( YM2149_AdvanceCounter ( &ToneB_count , ToneB_per , k ) & 1 )
+			ToneB_val ^= YM_SQUARE_UP;
+		if ( YM2149_AdvanceCounter ( &ToneC_count , ToneC_per , k ) & 1 )
+			ToneC_val ^= YM_SQUARE_UP;
+
+		Env_pos += YM2149_AdvanceCounter ( &Env_count , Env_per , k );
+		if ( Env_pos >= 3*32 )			/* blocks 0, 1 and 2 were used (Env_pos 0 to 95) */
+			Env_pos = 32 + ( Env_pos - 32 ) % ( 2*32 );	/* replay/loop blocks 1 and 2 (Env_pos 32 to 95) */
+
+		/* The first k-1 cycles keep the previous output */
+		next = YM2149_MixVoices ();
+		if ( next != raw )
+		{
+			pos = YM2149_StoreRun ( pos , raw , run + k - 1 );
+			raw = next;
+			run = 1;
+		}
+		else
+			run += k;
+
+		n -= k;
+	}
+
+	return YM2149_StoreRun ( pos , raw , run );
+}
+
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Return true if the events which can change the output come on average
+ * more often than every YM2149_Synth_MinRun cycles with the current
+ * registers (small tone / noise / envelope periods, as for digi sound).
+ * Runs are then too short for YM2149_DoSamples_250_Events() and stepping
+ * all counters on every cycle is faster.
+ */
+static bool	YM2149_EventsDense ( void )
+{
+	int	rate = 0;				/* Events per 65536 cycles */
+
+	if ( !mixerTA )
+		rate += 65536 / ( ToneA_per ? ToneA_per : 1 );
+	if ( !mixerTB )
+		rate += 65536 / ( ToneB_per ? ToneB_per : 1 );
+	if ( !mixerTC )
+		rate += 65536 / ( ToneC_per ? ToneC_per : 1 );
+	if ( EnvMask3Voices )
+		rate += 65536 / ( Env_per ? Env_per : 1 );
+	if ( !( mixerNA && mixerNB && mixerNC ) )
+		rate += 32768 / ( Noise_per ? Noise_per : 1 );	/* Noise counter runs at 125 kHz */
+
+	return rate * YM2149_Synth_MinRun > 65536;
+}
+
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Main function : compute the values of the next samples.
+ * Mixes all 3 voices with tone+noise+env and apply low pass
+ * filter if needed.
+ * For maximum accuracy, this function emulates all single cycles at 250 kHz
+ * As output we get a "raw" 250 kHz signal that will be later downsampled
+ * to the chosen output frequency (eg 44.1 kHz)
+ * Creating a complete 250 kHz signal allow to emulate effects that require
+ * precise cycle accuracy (such as "syncsquare" used in maxYMiser v1.53)
+ */
+static void	YM2149_DoSamples_250 ( int SamplesToGenerate_250 )
+{
+	int		pos;
+
+	/* We write new samples at position YM_Buffer_250_pos_write while we read them at the same time */
+	/* at position YM_Buffer_250_pos_read (to create the output at YM_REPLAY_FREQ) */
+	/* This means we must ensure YM_Buffer_250[] is large enough to avoid overwriting data */
+	/* that are not read yet */
+	/* Registers can't change during this call, so the method is chosen */
+	/* for all the samples from the current event density */
+	if ( YM2149_Synth_Method == YM2149_SYNTH_METHOD_CYCLES || YM2149_EventsDense () )
+		pos = YM2149_DoSamples_250_Cycles ( SamplesToGenerate_250 , YM_Buffer_250_pos_write );
+	else
+		pos = YM2149_DoSamples_250_Events ( SamplesToGenerate_250 , YM_Buffer_250_pos_write );
 
 #ifdef YM_250_DEBUG
 	/* write raw 250 kHz samples into a wav file */
@@ -1130,8 +1478,6 @@ static void	YM2149_DoSamples_250 ( int SamplesToGenerate_250 )
 #endif
 
 	YM_Buffer_250_pos_write = pos;
-
-//fprintf ( stderr , "ym2149_dosamples_250 out nb=%d ym_pos_wr=%d\n",SamplesToGenerate_250 , YM_Buffer_250_pos_write );
 }
 
 
@@ -1239,8 +1585,10 @@ static void	YM2149_DoSamples_250_Debug ( int SamplesToGenerate , int pos )
  *
  * On each call, we consider samples were already generated up to (and including) counter value
  * YM2149_Clock_250_prev. We must generate as many samples to reach (and include) YM2149_Clock_250.
+ * When the synthesis thread is used and 'bDefer' is true, the number of samples is only logged
+ * (the thread will generate them). Else the log must be empty (see YM2149_SynthSync).
  */
-static void	YM2149_Run ( uint64_t CPU_Clock )
+static void	YM2149_Run ( uint64_t CPU_Clock , bool bDefer )
 {
 	uint64_t		YM2149_Clock_250_prev;
 	int		YM2149_Nb_Updates_250;
@@ -1253,7 +1601,116 @@ static void	YM2149_Run ( uint64_t CPU_Clock )
 
 	if ( YM2149_Nb_Updates_250 > 0 )
 	{
-		YM2149_DoSamples_250 ( YM2149_Nb_Updates_250 );
+		if ( YM2149_Threaded && bDefer )
+			YM2149_LogWrite ( YM2149_Nb_Updates_250 , YM2149_LOG_NO_REG , 0 );
+		else
+			YM2149_DoSamples_250 ( YM2149_Nb_Updates_250 );
+	}
+}
+
+
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Add an entry to the log replayed by the synthesis thread : generate
+ * 'Samples' samples at 250 kHz, then write 'Data' to register 'Reg'
+ * (if not YM2149_LOG_NO_REG).
+ * The thread is only woken once enough samples or entries were logged since
+ * the last wakeup, the remaining entries are replayed on the next sync.
+ * If the log is full, we wait until the thread replayed it.
+ */
+static void	YM2149_LogWrite ( int Samples , uint8_t Reg , uint8_t Data )
+{
+	YM2149_LOG_ENTRY	*pEntry;
+
+	if ( YM2149_Log_Written - AUDIOMIX_LOAD ( &YM2149_Log_Done ) >= YM2149_LOG_SIZE )
+		YM2149_SynthSync ();
+
+	pEntry = &YM2149_Log[ YM2149_Log_Written & YM2149_LOG_SIZE_MASK ];
+	pEntry->Samples = Samples;
+	pEntry->Reg = Reg;
+	pEntry->Data = Data;
+	AUDIOMIX_STORE ( &YM2149_Log_Written , YM2149_Log_Written + 1 );
+
+	YM2149_Log_WokenSamples += Samples;
+	if ( YM2149_Log_WokenSamples >= YM2149_LOG_WAKE_SAMPLES
+	  || YM2149_Log_Written - YM2149_Log_Woken >= YM2149_LOG_WAKE_ENTRIES )
+	{
+		Audio_WakeSynthThread ();
+		YM2149_Log_Woken = YM2149_Log_Written;
+		YM2149_Log_WokenSamples = 0;
+	}
+}
+
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Replay the log entries, until there are none left
+ * (called by the synthesis thread, or by the emulation when it's idle)
+ */
+void	Sound_RunSynthLog ( void )
+{
+	YM2149_LOG_ENTRY	*pEntry;
+	uint32_t		written;
+
+	while ( ( written = AUDIOMIX_LOAD ( &YM2149_Log_Written ) ) != YM2149_Log_Done )
+	{
+		do
+		{
+			pEntry = &YM2149_Log[ YM2149_Log_Done & YM2149_LOG_SIZE_MASK ];
+			if ( pEntry->Samples > 0 )
+				YM2149_DoSamples_250 ( pEntry->Samples );
+			if ( pEntry->Reg != YM2149_LOG_NO_REG )
+				YM2149_WriteReg ( YM2149_SynthRegs , pEntry->Reg , pEntry->Data );
+
+			/* New samples in YM_Buffer_250[] are visible once the entry is done */
+			AUDIOMIX_STORE ( &YM2149_Log_Done , YM2149_Log_Done + 1 );
+		}
+		while ( YM2149_Log_Done != written );
+	}
+}
+
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Make sure all the log entries were replayed : the entries not taken by
+ * the synthesis thread yet are replayed here instead of waking it up and
+ * waiting for it (it doesn't use the YM2149 variables after that, until
+ * it's woken again)
+ */
+static void	YM2149_SynthSync ( void )
+{
+	if ( YM2149_Threaded && AUDIOMIX_LOAD ( &YM2149_Log_Done ) != YM2149_Log_Written )
+		Audio_WaitSynthThread ();
+
+	YM2149_Log_Woken = YM2149_Log_Written;
+	YM2149_Log_WokenSamples = 0;
+}
+
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Start or stop the thread generating the YM2149 samples at 250 kHz.
+ * If the audio backend can't start it, the samples are generated by the
+ * emulation as usual.
+ */
+void	Sound_SetSynthThread ( bool bEnable )
+{
+	if ( bEnable == YM2149_Threaded )
+		return;
+
+	if ( bEnable )
+	{
+		memcpy ( YM2149_SynthRegs , SoundRegs , sizeof ( YM2149_SynthRegs ) );
+		YM2149_Log_Written = YM2149_Log_Done = YM2149_Log_Woken = 0;
+		YM2149_Log_WokenSamples = 0;
+		YM2149_Threaded = Audio_StartSynthThread ();
+	}
+	else
+	{
+		YM2149_SynthSync ();
+		Audio_StopSynthThread ();
+		YM2149_Threaded = false;
 	}
 }
 
@@ -1402,47 +1859,128 @@ static ymsample	YM2149_NextSample_250 ( void )
 }
 
 
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Downsample the YM2149 samples data from 250 KHz to YM_REPLAY_FREQ with
+ * a polyphase windowed-sinc filter (see resample.c), storing the samples
+ * in AudioMixBuffer[] from position 'idx'.
+ * Samples are converted by blocks while at least 'ym_margin' samples
+ * are available after YM_Buffer_250_pos_read.
+ *
+ * It's the slowest method but it has almost no aliasing, even when the
+ * YM voices use very high frequencies.
+ */
+static int	YM2149_Resample_Sinc ( int idx , int ym_margin , bool bHPF )
+{
+	ymsample	block[ 256 ];
+	ymsample	sample;
+	int		avail;
+	int		nb , i;
+	int		Sample_Nbr = 0;
+
+	Resample_SetRates ( &YM2149_Resampler , YM_ATARI_CLOCK_COUNTER , YM_REPLAY_FREQ );
+
+	do
+	{
+		avail = ( YM_Buffer_250_pos_write - YM_Buffer_250_pos_read ) & YM_BUFFER_250_SIZE_MASK;
+		if ( avail < ym_margin )
+			break;
+
+		nb = Resample_Block ( &YM2149_Resampler , YM_Buffer_250 , YM_BUFFER_250_SIZE_MASK ,
+				&YM_Buffer_250_pos_read , &pos_fract_sinc , avail - ym_margin + 1 , block , 256 );
+
+		for ( i = 0 ; i < nb ; i++ )
+		{
+			sample = block[ i ];
+			if ( bHPF )
+				sample = Subsonic_IIR_HPF_Left ( sample );
+			AudioMixBuffer[idx][0] = AudioMixBuffer[idx][1] = sample;
+			idx = ( idx+1 ) & AUDIOMIXBUFFER_SIZE_MASK;
+		}
+		Sample_Nbr += nb;
+	}
+	while ( nb == 256 );
+
+	return Sample_Nbr;
+}
+
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Store the next YM2149 samples at YM_REPLAY_FREQ in AudioMixBuffer[] from
+ * position 'idx', as long as enough samples are available in YM_Buffer_250[].
+ * Apply the subsonic high pass filter if 'bHPF' is set.
+ * Return the number of samples.
+ */
+static int	YM2149_Resample ( int idx , bool bHPF )
+{
+	int		ym_margin;
+	ymsample	sample;
+	int		Sample_Nbr = 0;
+
+	ym_margin = ceil ( ((double)YM_ATARI_CLOCK_COUNTER) / nAudioFrequency ) + 2;
+//fprintf ( stderr , "sound_gen margin=%d read_max=%d\n" , ym_margin , ( YM_Buffer_250_pos_write - ym_margin ) & YM_BUFFER_250_SIZE_MASK );
+
+	if ( YM2149_Resample_Method == YM2149_RESAMPLE_METHOD_SINC )
+		return YM2149_Resample_Sinc ( idx , ym_margin , bHPF );
+
+	while ( ( ( YM_Buffer_250_pos_write - YM_Buffer_250_pos_read ) & YM_BUFFER_250_SIZE_MASK ) >= ym_margin )
+	{
+		sample = YM2149_NextSample_250();
+		if ( bHPF )
+			sample = Subsonic_IIR_HPF_Left ( sample );
+		AudioMixBuffer[idx][0] = AudioMixBuffer[idx][1] = sample;
+		idx = ( idx+1 ) & AUDIOMIXBUFFER_SIZE_MASK;
+		Sample_Nbr++;
+	}
+
+	return Sample_Nbr;
+}
+
+
 /*-----------------------------------------------------------------------*/
 /**
  * Update internal variables (steps, volume masks, ...) each
- * time an YM register is changed.
+ * time an YM register is changed. 'pRegs' is SoundRegs[] or
+ * YM2149_SynthRegs[] when called by the synthesis thread.
  */
 #define BIT_SHIFT 24
-void Sound_WriteReg(int reg, uint8_t data)
+static void YM2149_WriteReg(uint8_t *pRegs, int reg, uint8_t data)
 {
 	switch (reg)
 	{
 		case 0:
-			SoundRegs[0] = data;
-			ToneA_per = YM2149_TonePer ( SoundRegs[1] , SoundRegs[0] );
+			pRegs[0] = data;
+			ToneA_per = YM2149_TonePer ( pRegs[1] , pRegs[0] );
 			break;
 		case 1:
-			SoundRegs[1] = data & 0x0f;
-			ToneA_per = YM2149_TonePer ( SoundRegs[1] , SoundRegs[0] );
+			pRegs[1] = data & 0x0f;
+			ToneA_per = YM2149_TonePer ( pRegs[1] , pRegs[0] );
 			break;
 		case 2:
-			SoundRegs[2] = data;
-			ToneB_per = YM2149_TonePer ( SoundRegs[3] , SoundRegs[2] );
+			pRegs[2] = data;
+			ToneB_per = YM2149_TonePer ( pRegs[3] , pRegs[2] );
 			break;
 		case 3:
-			SoundRegs[3] = data & 0x0f;
-			ToneB_per = YM2149_TonePer ( SoundRegs[3] , SoundRegs[2] );
+			pRegs[3] = data & 0x0f;
+			ToneB_per = YM2149_TonePer ( pRegs[3] , pRegs[2] );
 			break;
 		case 4:
-			SoundRegs[4] = data;
-			ToneC_per = YM2149_TonePer ( SoundRegs[5] , SoundRegs[4] );
+			pRegs[4] = data;
+			ToneC_per = YM2149_TonePer ( pRegs[5] , pRegs[4] );
 			break;
 		case 5:
-			SoundRegs[5] = data & 0x0f;
-			ToneC_per = YM2149_TonePer ( SoundRegs[5] , SoundRegs[4] );
+			pRegs[5] = data & 0x0f;
+			ToneC_per = YM2149_TonePer ( pRegs[5] , pRegs[4] );
 			break;
 		case 6:
-			SoundRegs[6] = data & 0x1f;
-			Noise_per = YM2149_NoisePer ( SoundRegs[6] );
+			pRegs[6] = data & 0x1f;
+			Noise_per = YM2149_NoisePer ( pRegs[6] );
 			break;
 
 		case 7:
-			SoundRegs[7] = data & 0x3f;			/* ignore bits 6 and 7 */
+			pRegs[7] = data & 0x3f;			/* ignore bits 6 and 7 */
 			mixerTA = (data&(1<<0)) ? 0xffff : 0;
 			mixerTB = (data&(1<<1)) ? 0xffff : 0;
 			mixerTC = (data&(1<<2)) ? 0xffff : 0;
@@ -1452,7 +1990,7 @@ void Sound_WriteReg(int reg, uint8_t data)
 			break;
 
 		case 8:
-			SoundRegs[8] = data & 0x1f;
+			pRegs[8] = data & 0x1f;
 			if ( data & 0x10 )
 			{
 				EnvMask3Voices |= YM_MASK_A;		/* env ON */
@@ -1462,12 +2000,12 @@ void Sound_WriteReg(int reg, uint8_t data)
 			{
 				EnvMask3Voices &= ~YM_MASK_A;		/* env OFF */
 				Vol3Voices &= ~YM_MASK_A;		/* clear previous vol */
-				Vol3Voices |= YmVolume4to5[ SoundRegs[8] ];	/* fixed vol ON */
+				Vol3Voices |= YmVolume4to5[ pRegs[8] ];	/* fixed vol ON */
 			}
 			break;
 
 		case 9:
-			SoundRegs[9] = data & 0x1f;
+			pRegs[9] = data & 0x1f;
 			if ( data & 0x10 )
 			{
 				EnvMask3Voices |= YM_MASK_B;		/* env ON */
@@ -1477,12 +2015,12 @@ void Sound_WriteReg(int reg, uint8_t data)
 			{
 				EnvMask3Voices &= ~YM_MASK_B;		/* env OFF */
 				Vol3Voices &= ~YM_MASK_B;		/* clear previous vol */
-				Vol3Voices |= ( YmVolume4to5[ SoundRegs[9] ] ) << 5;	/* fixed vol ON */
+				Vol3Voices |= ( YmVolume4to5[ pRegs[9] ] ) << 5;	/* fixed vol ON */
 			}
 			break;
 
 		case 10:
-			SoundRegs[10] = data & 0x1f;
+			pRegs[10] = data & 0x1f;
 			if ( data & 0x10 )
 			{
 				EnvMask3Voices |= YM_MASK_C;		/* env ON */
@@ -1492,32 +2030,55 @@ void Sound_WriteReg(int reg, uint8_t data)
 			{
 				EnvMask3Voices &= ~YM_MASK_C;		/* env OFF */
 				Vol3Voices &= ~YM_MASK_C;		/* clear previous vol */
-				Vol3Voices |= ( YmVolume4to5[ SoundRegs[10] ] ) << 10;	/* fixed vol ON */
+				Vol3Voices |= ( YmVolume4to5[ pRegs[10] ] ) << 10;	/* fixed vol ON */
 			}
 			break;
 
 		case 11:
-			SoundRegs[11] = data;
-			Env_per = YM2149_EnvPer ( SoundRegs[12] , SoundRegs[11] );
+			pRegs[11] = data;
+			Env_per = YM2149_EnvPer ( pRegs[12] , pRegs[11] );
 			break;
 
 		case 12:
-			SoundRegs[12] = data;
-			Env_per = YM2149_EnvPer ( SoundRegs[12] , SoundRegs[11] );
+			pRegs[12] = data;
+			Env_per = YM2149_EnvPer ( pRegs[12] , pRegs[11] );
 			break;
 
 		case 13:
-			SoundRegs[13] = data & 0xf;
+			pRegs[13] = data & 0xf;
 			Env_pos = 0;					/* when writing to Env_shape, we must reset the Env_pos */
 			Env_count = 0;					/* this also starts a new phase */
-			Env_shape = SoundRegs[13];
-			bEnvelopeFreqFlag = true;			/* used for YmFormat saving */
+			Env_shape = pRegs[13];
 			break;
 
 	}
 }
 
 
+/*-----------------------------------------------------------------------*/
+/**
+ * Write to an YM register. When the synthesis thread is used, the write
+ * is logged to be replayed by the thread and only SoundRegs[] is updated.
+ */
+void Sound_WriteReg(int reg, uint8_t data)
+{
+	static const uint8_t RegsMask[ 14 ] = { 0xff , 0x0f , 0xff , 0x0f , 0xff , 0x0f , 0x1f ,
+						0x3f , 0x1f , 0x1f , 0x1f , 0xff , 0xff , 0x0f };
+
+	if ( reg == 13 )
+		bEnvelopeFreqFlag = true;			/* used for YmFormat saving */
+
+	if ( !YM2149_Threaded )
+		YM2149_WriteReg ( SoundRegs , reg , data );
+
+	else if ( reg >= 0 && reg < 14 )
+	{
+		SoundRegs[ reg ] = data & RegsMask[ reg ];
+		YM2149_LogWrite ( 0 , reg , data );
+	}
+}
+
+
 
 /*-----------------------------------------------------------------------*/
 /**
@@ -1539,27 +2100,16 @@ void Sound_Init(void)
  */
 void Sound_Reset(void)
 {
-	/* Lock audio system before accessing variables which are used by the
-	 * callback function, too! */
-	Audio_Lock();
-
-	/* Clear sound mixing buffer: */
+	/* Clear sound mixing buffer (not read by the audio callback) */
 	memset(AudioMixBuffer, 0, sizeof(AudioMixBuffer));
 
-	/* Clear buffer index and register '13' flags */
+	/* Clear register '13' flags */
 	bEnvelopeFreqFlag = false;
 
-	AudioMixBuffer_pos_read = 0;
-	/* We do not start with 0 here to fake some initial samples: */
-	nGeneratedSamples = SoundBufferSize + SAMPLES_PER_FRAME;
-	AudioMixBuffer_pos_write = nGeneratedSamples & AUDIOMIXBUFFER_SIZE_MASK;
-	AudioMixBuffer_pos_write_avi = AudioMixBuffer_pos_write;
-//fprintf ( stderr , "Sound_Reset SoundBufferSize %d SAMPLES_PER_FRAME %d nGeneratedSamples %d , AudioMixBuffer_pos_write %d\n" ,
-//	SoundBufferSize , SAMPLES_PER_FRAME, nGeneratedSamples , AudioMixBuffer_pos_write );
+	/* Restart with the default latency */
+	Sound_ResetBufferIndex();
 
 	Ym2149_Reset();
-
-	Audio_Unlock();
 }
 
 
@@ -1571,13 +2121,141 @@ void Sound_Reset(void)
  */
 void Sound_ResetBufferIndex(void)
 {
-	Audio_Lock();
-	nGeneratedSamples = SoundBufferSize + SAMPLES_PER_FRAME;
-	AudioMixBuffer_pos_write =  (AudioMixBuffer_pos_read + nGeneratedSamples) & AUDIOMIXBUFFER_SIZE_MASK;
+	uint32_t	read , keep , written;
+	int		pos , n;
+
+	/* We do not start with 0 here to fake some initial samples */
+	keep = SoundBufferSize + SAMPLES_PER_FRAME;
+	read = AUDIOMIX_LOAD ( &AudioPlayBuffer_Read );
+	written = AudioPlayBuffer_Written;
+
+	if ( written - read < keep )
+	{
+		/* Add silence in the free slots of AudioPlayBuffer[] */
+		for ( ; written != read + keep ; written += n )
+		{
+			pos = written & AUDIOMIXBUFFER_SIZE_MASK;
+			n = AUDIOMIXBUFFER_SIZE - pos;
+			if ( n > (int)( read + keep - written ) )
+				n = read + keep - written;
+			memset ( AudioPlayBuffer[ pos ] , 0 , n * sizeof(AudioPlayBuffer[0]) );
+		}
+		AUDIOMIX_STORE ( &AudioPlayBuffer_Written , written );
+	}
+	else
+	{
+		/* The audio callback may be reading these samples : it will */
+		/* drop the oldest ones itself on its next call */
+		AUDIOMIX_STORE ( &AudioPlayBuffer_Keep , keep );
+	}
+
 	AudioMixBuffer_pos_write_avi = AudioMixBuffer_pos_write;
-//fprintf ( stderr , "Sound_ResetBufferIndex SoundBufferSize %d SAMPLES_PER_FRAME %d nGeneratedSamples %d , AudioMixBuffer_pos_write %d\n" ,
-//	SoundBufferSize , SAMPLES_PER_FRAME, nGeneratedSamples , AudioMixBuffer_pos_write );
-	Audio_Unlock();
+//fprintf ( stderr , "Sound_ResetBufferIndex SoundBufferSize %d SAMPLES_PER_FRAME %d AudioMixBuffer_pos_write %d\n" ,
+//	SoundBufferSize , SAMPLES_PER_FRAME, AudioMixBuffer_pos_write );
+}
+
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Return the number of samples in AudioPlayBuffer[] which were not played yet
+ * (called by the audio callback and the emulation)
+ */
+int Sound_GetBufferedSamples(void)
+{
+	int32_t	nb;
+
+	nb = AUDIOMIX_LOAD ( &AudioPlayBuffer_Written ) - AUDIOMIX_LOAD ( &AudioPlayBuffer_Read );
+	if ( nb < 0 )
+		return 0;
+	if ( nb > AUDIOMIXBUFFER_SIZE )
+		return AUDIOMIXBUFFER_SIZE;
+	return nb;
+}
+
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Copy the 'nb' samples of AudioMixBuffer[] from position 'pos' to the
+ * free slots of AudioPlayBuffer[] (called by the emulation, there's only
+ * one writer). Return the number of samples which didn't fit and were
+ * dropped.
+ */
+static int Sound_QueueSamples(int pos, int nb)
+{
+	uint32_t	written;
+	int		free , dropped = 0 , n;
+
+	written = AudioPlayBuffer_Written;
+	free = AUDIOMIXBUFFER_SIZE - ( written - AUDIOMIX_LOAD ( &AudioPlayBuffer_Read ) );
+	if ( nb > free )
+	{
+		dropped = nb - free;
+		nb = free;
+	}
+
+	/* At most 3 copies, when reaching the end of one of the ring buffers */
+	for ( ; nb > 0 ; nb -= n )
+	{
+		n = AUDIOMIXBUFFER_SIZE - ( written & AUDIOMIXBUFFER_SIZE_MASK );
+		if ( n > AUDIOMIXBUFFER_SIZE - pos )
+			n = AUDIOMIXBUFFER_SIZE - pos;
+		if ( n > nb )
+			n = nb;
+		memcpy ( AudioPlayBuffer[ written & AUDIOMIXBUFFER_SIZE_MASK ] , AudioMixBuffer[ pos ] ,
+			 n * sizeof(AudioPlayBuffer[0]) );
+		written += n;
+		pos = ( pos + n ) & AUDIOMIXBUFFER_SIZE_MASK;
+	}
+
+	AUDIOMIX_STORE ( &AudioPlayBuffer_Written , written );
+	return dropped;
+}
+
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Copy the next 'len' stereo samples of AudioPlayBuffer[] to 'pBuffer'
+ * (called by the audio callback, there's only one reader). If less samples
+ * are available, the end of 'pBuffer' is filled with silence.
+ * Return the number of samples copied from AudioPlayBuffer[].
+ */
+int Sound_ReadSamples(int16_t (*pBuffer)[2], int len)
+{
+	uint32_t	read , keep;
+	int		nb , pos , first;
+
+	read = AUDIOMIX_LOAD ( &AudioPlayBuffer_Read );
+	nb = Sound_GetBufferedSamples();
+
+	/* Drop the oldest samples if Sound_ResetBufferIndex() asked for it */
+	keep = AUDIOMIX_TAKE ( &AudioPlayBuffer_Keep );
+	if ( keep && (uint32_t)nb > keep )
+	{
+		read += nb - keep;
+		nb = keep;
+	}
+
+	if ( nb > len )
+		nb = len;
+
+	/* At most 2 copies, when reaching the end of the ring buffer */
+	pos = read & AUDIOMIXBUFFER_SIZE_MASK;
+	first = AUDIOMIXBUFFER_SIZE - pos;
+	if ( first > nb )
+		first = nb;
+	memcpy ( pBuffer , AudioPlayBuffer[ pos ] , first * sizeof(AudioPlayBuffer[0]) );
+	memcpy ( pBuffer + first , AudioPlayBuffer[ 0 ] , ( nb - first ) * sizeof(AudioPlayBuffer[0]) );
+
+	if ( nb < len )
+	{
+		/* Not enough samples : clear the rest of the buffer to ensure */
+		/* we don't play random bytes instead of missing samples */
+		memset ( pBuffer + nb , 0 , ( len - nb ) * sizeof(AudioPlayBuffer[0]) );
+		AUDIOMIX_STORE ( &Sound_Stats_Underruns , Sound_Stats_Underruns + 1 );
+	}
+
+	AUDIOMIX_STORE ( &AudioPlayBuffer_Read , read + nb );
+	return nb;
 }
 
 
@@ -1587,6 +2265,8 @@ void Sound_ResetBufferIndex(void)
  */
 void Sound_MemorySnapShot_Capture(bool bSave)
 {
+	YM2149_SynthSync();
+
 	/* Save/Restore details */
 	MemorySnapShot_Store(&ToneA_per, sizeof(ToneA_per));
 	MemorySnapShot_Store(&ToneA_count, sizeof(ToneA_count));
@@ -1632,6 +2312,10 @@ void Sound_MemorySnapShot_Capture(bool bSave)
 	MemorySnapShot_Store(&pos_fract_nearest, sizeof(pos_fract_nearest));
 	MemorySnapShot_Store(&pos_fract_weighted_2, sizeof(pos_fract_weighted_2));
 	MemorySnapShot_Store(&pos_fract_weighted_n, sizeof(pos_fract_weighted_n));
+	MemorySnapShot_Store(&pos_fract_sinc, sizeof(pos_fract_sinc));
+
+	if (!bSave)
+		memcpy(YM2149_SynthRegs, SoundRegs, sizeof(YM2149_SynthRegs));
 }
 
 
@@ -1654,6 +2338,8 @@ static void Sound_Stats_Add ( int Samples_Nbr )
  * final number of generated samples during 1 second. This value should
  * stay as close as possible over time to the chosen audio frequency (eg 44100 Hz).
  * If not, it means the accuracy should be improved when generating YM samples
+ * Also show how many times the audio callback didn't have enough samples
+ * (underruns) and the emulation wrote over samples not played yet (overruns).
  */
 void Sound_Stats_Show ( void )
 {
@@ -1683,8 +2369,10 @@ void Sound_Stats_Show ( void )
 	if ( ( freq_diff > 0 ) && ( freq_diff < 40 ) && ( freq_diff > diff_max ) )
 		diff_max = freq_diff;
 
-	fprintf ( stderr , "Sound_Stats_Show vbl_per_sec=%.4f freq_gen=%.4f freq_diff=%.4f (min=%.4f max=%.4f)\n" ,
-		  vbl_per_sec , freq_gen , freq_diff , diff_min , diff_max );
+	fprintf ( stderr , "Sound_Stats_Show vbl_per_sec=%.4f freq_gen=%.4f freq_diff=%.4f (min=%.4f max=%.4f)"
+		  " buffered=%d underruns=%u overruns=%u\n" ,
+		  vbl_per_sec , freq_gen , freq_diff , diff_min , diff_max ,
+		  Sound_GetBufferedSamples() , AUDIOMIX_LOAD ( &Sound_Stats_Underruns ) , Sound_Stats_Overruns );
 }
 
 
@@ -1696,29 +2384,22 @@ void Sound_Stats_Show ( void )
 static int Sound_GenerateSamples(uint64_t CPU_Clock)
 {
 	int	idx;
-	int	ym_margin;
 	int	Sample_Nbr;
 
 //fprintf ( stderr , "sound_gen in ym_pos_rd=%d ym_pos_wr=%d clock=%ld\n" , YM_Buffer_250_pos_read , YM_Buffer_250_pos_write , CPU_Clock );
 
 	/* Run YM2149 emulation at 250 kHz to reach CPU_Clock counter value */
 	/* This fills YM_Buffer_250[] and update YM_Buffer_250_pos_write */
-	YM2149_Run ( CPU_Clock );
-
-	ym_margin = ceil ( ((double)YM_ATARI_CLOCK_COUNTER) / nAudioFrequency ) + 2;
-//fprintf ( stderr , "sound_gen margin=%d read_max=%d\n" , ym_margin , ( YM_Buffer_250_pos_write - ym_margin ) & YM_BUFFER_250_SIZE_MASK );
+	/* (the samples are needed now : once the synthesis thread replayed */
+	/* the log if it's used, they are generated here) */
+	YM2149_SynthSync ();
+	YM2149_Run ( CPU_Clock , false );
 
-	Sample_Nbr = 0;
 	idx = AudioMixBuffer_pos_write & AUDIOMIXBUFFER_SIZE_MASK;
 
 	if (Config_IsMachineFalcon())
 	{
-		while ( ( ( YM_Buffer_250_pos_write - YM_Buffer_250_pos_read ) & YM_BUFFER_250_SIZE_MASK ) >= ym_margin )
-		{
-			AudioMixBuffer[idx][0] = AudioMixBuffer[idx][1] = Subsonic_IIR_HPF_Left( YM2149_NextSample_250() );
-			idx = ( idx+1 ) & AUDIOMIXBUFFER_SIZE_MASK;
-			Sample_Nbr++;
-		}
+		Sample_Nbr = YM2149_Resample ( idx , true );
 		/* If Falcon emulation, crossbar does the job */
 		if ( Sample_Nbr > 0 )
 			Crossbar_GenerateSamples(AudioMixBuffer_pos_write, Sample_Nbr);
@@ -1726,12 +2407,7 @@ static int Sound_GenerateSamples(uint64_t CPU_Clock)
 
 	else if (!Config_IsMachineST())
 	{
-		while ( ( ( YM_Buffer_250_pos_write - YM_Buffer_250_pos_read ) & YM_BUFFER_250_SIZE_MASK ) >= ym_margin )
-		{
-			AudioMixBuffer[idx][0] = AudioMixBuffer[idx][1] = YM2149_NextSample_250();
-			idx = ( idx+1 ) & AUDIOMIXBUFFER_SIZE_MASK;
-			Sample_Nbr++;
-		}
+		Sample_Nbr = YM2149_Resample ( idx , false );
 		/* If Ste or TT emulation, DmaSnd does mixing and filtering */
 		if ( Sample_Nbr > 0 )
 			DmaSnd_GenerateSamples(AudioMixBuffer_pos_write, Sample_Nbr);
@@ -1739,16 +2415,10 @@ static int Sound_GenerateSamples(uint64_t CPU_Clock)
 
 	else
 	{
-		while ( ( ( YM_Buffer_250_pos_write - YM_Buffer_250_pos_read ) & YM_BUFFER_250_SIZE_MASK ) >= ym_margin )
-		{
-			AudioMixBuffer[idx][0] = AudioMixBuffer[idx][1] = Subsonic_IIR_HPF_Left( YM2149_NextSample_250() );
-			idx = ( idx+1 ) & AUDIOMIXBUFFER_SIZE_MASK;
-			Sample_Nbr++;
-		}
+		Sample_Nbr = YM2149_Resample ( idx , true );
 	}
 
 	AudioMixBuffer_pos_write = (AudioMixBuffer_pos_write + Sample_Nbr) & AUDIOMIXBUFFER_SIZE_MASK;
-	nGeneratedSamples += Sample_Nbr;
 //fprintf ( stderr , "sound_gen out nb=%d ym_pos_rd=%d ym_pos_wr=%d clock=%ld\n" , Sample_Nbr , YM_Buffer_250_pos_read , YM_Buffer_250_pos_write , CPU_Clock );
 	return Sample_Nbr;
 }
@@ -1763,14 +2433,12 @@ void Sound_Update(uint64_t CPU_Clock)
 {
 	int pos_write_prev = AudioMixBuffer_pos_write;
 	int Samples_Nbr;
-	int nGeneratedSamples_before;
+	int Samples_Dropped;
 
-	/* Make sure that we don't interfere with the audio callback function */
-	Audio_Lock();
-
-	/* Generate samples */
-	nGeneratedSamples_before = nGeneratedSamples;
+	/* Generate samples, they're played by the audio callback once */
+	/* they're copied to AudioPlayBuffer[] (no lock is needed) */
 	Samples_Nbr = Sound_GenerateSamples ( CPU_Clock );
+	Samples_Dropped = Sound_QueueSamples ( pos_write_prev , Samples_Nbr );
 	Sound_Stats_SamplePerVBL += Samples_Nbr;
 //fprintf ( stderr , "sound update vbl=%d hbl=%d nbr=%d\n" , nVBLs , nHBL, Samples_Nbr );
 
@@ -1778,14 +2446,15 @@ void Sound_Update(uint64_t CPU_Clock)
 	/* This should never happen, except if the system suffers major slowdown due to	other	*/
 	/* processes or if we run in fast forward mode.						*/
 	/* In the case of slowdown, we set Sound_BufferIndexNeedReset to "resync" the working	*/
-	/* buffer's index AudioMixBuffer_pos_write with the system buffer's index		*/
-	/* AudioMixBuffer_pos_read.								*/
+	/* buffer AudioPlayBuffer with the system buffer's index AudioPlayBuffer_Read.	*/
+	/* In both cases, the samples which don't fit in AudioPlayBuffer are dropped.		*/
 	/* In the case of fast forward, we do nothing here, Sound_BufferIndexNeedReset will be	*/
 	/* set when the user exits fast forward mode.						*/
-	if ( ( Samples_Nbr > AUDIOMIXBUFFER_SIZE - nGeneratedSamples_before ) && ( ConfigureParams.System.bFastForward == false )
+	if ( ( Samples_Dropped > 0 ) && ( ConfigureParams.System.bFastForward == false )
 	    && ( ConfigureParams.Sound.bEnableSound == true ) )
 	{
 		static int logcnt = 0;
+		Sound_Stats_Overruns++;
 		if (logcnt++ < 50)
 		{
 			Log_Printf(LOG_WARN, "Your system is too slow, "
@@ -1794,8 +2463,9 @@ void Sound_Update(uint64_t CPU_Clock)
 		Sound_BufferIndexNeedReset = true;
 	}
 
-	/* Allow audio callback function to occur again */
-	Audio_Unlock();
+	/* Tell the audio backend that new samples are available */
+	if ( Samples_Nbr > 0 )
+		Audio_NewSamples();
 
 	/* Save to WAV file, if open */
 	if (bRecordingWav)
@@ -1803,6 +2473,24 @@ void Sound_Update(uint64_t CPU_Clock)
 }
 
 
+/*-----------------------------------------------------------------------*/
+/**
+ * Bring the YM2149 emulation up to this clock cycle, before a write to
+ * an YM register.
+ * When the synthesis thread is used and the YM2149 is the only sound
+ * source to update (no DMA sound playing, no Falcon crossbar), the
+ * output samples are only generated on the next call to Sound_Update(),
+ * so the emulation doesn't have to wait for the thread.
+ */
+void Sound_UpdateYM(uint64_t CPU_Clock)
+{
+	if ( YM2149_Threaded && !Config_IsMachineFalcon() && !DmaSnd_IsPlaying() )
+		YM2149_Run ( CPU_Clock , true );
+	else
+		Sound_Update ( CPU_Clock );
+}
+
+
 /*-----------------------------------------------------------------------*/
 /**
  * On the end of each VBL, complete audio buffer up to the current value of CyclesGlobalClockCounter
@@ -1907,6 +2595,8 @@ bool Sound_AreWeRecording(void)
  */
 void Sound_SetYmVolumeMixing(void)
 {
+	YM2149_SynthSync();
+
 	/* Build the volume conversion table */
 	Ym2149_BuildVolumeTable();
 }
@@ -1917,6 +2607,9 @@ void Sound_SetYmVolumeMixing(void)
  */
 void Sound_SetOutputAudioFreq(int nNewFrequency)
 {
+	/* The synthesis thread uses YM2149_LPF_Filter */
+	YM2149_SynthSync();
+
 	/* Do not reset sound system if nothing has changed! */
 	if (nNewFrequency != nAudioFrequency)
 	{
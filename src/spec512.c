@@ -17,6 +17,13 @@
   palette with each change. As the table is already ordered this makes things
   very simple. Speed is a problem, though, as the palette can change once every
   4 pixels - that's a lot of processing.
+
+  So when the frame is converted, the table is first compacted : the palette
+  of each displayed line at its first pixel is computed, with the list of the
+  changes done within the displayed pixels. The conversion then only needs to
+  plot spans of pixels between these changes, and the lines whose palettes and
+  pixels didn't change since the previous frame don't need to be converted
+  again (most Spectrum 512 pictures are static).
 */
 
 
@@ -92,16 +99,39 @@ typedef struct
 }
 CYCLEPALETTE;
 
-/* 314k; 1024-bytes per line */
-static CYCLEPALETTE CyclePalettes[(MAX_SCANLINES_PER_FRAME+1)*MAX_CYCLEPALETTES_PERLINE];
-static CYCLEPALETTE *pCyclePalette;
-static int nCyclePalettes[(MAX_SCANLINES_PER_FRAME+1)];  /* Number of entries in above table for each scanline */
+/* 314k; 1024-bytes per line. Two sets, for the current frame and for the
+ * last frame kept in headless mode (see Spec512_SwapFrame) */
+static CYCLEPALETTE CyclePaletteSets[2][(MAX_SCANLINES_PER_FRAME+1)*MAX_CYCLEPALETTES_PERLINE];
+static CYCLEPALETTE *CyclePalettes = CyclePaletteSets[0];
+static int nCyclePaletteSets[2][(MAX_SCANLINES_PER_FRAME+1)];
+static int *nCyclePalettes = nCyclePaletteSets[0];  /* Number of entries in above table for each scanline */
+static bool bIsSpec512DisplaySaved;
 static int nPalettesAccesses;   /* Number of times accessed palette registers */
 static uint16_t CycleColour;
 static int CycleColourIndex;
-static int nScanLine, ScanLineCycleCount;
 static bool bIsSpec512Display;
 
+/* Palettes of the displayed lines, compacted from the table above. Two sets,
+ * for the frame being converted and for the previous one */
+typedef struct
+{
+	uint32_t Palette[16];       /* 'STRGBPalette' at the first displayed pixel */
+	SPEC512CHANGE *pChanges;    /* Changes within the displayed pixels */
+	int nChanges;
+	bool bMedium;               /* Line converted in medium res */
+}
+SPEC512LINE;
+
+static SPEC512LINE Spec512LineSets[2][NUM_VISIBLE_LINES];
+static SPEC512CHANGE Spec512ChangeSets[2][NUM_VISIBLE_LINES*MAX_CYCLEPALETTES_PERLINE];
+static SPEC512LINE *Spec512Lines = Spec512LineSets[0];
+static SPEC512LINE *Spec512PrevLines = Spec512LineSets[1];
+static int nSpec512Lines, nSpec512PrevLines;
+static SPEC512LINE *pSpec512Line;       /* Next line to convert */
+static SPEC512LINE *pCurLine;           /* Line being converted */
+static const SPEC512CHANGE *pLineChange;
+static int nLineChanges, nLineSpan;
+
 #if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
 static const int STRGBPalEndianTable[16] =
 {
@@ -133,7 +163,7 @@ bool Spec512_IsImage(void)
 void Spec512_StartVBL(void)
 {
 	/* Clear number of cycle palettes on each frame */
-	memset(nCyclePalettes, 0x0, sizeof(nCyclePalettes));
+	memset(nCyclePalettes, 0x0, sizeof(nCyclePaletteSets[0]));
 
 	/* Clear number of times accessed on entry in palette (used to check if
 	 * it is true Spectrum 512 image) */
@@ -144,6 +174,33 @@ void Spec512_StartVBL(void)
 }
 
 
+/*-----------------------------------------------------------------------*/
+/**
+ * Swap the palette writes of the current frame with the saved ones.
+ * Used in headless mode to keep the writes of the last frame until
+ * it is converted (or the next one is saved).
+ */
+void Spec512_SwapFrame(void)
+{
+	bool bTmp;
+
+	if (CyclePalettes == CyclePaletteSets[0])
+	{
+		CyclePalettes = CyclePaletteSets[1];
+		nCyclePalettes = nCyclePaletteSets[1];
+	}
+	else
+	{
+		CyclePalettes = CyclePaletteSets[0];
+		nCyclePalettes = nCyclePaletteSets[0];
+	}
+
+	bTmp = bIsSpec512Display;
+	bIsSpec512Display = bIsSpec512DisplaySaved;
+	bIsSpec512DisplaySaved = bTmp;
+}
+
+
 /*-----------------------------------------------------------------------*/
 /**
  * Store color into table 'CyclePalettes[]' for screen conversion according
@@ -228,103 +285,195 @@ void Spec512_StoreCyclePalette(uint16_t col, uint32_t addr)
 
 /*-----------------------------------------------------------------------*/
 /**
- * Begin palette calculation for Spectrum 512 style images,
+ * Replay the palette writes of 'ScanLine' over 'nSpans' 4 cycles periods,
+ * updating 'Palette'. The writes done from the 'FirstSpan' period are
+ * stored in 'pLine' (if not NULL), with the palette before them.
+ * As when the writes were read period by period, a write which is not
+ * at a 4 cycles position after the previous one is never reached, so it
+ * stops the replay of the line.
  */
-void Spec512_StartFrame(void)
+static SPEC512CHANGE *Spec512_CompactLine(int ScanLine, uint32_t *Palette,
+                                          SPEC512LINE *pLine, SPEC512CHANGE *pChange,
+                                          int FirstSpan, int nSpans)
 {
-	int i;
+	CYCLEPALETTE *pCycle = &CyclePalettes[ScanLine*MAX_CYCLEPALETTES_PERLINE];
+	int n = nCyclePalettes[ScanLine];
+	int Span = 0, Index;
 
-	/* Set so screen gets full-update when returns from Spectrum 512 display */
-	ConvST_SetFullUpdate();
+	if (pLine)
+	{
+		pLine->pChanges = pChange;
+		pLine->nChanges = 0;
+	}
 
-	/* Set terminators on each line, so when scan during conversion we know when to stop */
-	for (i = 0; i < (nScanlinesPerFrame+1); i++)
+	for ( ; n > 0; n--, pCycle++)
 	{
-		pCyclePalette = &CyclePalettes[ (i*MAX_CYCLEPALETTES_PERLINE) + nCyclePalettes[i] ];
-		pCyclePalette->LineCycles = -1;          /* Term */
+		if ((pCycle->LineCycles & 3) || pCycle->LineCycles < Span*4
+		    || pCycle->LineCycles >= nSpans*4)
+			break;
+		Span = pCycle->LineCycles / 4;
+
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+		Index = STRGBPalEndianTable[pCycle->Index];
+#else
+		Index = pCycle->Index;
+#endif
+		if (pLine && Span >= FirstSpan)
+		{
+			if (pLine->nChanges == 0)
+				memcpy(pLine->Palette, Palette, sizeof(pLine->Palette));
+			pChange->Colour = pCycle->Colour;
+			pChange->Span = Span - FirstSpan;
+			pChange->Index = Index;
+			pChange++;
+			pLine->nChanges++;
+		}
+		Palette[Index] = ST2RGB[pCycle->Colour];
+		Span++;
 	}
 
-	/* Copy first line palette, kept in 'HBLPalettes' and store to 'STRGBPalette' */
+	if (pLine && pLine->nChanges == 0)
+		memcpy(pLine->Palette, Palette, sizeof(pLine->Palette));
+
+	return pChange;
+}
+
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Begin palette calculation for Spectrum 512 style images : compact the
+ * palette writes of the 'nLines' displayed lines, which have 'nLineSpans'
+ * 4 cycles periods of pixels.
+ */
+void Spec512_StartFrame(int nLines, int nLineSpans)
+{
+	uint32_t Palette[16];
+	SPEC512LINE *pTmpLines;
+	SPEC512CHANGE *pChange;
+	int i, ScanLine, LineStartCycle, FirstSpan, nWholeSpans, nSpans;
+
+	/* Set so screen gets full-update when returns from Spectrum 512 display */
+	ConvST_SetFullUpdate();
+
+	/* Keep the lines of the previous frame, to compare them with the new ones */
+	pTmpLines = Spec512PrevLines;
+	Spec512PrevLines = Spec512Lines;
+	Spec512Lines = pTmpLines;
+	nSpec512PrevLines = nSpec512Lines;
+	nSpec512Lines = nLines < NUM_VISIBLE_LINES ? nLines : NUM_VISIBLE_LINES;
+	pChange = Spec512ChangeSets[Spec512Lines == Spec512LineSets[0] ? 0 : 1];
+
+	/* First line palette is kept in 'HBLPalettes' */
 	for (i = 0; i < 16; i++)
 	{
 #if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
-		STRGBPalette[STRGBPalEndianTable[i]] = ST2RGB[pHBLPalettes[i]];
+		Palette[STRGBPalEndianTable[i]] = ST2RGB[pHBLPalettes[i]];
 #else
-		STRGBPalette[i] = ST2RGB[pHBLPalettes[i]];
+		Palette[i] = ST2RGB[pHBLPalettes[i]];
 #endif
 	}
 
-	/* Ready for first call to 'Spec512_ScanLine' */
-	nScanLine = 0;
+	if ( nScanlinesPerFrame == SCANLINES_PER_FRAME_50HZ )
+		LineStartCycle = LINE_START_CYCLE_50;			/* The screen was 50 Hz */
+	else
+		LineStartCycle = LINE_START_CYCLE_60;			/* The screen was 60 Hz */
+
+	/* Periods until the first displayed pixel ([NP] '7' is required to align
+	 * pixels and colors), including the skipped left border if not using
+	 * overscan display to user (eg, 16 bytes = 32 pixels or 8 palette periods) */
+	FirstSpan = (LineStartCycle-SCREENBYTES_LEFT*2)/4 + 7 + STScreenLeftSkipBytes/2;
+
+	/* Whole lines are read up to the end of the line */
+	nWholeSpans = ((nCyclesPerLine >> nCpuFreqShift) + 3) / 4;
+	nSpans = FirstSpan + nLineSpans;
+	if (nSpans < nWholeSpans)
+		nSpans = nWholeSpans;
+
+	ScanLine = 0;
 	if (VerticalOverscan & V_OVERSCAN_NO_TOP)
-		nScanLine += OVERSCAN_TOP;
+		ScanLine += OVERSCAN_TOP;
+
+	/* Lines before the first displayed one only update the palette */
+	for (i = 0; i < (STScreenStartHorizLine+(nStartHBL-OVERSCAN_TOP)) && ScanLine <= MAX_SCANLINES_PER_FRAME; i++)
+		Spec512_CompactLine(ScanLine++, Palette, NULL, NULL, 0, nWholeSpans);
+
+	for (i = 0; i < nSpec512Lines; i++)
+	{
+		if (ScanLine <= MAX_SCANLINES_PER_FRAME)
+		{
+			pChange = Spec512_CompactLine(ScanLine++, Palette, &Spec512Lines[i],
+			                              pChange, FirstSpan, nSpans);
+		}
+		else
+		{
+			memcpy(Spec512Lines[i].Palette, Palette, sizeof(Palette));
+			Spec512Lines[i].nChanges = 0;
+		}
+	}
 
-	/* Skip to first line(where start to draw screen from) */
-	for (i = 0; i < (STScreenStartHorizLine+(nStartHBL-OVERSCAN_TOP)); i++)
-		Spec512_ScanWholeLine();
+	/* Ready for first call to 'Spec512_StartScanLine' */
+	pSpec512Line = Spec512Lines;
 }
 
 
 /*-----------------------------------------------------------------------*/
 /**
- * Scan whole line and build up palette - need to do this so when get to screen line we have
- * the correct 16 colours set
+ * Set 'STRGBPalette' to the palette at the first displayed pixel of the
+ * next line (converted in medium res if 'bMedium'), ready for
+ * 'Spec512_UpdatePaletteSpan' or 'Spec512_GetLineChanges'
  */
-void Spec512_ScanWholeLine(void)
+void Spec512_StartScanLine(bool bMedium)
 {
-	/* Store pointer to line of palette cycle writes */
-	pCyclePalette = &CyclePalettes[nScanLine*MAX_CYCLEPALETTES_PERLINE];
-	/* Ready for next scan line */
-	nScanLine++;
-
-	/* Update palette entries until we reach start of displayed screen */
-	ScanLineCycleCount = 0;
-	Spec512_EndScanLine();        /* Read whole line of palettes and update 'STRGBPalette' */
+	/* Lines after the compacted ones keep the last palette */
+	if (pSpec512Line < Spec512Lines + nSpec512Lines)
+	{
+		pCurLine = pSpec512Line++;
+		pCurLine->bMedium = bMedium;
+		memcpy(STRGBPalette, pCurLine->Palette, sizeof(STRGBPalette));
+		pLineChange = pCurLine->pChanges;
+		nLineChanges = pCurLine->nChanges;
+	}
+	else
+	{
+		pCurLine = NULL;
+		nLineChanges = 0;
+	}
+	nLineSpan = 0;
 }
 
 
 /*-----------------------------------------------------------------------*/
 /**
- * Build up palette for this scan line and store in 'ScanLinePalettes'
+ * Return true if the line started by 'Spec512_StartScanLine' has different
+ * palettes than the same line in the previous frame.
  */
-void Spec512_StartScanLine(void)
+bool Spec512_LineChanged(void)
 {
-	int i;
-	int LineStartCycle;
-
-	/* Store pointer to line of palette cycle writes */
-	pCyclePalette = &CyclePalettes[nScanLine*MAX_CYCLEPALETTES_PERLINE];
-	/* Ready for next scan line */
-	nScanLine++;
-
-	if ( nScanlinesPerFrame == SCANLINES_PER_FRAME_50HZ )
-		LineStartCycle = LINE_START_CYCLE_50;			/* The screen was 50 Hz */
-	else
-		LineStartCycle = LINE_START_CYCLE_60;			/* The screen was 60 Hz */
+	const SPEC512LINE *pLine = pCurLine;
+	const SPEC512LINE *pPrevLine;
 
-	/* Update palette entries until we reach start of displayed screen */
-	ScanLineCycleCount = 0;
-	for (i=0; i<((LineStartCycle-SCREENBYTES_LEFT*2)/4 + 7); i++)	/* [NP] '7' is required to align pixels and colors */
-		Spec512_UpdatePaletteSpan();              /* Update palette for this 4-cycle period */
+	if (!pLine || pLine - Spec512Lines >= nSpec512PrevLines)
+		return true;
 
-	/* And skip for left border is not using overscan display to user */
-	for (i=0; i<(STScreenLeftSkipBytes/2); i++)   /* Eg, 16 bytes = 32 pixels or 8 palette periods */
-		Spec512_UpdatePaletteSpan();
+	pPrevLine = &Spec512PrevLines[pLine - Spec512Lines];
+	return pLine->bMedium != pPrevLine->bMedium
+	       || pLine->nChanges != pPrevLine->nChanges
+	       || memcmp(pLine->Palette, pPrevLine->Palette, sizeof(pLine->Palette))
+	       || memcmp(pLine->pChanges, pPrevLine->pChanges, pLine->nChanges * sizeof(SPEC512CHANGE));
 }
 
 
 /*-----------------------------------------------------------------------*/
 /**
- * Run to end of scan line looking up palettes so 'STRGBPalette' is up-to-date
+ * Return the palette changes of the line started by 'Spec512_StartScanLine'.
+ * A change with 'Span' n applies to the pixels after the n+1th call to
+ * 'Spec512_UpdatePaletteSpan', i.e. from pixel 4*n+1 in low res and from
+ * pixel 8*n+5 in medium res.
  */
-void Spec512_EndScanLine(void)
+int Spec512_GetLineChanges(const SPEC512CHANGE **ppChanges)
 {
-	int	CycleEnd = nCyclesPerLine;
-
-	CycleEnd >>= nCpuFreqShift;			/* Convert cycle position to 8 MHz equivalent */
-	/* Continue to reads palette until complete so have correct version for next line */
-	while (ScanLineCycleCount < CycleEnd)
-		Spec512_UpdatePaletteSpan();
+	*ppChanges = pLineChange;
+	return nLineChanges;
 }
 
 
@@ -334,16 +483,12 @@ void Spec512_EndScanLine(void)
  */
 void Spec512_UpdatePaletteSpan(void)
 {
-	if (pCyclePalette->LineCycles == ScanLineCycleCount)
+	if (nLineChanges && pLineChange->Span == nLineSpan)
 	{
 		/* Need to update palette with new entry */
-#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
-		STRGBPalette[STRGBPalEndianTable[pCyclePalette->Index]] = ST2RGB[pCyclePalette->Colour];
-#else
-		STRGBPalette[pCyclePalette->Index] = ST2RGB[pCyclePalette->Colour];
-//fprintf ( stderr , "upd spec cyc %d %x %x\n" , ScanLineCycleCount , pCyclePalette->Index , pCyclePalette->Colour );
-#endif
-		pCyclePalette += 1;
+		STRGBPalette[pLineChange->Index] = ST2RGB[pLineChange->Colour];
+		pLineChange++;
+		nLineChanges--;
 	}
-	ScanLineCycleCount += 4;      /* Next 4 cycles */
+	nLineSpan++;                  /* Next 4 cycles */
 }
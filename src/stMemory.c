@@ -117,6 +117,7 @@ bool STMemory_SafeClear(uint32_t addr, unsigned int len)
 	{
 		if (addr + len < 0x1000000)
 		{
+			Video_LineSourceInvalidate(addr, len);
 			memset(&STRam[addr], 0, len);
 		}
 		else
@@ -163,6 +164,7 @@ bool STMemory_SafeCopy(uint32_t addr, uint8_t *src, unsigned int len, const char
 	{
 		if (addr + len < 0x1000000)
 		{
+			Video_LineSourceInvalidate(addr, len);
 			memcpy(&STRam[addr], src, len);
 		}
 		else
@@ -648,6 +650,8 @@ void	STMemory_Write ( uint32_t addr , uint32_t val , int size )
 
 	/* We modify the memory, so we flush the instr/data caches if needed */
 	M68000_Flush_All_Caches ( addr , size );
+	if ( pBank->baseaddr == STRam )
+		Video_LineSourceInvalidate ( addr , size );
 	
 	if ( size == 4 )
 		do_put_mem_long ( p , val );
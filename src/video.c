@@ -443,6 +443,7 @@ const char Video_fileid[] = "Hatari video.c";
 #include "ioMem.h"
 #include "keymap.h"
 #include "m68000.h"
+#include "cpu/idleloop.h"
 #include "hatari-glue.h"
 #include "memorySnapShot.h"
 #include "mfp.h"
@@ -533,6 +534,10 @@ static bool bSteBorderFlag;			/* true when screen width has been switched to 336
 static int NewSteBorderFlag = -1;		/* New value for next line */
 static bool bTTColorsSync;			/* whether TT colors need conversion */
 static int VideoRasterDelayedInc;		/* Number of bytes to add at the end of the current video line */
+static int LineSourceBytes;			/* Bytes per line in pSTScreen for the lines left in ST RAM */
+
+uint8_t Video_LinePageGen[ VIDEO_LINE_PAGES ];	/* Video_LineGen if a line left in ST RAM uses the page */
+uint8_t Video_LineGen = 1;			/* Generation of the current frame, never 0 */
 
 int TTSpecialVideoMode;				/* TT special video mode */
 static int nPrevTTSpecialVideoMode;		/* TT special video mode */
@@ -3270,7 +3275,7 @@ if ( CycInt_From_Opcode )		/* TEMP : to update CYCLES_COUNTER_VIDEO during an op
 	Video_GetPosition ( &FrameCycles , &HblCounterVideo , &LineCycles );
 
 	/* How many cycle was this HBL delayed (>= 0) */
-	PendingCyclesOver = -INT_CONVERT_FROM_INTERNAL ( PendingInterruptCount , INT_CPU_CYCLE );
+	PendingCyclesOver = -INT_CONVERT_FROM_INTERNAL ( CycInt_DelayedCycles , INT_CPU_CYCLE );
  	PendingCyclesOver <<= nCpuFreqShift;
 
 	/* Remove this interrupt from list and re-order */
@@ -3613,7 +3618,7 @@ static void Video_StartHBL(void)
 void Video_InterruptHandler_EndLine(void)
 {
 	int FrameCycles, HblCounterVideo, LineCycles;
-	int PendingCycles = -INT_CONVERT_FROM_INTERNAL ( PendingInterruptCount , INT_CPU_CYCLE );
+	int PendingCycles = -INT_CONVERT_FROM_INTERNAL ( CycInt_DelayedCycles , INT_CPU_CYCLE );
 
 #ifdef OLD_GET_POS_FORCE_INC
 if ( CycInt_From_Opcode )		/* TEMP : to update CYCLES_COUNTER_VIDEO during an opcode */
@@ -3809,6 +3814,110 @@ static void*	video_memcpy_direct ( uint8_t *dest , uint8_t *src , int n )
 
 
 
+/*-----------------------------------------------------------------------*/
+/**
+ * When enabled, the lines without any effect don't need to be copied :
+ * keep where they are in ST RAM, so the screen conversion reads them
+ * from there at the end of the frame. If their RAM is written to before,
+ * they are copied at that time (see Video_LineSourceFlush()).
+ * Return true if the line at pVideoRaster doesn't need to be copied.
+ */
+static bool Video_SetLineSource(int LineBytes)
+{
+	uint32_t addr;
+	int line, size;
+
+	if ( !ConfigureParams.Screen.bDirectLines || video_memcpy != video_memcpy_direct
+	    || ( (uintptr_t)pVideoRaster & 3 ) )		/* conversion reads 32 bits at a time */
+		return false;
+
+	line = ( pSTScreen - pFrameBuffer->pSTScreen ) / LineBytes;
+	if ( line < 0 || line >= MAX_SOURCE_LINES )
+		return false;
+
+	pFrameBuffer->pLineSource[ line ] = pVideoRaster;
+	pFrameBuffer->nLineSources++;
+	LineSourceBytes = LineBytes;
+
+	/* Tag the pages of the line, so a later write during this frame */
+	/* copies the line first (see Video_LineSourceWrite()) */
+	addr = pVideoRaster - STRam;
+	size = ( LineBytes == SCREENBYTES_MONOLINE ) ? SCREENBYTES_MONOLINE : SCREENBYTES_MIDDLE;
+	Video_LinePageGen[ ( addr & 0xffffff ) >> VIDEO_LINE_PAGE_SHIFT ] = Video_LineGen;
+	Video_LinePageGen[ ( ( addr + size - 1 ) & 0xffffff ) >> VIDEO_LINE_PAGE_SHIFT ] = Video_LineGen;
+	memory_watch_writes ( addr );				/* no direct write to RAM (see memory.h) */
+	memory_watch_writes ( addr + size - 1 );
+	return true;
+}
+
+
+/*-----------------------------------------------------------------------*/
+/**
+ * ST RAM at 'addr' is about to be written to while some lines displayed
+ * during this frame are still read from its page : copy these lines to
+ * pSTScreen now, so the conversion shows them as they were displayed.
+ */
+void Video_LineSourceFlush ( uint32_t addr )
+{
+	uint32_t page = ( addr & 0xffffff ) >> VIDEO_LINE_PAGE_SHIFT;
+	uint32_t start;
+	uint8_t *src;
+	int line, size, offset;
+
+	Video_LinePageGen[ page ] = 0;
+
+	if ( LineSourceBytes == SCREENBYTES_MONOLINE )
+	{
+		size = SCREENBYTES_MONOLINE;
+		offset = 0;
+	}
+	else
+	{
+		size = SCREENBYTES_MIDDLE;
+		offset = SCREENBYTES_LEFT;
+	}
+
+	for ( line = 0 ; line < MAX_SOURCE_LINES && pFrameBuffer->nLineSources > 0 ; line++ )
+	{
+		src = pFrameBuffer->pLineSource[ line ];
+		if ( src == NULL )
+			continue;
+
+		start = src - STRam;
+		if ( ( ( start & 0xffffff ) >> VIDEO_LINE_PAGE_SHIFT ) != page
+		  && ( ( ( start + size - 1 ) & 0xffffff ) >> VIDEO_LINE_PAGE_SHIFT ) != page )
+			continue;
+
+		memcpy ( pFrameBuffer->pSTScreen + line * LineSourceBytes + offset , src , size );
+		pFrameBuffer->pLineSource[ line ] = NULL;
+		pFrameBuffer->nLineSources--;
+	}
+}
+
+
+/**
+ * Same as Video_LineSourceWrite() for the 'size' bytes at 'addr' (memory
+ * written by the host, for example by GEMDOS HD emulation)
+ */
+void Video_LineSourceInvalidate ( uint32_t addr , int size )
+{
+	uint32_t page, last;
+
+	if ( size <= 0 )
+		return;
+
+	page = ( addr & 0xffffff ) >> VIDEO_LINE_PAGE_SHIFT;
+	last = ( ( addr + size - 1 ) & 0xffffff ) >> VIDEO_LINE_PAGE_SHIFT;
+	for ( ; ; page = ( page + 1 ) & ( VIDEO_LINE_PAGES - 1 ) )
+	{
+		if ( Video_LinePageGen[ page ] == Video_LineGen )
+			Video_LineSourceFlush ( page << VIDEO_LINE_PAGE_SHIFT );
+		if ( page == last )
+			break;
+	}
+}
+
+
 /*-----------------------------------------------------------------------*/
 /**
  * Copy one line of monochrome screen into buffer for conversion later.
@@ -3820,7 +3929,8 @@ static void Video_CopyScreenLineMono(void)
 	uint32_t VideoMask = Video_GetAddrMask();
 
 	/* Copy one line - 80 bytes in ST high resolution */
-	video_memcpy ( pSTScreen, pVideoRaster, SCREENBYTES_MONOLINE );
+	if ( HWScrollCount || !Video_SetLineSource ( SCREENBYTES_MONOLINE ) )
+		video_memcpy ( pSTScreen, pVideoRaster, SCREENBYTES_MONOLINE );
 	pVideoRaster += SCREENBYTES_MONOLINE;
 
 	/* Handle STE fine scrolling (HWScrollCount is zero on ST). */
@@ -4077,8 +4187,11 @@ static void Video_CopyScreenLineColor(void)
 		}
 		else
 		{
-			/* normal middle part (160 bytes) */
-			video_memcpy ( pSTScreen+SCREENBYTES_LEFT, pVideoRaster, SCREENBYTES_MIDDLE );
+			/* normal middle part (160 bytes), no need to copy it if there's */
+			/* no border / scroll effect changing it for this line */
+			if ( LineBorderMask || bSteBorderFlag || HWScrollCount || STF_PixelScroll
+			    || !Video_SetLineSource ( SCREENBYTES_LINE ) )
+				video_memcpy ( pSTScreen+SCREENBYTES_LEFT, pVideoRaster, SCREENBYTES_MIDDLE );
 			pVideoRaster += SCREENBYTES_MIDDLE;
 		}
 
@@ -4660,6 +4773,18 @@ static void Video_ClearOnVBL(void)
 		Video_RestartVideoCounter();
 
 	pSTScreen = pFrameBuffer->pSTScreen;
+	if ( pFrameBuffer->nLineSources )
+	{
+		memset ( pFrameBuffer->pLineSource, 0, sizeof ( pFrameBuffer->pLineSource ) );
+		pFrameBuffer->nLineSources = 0;
+	}
+	/* New generation : pages tagged during the previous frame don't match anymore */
+	if ( ++Video_LineGen == 0 )
+	{
+		memset ( Video_LinePageGen, 0, sizeof ( Video_LinePageGen ) );
+		Video_LineGen = 1;
+	}
+	memory_unwatch_writes ();
 
 	Video_SetScreenRasters();
 	Video_InitShifterLines();
@@ -4797,12 +4922,16 @@ bool Video_RenderTTScreen(void)
 /*-----------------------------------------------------------------------*/
 /**
  * Draw screen (either with ST/STE shifter drawing functions or with
- * Videl drawing functions)
+ * Videl drawing functions).
+ * In headless mode, the frame is only saved and converted when needed
+ * (for screenshots), except while recording a video.
  */
 static void Video_DrawScreen(void)
 {
+	bool bHeadless = ConfigureParams.Screen.bHeadless && !Avi_AreWeRecording();
+
 	/* Skip frame if need to */
-	if (nVBLs % (nFrameSkips+1))
+	if (!bHeadless && nVBLs % (nFrameSkips+1))
 		return;
 
 	if (bUseVDIRes)
@@ -4825,7 +4954,10 @@ static void Video_DrawScreen(void)
 			memset(pSTScreen, 0, SCREENBYTES_LINE * ( nLastVisibleHbl - nHBL ) );
 	}
 
-	ConvST_Refresh(false);
+	if (bHeadless)
+		ConvST_SaveFrame();
+	else
+		ConvST_Refresh(false);
 }
 
 
@@ -4952,18 +5084,18 @@ void Video_StartInterrupts ( int PendingCyclesOver )
 void Video_InterruptHandler_VBL ( void )
 {
 	int PendingCyclesOver;
-	int PendingInterruptCount_save;
+	int DelayedCycles_save;
 	uint64_t VBL_ClockCounter_prev;
 
-	PendingInterruptCount_save = PendingInterruptCount;
+	DelayedCycles_save = CycInt_DelayedCycles;
 
-	/* In case we press a shortcut for reset, PendingInterruptCount will be changed to >0 and we will get */
+	/* In case we press a shortcut for reset, CycInt_DelayedCycles will be changed to >0 and we will get */
 	/* some warnings "bug nHBL=...". To avoid this we restore the value (<= 0) saved at the start of the VBL */
-	if ( PendingInterruptCount > 0 )
-		PendingInterruptCount = PendingInterruptCount_save;
+	if ( CycInt_DelayedCycles > 0 )
+		CycInt_DelayedCycles = DelayedCycles_save;
 
 	/* Store cycles we went over for this frame(this is our initial count) */
-	PendingCyclesOver = -INT_CONVERT_FROM_INTERNAL ( PendingInterruptCount , INT_CPU_CYCLE );    /* +ve */
+	PendingCyclesOver = -INT_CONVERT_FROM_INTERNAL ( CycInt_DelayedCycles , INT_CPU_CYCLE );    /* +ve */
 
 	/* Remove this interrupt from list and re-order */
 	/* NOTE [NP] : in case ShortCut_ActKey above was used to change some parameters that require */
@@ -4989,6 +5121,9 @@ void Video_InterruptHandler_VBL ( void )
 	/* Check printer status */
 	Printer_CheckIdleStatus();
 
+	/* Fast forward could have been changed during the last frame */
+	IdleLoop_UpdateEnabled();
+
 	/* Update counter for number of screen refreshes per second */
 	nVBLs++;
 	/* Set video registers for frame */
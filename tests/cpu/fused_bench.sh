@@ -0,0 +1,63 @@
+#!/bin/sh
+#
+# Compare the emulation speed (VBL/s) of a Hatari built with fused opcode
+# pair handlers (cmake -DCPU_FUSED_PAIRS=<file>, e.g. src/cpu/fused.68k)
+# against a normal build, for a given program, machine and CPU level.
+# Both builds should use the same ENABLE_LAZY_FLAGS setting.
+# Extra arguments are passed to Hatari as-is.
+
+if [ $# -lt 3 ] || [ "$1" = "-h" ] || [ "$1" = "--help" ]; then
+	echo "Usage: $0 <fused hatari> <unfused hatari> <program> [hatari options]"
+	echo
+	echo "Example: $0 fused/src/hatari build/src/hatari bench.prg --machine falcon --cpulevel 3"
+	exit 1;
+fi
+
+fused=$1
+unfused=$2
+shift 2
+if [ ! -x "$fused" ] || [ ! -x "$unfused" ]; then
+	echo "First two parameters must point to valid hatari executables."
+	exit 1;
+fi;
+
+prg=$1
+shift
+if [ ! -f "$prg" ]; then
+	echo "Third parameter must point to valid program."
+	exit 1;
+fi;
+
+testdir=$(mktemp -d)
+
+remove_temp() {
+  rm -rf "$testdir"
+}
+trap remove_temp EXIT
+
+export SDL_VIDEODRIVER=dummy
+export SDL_AUDIODRIVER=dummy
+
+run_bench() {
+	mode=$1
+	hatari=$2
+	shift 2
+	HOME="$testdir" $hatari --log-level warn --sound off --benchmark \
+		--tos none --compatible off --cpu-exact off --jit off \
+		--fast-forward-idle-skip off \
+		--run-vbls 500 "$@" "$prg" > "$testdir/$mode.txt" 2>&1
+	speed=$(sed -n 's/.*SPEED: \([0-9.]*\) VBL\/s.*/\1/p' "$testdir/$mode.txt" | tail -1)
+	if [ -z "$speed" ]; then
+		echo "Running the $mode hatari failed:"
+		cat "$testdir/$mode.txt"
+		exit 1
+	fi
+	echo "$mode: $speed VBL/s"
+}
+
+run_bench unfused "$unfused" "$@"
+slow=$speed
+run_bench fused "$fused" "$@"
+fast=$speed
+
+echo "$fast $slow" | awk '{ printf("Fused pairs speedup: %.2fx\n", $1 / $2) }'
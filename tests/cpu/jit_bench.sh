@@ -0,0 +1,58 @@
+#!/bin/sh
+#
+# Compare the emulation speed (VBL/s) of the JIT compiler against
+# the interpreter, for a given program, machine and CPU level.
+# Extra arguments are passed to Hatari as-is.
+
+if [ $# -lt 2 ] || [ "$1" = "-h" ] || [ "$1" = "--help" ]; then
+	echo "Usage: $0 <hatari> <program> [hatari options]"
+	echo
+	echo "Example: $0 ./hatari bench.prg --machine falcon --cpulevel 3 --run-vbls 1000"
+	exit 1;
+fi
+
+hatari=$1
+shift
+if [ ! -x "$hatari" ]; then
+	echo "First parameter must point to valid hatari executable."
+	exit 1;
+fi;
+
+prg=$1
+shift
+if [ ! -f "$prg" ]; then
+	echo "Second parameter must point to valid program."
+	exit 1;
+fi;
+
+testdir=$(mktemp -d)
+
+remove_temp() {
+  rm -rf "$testdir"
+}
+trap remove_temp EXIT
+
+export SDL_VIDEODRIVER=dummy
+export SDL_AUDIODRIVER=dummy
+
+run_bench() {
+	mode=$1
+	shift
+	HOME="$testdir" $hatari --log-level warn --sound off --benchmark \
+		--tos none --compatible off --cpu-exact off --run-vbls 500 \
+		"$@" "$prg" > "$testdir/$mode.txt" 2>&1
+	speed=$(sed -n 's/.*SPEED: \([0-9.]*\) VBL\/s.*/\1/p' "$testdir/$mode.txt" | tail -1)
+	if [ -z "$speed" ]; then
+		echo "Running hatari in $mode mode failed:"
+		cat "$testdir/$mode.txt"
+		exit 1
+	fi
+	echo "$mode: $speed VBL/s"
+}
+
+run_bench interpreter --jit off "$@"
+interp=$speed
+run_bench jit --jit on "$@"
+jit=$speed
+
+echo "$jit $interp" | awk '{ printf("JIT speedup: %.2fx\n", $1 / $2) }'
@@ -0,0 +1,67 @@
+#!/bin/sh
+#
+# Check that the generic cpu cores built with lazy condition codes give
+# the same results as the prefetch cores, which always compute the flags.
+
+if [ $# -lt 2 ] || [ "$1" = "-h" ] || [ "$1" = "--help" ]; then
+	echo "Usage: $0 <hatari> <testprg> ..."
+	exit 1;
+fi
+
+hatari=$1
+shift
+if [ ! -x "$hatari" ]; then
+	echo "First parameter must point to valid hatari executable."
+	exit 1;
+fi;
+
+testprg=$1
+shift
+if [ ! -f "$testprg" ]; then
+	echo "Second parameter must point to valid test PRG."
+	exit 1;
+fi;
+
+testdir=$(mktemp -d)
+
+remove_temp() {
+  rm -rf "$testdir"
+}
+trap remove_temp EXIT
+
+export HATARI_TEST=cpu
+export SDL_VIDEODRIVER=dummy
+export SDL_AUDIODRIVER=dummy
+
+for core in eager lazy; do
+	if [ "$core" = "eager" ]; then
+		opts="--compatible on"
+	else
+		opts="--compatible off --cpu-exact off"
+	fi
+	mkdir "$testdir/$core"
+	HOME="$testdir/$core" $hatari --log-level error --sound off \
+		--fast-forward on --tos none --run-vbls 500 $opts "$@" \
+		"$testprg" > "$testdir/out-$core.txt" 2>&1
+	exitstat=$?
+	if [ $exitstat -ne 0 ]; then
+		echo "Running hatari failed ($core flags). Status=${exitstat}."
+		cat "$testdir/out-$core.txt"
+		exit 1
+	fi
+done
+
+if grep -qi fail "$testdir/out-lazy.txt"; then
+	echo "Test FAILED with lazy flags:"
+	cat "$testdir/out-lazy.txt"
+	exit 1
+fi
+
+if ! diff -q "$testdir/out-eager.txt" "$testdir/out-lazy.txt" > /dev/null; then
+	echo "Test FAILED, results differ with lazy flags:"
+	diff -u "$testdir/out-eager.txt" "$testdir/out-lazy.txt"
+	exit 1
+fi
+
+echo "Test PASSED."
+exit 0
@@ -0,0 +1,74 @@
+#!/bin/sh
+#
+# Compare the time needed to boot a MMU using TOS / OS (for example
+# MiNT with memory protection) to its shell, with the real 68030 / 68040 /
+# 68060 ATC and with the bigger hashed host ATC, using the same (non cycle
+# exact) CPU core. The shell is considered ready when the given marker
+# text is output to the console (see "--conout"), for example the prompt.
+# Extra arguments are passed to Hatari as-is.
+
+if [ $# -lt 2 ] || [ "$1" = "-h" ] || [ "$1" = "--help" ]; then
+	echo "Usage: $0 <hatari> <marker> [hatari options]"
+	echo
+	echo "Example: $0 ./hatari 'login:' --machine tt --tos tos306.img --harddrive mint/"
+	exit 1;
+fi
+
+hatari=$1
+shift
+if [ ! -x "$hatari" ]; then
+	echo "First parameter must point to valid hatari executable."
+	exit 1;
+fi;
+
+marker=$1
+shift
+
+# Max seconds to wait for the marker
+timeout=${MMU_BENCH_TIMEOUT:-600}
+
+testdir=$(mktemp -d)
+
+remove_temp() {
+  rm -rf "$testdir"
+}
+trap remove_temp EXIT
+
+export SDL_VIDEODRIVER=dummy
+export SDL_AUDIODRIVER=dummy
+
+run_bench() {
+	mode=$1
+	shift
+	start=$(date +%s.%N)
+	HOME="$testdir" $hatari --log-level warn --sound off --benchmark \
+		--conout 2 --cpulevel 4 --mmu on --compatible off --cpu-exact off \
+		"$@" > "$testdir/$mode.txt" 2>&1 &
+	pid=$!
+	while ! grep -q -F -e "$marker" "$testdir/$mode.txt"; do
+		if ! kill -0 $pid 2>/dev/null; then
+			echo "Hatari exited before the marker with the $mode ATC:"
+			cat "$testdir/$mode.txt"
+			exit 1
+		fi
+		if [ $(($(date +%s) - ${start%.*})) -gt "$timeout" ]; then
+			kill $pid
+			echo "No marker after $timeout seconds with the $mode ATC:"
+			cat "$testdir/$mode.txt"
+			exit 1
+		fi
+		sleep 0.1
+	done
+	end=$(date +%s.%N)
+	kill $pid
+	wait $pid 2>/dev/null
+	secs=$(echo "$start $end" | awk '{ printf("%.2f", $2 - $1) }')
+	echo "$mode ATC: $secs s"
+}
+
+run_bench real --mmu-host-atc off "$@"
+real=$secs
+run_bench host --mmu-host-atc on "$@"
+host=$secs
+
+echo "$real $host" | awk '{ printf("Host ATC speedup: %.2fx\n", $1 / $2) }'
@@ -0,0 +1,57 @@
+#!/bin/sh
+#
+# Check that the 68000 core gives the same cycle counts with and
+# without the pre-decoded block cache.
+
+if [ $# -lt 1 ] || [ "$1" = "-h" ] || [ "$1" = "--help" ]; then
+	echo "Usage: $0 <hatari>"
+	exit 1;
+fi
+
+hatari=$1
+shift
+if [ ! -x "$hatari" ]; then
+	echo "First parameter must point to valid hatari executable."
+	exit 1;
+fi;
+
+basedir=$(dirname "$0")
+testdir=$(mktemp -d)
+
+remove_temp() {
+  rm -rf "$testdir"
+}
+trap remove_temp EXIT
+
+export HATARI_TEST=cycles
+export SDL_VIDEODRIVER=dummy
+export SDL_AUDIODRIVER=dummy
+
+for cache in off on; do
+	mkdir "$testdir/$cache"
+	cp "$basedir/cyccheck.prg" "$testdir/$cache"
+	HOME="$testdir" $hatari --log-level fatal --fast-forward on --sound off \
+		--run-vbls 1000 --tos none --compatible false --cpu-exact false \
+		--block-cache $cache "$@" "$testdir/$cache/cyccheck.prg" \
+		> "$testdir/log-$cache.txt" 2>&1
+	exitstat=$?
+	if [ $exitstat -ne 0 ]; then
+		echo "Test FAILED, Hatari returned error status ${exitstat} (block cache $cache)."
+		cat "$testdir/log-$cache.txt"
+		exit 1
+	fi
+	if [ ! -f "$testdir/$cache/RESULTS.TXT" ]; then
+		echo "Test FAILED, no results with block cache $cache."
+		cat "$testdir/log-$cache.txt"
+		exit 1
+	fi
+done
+
+if ! diff -q "$testdir/off/RESULTS.TXT" "$testdir/on/RESULTS.TXT"; then
+	echo "Test FAILED, cycles differ with the block cache:"
+	diff -u "$testdir/off/RESULTS.TXT" "$testdir/on/RESULTS.TXT"
+	exit 1
+fi
+
+echo "Test PASSED."
+exit 0
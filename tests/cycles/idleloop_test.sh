@@ -0,0 +1,73 @@
+#!/bin/sh
+#
+# Check that the 68000 cores give the same cycle counts with and
+# without the skipping of idle loops in fast forward mode, and that
+# cycles were really skipped (the STOP loops waiting for the VBL).
+
+if [ $# -lt 1 ] || [ "$1" = "-h" ] || [ "$1" = "--help" ]; then
+	echo "Usage: $0 <hatari>"
+	exit 1;
+fi
+
+hatari=$1
+shift
+if [ ! -x "$hatari" ]; then
+	echo "First parameter must point to valid hatari executable."
+	exit 1;
+fi;
+
+basedir=$(dirname "$0")
+testdir=$(mktemp -d)
+
+remove_temp() {
+  rm -rf "$testdir"
+}
+trap remove_temp EXIT
+
+export HATARI_TEST=cycles
+export SDL_VIDEODRIVER=dummy
+export SDL_AUDIODRIVER=dummy
+
+for skip in off on; do
+	mkdir "$testdir/$skip"
+	cp "$basedir/cyccheck.prg" "$testdir/$skip"
+	HOME="$testdir" $hatari --log-level info --fast-forward on --sound off \
+		--run-vbls 1000 --tos none --fast-forward-idle-skip $skip \
+		"$@" "$testdir/$skip/cyccheck.prg" \
+		> "$testdir/log-$skip.txt" 2>&1
+	exitstat=$?
+	if [ $exitstat -ne 0 ]; then
+		echo "Test FAILED, Hatari returned error status ${exitstat} (idle skip $skip)."
+		cat "$testdir/log-$skip.txt"
+		exit 1
+	fi
+	if [ ! -f "$testdir/$skip/RESULTS.TXT" ]; then
+		echo "Test FAILED, no results with idle skip $skip."
+		cat "$testdir/log-$skip.txt"
+		exit 1
+	fi
+	skipped=$(sed -n 's/.*Idle loops: \([0-9]*\) cycles skipped.*/\1/p' "$testdir/log-$skip.txt")
+	if [ -z "$skipped" ]; then
+		echo "Test FAILED, no skipped cycles count with idle skip $skip."
+		cat "$testdir/log-$skip.txt"
+		exit 1
+	fi
+	if [ "$skip" = "off" ] && [ "$skipped" -ne 0 ]; then
+		echo "Test FAILED, $skipped cycles skipped with idle skip off."
+		exit 1
+	fi
+	if [ "$skip" = "on" ] && [ "$skipped" -eq 0 ]; then
+		echo "Test FAILED, no cycles skipped with idle skip on."
+		exit 1
+	fi
+	echo "Idle skip $skip: $skipped cycles skipped."
+done
+
+if ! diff -q "$testdir/off/RESULTS.TXT" "$testdir/on/RESULTS.TXT"; then
+	echo "Test FAILED, cycles differ when skipping idle loops:"
+	diff -u "$testdir/off/RESULTS.TXT" "$testdir/on/RESULTS.TXT"
+	exit 1
+fi
+
+echo "Test PASSED."
+exit 0
@@ -0,0 +1,60 @@
+#!/bin/sh
+#
+# Check that the screen is the same with and without --direct-lines,
+# for a program which changes a line after it has been displayed.
+
+if [ $# -lt 2 ] || [ "$1" = "-h" ] || [ "$1" = "--help" ]; then
+	echo "Usage: $0 <hatari> <prg> ..."
+	exit 1
+fi
+
+hatari=$1
+shift
+if [ ! -x "$hatari" ]; then
+	echo "First parameter must point to valid hatari executable."
+	exit 1
+fi;
+
+prg=$1
+shift
+
+testdir=$(mktemp -d)
+
+remove_temp() {
+  rm -rf "$testdir"
+}
+trap remove_temp EXIT
+
+export HATARI_TEST=screen
+export SDL_VIDEODRIVER=dummy
+export SDL_AUDIODRIVER=dummy
+unset TERM
+
+for direct in off on; do
+	mkdir "$testdir/$direct"
+	HOME="$testdir" $hatari --log-level fatal --sound off -z 1 --max-width 416 \
+		--bios-intercept on --statusbar off --drive-led off --fast-forward on \
+		--run-vbls 500 --frameskips 0 --tos none \
+		--screenshot-dir "$testdir/$direct" --direct-lines $direct \
+		"$@" "$prg" > "$testdir/log-$direct.txt" 2>&1
+	exitstat=$?
+	if [ $exitstat -ne 0 ]; then
+		echo "Test FAILED, Hatari returned error status ${exitstat} (direct lines $direct)."
+		cat "$testdir/log-$direct.txt"
+		exit 1
+	fi
+	# shellcheck disable=SC2144 # there's only one match
+	if [ ! -e "$testdir/$direct"/grab0001.* ]; then
+		echo "Test FAILED: Screenshot has not been taken (direct lines $direct)."
+		cat "$testdir/log-$direct.txt"
+		exit 1
+	fi
+done
+
+if ! cmp -s "$testdir"/off/grab0001.* "$testdir"/on/grab0001.*; then
+	echo "Test FAILED, screenshot differs with direct lines!"
+	exit 1
+fi
+
+echo "Test PASSED."
+exit 0
@@ -0,0 +1,60 @@
+; Change a screen line after it has been displayed
+; (assemble with TurboAss)
+;
+; The screen is filled with color 15. Each frame, once the video counter
+; is past line 150, line 50 is cleared, and it is restored at line 10 of
+; the next frame, before it is displayed again. So line 50 must never show
+; up cleared on the screen, even when the emulator doesn't copy the lines
+; while they are displayed (--direct-lines). After 50 frames, a
+; screenshot is taken for the comparison.
+
+screen          EQU $080000
+line            EQU 50
+
+
+                clr.l   -(SP)
+                move.w  #$20,-(SP)
+                trap    #1              ; Super
+                addq.l  #6,SP
+
+                move.w  #$2700,SR
+
+                move.b  #screen>>16,$FFFF8201.w
+                clr.b   $FFFF8203.w
+                clr.w   $FFFF8240.w
+                move.w  #$0777,$FFFF825E.w
+
+                moveq   #50-1,D2        ; frames before the screenshot
+                moveq   #-1,D1
+                lea     screen,A0
+                move.w  #32000/4-1,D0
+fill:           move.l  D1,(A0)+
+                dbra    D0,fill
+
+frame:          lea     screen+line*160,A0
+wait_disp:      cmpi.b  #$5E,$FFFF8207.w ; video counter past line 150?
+                bcs.s   wait_disp
+
+                moveq   #160/4-1,D0
+clear:          clr.l   (A0)+
+                dbra    D0,clear
+
+wait_vbl:       cmpi.b  #$10,$FFFF8207.w ; next frame started?
+                bcc.s   wait_vbl
+wait_top:       cmpi.b  #$06,$FFFF8207.w ; and past line 10 (so after the
+                bcs.s   wait_top        ; end of the previous frame)
+
+                lea     -160(A0),A0
+                moveq   #160/4-1,D0
+restore:        move.l  D1,(A0)+
+                dbra    D0,restore
+                dbra    D2,frame
+
+                move.w  #20,-(SP)
+                trap    #14             ; Scrdmp
+                addq.l  #2,SP
+
+                clr.w   -(SP)
+                trap    #1              ; Pterm0
+
+                END
@@ -0,0 +1,22 @@
+; Start the MFP timers A-D and loop forever, used to record the Falcon
+; event trace replayed by test-cycint (see test-cycint.c)
+; (assemble with TurboAss)
+
+                clr.l   -(SP)
+                move.w  #$20,-(SP)
+                trap    #1              ; Super
+                addq.l  #6,SP
+
+                move.w  #$2700,SR
+
+                move.b  #123,$FFFFFA1F.w ; timer A data
+                move.b  #1,$FFFFFA19.w  ; timer A delay mode, prescale 4
+                move.b  #200,$FFFFFA21.w ; timer B data
+                move.b  #3,$FFFFFA1B.w  ; timer B delay mode, prescale 16
+                move.b  #192,$FFFFFA23.w ; timer C data
+                move.b  #2,$FFFFFA25.w  ; timer D data
+                move.b  #$51,$FFFFFA1D.w ; timer C prescale 64, D prescale 4
+
+loop:           bra.s   loop
+
+                END
@@ -0,0 +1,84 @@
+/*
+ * Helpers shared by the tests of the SIMD kernels
+ * (test-conv_simd.c, test-conv_gen.c, test-resample.c, test-lmc1992.c)
+ *
+ * The kernels of a module are selected with its <Module>_Init(level)
+ * function, which returns the selected level (SIMD_NONE if the host cpu
+ * doesn't support the level).
+ */
+
+#ifndef SIMD_TEST_H
+#define SIMD_TEST_H
+
+#include "simd.h"
+
+static uint32_t	SimdTest_Seed = 1;
+
+/* Same random data on each run and each host */
+static inline uint32_t SimdTest_Random(void)
+{
+	SimdTest_Seed = SimdTest_Seed * 1103515245 + 12345;
+	return SimdTest_Seed >> 8 ^ SimdTest_Seed << 16;
+}
+
+static inline void SimdTest_RandomSamples(int16_t *samples, int count)
+{
+	while (count-- > 0)
+		*samples++ = SimdTest_Random();
+}
+
+/*
+ * Return the first level from 'level' (up to SIMD_BEST, which ends the
+ * loop) which is selected by 'init'. The levels which are not supported
+ * by the host cpu are reported once.
+ */
+static inline int SimdTest_NextLevel(int level, int (*init)(int))
+{
+	static int reported;
+
+	for ( ; level < SIMD_BEST; level++)
+	{
+		if (init(level) == level)
+			break;
+		if (!(reported & SIMD_LEVEL(level)))
+			printf("%s: not available on this host\n", Simd_Name(level));
+		reported |= SIMD_LEVEL(level);
+	}
+	return level;
+}
+
+/* Loop over the levels from 'first' supported by the host cpu,
+ * 'init' selecting the kernels of each level
+ */
+#define SIMDTEST_FOR_EACH_LEVEL(level, first, init) \
+	for (level = SimdTest_NextLevel(first, init); level < SIMD_BEST; \
+	     level = SimdTest_NextLevel(level + 1, init))
+
+/* Seconds elapsed since 'start' */
+static inline double SimdTest_Seconds(clock_t start)
+{
+	return (double)(clock() - start) / CLOCKS_PER_SEC;
+}
+
+/* Show the speed of a benchmark, in millions of 'done' items per second */
+static inline void SimdTest_ShowSpeed(int level, const char *name, int done, clock_t start)
+{
+	double secs = SimdTest_Seconds(start);
+
+	printf("  %-6s %-26s %7.2f M samples/s\n", Simd_Name(level), name,
+	       secs > 0 ? done / secs / 1e6 : 0);
+}
+
+/* Show the result, return the exit code of the test */
+static inline int SimdTest_Result(int errors)
+{
+	if (errors)
+	{
+		fprintf(stderr, "\n*** %d errors ***\n", errors);
+		return 1;
+	}
+	printf("\nSUCCESS\n");
+	return 0;
+}
+
+#endif /* SIMD_TEST_H */
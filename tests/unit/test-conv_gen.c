@@ -0,0 +1,304 @@
+/*
+ * Test and micro benchmark for the dirty lines handling of the generic
+ * screen conversion (conv_gen.c) used for TT / Falcon / VDI screens
+ *
+ * Random lines of TT / Falcon screens are changed between frames : each
+ * frame converted incrementally (only the lines which changed) must be the
+ * same as the whole screen converted again, and the host screen lines
+ * which changed must be in the range given by ConvGen_GetDirtyLines().
+ * Big screens are also converted by bands (run in reverse order here),
+ * the result must be the same as the conversion in one go.
+ *
+ * Usage: test-conv_gen [number of frames]
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "main.h"
+#include "configuration.h"
+#include "conv_gen.h"
+#include "conv_simd.h"
+#include "simd_test.h"
+#include "conv_st.h"
+#include "gui_event.h"
+#include "log.h"
+#include "memorySnapShot.h"
+#include "screen.h"
+#include "statusbar.h"
+
+#define	DEFAULT_FRAMES	200
+#define	RAM_SIZE	(4 * 1024 * 1024)
+#define	VIDEO_BASE	0x10000
+#define	HOST_WIDTH	1280
+#define	HOST_HEIGHT	1024
+
+
+/* Fake emulator */
+CNF_PARAMS ConfigureParams;
+uint8_t *STRam;
+uint32_t STRamEnd = RAM_SIZE;
+uint8_t *IOmemory;
+int TTSpecialVideoMode;
+int nScreenZoomX = 1, nScreenZoomY = 1;
+uint32_t *ConvertPalette;
+int ConvertPaletteSize;
+bool bInFullScreen, bUseHighRes, bUseVDIRes;
+
+void Log_Printf(LOGTYPE nType, const char *psFormat, ...) { }
+void MemorySnapShot_Store(void *pData, int Size) { }
+void GuiEvent_WarpMouse(int x, int y, bool restore) { }
+int Statusbar_SetHeight(int ScreenWidth, int ScreenHeight) { return 0; }
+int Statusbar_GetHeightForSize(int width, int height) { return 0; }
+
+/* Fake host screen : 32 bits ARGB */
+static uint32_t HostPixels[HOST_WIDTH * HOST_HEIGHT];
+static int HostWidth, HostHeight;
+
+uint32_t Screen_MapRGB(uint8_t red, uint8_t green, uint8_t blue)
+{
+	return 0xff000000 | red << 16 | green << 8 | blue;
+}
+
+void Screen_GetPixelFormat(uint32_t *rmask, uint32_t *gmask, uint32_t *bmask,
+                           int *rshift, int *gshift, int *bshift)
+{
+	*rmask = 0xff0000; *gmask = 0xff00; *bmask = 0xff;
+	*rshift = 16; *gshift = 8; *bshift = 0;
+}
+
+void Screen_GetDimension(uint32_t **pixels, int *width, int *height, int *pitch)
+{
+	if (pixels)
+		*pixels = HostPixels;
+	if (width)
+		*width = HostWidth;
+	if (height)
+		*height = HostHeight;
+	if (pitch)
+		*pitch = HOST_WIDTH * sizeof(uint32_t);
+}
+
+uint32_t Screen_GetGenConvWidth(void) { return HostWidth; }
+uint32_t Screen_GetGenConvHeight(void) { return HostHeight; }
+void Screen_GetDesktopSize(int *width, int *height) { *width = *height = 0; }
+bool Screen_SetVideoSize(int width, int height, bool bForceChange) { return false; }
+void Screen_ClearScreen(void) { }
+bool Screen_Lock(void) { return true; }
+void Screen_UnLock(void) { }
+void Screen_GenConvUpdate(bool update_statusbar) { }
+
+/* Fake workers : the jobs are run in reverse order */
+static int Workers;
+
+int Screen_GetWorkerCount(void) { return Workers; }
+
+void Screen_RunWorkers(void (*func)(int idx, void *data), int jobs, void *data)
+{
+	while (jobs-- > 0)
+		func(jobs, data);
+}
+
+
+/*-----------------------------------------------------------------------*/
+
+typedef struct
+{
+	const char *name;
+	int vw, vh, vbpp;
+	int hscroll;
+	int left, right, upper, lower;
+	int zoomx, zoomy;
+} MODE;
+
+static const MODE Modes[] =
+{
+	{ "TT 640x480x8", 640, 480, 8, 0, 0, 0, 0, 0, 1, 1 },
+	{ "TT 1280x960x1", 1280, 960, 1, 0, 0, 0, 0, 0, 1, 1 },
+	{ "Falcon 320x200x4 scrolled", 320, 200, 4, 5, 0, 0, 0, 0, 2, 2 },
+	{ "Falcon 640x400x2 borders", 640, 400, 2, 0, 32, 32, 20, 20, 1, 1 },
+	{ "Falcon 320x240x16", 320, 240, 16, 0, 0, 0, 0, 0, 1, 1 },
+	{ "Falcon 384x240x16 zoomed", 384, 240, 16, 0, 16, 16, 8, 8, 2, 2 },
+	{ "Falcon 320x480x8 zoomed", 320, 480, 8, 0, 0, 0, 0, 0, 2, 1 },
+	{ "Falcon 320x210x8 zoomed 3x", 320, 210, 8, 0, 0, 0, 0, 0, 3, 3 },
+};
+
+static uint32_t Frame[HOST_WIDTH * HOST_HEIGHT];
+
+static int NextLine(const MODE *m)
+{
+	return m->vw * m->vbpp / 16;
+}
+
+static bool Convert(const MODE *m)
+{
+	return ConvGen_Convert(VIDEO_BASE, &STRam[VIDEO_BASE], m->vw, m->vh, m->vbpp,
+	                       NextLine(m), m->hscroll, m->left, m->right,
+	                       m->upper, m->lower);
+}
+
+static void Set_Mode(const MODE *m)
+{
+	int i;
+
+	nScreenZoomX = m->zoomx;
+	nScreenZoomY = m->zoomy;
+	HostWidth = (m->left + m->vw + m->right) * m->zoomx;
+	HostHeight = (m->upper + m->vh + m->lower) * m->zoomy;
+
+	for (i = 0; i < RAM_SIZE; i++)
+		STRam[i] = SimdTest_Random();
+	for (i = 0; i < 256; i++)
+		ConvGen_SetPaletteColor(i, SimdTest_Random(), SimdTest_Random(), SimdTest_Random());
+}
+
+/* Change some lines of the screen, the palette from time to time */
+static void Change_Frame(const MODE *m)
+{
+	int i, y, count, size;
+	uint8_t *line;
+
+	count = SimdTest_Random() % 8;
+	size = NextLine(m) * 2;
+	for (i = 0; i < count; i++)
+	{
+		y = SimdTest_Random() % m->vh;
+		line = &STRam[VIDEO_BASE + y * size];
+		line[SimdTest_Random() % size] ^= 1 << (SimdTest_Random() % 8);
+	}
+	if (SimdTest_Random() % 16 == 0)
+		ConvGen_SetPaletteColor(SimdTest_Random() % 256, SimdTest_Random(), SimdTest_Random(), SimdTest_Random());
+}
+
+/* Convert frames incrementally and compare them with full conversions */
+static int Check_Mode(const MODE *m, int frames)
+{
+	int i, y, top, bottom, workers, errors = 0;
+	size_t size = HOST_WIDTH * HostHeight * sizeof(uint32_t);
+
+	ConvGen_SetFullUpdate();
+	Convert(m);
+	ConvGen_GetDirtyLines(&top, &bottom);
+
+	/* Same frame : nothing to convert */
+	if (Convert(m) || ConvGen_GetDirtyLines(&top, &bottom))
+	{
+		fprintf(stderr, "%s: unchanged frame converted\n", m->name);
+		errors++;
+	}
+
+	for (i = 0; i < frames && errors < 10; i++)
+	{
+		memcpy(Frame, HostPixels, size);
+		Change_Frame(m);
+		Convert(m);
+		if (!ConvGen_GetDirtyLines(&top, &bottom))
+			top = bottom = 0;
+
+		/* Changed host lines must be in the dirty range */
+		for (y = 0; y < HostHeight; y++)
+		{
+			if ((y < top || y >= bottom) &&
+			    memcmp(&Frame[y * HOST_WIDTH], &HostPixels[y * HOST_WIDTH],
+			           HostWidth * sizeof(uint32_t)))
+			{
+				fprintf(stderr, "%s: frame %d, line %d changed outside of %d-%d\n",
+				        m->name, i, y, top, bottom);
+				errors++;
+				break;
+			}
+		}
+
+		/* Must be the same as a full conversion in one go */
+		memcpy(Frame, HostPixels, size);
+		memset(HostPixels, 0x55, size);
+		ConvGen_SetFullUpdate();
+		workers = Workers;
+		Workers = 0;
+		Convert(m);
+		Workers = workers;
+		ConvGen_GetDirtyLines(&top, &bottom);
+		for (y = 0; y < HostHeight; y++)
+		{
+			if (memcmp(&Frame[y * HOST_WIDTH], &HostPixels[y * HOST_WIDTH],
+			           HostWidth * sizeof(uint32_t)))
+			{
+				fprintf(stderr, "%s: frame %d, line %d differs from full conversion\n",
+				        m->name, i, y);
+				errors++;
+				break;
+			}
+		}
+	}
+	return errors;
+}
+
+/* Static frames (like the GEM desktop) and frames with few changes */
+static void Benchmark_Mode(const MODE *m, int frames)
+{
+	double time_full, time_static, time_changes;
+	clock_t start;
+	int i;
+
+	start = clock();
+	for (i = 0; i < frames; i++)
+	{
+		ConvGen_SetFullUpdate();
+		Convert(m);
+	}
+	time_full = SimdTest_Seconds(start);
+
+	start = clock();
+	for (i = 0; i < frames; i++)
+		Convert(m);
+	time_static = SimdTest_Seconds(start);
+
+	start = clock();
+	for (i = 0; i < frames; i++)
+	{
+		Change_Frame(m);
+		Convert(m);
+	}
+	time_changes = SimdTest_Seconds(start);
+
+	printf("%s: %d frames, full %.3fs, static %.3fs, few changes %.3fs\n",
+	       m->name, frames, time_full, time_static, time_changes);
+}
+
+int main(int argc, char *argv[])
+{
+	int frames = DEFAULT_FRAMES;
+	int errors = 0;
+	int level;
+	size_t i;
+
+	if (argc > 1)
+		frames = atoi(argv[1]);
+
+	STRam = malloc(RAM_SIZE);
+	if (!STRam)
+		return 1;
+
+	SIMDTEST_FOR_EACH_LEVEL(level, SIMD_NONE, ConvSimd_Init)
+	{
+		for (i = 0; i < sizeof(Modes) / sizeof(Modes[0]); i++)
+		{
+			for (Workers = 0; Workers <= 3; Workers += 3)
+			{
+				Set_Mode(&Modes[i]);
+				errors += Check_Mode(&Modes[i], frames);
+			}
+			Workers = 0;
+			if (level == SIMD_NONE)
+				Benchmark_Mode(&Modes[i], frames);
+		}
+	}
+
+	free(STRam);
+
+	return SimdTest_Result(errors);
+}
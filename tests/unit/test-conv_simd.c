@@ -0,0 +1,579 @@
+/*
+ * Test and micro benchmark for the SIMD screen conversion kernels (conv_simd.c)
+ *
+ * Random ST low / medium resolution lines are converted with each kernel
+ * supported by the host cpu and with the scalar macros of src/convert/,
+ * the results must be the same pixel for pixel (including the blocks
+ * which are skipped because they didn't change since the previous frame).
+ * TT / Falcon bitplanes and 16 bit lines are compared with the same
+ * conversion done pixel by pixel as in conv_gen.c.
+ *
+ * Usage: test-conv_simd [number of lines]
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "main.h"
+#include "conv_simd.h"
+#include "simd_test.h"
+
+#define	DEFAULT_LINES	20000
+#define	BLOCKS		26		/* 416 pixels : max line with borders */
+#define	GEN_PIXELS	768		/* Max width of TT / Falcon lines to check */
+
+uint32_t STRGBPalette[16];		/* Used by the conversion macros */
+
+#include "convert/macros.h"
+
+
+/*-----------------------------------------------------------------------*/
+/* Reference scalar conversion, same as in src/convert/ */
+
+static bool Ref_LowLine(const uint32_t *edi, const uint32_t *ebp, uint32_t *esi,
+                        int x, bool update, bool doubled)
+{
+	uint32_t eax, ebx, ecx, edx;
+	bool changed = false;
+
+	for ( ; x > 0; x--, edi += 2, ebp += 2, esi += doubled ? 32 : 16)
+	{
+		ebx = *edi;
+		ecx = *(edi+1);
+		if (!update && ebx == *ebp && ecx == *(ebp+1))
+			continue;
+		changed = true;
+
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+		if (doubled)
+		{
+			LOW_BUILD_PIXELS_0; PLOT_LOW_640_32BIT(24);
+			LOW_BUILD_PIXELS_1; PLOT_LOW_640_32BIT(8);
+			LOW_BUILD_PIXELS_2; PLOT_LOW_640_32BIT(16);
+			LOW_BUILD_PIXELS_3; PLOT_LOW_640_32BIT(0);
+		}
+		else
+		{
+			LOW_BUILD_PIXELS_0; PLOT_LOW_320_32BIT(12);
+			LOW_BUILD_PIXELS_1; PLOT_LOW_320_32BIT(4);
+			LOW_BUILD_PIXELS_2; PLOT_LOW_320_32BIT(8);
+			LOW_BUILD_PIXELS_3; PLOT_LOW_320_32BIT(0);
+		}
+#else
+		if (doubled)
+		{
+			LOW_BUILD_PIXELS_0; PLOT_LOW_640_32BIT(8);
+			LOW_BUILD_PIXELS_1; PLOT_LOW_640_32BIT(24);
+			LOW_BUILD_PIXELS_2; PLOT_LOW_640_32BIT(0);
+			LOW_BUILD_PIXELS_3; PLOT_LOW_640_32BIT(16);
+		}
+		else
+		{
+			LOW_BUILD_PIXELS_0; PLOT_LOW_320_32BIT(4);
+			LOW_BUILD_PIXELS_1; PLOT_LOW_320_32BIT(12);
+			LOW_BUILD_PIXELS_2; PLOT_LOW_320_32BIT(0);
+			LOW_BUILD_PIXELS_3; PLOT_LOW_320_32BIT(8);
+		}
+#endif
+	}
+	return changed;
+}
+
+static bool Ref_MedLine(const uint32_t *edi, const uint32_t *ebp, uint32_t *esi,
+                        int x, bool update)
+{
+	uint32_t eax, ebx, ecx;
+	bool changed = false;
+
+	for ( ; x > 0; x--, edi++, ebp++, esi += 16)
+	{
+		ebx = *edi;
+		if (!update && ebx == *ebp)
+			continue;
+		changed = true;
+
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+		MED_BUILD_PIXELS_0; PLOT_MED_640_32BIT(12);
+		MED_BUILD_PIXELS_1; PLOT_MED_640_32BIT(4);
+		MED_BUILD_PIXELS_2; PLOT_MED_640_32BIT(8);
+		MED_BUILD_PIXELS_3; PLOT_MED_640_32BIT(0);
+#else
+		MED_BUILD_PIXELS_0; PLOT_MED_640_32BIT(4);
+		MED_BUILD_PIXELS_1; PLOT_MED_640_32BIT(12);
+		MED_BUILD_PIXELS_2; PLOT_MED_640_32BIT(0);
+		MED_BUILD_PIXELS_3; PLOT_MED_640_32BIT(8);
+#endif
+	}
+	return changed;
+}
+
+
+/* Bitplanes to palette indexes, one pixel at a time */
+static void Ref_BitplanePixels(const uint16_t *planes, int bpp, uint8_t *pixels, int blocks)
+{
+	const uint8_t *bytes = (const uint8_t *)planes;
+	int i, k, word;
+
+	for ( ; blocks > 0; blocks--, bytes += 2 * bpp, pixels += 16)
+	{
+		for (i = 0; i < 16; i++)
+		{
+			pixels[i] = 0;
+			for (k = 0; k < bpp; k++)
+			{
+				word = bytes[2*k] << 8 | bytes[2*k+1];	/* big endian */
+				pixels[i] |= ((word >> (15 - i)) & 1) << k;
+			}
+		}
+	}
+}
+
+/* ConvGen_BitplaneToChunky32() of conv_gen.c, for the benchmark */
+static void Ref_BitplaneToChunky32(uint16_t *atariBitplaneData, uint16_t bpp,
+                                   uint32_t *hvram, const uint32_t *pal)
+{
+	uint32_t a, b, c, d, x;
+
+	if (bpp >= 4) {
+		d = *(uint32_t *)&atariBitplaneData[0];
+		c = *(uint32_t *)&atariBitplaneData[2];
+		if (bpp == 4) {
+			a = b = 0;
+		} else {
+			b = *(uint32_t *)&atariBitplaneData[4];
+			a = *(uint32_t *)&atariBitplaneData[6];
+		}
+
+		x = a;
+		a =  (a & 0xf0f0f0f0)       | ((c & 0xf0f0f0f0) >> 4);
+		c = ((x & 0x0f0f0f0f) << 4) |  (c & 0x0f0f0f0f);
+	} else {
+		a = b = c = 0;
+		if (bpp == 2)
+			d = *(uint32_t *)&atariBitplaneData[0];
+		else
+			d = atariBitplaneData[0];
+	}
+
+	x = b;
+	b =  (b & 0xf0f0f0f0)       | ((d & 0xf0f0f0f0) >> 4);
+	d = ((x & 0x0f0f0f0f) << 4) |  (d & 0x0f0f0f0f);
+
+	x = a;
+	a =  (a & 0xcccccccc)       | ((b & 0xcccccccc) >> 2);
+	b = ((x & 0x33333333) << 2) |  (b & 0x33333333);
+	x = c;
+	c =  (c & 0xcccccccc)       | ((d & 0xcccccccc) >> 2);
+	d = ((x & 0x33333333) << 2) |  (d & 0x33333333);
+
+	a = (a & 0xaaaa5555) | ((a & 0x0000aaaa) << 15) | ((a & 0x55550000) >> 15);
+	b = (b & 0xaaaa5555) | ((b & 0x0000aaaa) << 15) | ((b & 0x55550000) >> 15);
+	c = (c & 0xaaaa5555) | ((c & 0x0000aaaa) << 15) | ((c & 0x55550000) >> 15);
+	d = (d & 0xaaaa5555) | ((d & 0x0000aaaa) << 15) | ((d & 0x55550000) >> 15);
+
+	*hvram++ = pal[(uint8_t)(a >> 16)];
+	*hvram++ = pal[(uint8_t)a];
+	*hvram++ = pal[(uint8_t)(b >> 16)];
+	*hvram++ = pal[(uint8_t)b];
+	*hvram++ = pal[(uint8_t)(c >> 16)];
+	*hvram++ = pal[(uint8_t)c];
+	*hvram++ = pal[(uint8_t)(d >> 16)];
+	*hvram++ = pal[(uint8_t)d];
+	*hvram++ = pal[(uint8_t)(a >> 24)];
+	*hvram++ = pal[(uint8_t)(a >> 8)];
+	*hvram++ = pal[(uint8_t)(b >> 24)];
+	*hvram++ = pal[(uint8_t)(b >> 8)];
+	*hvram++ = pal[(uint8_t)(c >> 24)];
+	*hvram++ = pal[(uint8_t)(c >> 8)];
+	*hvram++ = pal[(uint8_t)(d >> 24)];
+	*hvram++ = pal[(uint8_t)(d >> 8)];
+}
+
+/* Falcon 16 bit pixels, as in conv_gen.c with Screen_MapRGB() */
+static void Ref_HiColorLine(const uint16_t *src, uint32_t *dst, int count, const CONVSIMD_RGB *format)
+{
+	const uint8_t *bytes = (const uint8_t *)src;
+	uint16_t srcword;
+	uint8_t r, g, b;
+
+	for ( ; count > 0; count--, bytes += 2)
+	{
+		srcword = bytes[0] << 8 | bytes[1];
+		r = ((srcword >> 8) & 0xf8) | (srcword >> 13);
+		g = ((srcword >> 3) & 0xfc) | ((srcword >> 9) & 0x3);
+		b = (srcword << 3) | ((srcword >> 2) & 0x07);
+		*dst++ = format->base | (uint32_t)r << format->rshift
+		         | (uint32_t)g << format->gshift | (uint32_t)b << format->bshift;
+	}
+}
+
+
+/*-----------------------------------------------------------------------*/
+
+/* Random line, and previous frame with about half the blocks unchanged */
+static void Random_Line(uint32_t *st, uint32_t *copy, int words)
+{
+	int i;
+
+	for (i = 0; i < words; i++)
+	{
+		st[i] = SimdTest_Random();
+		copy[i] = (SimdTest_Random() & 1) ? st[i] : SimdTest_Random();
+	}
+}
+
+static void Random_Palette(void)
+{
+	int i;
+
+	for (i = 0; i < 16; i++)
+		STRGBPalette[i] = SimdTest_Random();
+}
+
+/* Fill the output buffers with the same data, to check the skipped blocks */
+static void Fill_Output(uint32_t *ref, uint32_t *simd, int size)
+{
+	int i;
+
+	for (i = 0; i < size; i++)
+		ref[i] = simd[i] = SimdTest_Random();
+}
+
+
+static int Check_Level(int level, int lines)
+{
+	static uint32_t st[BLOCKS * 2], copy[BLOCKS * 2];
+	static uint32_t ref[BLOCKS * 32], simd[BLOCKS * 32];
+	uint8_t pixels[BLOCKS * 32];
+	uint32_t index[16];
+	bool update, doubled, changed_ref, changed_simd;
+	int i, j, blocks, errors = 0;
+
+	for (i = 0; i < 16; i++)
+		index[i] = i;
+
+	for (i = 0; i < lines && errors < 10; i++)
+	{
+		blocks = 1 + SimdTest_Random() % BLOCKS;
+		update = (SimdTest_Random() & 3) == 0;
+		doubled = SimdTest_Random() & 1;
+		Random_Palette();
+
+		/* Low resolution */
+		Random_Line(st, copy, blocks * 2);
+		if (ConvSimd_LowLine)
+		{
+			Fill_Output(ref, simd, BLOCKS * 32);
+			changed_ref = Ref_LowLine(st, copy, ref, blocks, update, doubled);
+			changed_simd = ConvSimd_LowLine(st, copy, simd, blocks, update, STRGBPalette, doubled);
+			if (changed_ref != changed_simd || memcmp(ref, simd, sizeof(ref)))
+			{
+				fprintf(stderr, "%s: low res line %d (%d blocks, update %d, doubled %d) differs\n",
+				        Simd_Name(level), i, blocks, update, doubled);
+				errors++;
+			}
+		}
+
+		/* Medium resolution */
+		if (ConvSimd_MedLine)
+		{
+			Fill_Output(ref, simd, BLOCKS * 32);
+			changed_ref = Ref_MedLine(st, copy, ref, blocks * 2, update);
+			changed_simd = ConvSimd_MedLine(st, copy, simd, blocks * 2, update, STRGBPalette);
+			if (changed_ref != changed_simd || memcmp(ref, simd, sizeof(ref)))
+			{
+				fprintf(stderr, "%s: medium res line %d (%d blocks, update %d) differs\n",
+				        Simd_Name(level), i, blocks * 2, update);
+				errors++;
+			}
+		}
+
+		/* Palette indexes for Spec512 */
+		memcpy(STRGBPalette, index, sizeof(index));
+		Ref_LowLine(st, copy, ref, blocks, true, false);
+		ConvSimd_LowPixels(st, pixels, blocks);
+		for (j = 0; j < blocks * 16; j++)
+		{
+			if (pixels[j] != ref[j])
+			{
+				fprintf(stderr, "%s: low res pixel %d of line %d is %d instead of %d\n",
+				        Simd_Name(level), j, i, pixels[j], ref[j]);
+				errors++;
+				break;
+			}
+		}
+		Ref_MedLine(st, copy, ref, blocks * 2, true);
+		ConvSimd_MedPixels(st, pixels, blocks * 2);
+		for (j = 0; j < blocks * 32; j++)
+		{
+			if (pixels[j] != ref[j])
+			{
+				fprintf(stderr, "%s: medium res pixel %d of line %d is %d instead of %d\n",
+				        Simd_Name(level), j, i, pixels[j], ref[j]);
+				errors++;
+				break;
+			}
+		}
+	}
+
+	return errors;
+}
+
+/* TT / Falcon lines of conv_gen.c */
+static int Check_Generic(int level, int lines)
+{
+	static const CONVSIMD_RGB formats[2] =
+	{
+		{ 0xff000000, 16, 8, 0 },		/* ARGB8888 */
+		{ 0, 0, 8, 16 }				/* ABGR8888 without alpha */
+	};
+	static uint16_t src[GEN_PIXELS];
+	static uint8_t pixels_ref[GEN_PIXELS], pixels_simd[GEN_PIXELS];
+	static uint32_t palette[GEN_PIXELS], ref[GEN_PIXELS], simd[GEN_PIXELS];
+	static int xtable[GEN_PIXELS];
+	int i, j, k, bpp, count, errors = 0;
+
+	for (i = 0; i < lines && errors < 10; i++)
+	{
+		for (j = 0; j < GEN_PIXELS; j++)
+			src[j] = SimdTest_Random();
+		for (j = 0; j < GEN_PIXELS; j++)
+			palette[j] = SimdTest_Random();
+
+		/* Bitplanes */
+		bpp = 1 << (SimdTest_Random() % 4);
+		count = 16 + 16 * (SimdTest_Random() % (GEN_PIXELS / 16 / 8));
+		Ref_BitplanePixels(src, bpp, pixels_ref, count / 16);
+		ConvSimd_BitplanePixels(src, bpp, pixels_simd, count / 16);
+		if (memcmp(pixels_ref, pixels_simd, count))
+		{
+			fprintf(stderr, "%s: %d planes line %d (%d pixels) differs\n",
+			        Simd_Name(level), bpp, i, count);
+			errors++;
+		}
+
+		/* Palette mapping, with any start / length */
+		j = SimdTest_Random() % 16;
+		count = SimdTest_Random() % (GEN_PIXELS - j);
+		Fill_Output(ref, simd, GEN_PIXELS);
+		for (k = 0; k < count; k++)
+			ref[k] = palette[pixels_ref[j + k]];
+		ConvSimd_PaletteLine(pixels_ref + j, simd, count, palette);
+		if (memcmp(ref, simd, sizeof(ref)))
+		{
+			fprintf(stderr, "%s: palette line %d (%d pixels) differs\n",
+			        Simd_Name(level), i, count);
+			errors++;
+		}
+
+		/* Falcon 16 bit */
+		count = SimdTest_Random() % GEN_PIXELS;
+		Fill_Output(ref, simd, GEN_PIXELS);
+		Ref_HiColorLine(src, ref, count, &formats[i & 1]);
+		ConvSimd_HiColorLine(src, simd, count, &formats[i & 1]);
+		if (memcmp(ref, simd, sizeof(ref)))
+		{
+			fprintf(stderr, "%s: 16 bit line %d (%d pixels) differs\n",
+			        Simd_Name(level), i, count);
+			errors++;
+		}
+
+		/* Zoom by 2 or 1.5 of a converted line */
+		if (ConvSimd_ZoomLine)
+		{
+			count = SimdTest_Random() % GEN_PIXELS;
+			for (j = 0; j < count; j++)
+				xtable[j] = (j * 2) / ((i & 1) + 3);
+			Fill_Output(ref, simd, GEN_PIXELS);
+			for (j = 0; j < count; j++)
+				ref[j] = palette[xtable[j]];
+			ConvSimd_ZoomLine(palette, simd, count, xtable);
+			if (memcmp(ref, simd, sizeof(ref)))
+			{
+				fprintf(stderr, "%s: zoomed line %d (%d pixels) differs\n",
+				        Simd_Name(level), i, count);
+				errors++;
+			}
+		}
+
+		/* Integer zoom by 2, 3 or 4 of a converted line */
+		if (ConvSimd_ScaleLine)
+		{
+			int factor = 2 + i % 3;
+
+			count = SimdTest_Random() % (GEN_PIXELS / factor);
+			Fill_Output(ref, simd, GEN_PIXELS);
+			for (j = 0; j < count * factor; j++)
+				ref[j] = palette[j / factor];
+			ConvSimd_ScaleLine(palette, simd, count, factor);
+			if (memcmp(ref, simd, sizeof(ref)))
+			{
+				fprintf(stderr, "%s: x%d scaled line %d (%d pixels) differs\n",
+				        Simd_Name(level), factor, i, count);
+				errors++;
+			}
+		}
+
+		/* Half intensity line (TV mode / scanlines) */
+		if (ConvSimd_HalveLine)
+		{
+			count = SimdTest_Random() % GEN_PIXELS;
+			Fill_Output(ref, simd, GEN_PIXELS);
+			for (j = 0; j < count; j++)
+				ref[j] = (palette[j] >> 1) & 0x7f7f7f;
+			ConvSimd_HalveLine(palette, simd, count, 0x7f7f7f);
+			if (memcmp(ref, simd, sizeof(ref)))
+			{
+				fprintf(stderr, "%s: halved line %d (%d pixels) differs\n",
+				        Simd_Name(level), i, count);
+				errors++;
+			}
+		}
+	}
+
+	return errors;
+}
+
+/* Full update of low res lines (416 pixels with borders) */
+static void Benchmark_Level(int level, int lines)
+{
+	static uint32_t st[BLOCKS * 2], copy[BLOCKS * 2];
+	static uint32_t dst[BLOCKS * 32];
+	static uint8_t pixels[BLOCKS * 16];
+	double time_ref, time_simd;
+	clock_t start;
+	int i;
+
+	Random_Palette();
+	Random_Line(st, copy, BLOCKS * 2);
+
+	if (ConvSimd_LowLine)
+	{
+		start = clock();
+		for (i = 0; i < lines; i++)
+			Ref_LowLine(st, copy, dst, BLOCKS, true, true);
+		time_ref = SimdTest_Seconds(start);
+
+		start = clock();
+		for (i = 0; i < lines; i++)
+			ConvSimd_LowLine(st, copy, dst, BLOCKS, true, STRGBPalette, true);
+		time_simd = SimdTest_Seconds(start);
+
+		printf("%s: %d x2 lines, scalar %.3fs, %s %.3fs\n", Simd_Name(level),
+		       lines, time_ref, Simd_Name(level), time_simd);
+	}
+
+	/* Indexes only, compared with the scalar conversion to 320 pixels */
+	start = clock();
+	for (i = 0; i < lines; i++)
+		Ref_LowLine(st, copy, dst, BLOCKS, true, false);
+	time_ref = SimdTest_Seconds(start);
+
+	start = clock();
+	for (i = 0; i < lines; i++)
+		ConvSimd_LowPixels(st, pixels, BLOCKS);
+	time_simd = SimdTest_Seconds(start);
+
+	printf("%s: %d x1 lines, scalar %.3fs, %s indexes %.3fs\n", Simd_Name(level),
+	       lines, time_ref, Simd_Name(level), time_simd);
+}
+
+/* 640 pixels lines of TT / Falcon 8 planes and Falcon 16 bit modes */
+static void Benchmark_Generic(int level, int lines)
+{
+	static const CONVSIMD_RGB format = { 0xff000000, 16, 8, 0 };
+	static uint16_t src[640];
+	static uint8_t pixels[640];
+	static uint32_t palette[256], dst[640];
+	double time_ref, time_simd;
+	clock_t start;
+	int i, j;
+
+	for (j = 0; j < 640; j++)
+		src[j] = SimdTest_Random();
+	for (j = 0; j < 256; j++)
+		palette[j] = SimdTest_Random();
+
+	start = clock();
+	for (i = 0; i < lines; i++)
+		for (j = 0; j < 640 / 16; j++)
+			Ref_BitplaneToChunky32(&src[j * 8], 8, &dst[j * 16], palette);
+	time_ref = SimdTest_Seconds(start);
+
+	start = clock();
+	for (i = 0; i < lines; i++)
+	{
+		ConvSimd_BitplanePixels(src, 8, pixels, 640 / 16);
+		ConvSimd_PaletteLine(pixels, dst, 640, palette);
+	}
+	time_simd = SimdTest_Seconds(start);
+
+	printf("%s: %d 8 planes lines, scalar %.3fs, %s %.3fs\n", Simd_Name(level),
+	       lines, time_ref, Simd_Name(level), time_simd);
+
+	start = clock();
+	for (i = 0; i < lines; i++)
+		Ref_HiColorLine(src, dst, 640, &format);
+	time_ref = SimdTest_Seconds(start);
+
+	start = clock();
+	for (i = 0; i < lines; i++)
+		ConvSimd_HiColorLine(src, dst, 640, &format);
+	time_simd = SimdTest_Seconds(start);
+
+	printf("%s: %d 16 bit lines, scalar (without Screen_MapRGB calls) %.3fs, %s %.3fs\n",
+	       Simd_Name(level), lines, time_ref, Simd_Name(level), time_simd);
+
+	/* 4x zoom of 320 pixels lines, compared with the zoom table loop */
+	if (ConvSimd_ScaleLine)
+	{
+		static uint32_t line[320], zoomed[320 * 4];
+		static int xtable[320 * 4];
+
+		for (j = 0; j < 320; j++)
+			line[j] = palette[j & 0xff];
+		for (j = 0; j < 320 * 4; j++)
+			xtable[j] = j / 4;
+
+		start = clock();
+		for (i = 0; i < lines; i++)
+			for (j = 0; j < 320 * 4; j++)
+				zoomed[j] = line[xtable[j]];
+		time_ref = SimdTest_Seconds(start);
+
+		start = clock();
+		for (i = 0; i < lines; i++)
+			ConvSimd_ScaleLine(line, zoomed, 320, 4);
+		time_simd = SimdTest_Seconds(start);
+
+		printf("%s: %d x4 zoomed lines, scalar %.3fs, %s %.3fs\n",
+		       Simd_Name(level), lines, time_ref, Simd_Name(level), time_simd);
+	}
+}
+
+int main(int argc, char *argv[])
+{
+	int lines = DEFAULT_LINES;
+	int level, checked = 0, errors = 0;
+
+	if (argc > 1)
+		lines = atoi(argv[1]);
+
+	SIMDTEST_FOR_EACH_LEVEL(level, SIMD_NONE + 1, ConvSimd_Init)
+	{
+		errors += Check_Level(level, lines);
+		errors += Check_Generic(level, lines);
+		Benchmark_Level(level, lines * 10);
+		Benchmark_Generic(level, lines);
+		checked++;
+	}
+
+	if (!checked)
+		printf("No SIMD kernels for this host, scalar conversion is used\n");
+
+	return SimdTest_Result(errors);
+}
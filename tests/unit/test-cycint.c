@@ -0,0 +1,458 @@
+/*
+ * Test and micro benchmark for the internal interrupts heap (cycInt.c)
+ *
+ * The internal interrupts recorded on a Falcon (cycint-falcon.trace) are
+ * replayed against the binary heap used by cycInt.c and against a
+ * reference copy of the previous sorted linked list implementation. Both
+ * must give the active interrupts recorded in the trace, the same sorted
+ * interrupts, and the snapshot format (linked list of active interrupts)
+ * must stay the same.
+ *
+ * Usage: test-cycint <trace file> [number of replays for the benchmark]
+ */
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "main.h"
+#include "log.h"
+#include "m68000.h"
+#include "cycles.h"
+#include "cycInt.h"
+#include "configuration.h"
+#include "clocks_timings.h"
+#include "video.h"
+#include "mfp.h"
+#include "acia.h"
+#include "ikbd.h"
+#include "dmaSnd.h"
+#include "crossbar.h"
+#include "fdc.h"
+#include "blitter.h"
+#include "midi.h"
+#include "scc.h"
+#include "hdc.h"
+#include "memorySnapShot.h"
+
+#define	DEFAULT_REPLAYS	1000
+#define	MAX_EVENTS	100000
+#define	SNAPSHOT_SIZE	4096
+
+
+/* Fake tracing */
+uint64_t LogTraceFlags = 0;
+FILE *TraceFile;
+void Log_Trace(const char *format, ...) { }
+
+/* Fake cpu / clocks */
+uint64_t CyclesGlobalClockCounter;
+int nCpuFreqShift = 1;				/* 16 MHz like a Falcon */
+CLOCKS_STRUCT MachineClocks;
+uint64_t Cycles_GetClockCounterImmediate(void) { return CyclesGlobalClockCounter; }
+int Video_GetCyclesSinceVbl(void) { return 0; }
+
+/* Fake snapshot, saved to / restored from a memory buffer */
+static uint8_t	Snapshot[SNAPSHOT_SIZE];
+static int	SnapshotPos;
+static bool	SnapshotSave;
+
+void MemorySnapShot_Store(void *pData, int Size)
+{
+	assert(SnapshotPos + Size <= SNAPSHOT_SIZE);
+	if (SnapshotSave)
+		memcpy(&Snapshot[SnapshotPos], pData, Size);
+	else
+		memcpy(pData, &Snapshot[SnapshotPos], Size);
+	SnapshotPos += Size;
+}
+
+/* Handlers referenced by cycInt.c, never called by the replay */
+void Video_InterruptHandler_VBL(void) { }
+void Video_InterruptHandler_HBL(void) { }
+void Video_InterruptHandler_EndLine(void) { }
+void MFP_Main_InterruptHandler_TimerA(void) { }
+void MFP_Main_InterruptHandler_TimerB(void) { }
+void MFP_Main_InterruptHandler_TimerC(void) { }
+void MFP_Main_InterruptHandler_TimerD(void) { }
+void MFP_TT_InterruptHandler_TimerA(void) { }
+void MFP_TT_InterruptHandler_TimerB(void) { }
+void MFP_TT_InterruptHandler_TimerC(void) { }
+void MFP_TT_InterruptHandler_TimerD(void) { }
+void ACIA_InterruptHandler_IKBD(void) { }
+void IKBD_InterruptHandler_ResetTimer(void) { }
+void IKBD_InterruptHandler_AutoSend(void) { }
+void DmaSnd_InterruptHandler_Microwire(void) { }
+void Crossbar_InterruptHandler_25Mhz(void) { }
+void Crossbar_InterruptHandler_32Mhz(void) { }
+void FDC_InterruptHandler_Update(void) { }
+void Blitter_InterruptHandler(void) { }
+void Midi_InterruptHandler_Update(void) { }
+void SCC_InterruptHandler_BRG_A(void) { }
+void SCC_InterruptHandler_TX_RX_A(void) { }
+void SCC_InterruptHandler_RX_A(void) { }
+void SCC_InterruptHandler_BRG_B(void) { }
+void SCC_InterruptHandler_TX_RX_B(void) { }
+void SCC_InterruptHandler_RX_B(void) { }
+void HDC_ACSI_InterruptHandler_Update(void) { }
+
+
+/*-----------------------------------------------------------------------*/
+/* Reference implementation : sorted linked list from the previous cycInt.c */
+
+typedef struct
+{
+	bool	Active;
+	uint64_t Cycles;
+	int	IntList_Prev;
+	int	IntList_Next;
+} REF_HANDLER;
+
+static REF_HANDLER	Ref[MAX_INTERRUPTS];
+static int		Ref_ActiveInt;
+
+static void Ref_Reset(void)
+{
+	int i;
+
+	for (i = 0; i < MAX_INTERRUPTS; i++)
+	{
+		Ref[i].Active = false;
+		Ref[i].Cycles = 0;
+		Ref[i].IntList_Prev = -1;
+		Ref[i].IntList_Next = -1;
+	}
+	Ref[0].Active = true;
+	Ref[0].Cycles = UINT64_MAX;
+	Ref_ActiveInt = 0;
+}
+
+static void Ref_InsertInt(int IntId)
+{
+	int n, prev;
+
+	n = Ref_ActiveInt;
+	prev = Ref[n].IntList_Prev;
+	while (Ref[IntId].Cycles > Ref[n].Cycles)
+	{
+		n = Ref[n].IntList_Next;
+		prev = Ref[n].IntList_Prev;
+	}
+
+	Ref[IntId].IntList_Next = n;
+	Ref[n].IntList_Prev = IntId;
+
+	if (n == Ref_ActiveInt)
+	{
+		Ref_ActiveInt = IntId;
+		Ref[IntId].IntList_Prev = -1;
+	}
+	else
+	{
+		Ref[IntId].IntList_Prev = prev;
+		Ref[prev].IntList_Next = IntId;
+	}
+}
+
+static void Ref_Remove(interrupt_id Handler)
+{
+	if (!Ref[Handler].Active)
+		return;
+	Ref[Handler].Active = false;
+
+	if ((int)Handler == Ref_ActiveInt)
+	{
+		Ref_ActiveInt = Ref[Handler].IntList_Next;
+		Ref[Ref_ActiveInt].IntList_Prev = -1;
+	}
+	else
+	{
+		Ref[Ref[Handler].IntList_Prev].IntList_Next = Ref[Handler].IntList_Next;
+		Ref[Ref[Handler].IntList_Next].IntList_Prev = Ref[Handler].IntList_Prev;
+	}
+}
+
+static void Ref_Acknowledge(void)
+{
+	Ref[Ref_ActiveInt].Active = false;
+	Ref_ActiveInt = Ref[Ref_ActiveInt].IntList_Next;
+	Ref[Ref_ActiveInt].IntList_Prev = -1;
+}
+
+static void Ref_AddRelative(int CycleTime, int CycleType, interrupt_id Handler, int CycleOffset)
+{
+	if (Ref[Handler].Active)
+		Ref_Remove(Handler);
+	Ref[Handler].Active = true;
+	Ref[Handler].Cycles = INT_CONVERT_TO_INTERNAL((int64_t)CycleTime, CycleType) + CycleOffset;
+	Ref[Handler].Cycles += INT_CONVERT_TO_INTERNAL(Cycles_GetClockCounterImmediate(), INT_CPU_CYCLE);
+	Ref_InsertInt(Handler);
+}
+
+static int Ref_GetActiveInt(void)
+{
+	return Ref_ActiveInt;
+}
+
+
+/*-----------------------------------------------------------------------*/
+/* Functions used by the replay, for both implementations */
+
+typedef struct
+{
+	const char *name;
+	void	(*Reset)(void);
+	void	(*Acknowledge)(void);
+	void	(*AddRelative)(int CycleTime, int CycleType, interrupt_id Handler, int CycleOffset);
+	void	(*Remove)(interrupt_id Handler);
+	int	(*GetActiveInt)(void);
+} QUEUE;
+
+static const QUEUE QueueHeap =
+{
+	"heap", CycInt_Reset, CycInt_AcknowledgeInterrupt,
+	CycInt_AddRelativeInterruptWithOffset, CycInt_RemovePendingInterrupt,
+	CycInt_GetActiveInt
+};
+
+static const QUEUE QueueList =
+{
+	"list", Ref_Reset, Ref_Acknowledge, Ref_AddRelative, Ref_Remove,
+	Ref_GetActiveInt
+};
+
+
+/*-----------------------------------------------------------------------*/
+/* Recorded events */
+
+typedef struct
+{
+	char	Op;				/* 'a'dd, 'r'emove or ac'k'nowledge */
+	int	IntId;
+	uint64_t Cycles;			/* Internal cycles for 'a' */
+} EVENT;
+
+static EVENT	Events[MAX_EVENTS];
+static int	EventsCount;
+
+static bool Trace_Load(const char *filename)
+{
+	char line[128];
+	int64_t cycles, last = 0;
+	FILE *fp;
+	EVENT *ev;
+
+	fp = fopen(filename, "r");
+	if (!fp)
+	{
+		perror(filename);
+		return false;
+	}
+	while (fgets(line, sizeof(line), fp) && EventsCount < MAX_EVENTS)
+	{
+		if (line[0] == '#' || line[0] == '\n')
+			continue;
+		ev = &Events[EventsCount];
+		ev->Op = line[0];
+		cycles = 0;
+		if (sscanf(line + 1, "%d %"SCNd64, &ev->IntId, &cycles) < 1
+		    || ev->IntId < 0 || ev->IntId >= MAX_INTERRUPTS
+		    || (ev->Op != 'a' && ev->Op != 'r' && ev->Op != 'k'))
+		{
+			fprintf(stderr, "%s: bad line '%s'\n", filename, line);
+			fclose(fp);
+			return false;
+		}
+		last += cycles;
+		ev->Cycles = last;
+		EventsCount++;
+	}
+	fclose(fp);
+	return EventsCount > 0;
+}
+
+/* Replay events 'first' to 'last' and return the hash of the active ints */
+static uint64_t Replay(const QUEUE *q, int first, int last)
+{
+	uint64_t hash = 0;
+	const EVENT *ev;
+	int i;
+
+	for (i = first; i < last; i++)
+	{
+		ev = &Events[i];
+		switch (ev->Op)
+		{
+		 case 'a':
+			CyclesGlobalClockCounter = ev->Cycles >> CYCINT_SHIFT;
+			q->AddRelative(0, INT_CPU_CYCLE, ev->IntId,
+			               ev->Cycles & ((1 << CYCINT_SHIFT) - 1));
+			break;
+		 case 'r':
+			q->Remove(ev->IntId);
+			break;
+		 case 'k':
+			q->Acknowledge();
+			break;
+		}
+		hash = (hash ^ q->GetActiveInt()) * 0x100000001b3ULL;
+	}
+	return hash;
+}
+
+
+/*-----------------------------------------------------------------------*/
+/* Checks */
+
+/* Replay both implementations side by side, the active int must be the */
+/* recorded one after each 'k', and all the ints must be in the same order */
+static int Check_Replay(void)
+{
+	int IntList[MAX_INTERRUPTS + 1];
+	int i, j, n, count, errors = 0;
+
+	QueueHeap.Reset();
+	QueueList.Reset();
+	for (i = 0; i < EventsCount && errors < 10; i++)
+	{
+		Replay(&QueueHeap, i, i + 1);
+		Replay(&QueueList, i, i + 1);
+
+		if (Events[i].Op == 'k' && CycInt_GetActiveInt() != Events[i].IntId)
+		{
+			fprintf(stderr, "Event %d: active int %d instead of %d\n",
+			        i, CycInt_GetActiveInt(), Events[i].IntId);
+			errors++;
+		}
+
+		count = CycInt_GetSortedInts(IntList);
+		for (j = 0, n = Ref_ActiveInt; j < count; j++, n = Ref[n].IntList_Next)
+		{
+			if (IntList[j] != n)
+			{
+				fprintf(stderr, "Event %d: int %d at position %d instead of %d\n",
+				        i, IntList[j], j, n);
+				errors++;
+				break;
+			}
+		}
+		if (j == count && n >= 0)
+		{
+			fprintf(stderr, "Event %d: only %d ints\n", i, count);
+			errors++;
+		}
+	}
+	return errors;
+}
+
+/* The snapshot must be the same as the list of the reference, and */
+/* restoring it must give the same active ints */
+static int Check_Snapshot(void)
+{
+	int i, pos, prev, next, errors = 0;
+	int half = EventsCount / 2;
+	uint64_t hash;
+
+	QueueHeap.Reset();
+	QueueList.Reset();
+	Replay(&QueueHeap, 0, half);
+	Replay(&QueueList, 0, half);
+
+	SnapshotSave = true;
+	SnapshotPos = 0;
+	CycInt_MemorySnapShot_Capture(true);
+
+	pos = 0;
+	for (i = 0; i < MAX_INTERRUPTS; i++)
+	{
+		/* Active, Cycles, IntList_Prev, IntList_Next, handler ID */
+		pos += sizeof(bool) + sizeof(uint64_t);
+		memcpy(&prev, &Snapshot[pos], sizeof(int));
+		memcpy(&next, &Snapshot[pos + sizeof(int)], sizeof(int));
+		pos += 3 * sizeof(int);
+
+		if (Ref[i].Active && (prev != Ref[i].IntList_Prev || next != Ref[i].IntList_Next))
+		{
+			fprintf(stderr, "Snapshot: int %d prev/next %d/%d instead of %d/%d\n",
+			        i, prev, next, Ref[i].IntList_Prev, Ref[i].IntList_Next);
+			errors++;
+		}
+	}
+
+	hash = Replay(&QueueHeap, half, EventsCount);
+
+	CycInt_Reset();
+	SnapshotSave = false;
+	SnapshotPos = 0;
+	CycInt_MemorySnapShot_Capture(false);
+	if (Replay(&QueueHeap, half, EventsCount) != hash)
+	{
+		fprintf(stderr, "Different active ints after restoring snapshot\n");
+		errors++;
+	}
+	return errors;
+}
+
+static double Benchmark(const QUEUE *q, int replays, uint64_t *hash)
+{
+	clock_t start;
+	int i;
+
+	start = clock();
+	for (i = 0; i < replays; i++)
+	{
+		q->Reset();
+		*hash = Replay(q, 0, EventsCount);
+	}
+	return (double)(clock() - start) / CLOCKS_PER_SEC;
+}
+
+int main(int argc, char *argv[])
+{
+	int replays = DEFAULT_REPLAYS;
+	uint64_t hash_heap, hash_list;
+	double time_heap, time_list;
+	int errors = 0;
+
+	if (argc < 2)
+	{
+		fprintf(stderr, "Usage: %s <trace file> [replays]\n", argv[0]);
+		return 1;
+	}
+	if (!Trace_Load(argv[1]))
+		return 1;
+	if (argc > 2)
+		replays = atoi(argv[2]);
+	if (replays < 1)
+		replays = 1;
+
+	MachineClocks.CPU_Freq_Emul = 8021248 << nCpuFreqShift;
+	MachineClocks.MFP_Timer_Freq = 2457600;
+
+	errors += Check_Replay();
+	errors += Check_Snapshot();
+
+	time_list = Benchmark(&QueueList, replays, &hash_list);
+	time_heap = Benchmark(&QueueHeap, replays, &hash_heap);
+	if (hash_heap != hash_list)
+	{
+		fprintf(stderr, "Different active ints between heap and list\n");
+		errors++;
+	}
+
+	printf("%d x %d events: %s %.3fs, %s %.3fs\n", replays, EventsCount,
+	       QueueHeap.name, time_heap, QueueList.name, time_list);
+
+	if (errors)
+	{
+		fprintf(stderr, "\n*** %d errors ***\n", errors);
+		return 1;
+	}
+	printf("\nSUCCESS\n");
+	return 0;
+}
@@ -0,0 +1,246 @@
+/*
+ * Test and benchmark for the STE / TT LMC1992 tone and volume chain (lmc1992.c)
+ *
+ * Random samples and loud square waves are filtered with the scalar code
+ * and each SIMD kernel supported by the host cpu, for several bass /
+ * treble / volume settings with and without the subsonic high pass filter.
+ * The result must match the per sample code previously used in dmaSnd.c
+ * within LMC1992_TOLERANCE, also when the signal is split in blocks of
+ * different sizes.
+ * The filtering speed is shown in stereo samples per second.
+ *
+ * Usage: test-lmc1992 [number of stereo samples for the benchmark]
+ */
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "main.h"
+#include "lmc1992.h"
+#include "simd_test.h"
+
+#define	DEFAULT_BENCH	20000000
+#define	SAMPLES		65536
+#define	RATE		44100.0f
+
+static const struct
+{
+	const char *name;
+	float bass_db, treble_db;	/* -12 to +12 dB */
+	double volume;			/* volume * master volume, 0 to 1 */
+	bool bHPF;
+} Settings[] =
+{
+	{ "flat, full volume", 0, 0, 1.0, true },
+	{ "bass +12 dB", 12, 0, 1.0, true },
+	{ "treble +12 dB", 0, 12, 1.0, true },
+	{ "bass / treble -12 dB", -12, -12, 0.5, true },
+	{ "bass +12 dB, no HPF", 12, 6, 0.8, false },
+	{ "flat, -40 dB", 0, 0, 0.01, true },
+};
+
+static int16_t In[SAMPLES][2];
+static int16_t Out[SAMPLES][2];
+static int16_t Ref[SAMPLES][2];
+
+
+/*-----------------------------------------------------------------------*/
+/**
+ * First order bass / treble shelves and their product, as computed
+ * by DmaSnd_Init_Bass_and_Treble_Tables() / DmaSnd_Set_Tone_Level()
+ */
+static void Tone_Coefs(float coef[5], float bass_db, float treble_db)
+{
+	float g, t, ba1, bb0, bb1, ta1, tb0, tb1;
+
+	g = powf(10.0, bass_db/20.0);
+	t = tanf(M_PI*118.2763f/RATE);
+	ba1 = g < 1.0 ? (t - g) / (t + g) : (t - 1.0) / (t + 1.0);
+	bb0 = (1.0 + ba1) * (g - 1.0) / 2.0 + 1.0;
+	bb1 = (1.0 + ba1) * (g - 1.0) / 2.0 + ba1;
+
+	g = powf(10.0, treble_db/20.0);
+	t = tanf(M_PI*8438.756f/RATE);
+	ta1 = g < 1.0 ? (g*t - 1.0) / (g*t + 1.0) : (t - 1.0) / (t + 1.0);
+	tb0 = 1.0 + (1.0 - ta1) * (g - 1.0) / 2.0;
+	tb1 = ta1 + (ta1 - 1.0) * (g - 1.0) / 2.0;
+
+	coef[0] = ta1 + ba1;
+	coef[1] = ta1 * ba1;
+	coef[2] = tb0 * bb0;
+	coef[3] = tb0 * bb1 + tb1 * bb0;
+	coef[4] = tb1 * bb1;
+}
+
+
+/**
+ * Reference : subsonic high pass filter and biquad of one channel,
+ * one sample at a time (as in sound.c and dmaSnd.c before lmc1992.c)
+ */
+static int16_t Ref_Sample(const LMC1992_CHAIN *set, int c, int16_t x0)
+{
+	static int32_t x1[2], y1[2], y0[2];
+	static float data[2][2];
+	float a, yn;
+	int32_t sample;
+
+	if (!set)
+	{
+		memset(x1, 0, sizeof(x1));
+		memset(y1, 0, sizeof(y1));
+		memset(y0, 0, sizeof(y0));
+		memset(data, 0, sizeof(data));
+		return 0;
+	}
+
+	if (set->bHPF)
+	{
+		y1[c] += ((x0 - x1[c]) * 32768) - (y0[c] * 64);
+		y0[c] = y1[c] / 32768;
+		x1[c] = x0;
+		x0 = y0[c];
+	}
+
+	a  = set->gain[c] * x0;
+	a -= set->coef[0] * data[c][0];
+	a -= set->coef[1] * data[c][1];
+	yn  = set->coef[2] * a;
+	yn += set->coef[3] * data[c][0];
+	yn += set->coef[4] * data[c][1];
+	data[c][1] = data[c][0];
+	data[c][0] = a;
+
+	sample = yn;
+	if (sample < -32767)
+		sample = -32767;
+	else if (sample > 32767)
+		sample = 32767;
+	return sample;
+}
+
+
+/**
+ * Fill the input with random samples, then loud square waves with
+ * a DC offset (to clip the boosted bass and to move the HPF)
+ */
+static void Fill_Input(void)
+{
+	int i;
+
+	SimdTest_RandomSamples(&In[0][0], SAMPLES);
+	for (i = SAMPLES / 2; i < SAMPLES; i++)
+	{
+		In[i][0] = (i / 300) & 1 ? 30000 : -20000;
+		In[i][1] = (i / 77) & 1 ? -32768 : 32767;
+	}
+}
+
+
+/**
+ * Init the chain's settings for Settings[idx], with a cleared state
+ */
+static void Init_Chain(LMC1992_CHAIN *lc, int idx)
+{
+	memset(lc, 0, sizeof(*lc));
+	Tone_Coefs(lc->coef, Settings[idx].bass_db, Settings[idx].treble_db);
+	/* Gains are doubled in dmaSnd.c, DMA samples being at half level */
+	lc->gain[0] = Settings[idx].volume * 2;
+	lc->gain[1] = Settings[idx].volume * 1.5;
+	lc->bHPF = Settings[idx].bHPF;
+}
+
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Compare the kernel of 'level' with the reference code for Settings[idx]
+ */
+static int Check_Level(int level, int idx)
+{
+	LMC1992_CHAIN lc;
+	int i, c, n, len, diff, max_diff = 0, errors = 0;
+
+	Init_Chain(&lc, idx);
+	Ref_Sample(NULL, 0, 0);
+	for (i = 0; i < SAMPLES; i++)
+		for (c = 0; c < 2; c++)
+			Ref[i][c] = Ref_Sample(&lc, c, In[i][c]);
+
+	/* Blocks of 1 to 1000 samples, the state must be kept between them */
+	memcpy(Out, In, sizeof(Out));
+	for (i = 0, len = 1; i < SAMPLES; i += n, len = len * 7 % 1000 + 1)
+	{
+		n = SAMPLES - i < len ? SAMPLES - i : len;
+		Lmc1992_Filter(&lc, &Out[i], n);
+	}
+
+	for (i = 0; i < SAMPLES; i++)
+	{
+		for (c = 0; c < 2; c++)
+		{
+			diff = abs(Out[i][c] - Ref[i][c]);
+			if (diff > max_diff)
+				max_diff = diff;
+			if (diff > LMC1992_TOLERANCE && errors++ < 10)
+				fprintf(stderr, "%s / %s: sample %d/%d is %d instead of %d\n",
+				        Simd_Name(level), Settings[idx].name, i, c,
+				        Out[i][c], Ref[i][c]);
+		}
+	}
+
+	printf("%-6s %-22s : max difference %d\n", Simd_Name(level),
+	       Settings[idx].name, max_diff);
+	return errors;
+}
+
+
+/**
+ * Show the filtering speed with the kernel of 'level'
+ */
+static void Benchmark_Level(int level, int samples)
+{
+	LMC1992_CHAIN lc;
+	int done = 0;
+	clock_t start;
+
+	Init_Chain(&lc, 1);
+	memcpy(Out, In, sizeof(Out));
+
+	start = clock();
+	while (done < samples)
+	{
+		/* Same size as a 44.1 kHz VBL */
+		Lmc1992_Filter(&lc, Out, 882);
+		done += 882;
+	}
+
+	SimdTest_ShowSpeed(level, Settings[1].name, done, start);
+}
+
+
+int main(int argc, char *argv[])
+{
+	int bench = DEFAULT_BENCH;
+	int level, idx, errors = 0;
+
+	if (argc > 1)
+		bench = atoi(argv[1]);
+
+	Fill_Input();
+
+	SIMDTEST_FOR_EACH_LEVEL(level, SIMD_NONE, Lmc1992_Init)
+	{
+		for (idx = 0; idx < ARRAY_SIZE(Settings); idx++)
+			errors += Check_Level(level, idx);
+	}
+
+	printf("\nFiltering speed:\n");
+	SIMDTEST_FOR_EACH_LEVEL(level, SIMD_NONE, Lmc1992_Init)
+		Benchmark_Level(level, bench);
+
+	return SimdTest_Result(errors);
+}
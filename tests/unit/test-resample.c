@@ -0,0 +1,236 @@
+/*
+ * Test and benchmark for the polyphase sample rate conversion (resample.c)
+ *
+ * For the YM2149, DMA sound and crossbar rates, a sweep of sine tones is
+ * converted to the host rate : tones in the pass band must keep their
+ * level, tones above the output's Nyquist frequency (which alias with the
+ * averaging resamplers) must be attenuated by at least 70 dB.
+ * Random samples are converted with the scalar code and each SIMD kernel
+ * supported by the host cpu, the result must be the same as a direct
+ * computation of the filter (also when the filter's samples cross the
+ * end of the ring buffer).
+ * The conversion speed is shown in output samples per second.
+ *
+ * Usage: test-resample [number of output samples for the benchmark]
+ */
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "main.h"
+#include "resample.h"
+#include "simd_test.h"
+
+#define	DEFAULT_BENCH	2000000
+#define	RING_BITS	16
+#define	RING_SIZE	( 1 << RING_BITS )
+#define	RING_MASK	( RING_SIZE - 1 )
+#define	SWEEP_TONES	48
+#define	AMPLITUDE	16000
+
+static const struct
+{
+	const char *name;
+	int in_rate, out_rate;
+} Rates[] =
+{
+	{ "YM2149 250 kHz -> 44100", 250000, 44100 },
+	{ "YM2149 250 kHz -> 48000", 250000, 48000 },
+	{ "YM2149 250 kHz -> 22050", 250000, 22050 },
+	{ "DMA 50066 -> 44100", 50066, 44100 },
+	{ "DMA 12517 -> 48000", 12517, 48000 },
+	{ "Crossbar 49170 -> 44100", 49170, 44100 },
+	{ "Crossbar 24585 -> 44100", 24585, 44100 },
+};
+
+static int16_t Ring[RING_SIZE];
+static int16_t Out[RING_SIZE];
+
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Convert the whole ring, return the number of output samples
+ */
+static int Convert_Ring(RESAMPLE_FILTER *rf, int read)
+{
+	uint32_t frac = 0;
+
+	return Resample_Block(rf, Ring, RING_MASK, &read, &frac,
+	                      RING_SIZE - read - 1, Out, RING_SIZE);
+}
+
+
+/**
+ * Return the gain in dB for a sine of 'freq' Hz converted with 'rf'
+ */
+static double Tone_Gain(RESAMPLE_FILTER *rf, double freq)
+{
+	double in = 0, out = 0;
+	int i, n, skip;
+
+	for (i = 0; i < RING_SIZE; i++)
+		Ring[i] = lrint(AMPLITUDE * sin(2 * M_PI * freq * i / rf->in_rate));
+
+	/* Skip the outputs using the start of the ring (not yet filled) */
+	n = Convert_Ring(rf, rf->taps);
+	skip = n / 8;
+	for (i = skip; i < n; i++)
+		out += (double)Out[i] * Out[i];
+	out /= n - skip;
+	in = AMPLITUDE * AMPLITUDE / 2.0;
+
+	return 10 * log10(out / in + 1e-20);
+}
+
+
+/**
+ * Check the pass band level and the aliasing for a sweep of tones
+ */
+static int Check_Sweep(int idx)
+{
+	RESAMPLE_FILTER rf = { 0 };
+	double low, freq, gain, ripple = 0, alias = -200;
+	int i, errors = 0;
+
+	Resample_SetRates(&rf, Rates[idx].in_rate, Rates[idx].out_rate);
+	low = Rates[idx].in_rate < Rates[idx].out_rate ? Rates[idx].in_rate : Rates[idx].out_rate;
+
+	/* Logarithmic sweep from 50 Hz up to the input's Nyquist frequency */
+	for (i = 0; i < SWEEP_TONES; i++)
+	{
+		freq = 50 * pow(Rates[idx].in_rate * 0.49 / 50, (double)i / (SWEEP_TONES - 1));
+		gain = Tone_Gain(&rf, freq);
+
+		if (freq <= 0.4 * low)
+		{
+			if (fabs(gain) > fabs(ripple))
+				ripple = gain;
+			if (fabs(gain) > 0.1)
+			{
+				fprintf(stderr, "%s: %.0f Hz pass band gain %.2f dB\n",
+				        Rates[idx].name, freq, gain);
+				errors++;
+			}
+		}
+		else if (freq >= 0.6 * low)
+		{
+			if (gain > alias)
+				alias = gain;
+			if (gain > -70)
+			{
+				fprintf(stderr, "%s: %.0f Hz stop band gain %.2f dB\n",
+				        Rates[idx].name, freq, gain);
+				errors++;
+			}
+		}
+	}
+
+	printf("%s : %d taps, pass band %+.3f dB", Rates[idx].name, rf.taps, ripple);
+	if (alias > -200)
+		printf(", aliasing %.1f dB", alias);
+	printf("\n");
+	Resample_Free(&rf);
+	return errors;
+}
+
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Compare the kernel of 'level' with a direct computation of the filter
+ * for random samples, starting near the end of the ring to check the
+ * wrap around
+ */
+static int Check_Level(int level, int idx)
+{
+	RESAMPLE_FILTER rf = { 0 };
+	const int16_t *c;
+	uint32_t frac, ref_frac;
+	int read, ref_read, n, i, t, errors = 0;
+	int32_t sum;
+
+	SimdTest_RandomSamples(Ring, RING_SIZE);
+	Resample_Init(level);
+	Resample_SetRates(&rf, Rates[idx].in_rate, Rates[idx].out_rate);
+
+	read = ref_read = RING_SIZE - 100;
+	frac = ref_frac = 0x12345678;
+	n = Resample_Block(&rf, Ring, RING_MASK, &read, &frac, RING_SIZE / 2, Out, RING_SIZE);
+
+	for (i = 0; i < n && errors < 10; i++)
+	{
+		c = rf.coefs + (ref_frac >> (32 - RESAMPLE_PHASES_BITS)) * rf.taps;
+		sum = 0;
+		for (t = 0; t < rf.taps; t++)
+			sum += Ring[(ref_read - rf.taps + 1 + t) & RING_MASK] * c[t];
+		sum = (sum + 0x4000) >> 15;
+		sum = sum > 32767 ? 32767 : sum < -32768 ? -32768 : sum;
+
+		if (Out[i] != sum)
+		{
+			fprintf(stderr, "%s / %s: sample %d is %d instead of %d\n",
+			        Simd_Name(level), Rates[idx].name, i, Out[i], sum);
+			errors++;
+		}
+
+		ref_read = (ref_read + (int)((ref_frac + rf.step) >> 32)) & RING_MASK;
+		ref_frac += rf.step;
+	}
+
+	Resample_Free(&rf);
+	return errors;
+}
+
+
+/**
+ * Show the conversion speed with the kernel of 'level'
+ */
+static void Benchmark_Level(int level, int idx, int samples)
+{
+	RESAMPLE_FILTER rf = { 0 };
+	uint32_t frac = 0;
+	int read = 0, done = 0;
+	clock_t start;
+
+	Resample_Init(level);
+	Resample_SetRates(&rf, Rates[idx].in_rate, Rates[idx].out_rate);
+
+	start = clock();
+	while (done < samples)
+		done += Resample_Block(&rf, Ring, RING_MASK, &read, &frac, RING_SIZE / 2, Out, 1024);
+
+	SimdTest_ShowSpeed(level, Rates[idx].name, done, start);
+	Resample_Free(&rf);
+}
+
+
+int main(int argc, char *argv[])
+{
+	int bench = DEFAULT_BENCH;
+	int level, idx, errors = 0;
+
+	if (argc > 1)
+		bench = atoi(argv[1]);
+
+	Resample_Init(SIMD_NONE);
+	for (idx = 0; idx < ARRAY_SIZE(Rates); idx++)
+		errors += Check_Sweep(idx);
+
+	SIMDTEST_FOR_EACH_LEVEL(level, SIMD_NONE, Resample_Init)
+	{
+		for (idx = 0; idx < ARRAY_SIZE(Rates); idx++)
+			errors += Check_Level(level, idx);
+	}
+
+	printf("\nConversion speed:\n");
+	SIMDTEST_FOR_EACH_LEVEL(level, SIMD_NONE, Resample_Init)
+	{
+		for (idx = 0; idx < ARRAY_SIZE(Rates); idx++)
+			Benchmark_Level(level, idx, bench);
+	}
+
+	return SimdTest_Result(errors);
+}
@@ -0,0 +1,536 @@
+/*
+ * Test and micro benchmark for the YM2149 synthesis at 250 kHz (sound.c)
+ *
+ * The same register writes are replayed with the generator stepping all
+ * counters on every 250 kHz cycle, with the generator going from one
+ * counter event to the next one, and with the default adaptive events
+ * method (stepping all cycles when the events are too close) : the
+ * YM_Buffer_250 samples must be the same, with each low pass filter.
+ * The songs are also played with the synthesis thread (the log of register
+ * writes is only replayed when the emulation needs the samples) : the
+ * samples at the output frequency must be the same as without the thread,
+ * also while DMA sound plays (each register write needs the samples).
+ * The number of thread wakeups and syncs is shown.
+ * When the samples are not read (like when the audio callback is late),
+ * the played ones must be the first samples, the new ones being dropped
+ * once the buffer is full instead of written over the unplayed ones.
+ *
+ * The register writes come from .ym files saved by Hatari (ymFormat.c,
+ * uncompressed "YM3!" format, written at the start of each VBL), or if no
+ * file is given from generated songs (tones, noise, envelopes, sync-buzzer,
+ * digi sound and writes at random cycles).
+ *
+ * Usage: test-ym2149 [file.ym ...]
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "main.h"
+#include "configuration.h"
+#include "audio.h"
+#include "avi_record.h"
+#include "clocks_timings.h"
+#include "crossbar.h"
+#include "dmaSnd.h"
+#include "file.h"
+#include "log.h"
+#include "memorySnapShot.h"
+#include "sound.h"
+#include "wavFormat.h"
+#include "ymFormat.h"
+
+#define	SONG_FRAMES	200
+#define	MAX_FRAMES	1500		/* 30 seconds of .ym file */
+#define	MAX_WRITES	(SONG_FRAMES * 200)
+#define	YM_BUFFER_250_SIZE	32768
+
+
+/* Fake emulator */
+CNF_PARAMS ConfigureParams;
+uint64_t CyclesGlobalClockCounter;
+int nCpuFreqShift;
+int nScreenRefreshRate = 50;
+int SoundBufferSize = 1024;
+bool bSoundWorking, bRecordingWav, bRecordingYM;
+
+void Log_Printf(LOGTYPE nType, const char *psFormat, ...) { }
+void Log_AlertDlg(LOGTYPE nType, const char *psFormat, ...) { }
+void MemorySnapShot_Store(void *pData, int Size) { }
+void Audio_Init(void) { }
+void Audio_UnInit(void) { }
+void Audio_NewSamples(void) { }
+static int SynthWakeups, SynthWaits;
+bool Audio_StartSynthThread(void) { return true; }
+void Audio_StopSynthThread(void) { }
+void Audio_WakeSynthThread(void) { SynthWakeups++; }
+void Audio_WaitSynthThread(void) { SynthWaits++; Sound_RunSynthLog(); }
+bool Avi_AreWeRecording(void) { return false; }
+bool Avi_RecordAudioStream(int16_t pSamples[][2], int SampleIndex, int SampleLength) { return true; }
+void Crossbar_Compute_Ratio(void) { }
+void Crossbar_GenerateSamples(int nMixBufIdx, int nSamplesToGenerate) { }
+void DmaSnd_GenerateSamples(int nMixBufIdx, int nSamplesToGenerate) { }
+void DmaSnd_Init_Bass_and_Treble_Tables(void) { }
+static bool DmaPlaying;
+bool DmaSnd_IsPlaying(void) { return DmaPlaying; }
+bool File_DoesFileExtensionMatch(const char *psName, const char *psExtension) { return false; }
+bool WAVFormat_OpenFile(char *pszWavFileName) { return false; }
+void WAVFormat_CloseFile(void) { }
+void WAVFormat_Update(int16_t pSamples[][2], int Index, int Length) { }
+bool YMFormat_BeginRecording(const char *filename) { return false; }
+void YMFormat_EndRecording(void) { }
+
+extern ymsample YM_Buffer_250[YM_BUFFER_250_SIZE];
+
+
+/*-----------------------------------------------------------------------*/
+
+typedef struct
+{
+	uint32_t cycle;			/* CPU cycle since the start of the song */
+	uint8_t reg, data;
+} WRITE;
+
+typedef struct
+{
+	char name[64];
+	WRITE *writes;
+	int count;
+	uint32_t length;		/* in CPU cycles */
+} SONG;
+
+static uint32_t Seed = 1;
+static uint32_t CyclesPerVBL;
+
+static uint32_t Random(void)
+{
+	Seed = Seed * 1103515245 + 12345;
+	return Seed >> 8;
+}
+
+static void Song_Write(SONG *song, uint32_t cycle, int reg, int data)
+{
+	if (song->count < MAX_WRITES)
+	{
+		song->writes[song->count].cycle = cycle;
+		song->writes[song->count].reg = reg;
+		song->writes[song->count].data = data;
+		song->count++;
+	}
+}
+
+static bool Song_Init(SONG *song, const char *name)
+{
+	snprintf(song->name, sizeof(song->name), "%s", name);
+	song->writes = malloc(sizeof(WRITE) * MAX_WRITES);
+	song->count = 0;
+	song->length = SONG_FRAMES * CyclesPerVBL;
+	return song->writes != NULL;
+}
+
+/* Registers of a .ym file saved by Hatari, one set per VBL */
+static bool Song_LoadYM(SONG *song, const char *filename)
+{
+	FILE *f;
+	uint8_t *data;
+	long size;
+	int frames, frame, reg;
+
+	f = fopen(filename, "rb");
+	if (!f)
+		return false;
+	fseek(f, 0, SEEK_END);
+	size = ftell(f);
+	rewind(f);
+	data = malloc(size);
+	if (!data || fread(data, 1, size, f) != (size_t)size
+	    || size < 4 || memcmp(data, "YM3!", 4) != 0)
+	{
+		fprintf(stderr, "%s: not an uncompressed YM3 file\n", filename);
+		fclose(f);
+		free(data);
+		return false;
+	}
+	fclose(f);
+
+	frames = (size - 4) / 14;
+	if (frames > MAX_FRAMES)
+		frames = MAX_FRAMES;
+	if (!Song_Init(song, filename))
+		return false;
+	song->length = frames * CyclesPerVBL;
+	for (frame = 0; frame < frames; frame++)
+	{
+		for (reg = 0; reg < 14; reg++)
+		{
+			uint8_t val = data[4 + reg * frames + frame];
+			if (reg == 13 && val == 0xff)
+				continue;
+			Song_Write(song, frame * CyclesPerVBL + reg * 8, reg, val);
+		}
+	}
+	free(data);
+	return true;
+}
+
+/* Music like songs : notes with tone/noise/env, registers written each VBL */
+static void Song_Music(SONG *song)
+{
+	int frame, reg;
+	uint32_t cycle;
+
+	Song_Init(song, "music");
+	for (frame = 0; frame < SONG_FRAMES; frame++)
+	{
+		cycle = frame * CyclesPerVBL;
+		if (frame % 4 == 0)
+		{
+			for (reg = 0; reg < 6; reg += 2)
+			{
+				Song_Write(song, cycle + reg * 8, reg, Random() % 256);
+				Song_Write(song, cycle + reg * 8 + 8, reg + 1, Random() % 4);
+			}
+			Song_Write(song, cycle + 48, 6, Random() % 32);
+			Song_Write(song, cycle + 56, 7, 0x38 | (Random() & 0x3f));
+		}
+		for (reg = 8; reg < 11; reg++)
+			Song_Write(song, cycle + reg * 8, reg, Random() % 32);
+		Song_Write(song, cycle + 200, 11, Random() % 256);
+		Song_Write(song, cycle + 208, 12, Random() % 4);
+		if (frame % 16 == 0)
+			Song_Write(song, cycle + 216, 13, Random() % 16);
+	}
+}
+
+/* Sync-buzzer : the envelope is restarted several times per VBL */
+static void Song_SyncBuzzer(SONG *song)
+{
+	int frame, i;
+	uint32_t cycle;
+
+	Song_Init(song, "sync-buzzer");
+	Song_Write(song, 0, 7, 0x3f);
+	Song_Write(song, 8, 8, 0x10);
+	Song_Write(song, 16, 9, 0x10);
+	for (frame = 0; frame < SONG_FRAMES; frame++)
+	{
+		cycle = frame * CyclesPerVBL;
+		Song_Write(song, cycle, 11, Random() % 64);
+		Song_Write(song, cycle + 8, 12, 0);
+		for (i = 0; i < 20; i++)
+			Song_Write(song, cycle + 100 + i * (CyclesPerVBL / 21), 13, 8 + Random() % 8);
+	}
+}
+
+/* Digi sound : a volume written at ~ 8 kHz, other voices with small periods */
+static void Song_Digi(SONG *song)
+{
+	uint32_t cycle;
+
+	Song_Init(song, "digi");
+	Song_Write(song, 0, 7, 0x3c);
+	Song_Write(song, 8, 2, 1);
+	Song_Write(song, 16, 4, 0);
+	Song_Write(song, 24, 9, 10);
+	Song_Write(song, 32, 10, 12);
+	for (cycle = 64; cycle < song->length; cycle += 1000)
+		Song_Write(song, cycle, 8, Random() % 16);
+}
+
+/* Writes at random cycles to any register, with small and zero periods */
+static void Song_Random(SONG *song)
+{
+	uint32_t cycle = 0;
+	int reg, val;
+
+	Song_Init(song, "random writes");
+	while (song->count < MAX_WRITES)
+	{
+		cycle += Random() % 4000;
+		if (cycle >= song->length)
+			break;
+		reg = Random() % 14;
+		val = Random() % 256;
+		if (reg < 6 || reg == 11 || reg == 12)
+			val %= (Random() % 2) ? 4 : 256;
+		Song_Write(song, cycle, reg, val);
+	}
+}
+
+/* Long steady tones, mostly the case of silent or sustained voices */
+static void Song_Steady(SONG *song)
+{
+	int frame;
+
+	Song_Init(song, "steady");
+	Song_Write(song, 0, 7, 0x3e);
+	Song_Write(song, 8, 0, 0x1c);
+	Song_Write(song, 16, 1, 0x1);
+	for (frame = 0; frame < SONG_FRAMES; frame++)
+		Song_Write(song, frame * CyclesPerVBL + 24, 8, frame % 64 < 32 ? 15 : 0);
+}
+
+/*-----------------------------------------------------------------------*/
+
+/* Replay the song and return the 250 kHz samples in 'out' */
+static int Play_Song(const SONG *song, int method, ymsample *out, int size)
+{
+	static int16_t played[1024][2];		/* Samples read like the audio callback */
+	CLOCKS_CYCLES_STRUCT conv = { 0, 0 };
+	uint64_t prev = 0;
+	int i, pos = 0, count = 0, n;
+
+	YM2149_Synth_Method = method;
+	CyclesGlobalClockCounter = 0;
+	Sound_Init();
+
+	for (i = 0; i <= song->count; i++)
+	{
+		uint64_t clock = i < song->count ? song->writes[i].cycle : song->length;
+
+		Sound_Update(clock);
+		while (Sound_ReadSamples(played, ARRAY_SIZE(played)) > 0)
+			;
+
+		/* Copy the new samples of the ring buffer */
+		ClocksTimings_ConvertCycles(clock - prev, MachineClocks.CPU_Freq_Emul,
+		                            &conv, MachineClocks.YM_Freq / 8);
+		prev = clock;
+		for (n = conv.Cycles; n > 0 && count < size; n--)
+		{
+			out[count++] = YM_Buffer_250[pos];
+			pos = (pos + 1) % YM_BUFFER_250_SIZE;
+		}
+
+		if (i < song->count)
+			Sound_WriteReg(song->writes[i].reg, song->writes[i].data);
+	}
+	return count;
+}
+
+/* Replay the song like the emulation (register writes and VBLs) and */
+/* return the samples at the output frequency in 'out'. If 'bRead' is */
+/* false, the samples are only read at the end of the song */
+static int Play_Output(const SONG *song, bool threaded, bool bRead, int16_t (*out)[2], int size)
+{
+	uint64_t vbl = CyclesPerVBL;
+	int i, count = 0;
+
+	/* Start from an empty buffer (with only the initial silence) */
+	while (Sound_ReadSamples(out, size) > 0)
+		;
+
+	/* The state of the subsonic filter can't be reset between songs */
+	YM2149_HPF_Filter = YM2149_HPF_FILTER_NONE;
+	YM2149_Synth_Method = YM2149_SYNTH_METHOD_EVENTS;
+	CyclesGlobalClockCounter = 0;
+	Sound_SetSynthThread(threaded);
+	Sound_Init();
+
+	for (i = 0; i <= song->count; i++)
+	{
+		uint64_t clock = i < song->count ? song->writes[i].cycle : song->length;
+
+		while (vbl <= clock)
+		{
+			Sound_Update(vbl);
+			vbl += CyclesPerVBL;
+			if (bRead)
+				count += Sound_ReadSamples(out + count, size - count);
+		}
+
+		Sound_UpdateYM(clock);
+		if (i < song->count)
+			Sound_WriteReg(song->writes[i].reg, song->writes[i].data);
+	}
+	Sound_Update(song->length);
+	count += Sound_ReadSamples(out + count, size - count);
+
+	Sound_SetSynthThread(false);
+	YM2149_HPF_Filter = YM2149_HPF_FILTER_IIR;
+	return count;
+}
+
+static int Check_Thread(const SONG *song, bool dma, int16_t (*ref)[2], int16_t (*out)[2], int size)
+{
+	const char *mode = dma ? "thread, DMA" : "thread";
+	int count_ref, count, i;
+
+	DmaPlaying = dma;
+	count_ref = Play_Output(song, false, true, ref, size);
+	SynthWakeups = SynthWaits = 0;
+	count = Play_Output(song, true, true, out, size);
+	DmaPlaying = false;
+
+	if (count != count_ref)
+	{
+		fprintf(stderr, "%s (%s): %d samples instead of %d\n",
+		        song->name, mode, count, count_ref);
+		return 1;
+	}
+	for (i = 0; i < count; i++)
+	{
+		if (out[i][0] != ref[i][0] || out[i][1] != ref[i][1])
+		{
+			fprintf(stderr, "%s (%s): sample %d is %d instead of %d\n",
+			        song->name, mode, i, out[i][0], ref[i][0]);
+			return 1;
+		}
+	}
+	printf("%s (%s): %d samples, %d register writes, %d wakeups, %d syncs\n",
+	       song->name, mode, count, song->count, SynthWakeups, SynthWaits);
+	return 0;
+}
+
+static int Check_Overrun(const SONG *song, int16_t (*ref)[2], int16_t (*out)[2], int size)
+{
+	int count_ref, count, i;
+
+	count_ref = Play_Output(song, false, true, ref, size);
+	count = Play_Output(song, false, false, out, size);
+
+	if (count != (count_ref < AUDIOMIXBUFFER_SIZE ? count_ref : AUDIOMIXBUFFER_SIZE))
+	{
+		fprintf(stderr, "%s (overrun): %d samples played instead of %d\n",
+		        song->name, count, AUDIOMIXBUFFER_SIZE);
+		return 1;
+	}
+	for (i = 0; i < count; i++)
+	{
+		if (out[i][0] != ref[i][0] || out[i][1] != ref[i][1])
+		{
+			fprintf(stderr, "%s (overrun): sample %d is %d instead of %d\n",
+			        song->name, i, out[i][0], ref[i][0]);
+			return 1;
+		}
+	}
+	printf("%s (overrun): %d first samples of %d played\n",
+	       song->name, count, count_ref);
+	return 0;
+}
+
+/* Replay the song with the events method (always going from one event */
+/* to the next if 'min_run' is 0) and compare the samples with 'ref' */
+static int Check_Events(const SONG *song, const char *filter, int min_run,
+                        const ymsample *ref, int count_ref, ymsample *out,
+                        int size, double *time)
+{
+	clock_t start;
+	int i, count;
+
+	YM2149_Synth_MinRun = min_run;
+	start = clock();
+	count = Play_Song(song, YM2149_SYNTH_METHOD_EVENTS, out, size);
+	*time = (double)(clock() - start) / CLOCKS_PER_SEC;
+	YM2149_Synth_MinRun = YM2149_SYNTH_MIN_RUN;
+
+	if (count != count_ref)
+	{
+		fprintf(stderr, "%s (%s, min run %d): %d samples instead of %d\n",
+		        song->name, filter, min_run, count, count_ref);
+		return 1;
+	}
+	for (i = 0; i < count; i++)
+	{
+		if (out[i] != ref[i])
+		{
+			fprintf(stderr, "%s (%s, min run %d): sample %d is %d instead of %d\n",
+			        song->name, filter, min_run, i, out[i], ref[i]);
+			return 1;
+		}
+	}
+	return 0;
+}
+
+static int Check_Song(const SONG *song, ymsample *ref, ymsample *out, int size)
+{
+	static const char *filters[] = { "none", "lpf_stf", "pwm" };
+	double time_cycles, time_events, time_auto;
+	clock_t start;
+	int filter, count_ref, errors = 0;
+
+	for (filter = YM2149_LPF_FILTER_NONE; filter <= YM2149_LPF_FILTER_PWM; filter++)
+	{
+		YM2149_LPF_Filter = filter;
+
+		start = clock();
+		count_ref = Play_Song(song, YM2149_SYNTH_METHOD_CYCLES, ref, size);
+		time_cycles = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+		errors += Check_Events(song, filters[filter], 0, ref, count_ref,
+		                       out, size, &time_events);
+		errors += Check_Events(song, filters[filter], YM2149_SYNTH_MIN_RUN,
+		                       ref, count_ref, out, size, &time_auto);
+
+		printf("%s (%s): %d samples, cycles %.3fs, events %.3fs, adaptive %.3fs\n",
+		       song->name, filters[filter], count_ref, time_cycles,
+		       time_events, time_auto);
+	}
+	return errors;
+}
+
+int main(int argc, char *argv[])
+{
+	void (*generate[])(SONG *) =
+	{
+		Song_Music, Song_SyncBuzzer, Song_Digi, Song_Random, Song_Steady
+	};
+	ymsample *ref, *out;
+	SONG song;
+	int size, i, errors = 0;
+
+	ConfigureParams.System.nMachineType = MACHINE_ST;
+	ClocksTimings_InitMachine(MACHINE_ST);
+	ClocksTimings_UpdateCpuFreqEmul(MACHINE_ST, nCpuFreqShift);
+	CyclesPerVBL = ClocksTimings_GetCyclesPerVBL(MACHINE_ST, nScreenRefreshRate);
+
+	size = MAX_FRAMES * (CyclesPerVBL / 32 + 1);
+	ref = malloc(size * sizeof(ymsample));
+	out = malloc(size * sizeof(ymsample));
+	if (!ref || !out)
+		return 1;
+
+	if (argc > 1)
+	{
+		for (i = 1; i < argc; i++)
+		{
+			if (!Song_LoadYM(&song, argv[i]))
+			{
+				errors++;
+				continue;
+			}
+			errors += Check_Song(&song, ref, out, size);
+			errors += Check_Thread(&song, false, (int16_t (*)[2])ref, (int16_t (*)[2])out, size / 2);
+			errors += Check_Thread(&song, true, (int16_t (*)[2])ref, (int16_t (*)[2])out, size / 2);
+			errors += Check_Overrun(&song, (int16_t (*)[2])ref, (int16_t (*)[2])out, size / 2);
+			free(song.writes);
+		}
+	}
+	else
+	{
+		for (i = 0; i < (int)(sizeof(generate) / sizeof(generate[0])); i++)
+		{
+			generate[i](&song);
+			errors += Check_Song(&song, ref, out, size);
+			errors += Check_Thread(&song, false, (int16_t (*)[2])ref, (int16_t (*)[2])out, size / 2);
+			errors += Check_Thread(&song, true, (int16_t (*)[2])ref, (int16_t (*)[2])out, size / 2);
+			errors += Check_Overrun(&song, (int16_t (*)[2])ref, (int16_t (*)[2])out, size / 2);
+			free(song.writes);
+		}
+	}
+
+	free(ref);
+	free(out);
+
+	if (errors)
+	{
+		fprintf(stderr, "\n*** %d errors ***\n", errors);
+		return 1;
+	}
+	printf("\nSUCCESS\n");
+	return 0;
+}